@@ -28,6 +28,7 @@ ONEFLOW_API_PYBIND11_MODULE("", m) {
 
   m.def("StartLazyGlobalSession", &StartLazyGlobalSession);
   m.def("StopLazyGlobalSession", &StopLazyGlobalSession);
+  m.def("WaitForAsyncModelSave", &WaitForAsyncModelSave);
 
   using namespace oneflow;
   m.def("NewSessionId", &NewSessionId);
@@ -28,6 +28,7 @@ limitations under the License.
 #include "oneflow/core/job/job_build_and_infer_ctx_mgr.h"
 #include "oneflow/core/framework/config_def.h"
 #include "oneflow/core/persistence/tee_persistent_log_stream.h"
+#include "oneflow/core/persistence/async_snapshot_writer.h"
 
 namespace oneflow {
 
@@ -89,6 +90,13 @@ inline Maybe<void> StopLazyGlobalSession() {
   return Maybe<void>::Ok();
 }
 
+inline Maybe<void> WaitForAsyncModelSave() {
+  if (Global<AsyncSnapshotWriter>::Get() != nullptr) {
+    Global<AsyncSnapshotWriter>::Get()->WaitUntilAllDone();
+  }
+  return Maybe<void>::Ok();
+}
+
 }  // namespace oneflow
 
 #endif  // ONEFLOW_API_PYTHON_SESSION_SESSION_H_
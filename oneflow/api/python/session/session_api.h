@@ -30,4 +30,6 @@ inline void StartLazyGlobalSession() { return oneflow::StartLazyGlobalSession().
 
 inline void StopLazyGlobalSession() { return oneflow::StopLazyGlobalSession().GetOrThrow(); }
 
+inline void WaitForAsyncModelSave() { return oneflow::WaitForAsyncModelSave().GetOrThrow(); }
+
 #endif  // ONEFLOW_API_PYTHON_SESSION_SESSION_API_H_
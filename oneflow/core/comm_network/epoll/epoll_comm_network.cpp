@@ -23,6 +23,7 @@ limitations under the License.
 #include "oneflow/core/job/env_desc.h"
 #include "oneflow/core/job/global_for.h"
 #include <netinet/tcp.h>
+#include <unistd.h>
 
 namespace oneflow {
 
@@ -76,9 +77,14 @@ uint16_t PullPort(int64_t machine_id) {
   return port;
 }
 
+std::string GenShmRingKey(int64_t src_machine_id, int64_t dst_machine_id) {
+  return "EpollShmRing/" + std::to_string(src_machine_id) + "/" + std::to_string(dst_machine_id);
+}
+
 }  // namespace
 
 EpollCommNet::~EpollCommNet() {
+  for (auto& pair : machine_id2shm_helper_) { pair.second->StopWrite(); }
   for (size_t i = 0; i < pollers_.size(); ++i) {
     LOG(INFO) << "CommNet Thread " << i << " finish";
     pollers_[i]->Stop();
@@ -87,6 +93,7 @@ EpollCommNet::~EpollCommNet() {
   OF_SESSION_BARRIER();
   for (IOEventPoller* poller : pollers_) { delete poller; }
   for (auto& pair : sockfd2helper_) { delete pair.second; }
+  for (auto& pair : machine_id2shm_helper_) { delete pair.second; }
 }
 
 void EpollCommNet::RegisterMemoryDone() {
@@ -97,7 +104,7 @@ void EpollCommNet::SendActorMsg(int64_t dst_machine_id, const ActorMsg& actor_ms
   SocketMsg msg;
   msg.msg_type = SocketMsgType::kActor;
   msg.actor_msg = actor_msg;
-  GetSocketHelper(dst_machine_id)->AsyncWrite(msg);
+  AsyncWrite(dst_machine_id, msg);
 }
 
 void EpollCommNet::SendTransportMsg(int64_t dst_machine_id, const TransportMsg& transport_msg) {
@@ -108,7 +115,7 @@ void EpollCommNet::SendTransportMsg(int64_t dst_machine_id, const TransportMsg&
 }
 
 void EpollCommNet::SendSocketMsg(int64_t dst_machine_id, const SocketMsg& msg) {
-  GetSocketHelper(dst_machine_id)->AsyncWrite(msg);
+  AsyncWrite(dst_machine_id, msg);
 }
 
 SocketMemDesc* EpollCommNet::NewMemDesc(void* ptr, size_t byte_size) {
@@ -138,6 +145,7 @@ void EpollCommNet::InitSockets() {
   int64_t total_machine_num = Global<ResourceDesc, ForSession>::Get()->TotalMachineNum();
   machine_id2sockfd_.assign(total_machine_num, -1);
   sockfd2helper_.clear();
+  InitShmHelpers();
   size_t poller_idx = 0;
   auto NewSocketHelper = [&](int sockfd) {
     IOEventPoller* poller = pollers_[poller_idx];
@@ -166,6 +174,7 @@ void EpollCommNet::InitSockets() {
 
   // connect
   for (int64_t peer_id : peer_machine_id()) {
+    if (machine_id2shm_helper_.find(peer_id) != machine_id2shm_helper_.end()) { continue; }
     if (peer_id < this_machine_id) {
       ++src_machine_count;
       continue;
@@ -201,6 +210,49 @@ void EpollCommNet::InitSockets() {
   }
 }
 
+void EpollCommNet::InitShmHelpers() {
+  machine_id2shm_helper_.clear();
+  const ResourceDesc* resource_desc = Global<ResourceDesc, ForSession>::Get();
+  if (!resource_desc->use_shm_comm_net()) { return; }
+  int64_t this_machine_id = GlobalProcessCtx::Rank();
+  const std::string this_addr = resource_desc->machine(this_machine_id).addr();
+  std::vector<int64_t> local_peer_ids;
+  for (int64_t peer_id : peer_machine_id()) {
+    if (resource_desc->machine(peer_id).addr() == this_addr) { local_peer_ids.push_back(peer_id); }
+  }
+  // every process creates the rings it reads from, an empty name tells the peer to use a socket
+  HashMap<int64_t, std::unique_ptr<ShmRing>> peer_id2in_ring;
+  std::vector<ShmRing*> in_rings;
+  for (int64_t peer_id : local_peer_ids) {
+    const std::string name = "/oneflow_epoll_" + std::to_string(getpid()) + "_"
+                             + std::to_string(peer_id) + "_" + std::to_string(this_machine_id);
+    std::unique_ptr<ShmRing> in_ring =
+        ShmRing::Create(name, resource_desc->shm_comm_net_ring_byte());
+    Global<CtrlClient>::Get()->PushKV(GenShmRingKey(peer_id, this_machine_id),
+                                      in_ring ? name : std::string());
+    if (in_ring) {
+      in_rings.push_back(in_ring.get());
+      peer_id2in_ring.emplace(peer_id, std::move(in_ring));
+    }
+  }
+  for (int64_t peer_id : local_peer_ids) {
+    std::string out_ring_name;
+    Global<CtrlClient>::Get()->PullKV(GenShmRingKey(this_machine_id, peer_id),
+                                      [&](const std::string& v) { out_ring_name = v; });
+    auto in_ring_it = peer_id2in_ring.find(peer_id);
+    if (out_ring_name.empty() || in_ring_it == peer_id2in_ring.end()) { continue; }
+    machine_id2shm_helper_.emplace(
+        peer_id, new ShmHelper(std::move(in_ring_it->second), ShmRing::Open(out_ring_name)));
+    LOG(INFO) << "CommNet:Epoll machine " << peer_id << " connected by shared memory";
+  }
+  // unlinking is safe once every peer has opened its out rings
+  OF_SESSION_BARRIER();
+  for (int64_t peer_id : local_peer_ids) {
+    Global<CtrlClient>::Get()->ClearKV(GenShmRingKey(peer_id, this_machine_id));
+  }
+  for (ShmRing* in_ring : in_rings) { in_ring->Unlink(); }
+}
+
 SocketHelper* EpollCommNet::GetSocketHelper(int64_t machine_id) {
   int sockfd = machine_id2sockfd_.at(machine_id);
   return sockfd2helper_.at(sockfd);
@@ -213,7 +265,16 @@ void EpollCommNet::DoRead(void* read_id, int64_t src_machine_id, void* src_token
   msg.request_write_msg.dst_machine_id = GlobalProcessCtx::Rank();
   msg.request_write_msg.dst_token = dst_token;
   msg.request_write_msg.read_id = read_id;
-  GetSocketHelper(src_machine_id)->AsyncWrite(msg);
+  AsyncWrite(src_machine_id, msg);
+}
+
+void EpollCommNet::AsyncWrite(int64_t dst_machine_id, const SocketMsg& msg) {
+  auto shm_helper_it = machine_id2shm_helper_.find(dst_machine_id);
+  if (shm_helper_it != machine_id2shm_helper_.end()) {
+    shm_helper_it->second->AsyncWrite(msg);
+  } else {
+    GetSocketHelper(dst_machine_id)->AsyncWrite(msg);
+  }
 }
 
 }  // namespace oneflow
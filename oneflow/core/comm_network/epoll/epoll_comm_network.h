@@ -21,6 +21,7 @@ limitations under the License.
 #include "oneflow/core/comm_network/comm_network.h"
 #include "oneflow/core/comm_network/epoll/socket_helper.h"
 #include "oneflow/core/comm_network/epoll/socket_memory_desc.h"
+#include "oneflow/core/comm_network/epoll/shm_helper.h"
 
 namespace oneflow {
 
@@ -46,12 +47,16 @@ class EpollCommNet final : public CommNetIf<SocketMemDesc> {
   EpollCommNet();
   DEPRECATED EpollCommNet(const Plan& plan);
   void InitSockets();
+  void InitShmHelpers();
   SocketHelper* GetSocketHelper(int64_t machine_id);
+  void AsyncWrite(int64_t dst_machine_id, const SocketMsg& msg);
   void DoRead(void* read_id, int64_t src_machine_id, void* src_token, void* dst_token) override;
 
   std::vector<IOEventPoller*> pollers_;
   std::vector<int> machine_id2sockfd_;
   HashMap<int, SocketHelper*> sockfd2helper_;
+  // the peers on the same host talk through shared memory instead of sockets
+  HashMap<int64_t, ShmHelper*> machine_id2shm_helper_;
 };
 
 }  // namespace oneflow
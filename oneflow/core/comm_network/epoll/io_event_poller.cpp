@@ -16,15 +16,58 @@ limitations under the License.
 #ifdef __linux__
 
 #include "oneflow/core/comm_network/epoll/io_event_poller.h"
+#include "oneflow/core/job/job_set.pb.h"
+#include <poll.h>
 #include <sys/eventfd.h>
 
 namespace oneflow {
 
+namespace {
+
+bool IsIoUringEnabled() {
+  return Global<const IOConf>::Get() != nullptr && Global<const IOConf>::Get()->enable_io_uring();
+}
+
+#ifdef OF_WITH_IO_URING
+
+constexpr uint32_t kIoUringEntries = 256;
+// the user_data of the polls which probe and cancel the multishot poll
+constexpr uint64_t kProbeUserData = 0;
+
+io_uring_sqe NewMultishotPollSqe(int fd, uint32_t poll_events, uint64_t user_data) {
+  io_uring_sqe sqe;
+  std::memset(&sqe, 0, sizeof(sqe));
+  sqe.opcode = IORING_OP_POLL_ADD;
+  sqe.fd = fd;
+  sqe.len = IORING_POLL_ADD_MULTI;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  poll_events = (poll_events << 16) | (poll_events >> 16);
+#endif
+  sqe.poll32_events = poll_events;
+  sqe.user_data = user_data;
+  return sqe;
+}
+
+void WaitCqes(IoUring* ring, size_t cqe_num, std::vector<io_uring_cqe>* cqes) {
+  ring->ReapCqes(cqes);
+  while (cqes->size() < cqe_num) {
+    if (ring->Enter(0, 1) < 0) { PCHECK(errno == EINTR || errno == EAGAIN || errno == EBUSY); }
+    ring->ReapCqes(cqes);
+  }
+}
+
+#endif  // OF_WITH_IO_URING
+
+}  // namespace
+
 const int IOEventPoller::max_event_num_ = 32;
 
-IOEventPoller::IOEventPoller() {
-  epfd_ = epoll_create1(0);
-  ep_events_ = new epoll_event[max_event_num_];
+IOEventPoller::IOEventPoller() : epfd_(-1), ep_events_(nullptr) {
+  use_io_uring_ = IsIoUringEnabled() && InitIoUring();
+  if (!use_io_uring_) {
+    epfd_ = epoll_create1(0);
+    ep_events_ = new epoll_event[max_event_num_];
+  }
   io_handlers_.clear();
   break_epoll_loop_fd_ = eventfd(0, 0);
   PCHECK(break_epoll_loop_fd_ != -1);
@@ -37,7 +80,7 @@ IOEventPoller::~IOEventPoller() {
     delete handler;
   }
   delete[] ep_events_;
-  PCHECK(close(epfd_) == 0);
+  if (epfd_ != -1) { PCHECK(close(epfd_) == 0); }
 }
 
 void IOEventPoller::AddFd(int fd, std::function<void()> read_handler,
@@ -49,7 +92,13 @@ void IOEventPoller::AddFdWithOnlyReadHandler(int fd, std::function<void()> read_
   AddFd(fd, &read_handler, nullptr);
 }
 
-void IOEventPoller::Start() { thread_ = std::thread(&IOEventPoller::EpollLoop, this); }
+void IOEventPoller::Start() {
+  if (use_io_uring_) {
+    thread_ = std::thread(&IOEventPoller::IoUringLoop, this);
+  } else {
+    thread_ = std::thread(&IOEventPoller::EpollLoop, this);
+  }
+}
 
 void IOEventPoller::Stop() {
   uint64_t break_epoll_loop_event = 1;
@@ -72,7 +121,13 @@ void IOEventPoller::AddFd(int fd, std::function<void()>* read_handler,
   if (read_handler) { io_handler->read_handler = *read_handler; }
   if (write_handler) { io_handler->write_handler = *write_handler; }
   io_handler->fd = fd;
+  if (read_handler) { io_handler->poll_events |= POLLIN; }
+  if (write_handler) { io_handler->poll_events |= POLLOUT; }
   io_handlers_.push_front(io_handler);
+  if (use_io_uring_) {
+    SubmitPoll(io_handler);
+    return;
+  }
   // Add Fd to Epoll
   epoll_event ep_event;
   ep_event.events = EPOLLET;
@@ -106,6 +161,78 @@ void IOEventPoller::EpollLoop() {
   }
 }
 
+#ifdef OF_WITH_IO_URING
+
+// Multishot polls are failed with EINVAL by kernels older than 5.13. The probe polls an eventfd
+// which is already readable, so it completes at once, and then is cancelled.
+bool IOEventPoller::InitIoUring() {
+  if (!ring_.Init(kIoUringEntries)) {
+    LOG(WARNING) << "fall back to epoll";
+    return false;
+  }
+  const int probe_fd = eventfd(1, 0);
+  PCHECK(probe_fd != -1);
+  std::vector<io_uring_cqe> cqes;
+  ring_.PushSqe(NewMultishotPollSqe(probe_fd, POLLIN, kProbeUserData));
+  ring_.EnterUntilSubmitted(1);
+  WaitCqes(&ring_, 1, &cqes);
+  const bool is_multishot = cqes.front().res >= 0 && (cqes.front().flags & IORING_CQE_F_MORE);
+  if (is_multishot) {
+    io_uring_sqe sqe;
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_POLL_REMOVE;
+    sqe.addr = kProbeUserData;
+    sqe.user_data = kProbeUserData;
+    ring_.PushSqe(sqe);
+    ring_.EnterUntilSubmitted(1);
+    // the completions of the removal and of the cancelled poll
+    WaitCqes(&ring_, 3, &cqes);
+  } else {
+    LOG(WARNING) << "multishot poll of io_uring is not supported, fall back to epoll";
+  }
+  PCHECK(close(probe_fd) == 0);
+  return is_multishot;
+}
+
+void IOEventPoller::SubmitPoll(const IOHandler* io_handler) {
+  std::unique_lock<std::mutex> lock(sq_mutex_);
+  ring_.PushSqe(NewMultishotPollSqe(io_handler->fd, io_handler->poll_events,
+                                    reinterpret_cast<uint64_t>(io_handler)));
+  ring_.EnterUntilSubmitted(1);
+}
+
+void IOEventPoller::IoUringLoop() {
+  std::vector<io_uring_cqe> cqes;
+  while (true) {
+    cqes.clear();
+    WaitCqes(&ring_, 1, &cqes);
+    for (const io_uring_cqe& cqe : cqes) {
+      auto io_handler = reinterpret_cast<const IOHandler*>(cqe.user_data);
+      CHECK_GE(cqe.res, 0) << "fd: " << io_handler->fd << " " << std::strerror(-cqe.res);
+      const uint32_t events = cqe.res;
+      CHECK(!(events & POLLERR)) << "fd: " << io_handler->fd;
+      if (io_handler->fd == break_epoll_loop_fd_) { return; }
+      if (events & POLLIN) { io_handler->read_handler(); }
+      if (events & POLLOUT) { io_handler->write_handler(); }
+      // the poll is ended by the kernel, e.g. when the completion queue overflows
+      if (!(cqe.flags & IORING_CQE_F_MORE)) { SubmitPoll(io_handler); }
+    }
+  }
+}
+
+#else
+
+bool IOEventPoller::InitIoUring() {
+  LOG(WARNING) << "io_uring is not supported, fall back to epoll";
+  return false;
+}
+
+void IOEventPoller::SubmitPoll(const IOHandler* io_handler) { UNIMPLEMENTED(); }
+
+void IOEventPoller::IoUringLoop() { UNIMPLEMENTED(); }
+
+#endif  // OF_WITH_IO_URING
+
 }  // namespace oneflow
 
 #endif  // __linux__
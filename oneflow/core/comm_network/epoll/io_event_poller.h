@@ -17,11 +17,16 @@ limitations under the License.
 #define ONEFLOW_CORE_COMM_NETWORK_EPOLL_IO_EVENT_POLLER_H_
 
 #include "oneflow/core/comm_network/epoll/socket_message.h"
+#include "oneflow/core/common/io_uring.h"
 
 #ifdef OF_PLATFORM_POSIX
 
 namespace oneflow {
 
+// Calls the handlers of fds in a background thread when they become readable or writable, like
+// edge-triggered epoll. With config enable_io_uring the fds are watched by multishot polls of an
+// io_uring instead, which need linux 5.13 and fall back to epoll otherwise. Only the readiness
+// notification goes through io_uring, the handlers still do the socket reads and writes themselves.
 class IOEventPoller final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(IOEventPoller);
@@ -40,17 +45,25 @@ class IOEventPoller final {
       read_handler = []() { UNIMPLEMENTED(); };
       write_handler = []() { UNIMPLEMENTED(); };
       fd = -1;
+      poll_events = 0;
     }
     std::function<void()> read_handler;
     std::function<void()> write_handler;
     int fd;
+    uint32_t poll_events;
   };
 
   void AddFd(int fd, std::function<void()>* read_handler, std::function<void()>* write_handler);
 
+  bool InitIoUring();
+  void SubmitPoll(const IOHandler* io_handler);
   void EpollLoop();
+  void IoUringLoop();
   static const int max_event_num_;
 
+  bool use_io_uring_;
+  IoUring ring_;
+  std::mutex sq_mutex_;
   int epfd_;
   epoll_event* ep_events_;
   std::forward_list<IOHandler*> io_handlers_;
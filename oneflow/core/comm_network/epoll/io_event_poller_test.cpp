@@ -0,0 +1,83 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifdef __linux__
+
+#include "oneflow/core/comm_network/epoll/io_event_poller.h"
+#include "oneflow/core/job/job_set.pb.h"
+
+namespace oneflow {
+
+namespace {
+
+// Writes bytes to one end of a socket pair from this thread, the poller drains the other end in
+// the read handler until EAGAIN like SocketReadHelper does.
+void TestTransfer(bool enable_io_uring) {
+  IOConf io_conf;
+  io_conf.mutable_data_fs_conf()->mutable_localfs_conf();
+  io_conf.mutable_snapshot_fs_conf()->mutable_localfs_conf();
+  io_conf.set_enable_io_uring(enable_io_uring);
+  Global<const IOConf>::New(io_conf);
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  const int64_t total_size = 1 << 22;
+  std::atomic<int64_t> read_size(0);
+  std::atomic<int64_t> write_event_cnt(0);
+  {
+    IOEventPoller poller;
+    poller.AddFd(
+        fds[0],
+        [&]() {
+          std::vector<char> buf(4096);
+          while (true) {
+            const ssize_t n = read(fds[0], buf.data(), buf.size());
+            if (n <= 0) {
+              ASSERT_EQ(n, -1);
+              ASSERT_TRUE(errno == EAGAIN || errno == EWOULDBLOCK);
+              break;
+            }
+            FOR_RANGE(ssize_t, i, 0, n) { ASSERT_EQ(buf[i], static_cast<char>(read_size + i)); }
+            read_size += n;
+          }
+        },
+        [&]() { write_event_cnt += 1; });
+    poller.Start();
+    // the writes block while the socket buffer is full, so the reader is woken up many times
+    std::vector<char> buf(total_size);
+    FOR_RANGE(int64_t, i, 0, total_size) { buf[i] = static_cast<char>(i); }
+    int64_t written_size = 0;
+    while (written_size < total_size) {
+      const ssize_t n = write(fds[1], buf.data() + written_size, total_size - written_size);
+      ASSERT_GT(n, 0);
+      written_size += n;
+    }
+    while (read_size < total_size) { std::this_thread::yield(); }
+    // the socket is writable since it is added
+    EXPECT_GT(write_event_cnt, 0);
+    poller.Stop();
+  }
+  PCHECK(close(fds[1]) == 0);
+  Global<const IOConf>::Delete();
+}
+
+}  // namespace
+
+TEST(IOEventPoller, transfer_by_epoll) { TestTransfer(false); }
+
+TEST(IOEventPoller, transfer_by_io_uring) { TestTransfer(true); }
+
+}  // namespace oneflow
+
+#endif  // __linux__
@@ -0,0 +1,93 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifdef __linux__
+
+#include "oneflow/core/comm_network/epoll/shm_helper.h"
+#include "oneflow/core/comm_network/epoll/epoll_comm_network.h"
+#include "oneflow/core/comm_network/epoll/socket_memory_desc.h"
+#include "oneflow/core/actor/actor_message_bus.h"
+#include "oneflow/core/transport/transport.h"
+
+namespace oneflow {
+
+ShmHelper::ShmHelper(std::unique_ptr<ShmRing>&& in_ring, std::unique_ptr<ShmRing>&& out_ring)
+    : in_ring_(std::move(in_ring)), out_ring_(std::move(out_ring)) {
+  write_thread_ = std::thread(&ShmHelper::WriteLoop, this);
+  read_thread_ = std::thread(&ShmHelper::ReadLoop, this);
+}
+
+ShmHelper::~ShmHelper() {
+  StopWrite();
+  StopRead();
+}
+
+void ShmHelper::AsyncWrite(const SocketMsg& msg) {
+  CHECK_EQ(msg_channel_.Send(msg), kChannelStatusSuccess);
+}
+
+void ShmHelper::StopWrite() {
+  msg_channel_.Close();
+  if (write_thread_.joinable()) { write_thread_.join(); }
+}
+
+void ShmHelper::StopRead() {
+  in_ring_->Stop();
+  if (read_thread_.joinable()) { read_thread_.join(); }
+}
+
+// The msgs are written by a dedicated thread, so that ReadLoop never blocks on a full out ring
+// when it answers a RequestWrite, which would deadlock two peers writing to each other.
+void ShmHelper::WriteLoop() {
+  SocketMsg msg;
+  while (msg_channel_.Receive(&msg) == kChannelStatusSuccess) {
+    CHECK(out_ring_->Write(&msg, sizeof(msg)));
+    if (msg.msg_type == SocketMsgType::kRequestRead) {
+      auto src_mem_desc = static_cast<const SocketMemDesc*>(msg.request_read_msg.src_token);
+      CHECK(out_ring_->Write(src_mem_desc->mem_ptr, src_mem_desc->byte_size));
+    }
+  }
+}
+
+void ShmHelper::ReadLoop() {
+  SocketMsg msg;
+  while (in_ring_->Read(&msg, sizeof(msg)) && ReadMsg(msg)) {}
+}
+
+bool ShmHelper::ReadMsg(const SocketMsg& msg) {
+  if (msg.msg_type == SocketMsgType::kRequestWrite) {
+    SocketMsg msg_to_send;
+    msg_to_send.msg_type = SocketMsgType::kRequestRead;
+    msg_to_send.request_read_msg.src_token = msg.request_write_msg.src_token;
+    msg_to_send.request_read_msg.dst_token = msg.request_write_msg.dst_token;
+    msg_to_send.request_read_msg.read_id = msg.request_write_msg.read_id;
+    Global<EpollCommNet>::Get()->SendSocketMsg(msg.request_write_msg.dst_machine_id, msg_to_send);
+  } else if (msg.msg_type == SocketMsgType::kRequestRead) {
+    auto dst_mem_desc = static_cast<const SocketMemDesc*>(msg.request_read_msg.dst_token);
+    if (!in_ring_->Read(dst_mem_desc->mem_ptr, dst_mem_desc->byte_size)) { return false; }
+    Global<EpollCommNet>::Get()->ReadDone(msg.request_read_msg.read_id);
+  } else if (msg.msg_type == SocketMsgType::kActor) {
+    Global<ActorMsgBus>::Get()->SendMsgWithoutCommNet(msg.actor_msg);
+  } else if (msg.msg_type == SocketMsgType::kTransport) {
+    Global<Transport>::Get()->EnqueueTransportMsg(msg.transport_msg);
+  } else {
+    UNIMPLEMENTED();
+  }
+  return true;
+}
+
+}  // namespace oneflow
+
+#endif  // __linux__
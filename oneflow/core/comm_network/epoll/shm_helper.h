@@ -0,0 +1,61 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMM_NETWORK_EPOLL_SHM_HELPER_H_
+#define ONEFLOW_CORE_COMM_NETWORK_EPOLL_SHM_HELPER_H_
+
+#include "oneflow/core/comm_network/epoll/socket_message.h"
+#include "oneflow/core/comm_network/shm/shm_ring.h"
+#include "oneflow/core/common/channel.h"
+
+#ifdef __linux__
+
+namespace oneflow {
+
+// Exchanges SocketMsgs, and the register bodies following RequestRead msgs, with a peer process on
+// the same host through a pair of shared memory rings instead of a socket. Register bodies are
+// copied through the ring rather than mapped into the peer, and outgoing msgs are queued on a
+// Channel (mutex based) for the writer thread, only the rings themselves are lock-free.
+class ShmHelper final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ShmHelper);
+  ShmHelper() = delete;
+  ~ShmHelper();
+
+  ShmHelper(std::unique_ptr<ShmRing>&& in_ring, std::unique_ptr<ShmRing>&& out_ring);
+
+  void AsyncWrite(const SocketMsg& msg);
+  // Finish writing the queued msgs, no more AsyncWrite is allowed.
+  void StopWrite();
+  // Stop reading, the peer must have called StopWrite.
+  void StopRead();
+
+ private:
+  void WriteLoop();
+  void ReadLoop();
+  bool ReadMsg(const SocketMsg& msg);
+
+  std::unique_ptr<ShmRing> in_ring_;
+  std::unique_ptr<ShmRing> out_ring_;
+  Channel<SocketMsg> msg_channel_;
+  std::thread write_thread_;
+  std::thread read_thread_;
+};
+
+}  // namespace oneflow
+
+#endif  // __linux__
+
+#endif  // ONEFLOW_CORE_COMM_NETWORK_EPOLL_SHM_HELPER_H_
@@ -0,0 +1,233 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifdef __linux__
+
+#include "oneflow/core/comm_network/shm/shm_ring.h"
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+
+namespace oneflow {
+
+namespace {
+
+constexpr uint64_t kShmRingMagic = 0x4f46534852494e47;  // "OFSHRING"
+constexpr size_t kCacheLineSize = 64;
+
+// Spins and then yields for a while, the caller goes to sleep on a futex after that.
+class Backoff final {
+ public:
+  Backoff() : count_(0) {}
+  ~Backoff() = default;
+
+  // Returns false once it is time to sleep.
+  bool Wait() {
+    ++count_;
+    if (count_ < 1024) {
+#if defined(__x86_64__)
+      __builtin_ia32_pause();
+#endif
+      return true;
+    } else if (count_ < 2048) {
+      std::this_thread::yield();
+      return true;
+    } else {
+      return false;
+    }
+  }
+
+ private:
+  int64_t count_;
+};
+
+// The futex words live in the shared memory, so they are not FUTEX_PRIVATE_FLAG. Errors such as
+// EAGAIN and EINTR are left to the callers, which check their condition again anyway.
+void FutexWait(std::atomic<uint32_t>* word, uint32_t val) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, val, nullptr, nullptr, 0);
+}
+
+void FutexWakeAll(std::atomic<uint32_t>* word) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+void WakeUpIfSleeping(std::atomic<uint32_t>* seq, std::atomic<uint32_t>* sleeping) {
+  if (sleeping->load() == 0) { return; }
+  seq->fetch_add(1);
+  FutexWakeAll(seq);
+}
+
+}  // namespace
+
+// head and tail count the bytes ever read and written, they live on separate cache lines so that
+// the reader and the writer do not invalidate the line of each other. The writer sleeps on
+// head_seq while the ring is full and the reader sleeps on tail_seq while it is empty.
+struct ShmRing::Header {
+  uint64_t magic;
+  uint64_t capacity;
+  alignas(kCacheLineSize) std::atomic<uint64_t> head;
+  std::atomic<uint32_t> head_seq;
+  std::atomic<uint32_t> writer_sleeping;
+  alignas(kCacheLineSize) std::atomic<uint64_t> tail;
+  std::atomic<uint32_t> tail_seq;
+  std::atomic<uint32_t> reader_sleeping;
+};
+
+ShmRing::ShmRing(const std::string& name, void* ptr, size_t byte_size, bool is_owner)
+    : name_(name), ptr_(ptr), byte_size_(byte_size), is_owner_(is_owner), stopped_(false) {
+  header_ = static_cast<Header*>(ptr);
+  data_ = static_cast<char*>(ptr) + RoundUp(sizeof(Header), kCacheLineSize);
+  capacity_ = header_->capacity;
+}
+
+ShmRing::~ShmRing() {
+  PCHECK(munmap(ptr_, byte_size_) == 0);
+  if (is_owner_) { Unlink(); }
+}
+
+std::unique_ptr<ShmRing> ShmRing::Create(const std::string& name, size_t capacity) {
+  static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "std::atomic<uint64_t> must be address-free");
+  CHECK_GT(capacity, 0);
+  const size_t byte_size = RoundUp(sizeof(Header), kCacheLineSize) + capacity;
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd == -1) {
+    PLOG(WARNING) << "shm_open " << name << " failed";
+    return nullptr;
+  }
+  // posix_fallocate makes the failure show up here rather than as SIGBUS on the first access
+  if (ftruncate(fd, byte_size) != 0 || posix_fallocate(fd, 0, byte_size) != 0) {
+    LOG(WARNING) << "allocating " << byte_size << " bytes for " << name << " failed";
+    PCHECK(close(fd) == 0);
+    PCHECK(shm_unlink(name.c_str()) == 0);
+    return nullptr;
+  }
+  void* ptr = mmap(nullptr, byte_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  PCHECK(ptr != MAP_FAILED);
+  PCHECK(close(fd) == 0);
+  Header* header = new (ptr) Header;
+  header->magic = kShmRingMagic;
+  header->capacity = capacity;
+  header->head.store(0);
+  header->head_seq.store(0);
+  header->writer_sleeping.store(0);
+  header->tail.store(0);
+  header->tail_seq.store(0);
+  header->reader_sleeping.store(0);
+  return std::unique_ptr<ShmRing>(new ShmRing(name, ptr, byte_size, true));
+}
+
+std::unique_ptr<ShmRing> ShmRing::Open(const std::string& name) {
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  PCHECK(fd != -1) << "shm_open " << name;
+  struct stat st;
+  PCHECK(fstat(fd, &st) == 0);
+  const size_t byte_size = st.st_size;
+  CHECK_GT(byte_size, sizeof(Header));
+  void* ptr = mmap(nullptr, byte_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  PCHECK(ptr != MAP_FAILED);
+  PCHECK(close(fd) == 0);
+  const Header* header = static_cast<const Header*>(ptr);
+  CHECK_EQ(header->magic, kShmRingMagic);
+  CHECK_EQ(RoundUp(sizeof(Header), kCacheLineSize) + header->capacity, byte_size);
+  return std::unique_ptr<ShmRing>(new ShmRing(name, ptr, byte_size, false));
+}
+
+bool ShmRing::Write(const void* ptr, size_t size) {
+  const char* src = static_cast<const char*>(ptr);
+  uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+  Backoff backoff;
+  while (size > 0) {
+    const uint64_t head = header_->head.load(std::memory_order_acquire);
+    const size_t free_size = capacity_ - (tail - head);
+    if (free_size == 0) {
+      if (stopped_.load(std::memory_order_relaxed)) { return false; }
+      if (!backoff.Wait()) {
+        SleepUntilMoved(header_->head, head, &header_->head_seq, &header_->writer_sleeping);
+      }
+      continue;
+    }
+    const size_t offset = tail % capacity_;
+    const size_t n = std::min(std::min(free_size, size), capacity_ - offset);
+    memcpy(data_ + offset, src, n);
+    tail += n;
+    src += n;
+    size -= n;
+    header_->tail.store(tail);
+    WakeUpIfSleeping(&header_->tail_seq, &header_->reader_sleeping);
+    backoff = Backoff();
+  }
+  return true;
+}
+
+bool ShmRing::Read(void* ptr, size_t size) {
+  char* dst = static_cast<char*>(ptr);
+  uint64_t head = header_->head.load(std::memory_order_relaxed);
+  Backoff backoff;
+  while (size > 0) {
+    const uint64_t tail = header_->tail.load(std::memory_order_acquire);
+    const size_t used_size = tail - head;
+    if (used_size == 0) {
+      if (stopped_.load(std::memory_order_relaxed)) { return false; }
+      if (!backoff.Wait()) {
+        SleepUntilMoved(header_->tail, tail, &header_->tail_seq, &header_->reader_sleeping);
+      }
+      continue;
+    }
+    const size_t offset = head % capacity_;
+    const size_t n = std::min(std::min(used_size, size), capacity_ - offset);
+    memcpy(dst, data_ + offset, n);
+    head += n;
+    dst += n;
+    size -= n;
+    header_->head.store(head);
+    WakeUpIfSleeping(&header_->head_seq, &header_->writer_sleeping);
+    backoff = Backoff();
+  }
+  return true;
+}
+
+void ShmRing::Stop() {
+  stopped_.store(true);
+  header_->head_seq.fetch_add(1);
+  FutexWakeAll(&header_->head_seq);
+  header_->tail_seq.fetch_add(1);
+  FutexWakeAll(&header_->tail_seq);
+}
+
+// The sleeper publishes *sleeping before checking pos and the waker moves pos before checking
+// *sleeping, all in sequentially consistent order, so at least one of them sees the other. If the
+// waker bumps *seq after the sleeper read it, FUTEX_WAIT returns at once or is woken up.
+void ShmRing::SleepUntilMoved(const std::atomic<uint64_t>& pos, uint64_t old_pos,
+                              std::atomic<uint32_t>* seq, std::atomic<uint32_t>* sleeping) {
+  const uint32_t old_seq = seq->load();
+  sleeping->store(1);
+  if (pos.load() == old_pos && !stopped_.load()) { FutexWait(seq, old_seq); }
+  sleeping->store(0);
+}
+
+void ShmRing::Unlink() {
+  if (is_owner_) {
+    if (shm_unlink(name_.c_str()) != 0) { PCHECK(errno == ENOENT); }
+    is_owner_ = false;
+  }
+}
+
+}  // namespace oneflow
+
+#endif  // __linux__
@@ -0,0 +1,70 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMM_NETWORK_SHM_SHM_RING_H_
+#define ONEFLOW_CORE_COMM_NETWORK_SHM_SHM_RING_H_
+
+#include "oneflow/core/common/util.h"
+
+#ifdef __linux__
+
+namespace oneflow {
+
+// A byte stream between two processes on one host, backed by a ring buffer in POSIX shared
+// memory. There must be only one writer thread and one reader thread at a time, possibly in
+// different processes; they never take a lock but spin, yield and then sleep on a futex while the
+// ring is full or empty.
+class ShmRing final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ShmRing);
+  ~ShmRing();
+
+  // Returns nullptr if the shared memory can not be created, e.g. /dev/shm is too small.
+  static std::unique_ptr<ShmRing> Create(const std::string& name, size_t capacity);
+  static std::unique_ptr<ShmRing> Open(const std::string& name);
+
+  // Block until all the bytes are transferred. Return false if Stop() is called meanwhile.
+  bool Write(const void* ptr, size_t size);
+  bool Read(void* ptr, size_t size);
+
+  // Wake up the blocked Write() and Read() of this process.
+  void Stop();
+  // Remove the name, the memory is kept until every process unmaps it.
+  void Unlink();
+
+  const std::string& name() const { return name_; }
+  size_t capacity() const { return capacity_; }
+
+ private:
+  struct Header;
+  ShmRing(const std::string& name, void* ptr, size_t byte_size, bool is_owner);
+  void SleepUntilMoved(const std::atomic<uint64_t>& pos, uint64_t old_pos,
+                       std::atomic<uint32_t>* seq, std::atomic<uint32_t>* sleeping);
+
+  std::string name_;
+  void* ptr_;
+  size_t byte_size_;
+  bool is_owner_;
+  Header* header_;
+  char* data_;
+  size_t capacity_;
+  std::atomic<bool> stopped_;
+};
+
+}  // namespace oneflow
+
+#endif  // __linux__
+
+#endif  // ONEFLOW_CORE_COMM_NETWORK_SHM_SHM_RING_H_
@@ -0,0 +1,115 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifdef __linux__
+
+#include "oneflow/core/comm_network/shm/shm_ring.h"
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace oneflow {
+
+namespace {
+
+std::string GenRingName(const std::string& suffix) {
+  return "/oneflow_shm_ring_test_" + std::to_string(getpid()) + "_" + suffix;
+}
+
+char Byte4Index(size_t i) { return static_cast<char>((i * 131 + 7) % 251); }
+
+// Writes total_size bytes in pieces of increasing size from a child process.
+void ForkWriter(const std::string& name, size_t total_size, pid_t* pid) {
+  *pid = fork();
+  ASSERT_NE(*pid, -1);
+  if (*pid == 0) {
+    std::unique_ptr<ShmRing> ring = ShmRing::Open(name);
+    std::vector<char> buf(total_size);
+    FOR_RANGE(size_t, i, 0, total_size) { buf[i] = Byte4Index(i); }
+    size_t offset = 0;
+    size_t piece_size = 1;
+    while (offset < total_size) {
+      const size_t n = std::min(piece_size, total_size - offset);
+      if (!ring->Write(buf.data() + offset, n)) { _exit(1); }
+      offset += n;
+      piece_size = piece_size * 3 + 1;
+    }
+    _exit(0);
+  }
+}
+
+void TestReadFromOtherProcess(size_t capacity, size_t total_size, size_t read_size) {
+  const std::string name = GenRingName(std::to_string(capacity));
+  std::unique_ptr<ShmRing> ring = ShmRing::Create(name, capacity);
+  ASSERT_TRUE(ring != nullptr);
+  pid_t pid = -1;
+  ForkWriter(name, total_size, &pid);
+  std::vector<char> buf(read_size);
+  size_t offset = 0;
+  while (offset < total_size) {
+    const size_t n = std::min(read_size, total_size - offset);
+    ASSERT_TRUE(ring->Read(buf.data(), n));
+    FOR_RANGE(size_t, i, 0, n) { ASSERT_EQ(buf[i], Byte4Index(offset + i)); }
+    offset += n;
+  }
+  int status = -1;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(WEXITSTATUS(status), 0);
+}
+
+}  // namespace
+
+TEST(ShmRing, read_from_other_process) {
+  TestReadFromOtherProcess(4096, 1 << 20, 1000);
+  TestReadFromOtherProcess(61, 100000, 17);
+  TestReadFromOtherProcess(1 << 20, 1 << 20, 1 << 20);
+}
+
+TEST(ShmRing, write_wakes_up_sleeping_reader) {
+  const std::string name = GenRingName("sleep");
+  std::unique_ptr<ShmRing> ring = ShmRing::Create(name, 64);
+  ASSERT_TRUE(ring != nullptr);
+  pid_t pid = fork();
+  ASSERT_NE(pid, -1);
+  if (pid == 0) {
+    // long enough for the reader to go to sleep on the futex
+    usleep(100 * 1000);
+    const char c = 42;
+    _exit(ShmRing::Open(name)->Write(&c, 1) ? 0 : 1);
+  }
+  char c = 0;
+  ASSERT_TRUE(ring->Read(&c, 1));
+  ASSERT_EQ(c, 42);
+  int status = -1;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(WEXITSTATUS(status), 0);
+}
+
+TEST(ShmRing, stop_wakes_up_reader) {
+  std::unique_ptr<ShmRing> ring = ShmRing::Create(GenRingName("stop"), 64);
+  ASSERT_TRUE(ring != nullptr);
+  std::thread reader([&ring]() {
+    char c = 0;
+    ASSERT_FALSE(ring->Read(&c, 1));
+  });
+  usleep(100 * 1000);
+  ring->Stop();
+  reader.join();
+}
+
+}  // namespace oneflow
+
+#endif  // __linux__
@@ -0,0 +1,115 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_BFLOAT16_H_
+#define ONEFLOW_CORE_COMMON_BFLOAT16_H_
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "oneflow/core/common/cpu_isa.h"
+
+namespace oneflow {
+
+// bfloat16 keeps the upper 16 bits of an ieee float: 1 sign bit, 8 exponent bits and 7 mantissa
+// bits, so it has the range of float with less precision. Values convert implicitly to and from
+// float and all arithmetic is done in float.
+struct alignas(2) bfloat16 {
+  uint16_t x;
+
+  bfloat16() = default;
+  bfloat16(float value) : x(RoundFromFloat(value)) {}
+  template<typename T, typename std::enable_if<std::is_arithmetic<T>::value
+                                               && !std::is_same<T, float>::value>::type* = nullptr>
+  bfloat16(T value) : bfloat16(static_cast<float>(value)) {}
+
+  operator float() const {
+    const uint32_t bits = static_cast<uint32_t>(x) << 16;
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  bfloat16& operator+=(float rhs) { return *this = bfloat16(static_cast<float>(*this) + rhs); }
+  bfloat16& operator-=(float rhs) { return *this = bfloat16(static_cast<float>(*this) - rhs); }
+  bfloat16& operator*=(float rhs) { return *this = bfloat16(static_cast<float>(*this) * rhs); }
+  bfloat16& operator/=(float rhs) { return *this = bfloat16(static_cast<float>(*this) / rhs); }
+
+  static bfloat16 FromBits(uint16_t bits) {
+    bfloat16 ret;
+    ret.x = bits;
+    return ret;
+  }
+
+  // round to nearest even, nan stays a quiet nan
+  static uint16_t RoundFromFloat(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    if ((bits & 0x7fffffffU) > 0x7f800000U) { return static_cast<uint16_t>((bits >> 16) | 0x40U); }
+    bits += 0x7fffU + ((bits >> 16) & 1U);
+    return static_cast<uint16_t>(bits >> 16);
+  }
+};
+
+static_assert(sizeof(bfloat16) == 2, "sizeof(bfloat16) != 2");
+
+#ifdef OF_WITH_AVX512BF16_DISPATCH
+// converts the leading multiple of 16 values and returns how many values it converted
+OF_TARGET_ISA("avx512f,avx512bf16")
+inline int64_t FloatToBFloat16Avx512Bf16(const float* in, bfloat16* out, int64_t n) {
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m256bh packed = _mm512_cvtneps_pbh(_mm512_loadu_ps(in + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), (__m256i)packed);
+  }
+  return i;
+}
+#endif  // OF_WITH_AVX512BF16_DISPATCH
+
+#ifdef OF_WITH_AVX512F_DISPATCH
+OF_TARGET_ISA("avx512f")
+inline int64_t BFloat16ToFloatAvx512(const bfloat16* in, float* out, int64_t n) {
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m512i widened =
+        _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)));
+    _mm512_storeu_ps(out + i, _mm512_castsi512_ps(_mm512_slli_epi32(widened, 16)));
+  }
+  return i;
+}
+#endif  // OF_WITH_AVX512F_DISPATCH
+
+// Bulk conversions used by the cast kernel and the bfloat16 gemm. On cpus with AVX512-BF16 the
+// narrowing conversion is one instruction per 16 values, it flushes denormals to zero unlike the
+// scalar path.
+inline void FloatToBFloat16(const float* in, bfloat16* out, int64_t n) {
+  int64_t i = 0;
+#ifdef OF_WITH_AVX512BF16_DISPATCH
+  if (CpuHasAvx512Bf16()) { i = FloatToBFloat16Avx512Bf16(in, out, n); }
+#endif
+  for (; i < n; ++i) { out[i] = bfloat16(in[i]); }
+}
+
+inline void BFloat16ToFloat(const bfloat16* in, float* out, int64_t n) {
+  int64_t i = 0;
+#ifdef OF_WITH_AVX512F_DISPATCH
+  if (CpuHasAvx512F()) { i = BFloat16ToFloatAvx512(in, out, n); }
+#endif
+  for (; i < n; ++i) { out[i] = static_cast<float>(in[i]); }
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_BFLOAT16_H_
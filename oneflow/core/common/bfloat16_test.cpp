@@ -0,0 +1,60 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/data_type.h"
+
+namespace oneflow {
+
+namespace test {
+
+TEST(BFloat16, round_to_nearest_even) {
+  ASSERT_EQ(bfloat16(1.f).x, 0x3f80);
+  ASSERT_EQ(bfloat16(-2.f).x, 0xc000);
+  // 1 + 2^-8 is halfway between 1 and 1 + 2^-7, ties go to the even mantissa
+  ASSERT_EQ(bfloat16(1.00390625f).x, 0x3f80);
+  ASSERT_EQ(bfloat16(1.01171875f).x, 0x3f82);
+  ASSERT_EQ(static_cast<float>(bfloat16(3.140625f)), 3.140625f);
+  ASSERT_TRUE(std::isnan(static_cast<float>(bfloat16(std::nanf("")))));
+  ASSERT_TRUE(std::isinf(static_cast<float>(bfloat16(std::numeric_limits<float>::infinity()))));
+}
+
+TEST(BFloat16, data_type) {
+  ASSERT_EQ(GetDataType<bfloat16>::value, DataType::kBFloat16);
+  ASSERT_EQ(GetSizeOfDataType(DataType::kBFloat16), 2);
+  ASSERT_EQ(static_cast<float>(GetZeroVal<bfloat16>()), 0.f);
+  ASSERT_EQ(static_cast<float>(GetOneVal<bfloat16>()), 1.f);
+  ASSERT_EQ(static_cast<float>(GetMaxVal<bfloat16>()), 3.38953139e38f);
+  ASSERT_EQ(static_cast<float>(GetMinVal<bfloat16>()), -3.38953139e38f);
+}
+
+TEST(BFloat16, bulk_conversion) {
+  const int64_t n = 1000;
+  std::vector<float> in(n);
+  FOR_RANGE(int64_t, i, 0, n) { in[i] = std::sin(static_cast<float>(i)) * (i + 1); }
+  std::vector<bfloat16> narrowed(n);
+  FloatToBFloat16(in.data(), narrowed.data(), n);
+  std::vector<float> widened(n);
+  BFloat16ToFloat(narrowed.data(), widened.data(), n);
+  FOR_RANGE(int64_t, i, 0, n) {
+    ASSERT_EQ(narrowed[i].x, bfloat16(in[i]).x);
+    ASSERT_EQ(widened[i], static_cast<float>(narrowed[i]));
+    ASSERT_NEAR(widened[i], in[i], std::abs(in[i]) / 128);
+  }
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -0,0 +1,63 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_CPU_ISA_H_
+#define ONEFLOW_CORE_COMMON_CPU_ISA_H_
+
+// oneflow is built for the baseline x86-64 instruction set. Code using AVX-512 is compiled per
+// function with OF_TARGET_ISA and called only after the matching CpuHas* check passed, so one
+// binary uses AVX-512 on the cpus having it and still runs on the others. Lambdas do not inherit
+// the target of the enclosing function, the intrinsics must stay in the attributed functions.
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define OF_TARGET_ISA(isa) __attribute__((target(isa)))
+#define OF_WITH_AVX512F_DISPATCH
+// avx512bf16 is known to both the target attribute and __builtin_cpu_supports since gcc 11 and
+// clang 12, avx512vnni is grouped with it to keep a single compiler requirement
+#if defined(__clang__) ? __clang_major__ >= 12 : __GNUC__ >= 11
+#define OF_WITH_AVX512BF16_DISPATCH
+#define OF_WITH_AVX512VNNI_DISPATCH
+#endif
+#endif
+
+namespace oneflow {
+
+#ifdef OF_WITH_AVX512F_DISPATCH
+inline bool CpuHasAvx512F() {
+  static const bool has = __builtin_cpu_supports("avx512f");
+  return has;
+}
+#endif  // OF_WITH_AVX512F_DISPATCH
+
+#ifdef OF_WITH_AVX512BF16_DISPATCH
+inline bool CpuHasAvx512Bf16() {
+  static const bool has =
+      __builtin_cpu_supports("avx512bf16") && __builtin_cpu_supports("avx512bw");
+  return has;
+}
+#endif  // OF_WITH_AVX512BF16_DISPATCH
+
+#ifdef OF_WITH_AVX512VNNI_DISPATCH
+inline bool CpuHasAvx512Vnni() {
+  static const bool has =
+      __builtin_cpu_supports("avx512vnni") && __builtin_cpu_supports("avx512bw");
+  return has;
+}
+#endif  // OF_WITH_AVX512VNNI_DISPATCH
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_CPU_ISA_H_
@@ -21,6 +21,7 @@ limitations under the License.
 #include <cuda_fp16.h>
 #endif
 #include "oneflow/core/common/fp16_data_type.h"
+#include "oneflow/core/common/bfloat16.h"
 #include "oneflow/core/common/data_type.pb.h"
 #include "oneflow/core/common/data_type_seq.h"
 #include "oneflow/core/record/record.pb.h"
@@ -71,7 +72,8 @@ struct GetDataType<void> : std::integral_constant<DataType, DataType::kChar> {};
   template<>                                                                      \
   struct GetDataType<type_cpp> : std::integral_constant<DataType, type_proto> {}; \
   inline type_cpp GetTypeByDataType(std::integral_constant<DataType, type_proto>) { return {}; }
-OF_PP_FOR_EACH_TUPLE(SPECIALIZE_GET_DATA_TYPE, ALL_DATA_TYPE_SEQ FLOAT16_DATA_TYPE_SEQ);
+OF_PP_FOR_EACH_TUPLE(SPECIALIZE_GET_DATA_TYPE,
+                     ALL_DATA_TYPE_SEQ FLOAT16_DATA_TYPE_SEQ BFLOAT16_DATA_TYPE_SEQ);
 #undef SPECIALIZE_GET_DATA_TYPE
 
 template<typename T>
@@ -157,6 +159,16 @@ OF_PP_FOR_EACH_TUPLE(SPECIALIZE_MAX_VAL, MAX_VAL_SEQ);
 OF_PP_FOR_EACH_TUPLE(SPECIALIZE_MIN_VAL, MIN_VAL_SEQ);
 #undef SPECIALIZE_MIN_VAL
 
+template<>
+OF_DEVICE_FUNC bfloat16 GetMaxVal<bfloat16>() {
+  return bfloat16::FromBits(0x7f7f);  // Binary: 0 11111110 1111111
+}
+
+template<>
+OF_DEVICE_FUNC bfloat16 GetMinVal<bfloat16>() {
+  return bfloat16::FromBits(0xff7f);  // Binary: 1 11111110 1111111
+}
+
 template<typename T>
 const T* GetZeroPtr() {
   static const T ret = GetZeroVal<T>();
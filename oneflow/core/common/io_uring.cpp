@@ -0,0 +1,156 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/io_uring.h"
+
+#ifdef OF_WITH_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // OF_WITH_IO_URING
+
+namespace oneflow {
+
+#ifdef OF_WITH_IO_URING
+
+namespace {
+
+int IoUringSetup(uint32_t entries, io_uring_params* params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(int fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags) {
+  return static_cast<int>(
+      syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+}  // namespace
+
+IoUring::IoUring()
+    : ring_fd_(-1), sq_ptr_(MAP_FAILED), cq_ptr_(MAP_FAILED), sqes_ptr_(MAP_FAILED) {}
+
+IoUring::~IoUring() {
+  if (sqes_ptr_ != MAP_FAILED) { munmap(sqes_ptr_, sqes_ptr_size_); }
+  if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) { munmap(cq_ptr_, cq_ptr_size_); }
+  if (sq_ptr_ != MAP_FAILED) { munmap(sq_ptr_, sq_ptr_size_); }
+  if (ring_fd_ >= 0) { close(ring_fd_); }
+}
+
+bool IoUring::Init(uint32_t entries) {
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  ring_fd_ = IoUringSetup(entries, &params);
+  if (ring_fd_ < 0) {
+    PLOG(WARNING) << "io_uring_setup failed";
+    return false;
+  }
+  sq_entries_ = params.sq_entries;
+  cq_entries_ = params.cq_entries;
+  sq_ptr_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  cq_ptr_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ptr_size_ = std::max(sq_ptr_size_, cq_ptr_size_);
+    cq_ptr_size_ = sq_ptr_size_;
+  }
+  sq_ptr_ = mmap(nullptr, sq_ptr_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                 ring_fd_, IORING_OFF_SQ_RING);
+  PCHECK(sq_ptr_ != MAP_FAILED);
+  if (single_mmap) {
+    cq_ptr_ = sq_ptr_;
+  } else {
+    cq_ptr_ = mmap(nullptr, cq_ptr_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   ring_fd_, IORING_OFF_CQ_RING);
+    PCHECK(cq_ptr_ != MAP_FAILED);
+  }
+  sqes_ptr_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  sqes_ptr_ = mmap(nullptr, sqes_ptr_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   ring_fd_, IORING_OFF_SQES);
+  PCHECK(sqes_ptr_ != MAP_FAILED);
+  char* sq_ptr = static_cast<char*>(sq_ptr_);
+  char* cq_ptr = static_cast<char*>(cq_ptr_);
+  sq_tail_ = reinterpret_cast<uint32_t*>(sq_ptr + params.sq_off.tail);
+  sq_ring_mask_ = reinterpret_cast<uint32_t*>(sq_ptr + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<uint32_t*>(sq_ptr + params.sq_off.array);
+  cq_head_ = reinterpret_cast<uint32_t*>(cq_ptr + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<uint32_t*>(cq_ptr + params.cq_off.tail);
+  cq_ring_mask_ = reinterpret_cast<uint32_t*>(cq_ptr + params.cq_off.ring_mask);
+  cqes_ = cq_ptr + params.cq_off.cqes;
+  return true;
+}
+
+void IoUring::PushSqe(const io_uring_sqe& sqe) {
+  const uint32_t tail = *sq_tail_;
+  const uint32_t index = tail & *sq_ring_mask_;
+  static_cast<io_uring_sqe*>(sqes_ptr_)[index] = sqe;
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+}
+
+void IoUring::EnterUntilSubmitted(uint32_t to_submit) {
+  while (to_submit > 0) {
+    const int ret = IoUringEnter(ring_fd_, to_submit, 0, 0);
+    if (ret >= 0) {
+      to_submit -= ret;
+    } else {
+      PCHECK(errno == EINTR || errno == EAGAIN || errno == EBUSY) << "io_uring_enter failed";
+    }
+  }
+}
+
+int IoUring::Enter(uint32_t to_submit, uint32_t min_complete) {
+  return IoUringEnter(ring_fd_, to_submit, min_complete, IORING_ENTER_GETEVENTS);
+}
+
+void IoUring::ReapCqes(std::vector<io_uring_cqe>* cqes) {
+  uint32_t head = *cq_head_;
+  const uint32_t tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+  for (; head != tail; ++head) {
+    cqes->push_back(static_cast<const io_uring_cqe*>(cqes_)[head & *cq_ring_mask_]);
+  }
+  __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+}
+
+int IoUring::Register(uint32_t opcode, const void* arg, uint32_t nr_args) {
+  return static_cast<int>(syscall(__NR_io_uring_register, ring_fd_, opcode, arg, nr_args));
+}
+
+#else
+
+IoUring::IoUring() : ring_fd_(-1) {}
+
+IoUring::~IoUring() = default;
+
+bool IoUring::Init(uint32_t entries) { return false; }
+
+void IoUring::PushSqe(const io_uring_sqe& sqe) { UNIMPLEMENTED(); }
+
+void IoUring::EnterUntilSubmitted(uint32_t to_submit) { UNIMPLEMENTED(); }
+
+int IoUring::Enter(uint32_t to_submit, uint32_t min_complete) {
+  UNIMPLEMENTED();
+  return -1;
+}
+
+void IoUring::ReapCqes(std::vector<io_uring_cqe>* cqes) { UNIMPLEMENTED(); }
+
+int IoUring::Register(uint32_t opcode, const void* arg, uint32_t nr_args) {
+  UNIMPLEMENTED();
+  return -1;
+}
+
+#endif  // OF_WITH_IO_URING
+
+}  // namespace oneflow
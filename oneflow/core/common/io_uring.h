@@ -0,0 +1,83 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_IO_URING_H_
+#define ONEFLOW_CORE_COMMON_IO_URING_H_
+
+#include "oneflow/core/common/util.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define OF_WITH_IO_URING
+#endif
+#endif
+
+#ifdef OF_WITH_IO_URING
+#include <linux/io_uring.h>
+#else
+struct io_uring_sqe;
+struct io_uring_cqe;
+#endif  // OF_WITH_IO_URING
+
+namespace oneflow {
+
+// The submission and completion queues of an io_uring mapped to this process, by raw syscalls so
+// that liburing is not needed. It does no locking, the callers serialize the submissions and the
+// reaping of completions respectively. Init() always fails if the headers of io_uring are missing.
+class IoUring final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(IoUring);
+  IoUring();
+  ~IoUring();
+
+  // Returns false if io_uring is not available, e.g. on old kernels or under seccomp.
+  bool Init(uint32_t entries);
+
+  // Copies sqe to the tail of the submission queue, which must not be full.
+  void PushSqe(const io_uring_sqe& sqe);
+  // Submits to_submit pushed sqes, retrying on EINTR, EAGAIN and EBUSY.
+  void EnterUntilSubmitted(uint32_t to_submit);
+  // Submits to_submit pushed sqes and blocks until there are at least min_complete cqes. Returns
+  // the result of io_uring_enter.
+  int Enter(uint32_t to_submit, uint32_t min_complete);
+  // Moves the available cqes to cqes and releases them to the kernel.
+  void ReapCqes(std::vector<io_uring_cqe>* cqes);
+  int Register(uint32_t opcode, const void* arg, uint32_t nr_args);
+
+  uint32_t sq_entries() const { return sq_entries_; }
+  uint32_t cq_entries() const { return cq_entries_; }
+
+ private:
+  int ring_fd_;
+  void* sq_ptr_;
+  size_t sq_ptr_size_;
+  void* cq_ptr_;
+  size_t cq_ptr_size_;
+  void* sqes_ptr_;
+  size_t sqes_ptr_size_;
+  uint32_t* sq_tail_;
+  uint32_t* sq_ring_mask_;
+  uint32_t* sq_array_;
+  uint32_t* cq_head_;
+  uint32_t* cq_tail_;
+  uint32_t* cq_ring_mask_;
+  void* cqes_;
+  uint32_t sq_entries_;
+  uint32_t cq_entries_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_IO_URING_H_
@@ -74,7 +74,9 @@ Maybe<void> EagerOneflow::RunPhysicalInstruction(
   for (const auto& eager_symbol : eager_symbol_list.eager_symbol()) {
     JUST(StorageAdd(eager_symbol));
   }
-  return vm::Run(instruction_list_proto);
+  // instructions run in the vm scheduler thread, callers sync through ClusterInstruction
+  JUST(vm::RunAsync(instruction_list_proto));
+  return Maybe<void>::Ok();
 }
 
 Maybe<void> EagerOneflow::RunPhysicalInstruction(
@@ -0,0 +1,108 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/eager/eager_oneflow.h"
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/control/ctrl_bootstrap.pb.h"
+#include "oneflow/core/control/global_process_ctx.h"
+#include "oneflow/core/job/cluster_instruction.pb.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/vm/host_stream_type.h"
+#include "oneflow/core/vm/instruction_type.h"
+#include "oneflow/core/vm/instruction.pb.h"
+#include "oneflow/core/vm/test_util.h"
+#include "oneflow/core/vm/virtual_machine_scope.h"
+#include "oneflow/core/vm/vm_util.h"
+
+namespace oneflow {
+namespace eager {
+namespace test {
+
+namespace {
+
+std::mutex blocking_mutex;
+std::condition_variable blocking_cond;
+bool blocking_released = false;
+bool blocking_computed = false;
+
+// blocks the host stream until the test releases it, the timeout keeps a synchronous submission
+// from hanging the test
+class TestBlockingInstructionType final : public vm::InstructionType {
+ public:
+  TestBlockingInstructionType() = default;
+  ~TestBlockingInstructionType() override = default;
+
+  using stream_type = vm::HostStreamType;
+
+  void Infer(vm::Instruction* instruction) const override { /* do nothing */
+  }
+  void Compute(vm::Instruction* instruction) const override {
+    std::unique_lock<std::mutex> lock(blocking_mutex);
+    blocking_cond.wait_for(lock, std::chrono::seconds(10), []() { return blocking_released; });
+    blocking_computed = blocking_released;
+  }
+};
+COMMAND(vm::RegisterInstructionType<TestBlockingInstructionType>("TestBlocking"));
+
+class TestVirtualMachineScope {
+ public:
+  TestVirtualMachineScope(int64_t gpu_device_num, int64_t cpu_device_num) {
+    Global<NumProcessPerNode>::New();
+    Global<NumProcessPerNode>::Get()->set_value(1);
+    Global<ProcessCtx>::New();
+    Global<ProcessCtx>::Get()->set_rank(0);
+    test_resource_desc_scope_.reset(new vm::TestResourceDescScope(gpu_device_num, cpu_device_num));
+    virtual_machine_scope_.reset(
+        new vm::VirtualMachineScope(Global<ResourceDesc, ForSession>::Get()->resource()));
+  }
+
+  ~TestVirtualMachineScope() {
+    virtual_machine_scope_.reset();
+    test_resource_desc_scope_.reset();
+    Global<ProcessCtx>::Delete();
+    Global<NumProcessPerNode>::Delete();
+  }
+
+ private:
+  std::unique_ptr<vm::TestResourceDescScope> test_resource_desc_scope_;
+  std::unique_ptr<vm::VirtualMachineScope> virtual_machine_scope_;
+};
+
+}  // namespace
+
+TEST(EagerOneflow, run_physical_instruction_returns_before_compute) {
+  TestVirtualMachineScope vm_scope(0, 1);
+  auto cluster_instruction = std::make_shared<ClusterInstructionProto>();
+  cluster_instruction->mutable_eager_instruction()
+      ->mutable_instruction_list()
+      ->add_instruction()
+      ->set_instr_type_name("TestBlocking");
+  CHECK_JUST(Global<EagerOneflow>::Get()->RunPhysicalInstruction(
+      std::const_pointer_cast<const ClusterInstructionProto>(cluster_instruction)));
+  {
+    std::unique_lock<std::mutex> lock(blocking_mutex);
+    ASSERT_FALSE(blocking_computed);
+    blocking_released = true;
+  }
+  blocking_cond.notify_all();
+  CHECK_JUST(vm::Sync());
+  std::unique_lock<std::mutex> lock(blocking_mutex);
+  ASSERT_TRUE(blocking_computed);
+}
+
+}  // namespace test
+}  // namespace eager
+}  // namespace oneflow
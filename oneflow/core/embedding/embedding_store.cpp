@@ -0,0 +1,272 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/embedding/embedding_store.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace oneflow {
+
+namespace {
+
+uint64_t SplitMix64(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+void PreadFully(int fd, char* buf, size_t size, off_t offset) {
+  while (size > 0) {
+    const ssize_t n = pread(fd, buf, size, offset);
+    PCHECK(n > 0);
+    buf += n;
+    size -= n;
+    offset += n;
+  }
+}
+
+void PwriteFully(int fd, const char* buf, size_t size, off_t offset) {
+  while (size > 0) {
+    const ssize_t n = pwrite(fd, buf, size, offset);
+    PCHECK(n > 0);
+    buf += n;
+    size -= n;
+    offset += n;
+  }
+}
+
+std::string WrittenBitsPath(const std::string& path) { return path + ".written"; }
+
+}  // namespace
+
+EmbeddingStore::EmbeddingStore(const EmbeddingStoreOptions& options)
+    : options_(options),
+      line_size_(options.embedding_dim + options.state_dim),
+      written_bits_(RoundUp(options.num_rows, 64) / 64, 0),
+      lines_(options.cache_capacity * line_size_),
+      slot2id_(options.cache_capacity, -1),
+      slot_is_dirty_(options.cache_capacity, false),
+      prev_slot_(options.cache_capacity, -1),
+      next_slot_(options.cache_capacity, -1),
+      head_slot_(-1),
+      tail_slot_(-1),
+      num_used_slots_(0) {
+  CHECK_GT(options_.num_rows, 0);
+  CHECK_GT(options_.embedding_dim, 0);
+  CHECK_GE(options_.state_dim, 0);
+  CHECK_GT(options_.cache_capacity, 0);
+  fd_ = open(options_.path.c_str(), O_RDWR | O_CREAT, 0644);
+  PCHECK(fd_ >= 0) << options_.path;
+  const off_t file_size = options_.num_rows * line_size_ * sizeof(float);
+  if (lseek(fd_, 0, SEEK_END) < file_size) { PCHECK(ftruncate(fd_, file_size) == 0); }
+  const int bits_fd = open(WrittenBitsPath(options_.path).c_str(), O_RDONLY);
+  if (bits_fd >= 0) {
+    const size_t bits_size = written_bits_.size() * sizeof(uint64_t);
+    if (lseek(bits_fd, 0, SEEK_END) == static_cast<off_t>(bits_size)) {
+      PreadFully(bits_fd, reinterpret_cast<char*>(written_bits_.data()), bits_size, 0);
+    } else {
+      LOG(WARNING) << "ignore " << WrittenBitsPath(options_.path) << " of unexpected size";
+    }
+    close(bits_fd);
+  }
+  write_back_thread_ = std::thread(&EmbeddingStore::PollWriteBack, this);
+  prefetch_thread_ = std::thread(&EmbeddingStore::PollPrefetch, this);
+}
+
+EmbeddingStore::~EmbeddingStore() {
+  prefetch_ids_.Close();
+  prefetch_thread_.join();
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (int64_t slot = 0; slot < num_used_slots_; ++slot) {
+      if (!slot_is_dirty_.at(slot)) { continue; }
+      WriteLine(slot2id_.at(slot), lines_.data() + slot * line_size_);
+      slot_is_dirty_.at(slot) = false;
+    }
+  }
+  write_back_ids_.Close();
+  write_back_thread_.join();
+  const int bits_fd = open(WrittenBitsPath(options_.path).c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+                           0644);
+  PCHECK(bits_fd >= 0);
+  PwriteFully(bits_fd, reinterpret_cast<const char*>(written_bits_.data()),
+              written_bits_.size() * sizeof(uint64_t), 0);
+  PCHECK(close(bits_fd) == 0);
+  PCHECK(close(fd_) == 0);
+}
+
+void EmbeddingStore::Prefetch(std::vector<int64_t>&& ids) {
+  CHECK_EQ(prefetch_ids_.Send(std::move(ids)), kChannelStatusSuccess);
+}
+
+void EmbeddingStore::Lookup(int64_t n, const int64_t* ids, float* embeddings) {
+  const int64_t dim = options_.embedding_dim;
+  std::unique_lock<std::mutex> lock(mutex_);
+  FOR_RANGE(int64_t, i, 0, n) {
+    const float* line = lines_.data() + GetOrLoadSlot(ids[i]) * line_size_;
+    std::copy(line, line + dim, embeddings + i * dim);
+  }
+}
+
+void EmbeddingStore::Update(
+    int64_t n, const int64_t* ids, const float* embedding_diff,
+    const std::function<void(float* line, const float* diff)>& UpdateLine) {
+  const int64_t dim = options_.embedding_dim;
+  HashMap<int64_t, int64_t> id2unique_index;
+  std::vector<int64_t> unique_ids;
+  std::vector<float> unique_diff;
+  FOR_RANGE(int64_t, i, 0, n) {
+    const auto it = id2unique_index.emplace(ids[i], unique_ids.size());
+    if (it.second) {
+      unique_ids.push_back(ids[i]);
+      unique_diff.insert(unique_diff.end(), embedding_diff + i * dim,
+                         embedding_diff + (i + 1) * dim);
+    } else {
+      float* sum = unique_diff.data() + it.first->second * dim;
+      FOR_RANGE(int64_t, j, 0, dim) { sum[j] += embedding_diff[i * dim + j]; }
+    }
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  FOR_RANGE(int64_t, i, 0, unique_ids.size()) {
+    const int64_t slot = GetOrLoadSlot(unique_ids.at(i));
+    UpdateLine(lines_.data() + slot * line_size_, unique_diff.data() + i * dim);
+    slot_is_dirty_.at(slot) = true;
+  }
+}
+
+int64_t EmbeddingStore::GetOrLoadSlot(int64_t id) {
+  CHECK_GE(id, 0);
+  CHECK_LT(id, options_.num_rows);
+  const auto it = id2slot_.find(id);
+  if (it != id2slot_.end()) {
+    MoveToFront(it->second);
+    return it->second;
+  }
+  const int64_t slot = AllocateSlot();
+  LoadLine(id, lines_.data() + slot * line_size_);
+  slot2id_.at(slot) = id;
+  slot_is_dirty_.at(slot) = false;
+  id2slot_.emplace(id, slot);
+  MoveToFront(slot);
+  return slot;
+}
+
+int64_t EmbeddingStore::AllocateSlot() {
+  if (num_used_slots_ < options_.cache_capacity) { return num_used_slots_++; }
+  const int64_t slot = tail_slot_;
+  const int64_t id = slot2id_.at(slot);
+  Unlink(slot);
+  id2slot_.erase(id);
+  if (slot_is_dirty_.at(slot)) { WriteLine(id, lines_.data() + slot * line_size_); }
+  return slot;
+}
+
+void EmbeddingStore::LoadLine(int64_t id, float* line) const {
+  const auto it = id2write_back_line_.find(id);
+  if (it != id2write_back_line_.end()) {
+    std::copy(it->second->begin(), it->second->end(), line);
+  } else if (IsWritten(id)) {
+    PreadFully(fd_, reinterpret_cast<char*>(line), line_size_ * sizeof(float),
+               id * line_size_ * sizeof(float));
+  } else {
+    const float range = options_.initializer_range;
+    FOR_RANGE(int64_t, j, 0, options_.embedding_dim) {
+      const uint64_t bits = SplitMix64(options_.seed ^ SplitMix64(id * line_size_ + j));
+      const float uniform = (bits >> 40) * (1.0f / (1 << 24));
+      line[j] = (2 * uniform - 1) * range;
+    }
+    std::fill(line + options_.embedding_dim, line + line_size_, 0.0f);
+  }
+}
+
+void EmbeddingStore::WriteLine(int64_t id, const float* line) {
+  id2write_back_line_[id].reset(new std::vector<float>(line, line + line_size_));
+  SetWritten(id);
+  CHECK_EQ(write_back_ids_.Send(id), kChannelStatusSuccess);
+}
+
+void EmbeddingStore::MoveToFront(int64_t slot) {
+  if (slot == head_slot_) { return; }
+  Unlink(slot);
+  next_slot_.at(slot) = head_slot_;
+  if (head_slot_ != -1) { prev_slot_.at(head_slot_) = slot; }
+  head_slot_ = slot;
+  if (tail_slot_ == -1) { tail_slot_ = slot; }
+}
+
+void EmbeddingStore::Unlink(int64_t slot) {
+  const int64_t prev = prev_slot_.at(slot);
+  const int64_t next = next_slot_.at(slot);
+  if (prev != -1) { next_slot_.at(prev) = next; }
+  if (next != -1) { prev_slot_.at(next) = prev; }
+  if (head_slot_ == slot) { head_slot_ = next; }
+  if (tail_slot_ == slot) { tail_slot_ = prev; }
+  prev_slot_.at(slot) = -1;
+  next_slot_.at(slot) = -1;
+}
+
+void EmbeddingStore::PollWriteBack() {
+  int64_t id = -1;
+  while (write_back_ids_.Receive(&id) == kChannelStatusSuccess) {
+    std::shared_ptr<std::vector<float>> line;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      const auto it = id2write_back_line_.find(id);
+      // already written along with an earlier request of the same row
+      if (it == id2write_back_line_.end()) { continue; }
+      line = it->second;
+    }
+    PwriteFully(fd_, reinterpret_cast<const char*>(line->data()), line_size_ * sizeof(float),
+                id * line_size_ * sizeof(float));
+    std::unique_lock<std::mutex> lock(mutex_);
+    const auto it = id2write_back_line_.find(id);
+    // the row may have been evicted again while being written
+    if (it != id2write_back_line_.end() && it->second == line) { id2write_back_line_.erase(it); }
+  }
+}
+
+void EmbeddingStore::PollPrefetch() {
+  std::vector<int64_t> ids;
+  while (prefetch_ids_.Receive(&ids) == kChannelStatusSuccess) {
+    for (const int64_t id : ids) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (id >= 0 && id < options_.num_rows) { GetOrLoadSlot(id); }
+    }
+  }
+}
+
+EmbeddingStoreMgr* EmbeddingStoreMgr::Get() {
+  static EmbeddingStoreMgr mgr;
+  return &mgr;
+}
+
+std::shared_ptr<EmbeddingStore> EmbeddingStoreMgr::GetOrCreate(
+    const EmbeddingStoreOptions& options) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  std::shared_ptr<EmbeddingStore> store = path2store_[options.path].lock();
+  if (store) {
+    const EmbeddingStoreOptions& existing = store->options();
+    CHECK_EQ(existing.num_rows, options.num_rows) << options.path;
+    CHECK_EQ(existing.embedding_dim, options.embedding_dim) << options.path;
+    CHECK_EQ(existing.state_dim, options.state_dim) << options.path;
+  } else {
+    store.reset(new EmbeddingStore(options));
+    path2store_[options.path] = store;
+  }
+  return store;
+}
+
+}  // namespace oneflow
@@ -0,0 +1,113 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EMBEDDING_EMBEDDING_STORE_H_
+#define ONEFLOW_CORE_EMBEDDING_EMBEDDING_STORE_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/channel.h"
+
+namespace oneflow {
+
+struct EmbeddingStoreOptions {
+  std::string path;
+  int64_t num_rows;
+  int64_t embedding_dim;
+  // optimizer states kept after the embedding of every row, e.g. 2 * embedding_dim for adam
+  int64_t state_dim;
+  // number of rows cached in memory
+  int64_t cache_capacity;
+  // rows never written are initialized uniformly in [-initializer_range, initializer_range]
+  float initializer_range;
+  int64_t seed;
+};
+
+// The rows of an embedding table too large for memory, stored in the file at path and read by
+// row id. The recently used rows are cached in memory and evicted in LRU order, dirty rows being
+// written back by a background thread. Rows can be loaded ahead of their use by Prefetch, which
+// runs on another background thread.
+class EmbeddingStore final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(EmbeddingStore);
+  explicit EmbeddingStore(const EmbeddingStoreOptions& options);
+  ~EmbeddingStore();
+
+  const EmbeddingStoreOptions& options() const { return options_; }
+  int64_t line_size() const { return line_size_; }
+
+  void Prefetch(std::vector<int64_t>&& ids);
+  // Copies the embeddings of ids into embeddings, n x embedding_dim.
+  void Lookup(int64_t n, const int64_t* ids, float* embeddings);
+  // Calls UpdateLine once for every unique id with its line and the sum of its gradients.
+  void Update(int64_t n, const int64_t* ids, const float* embedding_diff,
+              const std::function<void(float* line, const float* diff)>& UpdateLine);
+
+ private:
+  // Returns the cache slot of id, loading the row if it is not cached. Needs mutex_ held.
+  int64_t GetOrLoadSlot(int64_t id);
+  int64_t AllocateSlot();
+  void LoadLine(int64_t id, float* line) const;
+  // Queues line to be written back to the file. Needs mutex_ held.
+  void WriteLine(int64_t id, const float* line);
+  void MoveToFront(int64_t slot);
+  void Unlink(int64_t slot);
+  bool IsWritten(int64_t id) const { return (written_bits_.at(id / 64) >> (id % 64)) & 1; }
+  void SetWritten(int64_t id) { written_bits_.at(id / 64) |= (uint64_t{1} << (id % 64)); }
+  void PollWriteBack();
+  void PollPrefetch();
+
+  const EmbeddingStoreOptions options_;
+  const int64_t line_size_;
+  int fd_;
+  std::mutex mutex_;
+  // whether a row has ever been written to the file, saved next to it
+  std::vector<uint64_t> written_bits_;
+  std::vector<float> lines_;
+  std::vector<int64_t> slot2id_;
+  std::vector<bool> slot_is_dirty_;
+  HashMap<int64_t, int64_t> id2slot_;
+  // LRU list of the used slots, from the most recently used one
+  std::vector<int64_t> prev_slot_;
+  std::vector<int64_t> next_slot_;
+  int64_t head_slot_;
+  int64_t tail_slot_;
+  int64_t num_used_slots_;
+  // evicted rows not written yet
+  HashMap<int64_t, std::shared_ptr<std::vector<float>>> id2write_back_line_;
+  Channel<int64_t> write_back_ids_;
+  Channel<std::vector<int64_t>> prefetch_ids_;
+  std::thread write_back_thread_;
+  std::thread prefetch_thread_;
+};
+
+// Stores are shared by the ops accessing the same file in one process.
+class EmbeddingStoreMgr final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(EmbeddingStoreMgr);
+  ~EmbeddingStoreMgr() = default;
+
+  static EmbeddingStoreMgr* Get();
+  std::shared_ptr<EmbeddingStore> GetOrCreate(const EmbeddingStoreOptions& options);
+
+ private:
+  EmbeddingStoreMgr() = default;
+
+  std::mutex mutex_;
+  HashMap<std::string, std::weak_ptr<EmbeddingStore>> path2store_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EMBEDDING_EMBEDDING_STORE_H_
@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "half.hpp"
 #include "oneflow/core/common/util.h"
+#include "oneflow/core/common/bfloat16.h"
 #include "oneflow/core/common/switch_func.h"
 #include "oneflow/core/common/data_type_seq.h"
 #include "oneflow/core/framework/dtype.h"
@@ -31,7 +32,8 @@ std::size_t GetDataTypeBytes() {
 
 #define MAKE_DATA_TYPE_BYTES_SWITCH_ENTRY(func_name, T) func_name<T>
 DEFINE_STATIC_SWITCH_FUNC(std::size_t, GetDataTypeBytes, MAKE_DATA_TYPE_BYTES_SWITCH_ENTRY,
-                          MAKE_DATA_TYPE_CTRV_SEQ(POD_DATA_TYPE_SEQ FLOAT16_DATA_TYPE_SEQ));
+                          MAKE_DATA_TYPE_CTRV_SEQ(POD_DATA_TYPE_SEQ FLOAT16_DATA_TYPE_SEQ
+                                                  BFLOAT16_DATA_TYPE_SEQ));
 
 }  // namespace
 
@@ -78,6 +80,12 @@ Maybe<DType> DType::Float16() {
   return float16_dtype;
 }
 
+Maybe<DType> DType::BFloat16() {
+  static std::shared_ptr<DType> bfloat16_dtype =
+      std::make_shared<DType>(DataType::kBFloat16, "oneflow.bfloat16", true, true, false);
+  return bfloat16_dtype;
+}
+
 Maybe<DType> DType::Float() {
   static std::shared_ptr<DType> float_dtype =
       std::make_shared<DType>(DataType::kFloat, "oneflow.float32", true, true, false);
@@ -0,0 +1,285 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/graph/boxing/hierarchical_sub_task_graph_builder.h"
+#include "oneflow/core/graph/boxing/sub_task_graph_builder_util.h"
+#include "oneflow/core/graph/slice_boxing_task_node.h"
+#include "oneflow/core/register/tensor_slice_view.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/common/id_util.h"
+#include "oneflow/core/graph/id_serialization.h"
+#ifdef WITH_CUDA
+#include "oneflow/core/device/cuda_stream_index.h"
+#endif
+
+namespace oneflow {
+
+namespace {
+
+// The parallel ids of every machine, empty if those of some machine are not consecutive.
+std::vector<std::vector<int64_t>> GroupParallelIdsByMachine(const ParallelDesc& pd) {
+  std::vector<std::vector<int64_t>> groups;
+  int64_t last_machine_id = -1;
+  HashSet<int64_t> machine_ids;
+  FOR_RANGE(int64_t, parallel_id, 0, pd.parallel_num()) {
+    const int64_t machine_id = CHECK_JUST(pd.MachineId4ParallelId(parallel_id));
+    if (machine_id != last_machine_id) {
+      if (!machine_ids.insert(machine_id).second) { return {}; }
+      groups.emplace_back();
+      last_machine_id = machine_id;
+    }
+    groups.back().push_back(parallel_id);
+  }
+  return groups;
+}
+
+int64_t GetBoxingThrdId(const ParallelDesc& pd, int64_t parallel_id, bool is_copy_d2h) {
+  const int64_t machine_id = CHECK_JUST(pd.MachineId4ParallelId(parallel_id));
+  if (pd.device_type() == DeviceType::kCPU) {
+    return Global<IDMgr>::Get()->PickCpuThrdIdEvenly(machine_id);
+  } else if (pd.device_type() == DeviceType::kGPU) {
+#ifdef WITH_CUDA
+    DeviceId device_id{static_cast<DeviceId::rank_t>(machine_id), DeviceType::kGPU,
+                       static_cast<DeviceId::device_index_t>(
+                           CHECK_JUST(pd.DeviceId4ParallelId(parallel_id)))};
+    auto* generator = dynamic_cast<CudaStreamIndexGenerator*>(
+        Global<IDMgr>::Get()->GetStreamIndexGeneratorManager()->GetGenerator(device_id));
+    CHECK_NOTNULL(generator);
+    const StreamId::stream_index_t stream_index = is_copy_d2h
+                                                      ? generator->GenerateD2HStreamIndex()
+                                                      : generator->GenerateH2DStreamIndex();
+    return SerializeStreamIdToInt64(StreamId{device_id, stream_index});
+#else
+    UNIMPLEMENTED();
+#endif
+  } else {
+    UNIMPLEMENTED();
+  }
+  return -1;
+}
+
+class HierarchicalBoxingBuilder final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(HierarchicalBoxingBuilder);
+  HierarchicalBoxingBuilder(SubTskGphBuilderCtx* ctx, const ParallelDesc& pd,
+                            const std::vector<std::vector<int64_t>>& groups,
+                            const LogicalBlobId& lbi)
+      : ctx_(ctx), pd_(pd), groups_(groups), lbi_(lbi) {}
+  ~HierarchicalBoxingBuilder() = default;
+
+  int64_t MachineId4Group(int64_t group) const {
+    return CHECK_JUST(pd_.MachineId4ParallelId(groups_.at(group).front()));
+  }
+
+  // A node on the host of machine group, reading the blobs of its devices.
+  SliceBoxingTaskNode* NewLocalNode(int64_t group, const TensorSliceView& slice,
+                                    SliceBoxingTaskMode mode, int64_t index) {
+    const std::vector<int64_t>& parallel_ids = groups_.at(group);
+    auto* node = ctx_->task_graph()->NewNode<SliceBoxingTaskNode>();
+    node->Init(lbi_, slice, mode, MachineId4Group(group),
+               GetBoxingThrdId(pd_, parallel_ids.at(index % parallel_ids.size()), true),
+               Global<IDMgr>::Get()->CpuMemZoneId());
+    return node;
+  }
+
+  // A node on the host of machine group, reading host blobs only.
+  SliceBoxingTaskNode* NewHostNode(int64_t group, const TensorSliceView& slice,
+                                   SliceBoxingTaskMode mode) {
+    const int64_t machine_id = MachineId4Group(group);
+    auto* node = ctx_->task_graph()->NewNode<SliceBoxingTaskNode>();
+    node->Init(lbi_, slice, mode, machine_id,
+               Global<IDMgr>::Get()->PickCpuThrdIdEvenly(machine_id),
+               Global<IDMgr>::Get()->CpuMemZoneId());
+    return node;
+  }
+
+  TaskNode* ProxyOnHostOf(TaskNode* host_node, int64_t group) {
+    const int64_t cpu_mem_zone_id = Global<IDMgr>::Get()->CpuMemZoneId();
+    return ctx_->GetProxyNode(host_node, cpu_mem_zone_id, MachineId4Group(group),
+                              cpu_mem_zone_id);
+  }
+
+  // Reduces the partial blobs of in_nodes by machine first, then sends every machine the sum of
+  // its shard from the others. Returns the summed shard on the host of every machine.
+  std::vector<TaskNode*> ReduceScatter(const std::vector<TaskNode*>& in_nodes,
+                                       const TensorSliceView& in_slice,
+                                       const std::vector<TensorSliceView>& shards) {
+    std::vector<TaskNode*> shard_nodes;
+    FOR_RANGE(int64_t, n, 0, groups_.size()) {
+      SliceBoxingTaskNode* sum_node = NewHostNode(n, shards.at(n), kSliceBoxingTaskModeAdd);
+      FOR_RANGE(int64_t, m, 0, groups_.size()) {
+        SliceBoxingTaskNode* local_sum_node =
+            NewLocalNode(m, shards.at(n), kSliceBoxingTaskModeAdd, n);
+        for (const int64_t in_id : groups_.at(m)) {
+          local_sum_node->ConnectToSrcNodeWithSlice(in_nodes.at(in_id), NewEdge(), in_slice);
+        }
+        sum_node->ConnectToSrcNodeWithSlice(ProxyOnHostOf(local_sum_node, n), NewEdge(),
+                                            shards.at(n));
+      }
+      shard_nodes.push_back(sum_node);
+    }
+    return shard_nodes;
+  }
+
+  // Concatenates the shards on the host of every machine and hands the whole blob to its devices.
+  void AllGather(const std::vector<TaskNode*>& shard_nodes,
+                 const std::vector<TensorSliceView>& shards, const TensorSliceView& out_slice,
+                 const Shape* out_shape, std::vector<TaskNode*>* out_nodes) {
+    out_nodes->resize(pd_.parallel_num());
+    FOR_RANGE(int64_t, n, 0, groups_.size()) {
+      SliceBoxingTaskNode* whole_node = NewHostNode(n, out_slice, kSliceBoxingTaskModeCopy);
+      if (out_shape != nullptr) { whole_node->SetOutShape(*out_shape); }
+      FOR_RANGE(int64_t, m, 0, groups_.size()) {
+        whole_node->ConnectToSrcNodeWithSlice(ProxyOnHostOf(shard_nodes.at(m), n), NewEdge(),
+                                              shards.at(m));
+      }
+      for (const int64_t out_id : groups_.at(n)) {
+        int64_t mem_zone_id = Global<IDMgr>::Get()->CpuMemZoneId();
+        if (pd_.device_type() == DeviceType::kGPU) {
+          mem_zone_id =
+              Global<IDMgr>::Get()->GpuMemZoneId(CHECK_JUST(pd_.DeviceId4ParallelId(out_id)));
+        }
+        out_nodes->at(out_id) =
+            ctx_->GetProxyNode(whole_node, Global<IDMgr>::Get()->CpuMemZoneId(),
+                               MachineId4Group(n), mem_zone_id);
+      }
+    }
+  }
+
+  // Gathers the split blobs of in_nodes by machine. Returns the shard on the host of every machine.
+  std::vector<TaskNode*> GatherByMachine(const std::vector<TaskNode*>& in_nodes,
+                                         const std::vector<TensorSliceView>& in_slices,
+                                         const std::vector<TensorSliceView>& shards) {
+    std::vector<TaskNode*> shard_nodes;
+    FOR_RANGE(int64_t, m, 0, groups_.size()) {
+      SliceBoxingTaskNode* gather_node = NewLocalNode(m, shards.at(m), kSliceBoxingTaskModeCopy, 0);
+      for (const int64_t in_id : groups_.at(m)) {
+        gather_node->ConnectToSrcNodeWithSlice(in_nodes.at(in_id), NewEdge(), in_slices.at(in_id));
+      }
+      shard_nodes.push_back(gather_node);
+    }
+    return shard_nodes;
+  }
+
+  // Copies the slices of the devices out of the shard of their machine.
+  void ScatterByMachine(const std::vector<TaskNode*>& shard_nodes,
+                        const std::vector<TensorSliceView>& shards,
+                        const std::vector<TensorSliceView>& out_slices,
+                        std::vector<TaskNode*>* out_nodes) {
+    out_nodes->resize(pd_.parallel_num());
+    FOR_RANGE(int64_t, n, 0, groups_.size()) {
+      for (const int64_t out_id : groups_.at(n)) {
+        auto* node = ctx_->task_graph()->NewNode<SliceBoxingTaskNode>();
+        node->Init(lbi_, out_slices.at(out_id), kSliceBoxingTaskModeCopy, MachineId4Group(n),
+                   GetBoxingThrdId(pd_, out_id, false));
+        node->ConnectToSrcNodeWithSlice(shard_nodes.at(n), NewEdge(), shards.at(n));
+        out_nodes->at(out_id) = node;
+      }
+    }
+  }
+
+  // The union of the slices of the devices on every machine.
+  std::vector<TensorSliceView> MachineShards(const std::vector<TensorSliceView>& slices,
+                                             int64_t axis) const {
+    std::vector<TensorSliceView> shards;
+    for (const std::vector<int64_t>& parallel_ids : groups_) {
+      std::vector<TensorSliceView> machine_slices;
+      for (const int64_t parallel_id : parallel_ids) {
+        machine_slices.push_back(slices.at(parallel_id));
+      }
+      shards.push_back(TensorSliceView::Concatenate(machine_slices, axis));
+    }
+    return shards;
+  }
+
+ private:
+  TaskEdge* NewEdge() { return ctx_->task_graph()->NewEdge(); }
+
+  SubTskGphBuilderCtx* ctx_;
+  const ParallelDesc& pd_;
+  const std::vector<std::vector<int64_t>>& groups_;
+  const LogicalBlobId& lbi_;
+};
+
+}  // namespace
+
+Maybe<SubTskGphBuilderStatus> HierarchicalSubTskGphBuilder::Build(
+    SubTskGphBuilderCtx* ctx, const std::vector<TaskNode*>& sorted_in_tasks,
+    std::vector<TaskNode*>* sorted_out_tasks,
+    std::vector<std::vector<TaskNode*>>* sorted_ctrl_tasks, const ParallelDesc& in_parallel_desc,
+    const ParallelDesc& out_parallel_desc, const LogicalBlobId& lbi,
+    const BlobDesc& logical_blob_desc, const SbpParallel& in_sbp_parallel,
+    const SbpParallel& out_sbp_parallel, const Shape& time_shape) const {
+  if (in_parallel_desc != out_parallel_desc) { return Error::BoxingNotSupportedError(); }
+  if (!SubTskGphBuilderUtil::IsDeviceTypeCPUOrGPU(in_parallel_desc)) {
+    return Error::BoxingNotSupportedError();
+  }
+  if (SubTskGphBuilderUtil::BlobHasDynamicShape(logical_blob_desc)) {
+    return Error::BoxingNotSupportedError();
+  }
+  if (!(SubTskGphBuilderUtil::IsBoxingS2B(in_sbp_parallel, out_sbp_parallel)
+        || SubTskGphBuilderUtil::IsBoxingP2S(in_sbp_parallel, out_sbp_parallel)
+        || SubTskGphBuilderUtil::IsBoxingP2B(in_sbp_parallel, out_sbp_parallel))) {
+    return Error::BoxingNotSupportedError();
+  }
+  const int64_t parallel_num = in_parallel_desc.parallel_num();
+  if (SubTskGphBuilderUtil::HasEmptySliceIfSplit(parallel_num, in_sbp_parallel, logical_blob_desc)
+      || SubTskGphBuilderUtil::HasEmptySliceIfSplit(parallel_num, out_sbp_parallel,
+                                                    logical_blob_desc)) {
+    return Error::BoxingNotSupportedError();
+  }
+  const std::vector<std::vector<int64_t>> groups = GroupParallelIdsByMachine(in_parallel_desc);
+  // nothing to reduce or gather within a machine, or no network between them
+  if (groups.size() <= 1 || static_cast<int64_t>(groups.size()) == parallel_num) {
+    return Error::BoxingNotSupportedError();
+  }
+  HierarchicalBoxingBuilder builder(ctx, in_parallel_desc, groups, lbi);
+  const TensorSliceView whole_slice =
+      SubTskGphBuilderUtil::GetBroadcastTensorSliceView(logical_blob_desc);
+  std::string comment;
+  if (SubTskGphBuilderUtil::IsBoxingS2B(in_sbp_parallel, out_sbp_parallel)) {
+    const std::vector<TensorSliceView> in_slices =
+        SubTskGphBuilderUtil::GetTensorSliceView(parallel_num, in_sbp_parallel, logical_blob_desc);
+    const std::vector<TensorSliceView> shards =
+        builder.MachineShards(in_slices, in_sbp_parallel.split_parallel().axis());
+    builder.AllGather(builder.GatherByMachine(sorted_in_tasks, in_slices, shards), shards,
+                      whole_slice, nullptr, sorted_out_tasks);
+    comment = "S2B";
+  } else if (SubTskGphBuilderUtil::IsBoxingP2S(in_sbp_parallel, out_sbp_parallel)) {
+    const std::vector<TensorSliceView> out_slices =
+        SubTskGphBuilderUtil::GetTensorSliceView(parallel_num, out_sbp_parallel, logical_blob_desc);
+    const std::vector<TensorSliceView> shards =
+        builder.MachineShards(out_slices, out_sbp_parallel.split_parallel().axis());
+    builder.ScatterByMachine(builder.ReduceScatter(sorted_in_tasks, whole_slice, shards), shards,
+                             out_slices, sorted_out_tasks);
+    comment = "P2S";
+  } else {
+    // the blob is flattened to be split evenly among the machines
+    const int64_t elem_cnt = logical_blob_desc.shape().elem_cnt();
+    if (elem_cnt < static_cast<int64_t>(groups.size())) { return Error::BoxingNotSupportedError(); }
+    const BalancedSplitter bs(elem_cnt, groups.size());
+    std::vector<TensorSliceView> shards;
+    FOR_RANGE(int64_t, n, 0, groups.size()) {
+      shards.push_back(TensorSliceView({Range(bs.At(n).begin(), bs.At(n).end())}));
+    }
+    const TensorSliceView flat_slice({Range(0, elem_cnt)});
+    builder.AllGather(builder.ReduceScatter(sorted_in_tasks, flat_slice, shards), shards,
+                      flat_slice, &logical_blob_desc.shape(), sorted_out_tasks);
+    comment = "P2B";
+  }
+  return TRY(BuildSubTskGphBuilderStatus("HierarchicalSubTskGphBuilder", comment));
+}
+
+}  // namespace oneflow
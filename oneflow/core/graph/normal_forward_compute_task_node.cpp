@@ -19,6 +19,9 @@ limitations under the License.
 #include "oneflow/core/graph/task_graph.h"
 #include "oneflow/core/graph/logical_node.h"
 #include "oneflow/core/operator/variable_op.h"
+#include "oneflow/core/job/scope.h"
+#include "oneflow/core/vm/symbol_storage.h"
+#include "oneflow/core/job_rewriter/calculation_pass.h"
 
 namespace oneflow {
 
@@ -34,6 +37,17 @@ size_t RegstNum4OpSameOutputBlob(OperatorConf::OpTypeCase op_type_case) {
   }
 }
 
+// The forward ops of a pipeline stage hold the activations of as many iterations as there are
+// stages from it to the last one, see AutoPipelinePass.
+int32_t MinRegstNum4PipelineStage(const Operator& op) {
+  if (!op.op_conf().has_scope_symbol_id()) { return 1; }
+  const auto& scope_storage = *Global<symbol::Storage<Scope>>::Get();
+  if (!scope_storage.Has(op.op_conf().scope_symbol_id())) { return 1; }
+  const Scope& scope = scope_storage.Get(op.op_conf().scope_symbol_id());
+  if (scope.scope_proto().calculation_pass_name() != kForwardPass) { return 1; }
+  return std::max<int64_t>(scope.Int64("ssp_stage_regst_num"), 1);
+}
+
 std::string GetOutRegstNameByObn(const std::string& obn) {
   return "NormalForwardCompTaskNodeOutRegstName_" + obn;
 }
@@ -105,6 +119,12 @@ void NormalForwardCompTaskNode::ProduceAllRegstsAndBindEdges() {
     ProduceOutRegstByNameAndBlockNum("out", mem_block_num);
     ForEachOutDataEdge([&](TaskEdge* edge) { BindEdgeWithProducedRegst(edge, "out"); });
   }
+  if (mem_block_num == -1) {
+    const int32_t min_regst_num = MinRegstNum4PipelineStage(op);
+    for (const auto& pair : produced_regsts()) {
+      pair.second->UpdtMinRegstNumIfNeed(min_regst_num);
+    }
+  }
   ProduceRegst("tmp", true);
 }
 
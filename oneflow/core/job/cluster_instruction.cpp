@@ -20,6 +20,7 @@ limitations under the License.
 #include "oneflow/core/control/ctrl_client.h"
 #include "oneflow/core/control/global_process_ctx.h"
 #include "oneflow/core/job/env_desc.h"
+#include "oneflow/core/vm/vm_util.h"
 
 namespace oneflow {
 
@@ -141,7 +142,7 @@ void ClusterInstruction::WorkerReceiveInstruction(ClusterInstructionProto* clust
 void ClusterInstruction::HaltBarrier() { OF_ENV_BARRIER(); }
 
 void ClusterInstruction::EagerSyncBarrier() {
-  // TODO(jianhao): update here after eager instructions are run asynchronously
+  CHECK_JUST(vm::Sync());
   OF_ENV_BARRIER();
 }
 
@@ -42,6 +42,8 @@ limitations under the License.
 #include "oneflow/core/graph/plan_task_graph.h"
 #include "oneflow/core/graph/boxing/collective_boxing_util.h"
 #include "oneflow/core/profiler/profiler.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include <lz4.h>
 
 namespace std {
 
@@ -79,24 +81,12 @@ struct ReentrantLockBackEdge {
   LogicalBlobId critical_section_sink_lbi;  // back edge source.
 };
 
-std::string cluster_thrd_ids_key(const std::string& plan_name) {
-  return plan_name + "_cluster_thrd_ids";
+std::string machine_sub_plan_key(const std::string& plan_name, int64_t machine_id) {
+  return plan_name + "_" + std::to_string(machine_id) + "_machine_sub_plan";
 }
 
-std::string net_topo_key(const std::string& plan_name) { return plan_name + "_net_topo"; }
-
-std::string job_id2job_conf(const std::string& plan_name) { return plan_name + "_job_id2job_conf"; }
-
-std::string GetCollectiveBoxingPlanKey(const std::string& plan_name) {
-  return plan_name + "_collective_boxing_plan";
-}
-
-std::string sub_plan_key(const std::string& plan_name, int64_t machine_id, int64_t thrd_id) {
-  return plan_name + "_" + std::to_string(machine_id) + "_" + std::to_string(thrd_id);
-}
-
-std::string block7chunk_key(const std::string& plan_name, int64_t machine_id) {
-  return plan_name + "_" + std::to_string(machine_id) + "_block7chunk";
+std::string shared_sub_plan_key(const std::string& plan_name, int64_t relay_machine_id) {
+  return plan_name + "_" + std::to_string(relay_machine_id) + "_shared_sub_plan";
 }
 
 std::shared_ptr<OperatorConf> CreateSinkTickOpConf(const std::string& in_op_name) {
@@ -108,76 +98,126 @@ std::shared_ptr<OperatorConf> CreateSinkTickOpConf(const std::string& in_op_name
   return tick_op;
 }
 
-void PushPlan(const std::string& plan_name, const Plan& plan) {
-  HashMap<int64_t, std::set<int64_t>> machine_id2thrd_id_set;
-  HashMap<std::pair<int64_t, int64_t>, std::vector<TaskProto>> mchn_thrd_id2task_protos;
-  HashMap<int64_t, MemBlockAndChunkList> machine_id2block7chunk;
+// compressed value layout: | uint64 raw size | lz4 block |
+void CompressPbMessage(const PbMessage& msg, std::string* compressed) {
+  std::string serialized;
+  CHECK(msg.SerializeToString(&serialized));
+  CHECK_LE(serialized.size(), LZ4_MAX_INPUT_SIZE);
+  const uint64_t raw_size = serialized.size();
+  const int bound = LZ4_compressBound(serialized.size());
+  compressed->resize(sizeof(raw_size) + bound);
+  std::memcpy(&compressed->at(0), &raw_size, sizeof(raw_size));
+  const int compressed_size =
+      LZ4_compress_default(serialized.data(), &compressed->at(sizeof(raw_size)),
+                           static_cast<int>(serialized.size()), bound);
+  CHECK_GT(compressed_size, 0);
+  compressed->resize(sizeof(raw_size) + compressed_size);
+}
 
-  for (const auto& task : plan.task()) {
-    machine_id2thrd_id_set[task.machine_id()].insert(task.thrd_id());
-    mchn_thrd_id2task_protos[std::make_pair(task.machine_id(), task.thrd_id())].emplace_back(task);
-  }
+void DecompressPbMessage(const std::string& compressed, PbMessage* msg) {
+  uint64_t raw_size = 0;
+  CHECK_GE(compressed.size(), sizeof(raw_size));
+  std::memcpy(&raw_size, compressed.data(), sizeof(raw_size));
+  std::string serialized(raw_size, '\0');
+  const int decompressed_size = LZ4_decompress_safe(
+      compressed.data() + sizeof(raw_size), &serialized.at(0),
+      static_cast<int>(compressed.size() - sizeof(raw_size)), static_cast<int>(raw_size));
+  CHECK_EQ(decompressed_size, static_cast<int>(raw_size));
+  CHECK(msg->ParseFromString(serialized));
+}
 
-  HashMap<int64_t, ThrdIds> machine_id2thrd_ids;
-  for (const auto& pair : machine_id2thrd_id_set) {
-    CHECK(machine_id2thrd_ids.emplace(pair.first, ThrdIds()).second);
-    std::vector<int64_t> thrd_id_vec(pair.second.begin(), pair.second.end());
-    *(machine_id2thrd_ids.at(pair.first).mutable_thrd_id()) = StdVec2PbRf(thrd_id_vec);
-  }
+// the shared sub plan is fanned out along a binary tree rooted at the master, every machine
+// pulls it from the key relayed by its parent, so no single ctrl server serves all machines
+int64_t SharedSubPlanRelayParent(int64_t machine_id) { return (machine_id - 1) / 2; }
 
-  ClusterThrdIds cluster_thrd_ids;
-  *(cluster_thrd_ids.mutable_machine_id2thrd_ids()) = HashMap2PbMap(machine_id2thrd_ids);
-  Global<CtrlClient>::Get()->PushKV(cluster_thrd_ids_key(plan_name), cluster_thrd_ids);
+bool IsSharedSubPlanRelay(int64_t machine_id) {
+  return machine_id * 2 + 1 < Global<ResourceDesc, ForSession>::Get()->TotalMachineNum();
+}
 
-  for (const auto& pair : mchn_thrd_id2task_protos) {
-    SubPlan sub_plan;
-    *(sub_plan.mutable_task()) = StdVec2PbRpf(pair.second);
-    Global<CtrlClient>::Get()->PushKV(sub_plan_key(plan_name, pair.first.first, pair.first.second),
-                                      sub_plan);
+void PushPlan(const std::string& plan_name, const Plan& plan) {
+  double start_time = GetCurTime();
+  HashMap<int64_t, MachineSubPlan> machine_id2sub_plan;
+  for (const auto& task : plan.task()) {
+    *machine_id2sub_plan[task.machine_id()].add_task() = task;
   }
-
   for (const auto& mem_block : plan.block_chunk_list().mem_block()) {
-    *machine_id2block7chunk[mem_block.machine_id()].add_mem_block() = mem_block;
+    *machine_id2sub_plan[mem_block.machine_id()].mutable_block_chunk_list()->add_mem_block() =
+        mem_block;
   }
   for (const auto& chunk : plan.block_chunk_list().chunk()) {
-    *machine_id2block7chunk[chunk.machine_id()].add_chunk() = chunk;
+    *machine_id2sub_plan[chunk.machine_id()].mutable_block_chunk_list()->add_chunk() = chunk;
   }
-  for (const auto& pair : machine_id2block7chunk) {
-    Global<CtrlClient>::Get()->PushKV(block7chunk_key(plan_name, pair.first), pair.second);
+  std::vector<std::pair<int64_t, const MachineSubPlan*>> sub_plans;
+  FOR_RANGE(int64_t, machine_id, 0, Global<ResourceDesc, ForSession>::Get()->TotalMachineNum()) {
+    if (machine_id == GlobalProcessCtx::Rank()) { continue; }
+    MachineSubPlan* sub_plan = &machine_id2sub_plan[machine_id];
+    // block_chunk_list is required, machines without any mem block still need it set
+    sub_plan->mutable_block_chunk_list();
+    sub_plans.emplace_back(machine_id, sub_plan);
   }
-
-  Global<CtrlClient>::Get()->PushKV(net_topo_key(plan_name), plan.net_topo());
-  Global<CtrlClient>::Get()->PushKV(job_id2job_conf(plan_name), plan.job_confs());
-  Global<CtrlClient>::Get()->PushKV(GetCollectiveBoxingPlanKey(plan_name),
-                                    plan.collective_boxing_plan());
+  double split_time = GetCurTime();
+
+  std::atomic<size_t> compressed_bytes(0);
+  MultiThreadLoop(sub_plans.size() + 1, [&](size_t i) {
+    if (i == sub_plans.size()) {
+      SharedSubPlan shared_sub_plan;
+      *shared_sub_plan.mutable_net_topo() = plan.net_topo();
+      *shared_sub_plan.mutable_job_confs() = plan.job_confs();
+      *shared_sub_plan.mutable_collective_boxing_plan() = plan.collective_boxing_plan();
+      Global<CtrlClient>::Get()->PushKV(
+          shared_sub_plan_key(plan_name, GlobalProcessCtx::Rank()),
+          [&](std::string* val) {
+            CompressPbMessage(shared_sub_plan, val);
+            compressed_bytes += val->size();
+          });
+    } else {
+      Global<CtrlClient>::Get()->PushKV(machine_sub_plan_key(plan_name, sub_plans.at(i).first),
+                                        [&](std::string* val) {
+                                          CompressPbMessage(*sub_plans.at(i).second, val);
+                                          compressed_bytes += val->size();
+                                        });
+    }
+  });
+  double push_time = GetCurTime();
+  LOG(INFO) << "PushPlan " << plan_name << ": split " << (split_time - start_time) / 1e6
+            << " ms, compress and push " << (push_time - split_time) / 1e6 << " ms, "
+            << plan.ByteSizeLong() << " bytes compressed to " << compressed_bytes << " bytes";
 }
 
 void PullPlan(const std::string& plan_name, Plan* plan) {
-  ClusterThrdIds cluster_thrd_ids;
-  Global<CtrlClient>::Get()->PullKV(cluster_thrd_ids_key(plan_name), &cluster_thrd_ids);
-  PrintProtoToTextFile(cluster_thrd_ids, JoinPath(FLAGS_log_dir, cluster_thrd_ids_key(plan_name)));
-  HashMap<int64_t, ThrdIds> machine_id2thrd_ids;
-  machine_id2thrd_ids = PbMap2HashMap(cluster_thrd_ids.machine_id2thrd_ids());
-  int64_t machine_id = GlobalProcessCtx::Rank();
-  auto thrd_ids_it = machine_id2thrd_ids.find(machine_id);
-  CHECK(thrd_ids_it != machine_id2thrd_ids.end());
-  std::vector<int64_t> thrd_id_vec = PbRf2StdVec(thrd_ids_it->second.thrd_id());
-  for (auto thrd_id : thrd_id_vec) {
-    SubPlan sub_plan;
-    Global<CtrlClient>::Get()->PullKV(sub_plan_key(plan_name, machine_id, thrd_id), &sub_plan);
-    plan->mutable_task()->MergeFrom(sub_plan.task());
-  }
-  NetTopo net_topo;
-  Global<CtrlClient>::Get()->PullKV(net_topo_key(plan_name), &net_topo);
-  *(plan->mutable_net_topo()) = net_topo;
-  JobConfs job_confs;
-  Global<CtrlClient>::Get()->PullKV(job_id2job_conf(plan_name), &job_confs);
-  *(plan->mutable_job_confs()) = job_confs;
-  Global<CtrlClient>::Get()->PullKV(GetCollectiveBoxingPlanKey(plan_name),
-                                    plan->mutable_collective_boxing_plan());
-  MemBlockAndChunkList block7chunk;
-  Global<CtrlClient>::Get()->PullKV(block7chunk_key(plan_name, machine_id), &block7chunk);
-  plan->mutable_block_chunk_list()->CopyFrom(block7chunk);
+  double start_time = GetCurTime();
+  const int64_t machine_id = GlobalProcessCtx::Rank();
+  MachineSubPlan machine_sub_plan;
+  SharedSubPlan shared_sub_plan;
+  std::atomic<double> machine_sub_plan_time(0);
+  std::atomic<double> shared_sub_plan_time(0);
+  MultiThreadLoop(2, [&](size_t i) {
+    if (i == 0) {
+      Global<CtrlClient>::Get()->PullKV(
+          machine_sub_plan_key(plan_name, machine_id),
+          [&](const std::string& val) { DecompressPbMessage(val, &machine_sub_plan); });
+      machine_sub_plan_time = GetCurTime();
+    } else {
+      std::string compressed;
+      Global<CtrlClient>::Get()->PullKV(
+          shared_sub_plan_key(plan_name, SharedSubPlanRelayParent(machine_id)), &compressed);
+      shared_sub_plan_time = GetCurTime();
+      if (IsSharedSubPlanRelay(machine_id)) {
+        Global<CtrlClient>::Get()->PushKV(shared_sub_plan_key(plan_name, machine_id), compressed);
+      }
+      DecompressPbMessage(compressed, &shared_sub_plan);
+    }
+  });
+  double pull_time = GetCurTime();
+  plan->mutable_task()->Swap(machine_sub_plan.mutable_task());
+  plan->mutable_block_chunk_list()->Swap(machine_sub_plan.mutable_block_chunk_list());
+  plan->mutable_net_topo()->Swap(shared_sub_plan.mutable_net_topo());
+  plan->mutable_job_confs()->Swap(shared_sub_plan.mutable_job_confs());
+  plan->mutable_collective_boxing_plan()->Swap(shared_sub_plan.mutable_collective_boxing_plan());
+  LOG(INFO) << "PullPlan " << plan_name << ": machine sub plan "
+            << (machine_sub_plan_time - start_time) / 1e6 << " ms, shared sub plan "
+            << (shared_sub_plan_time - start_time) / 1e6 << " ms, relay and decompress "
+            << (pull_time - shared_sub_plan_time) / 1e6 << " ms";
 }
 
 bool IsCollectiveBoxingNode(const PlanTaskNode* node) {
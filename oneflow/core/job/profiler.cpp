@@ -108,6 +108,28 @@ void Profiler::Profile(const Plan& plan, const std::string& act_event_filepath)
                << " bottleneck_score:" << std::to_string(pair.second.CalcBottleNeckScore())
                << " type:" << TaskType_Name(task_id2task_type.at(pair.first)) << "\n";
   }
+
+  // the average act time of the actors of each op, read by AutoPipelinePass
+  HashMap<int64_t, const ActorProfileInfo*> actor_id2profile_info;
+  for (const ProfileInfoPair& pair : profile_info_vec) {
+    actor_id2profile_info.emplace(pair.first, &pair.second);
+  }
+  std::map<std::string, std::pair<double, int64_t>> op_name2acc_act_time_and_cnt;
+  for (const TaskProto& task : plan.task()) {
+    if (task.exec_sequence().exec_node_size() != 1) { continue; }
+    const auto it = actor_id2profile_info.find(task.task_id());
+    if (it == actor_id2profile_info.end()) { continue; }
+    const std::string& op_name =
+        task.exec_sequence().exec_node(0).kernel_conf().op_attribute().op_conf().name();
+    auto* acc_act_time_and_cnt = &op_name2acc_act_time_and_cnt[op_name];
+    acc_act_time_and_cnt->first += it->second->avg_act_time();
+    acc_act_time_and_cnt->second += 1;
+  }
+  auto op_log_stream = TeePersistentLogStream::Create("op_act_time");
+  for (const auto& pair : op_name2acc_act_time_and_cnt) {
+    op_log_stream << pair.first << " "
+                  << std::to_string(pair.second.first / pair.second.second) << "\n";
+  }
 }
 
 }  // namespace oneflow
@@ -42,6 +42,8 @@ class ResourceDesc final {
   size_t reserved_host_mem_byte() const { return resource_.reserved_host_mem_mbyte() * kMB; }
   size_t reserved_device_mem_byte() const { return resource_.reserved_device_mem_mbyte() * kMB; }
   bool use_rdma() const { return resource_.use_rdma(); }
+  bool use_shm_comm_net() const { return resource_.use_shm_comm_net(); }
+  size_t shm_comm_net_ring_byte() const { return resource_.shm_comm_net_ring_mbyte() * kMB; }
   bool enable_numa_aware_cuda_malloc_host() const {
     return resource_.enable_numa_aware_cuda_malloc_host();
   }
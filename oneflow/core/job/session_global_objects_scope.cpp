@@ -24,6 +24,7 @@ limitations under the License.
 #include "oneflow/core/job/id_manager.h"
 #include "oneflow/core/job/profiler.h"
 #include "oneflow/core/persistence/file_system.h"
+#include "oneflow/core/persistence/async_snapshot_writer.h"
 #include "oneflow/core/common/buffer_manager.h"
 #include "oneflow/core/job/foreign_job_instance.h"
 #include "oneflow/core/job/inter_user_job_info.pb.h"
@@ -40,6 +41,8 @@ namespace oneflow {
 
 namespace {
 
+constexpr int32_t kAsyncSnapshotWriterIoThreadNum = 4;
+
 std::string GetAmdCtrlKey(int64_t machine_id) {
   return "AvailableMemDesc/" + std::to_string(machine_id);
 }
@@ -77,6 +80,9 @@ Maybe<void> SessionGlobalObjectsScope::Init(const ConfigProto& config_proto) {
   Global<const IOConf>::SessionNew(config_proto.session_id(), config_proto.io_conf());
   Global<const ProfilerConf>::New(config_proto.profiler_conf());
   Global<IDMgr>::New();
+  if (config_proto.io_conf().enable_async_model_save()) {
+    Global<AsyncSnapshotWriter>::New(kAsyncSnapshotWriterIoThreadNum);
+  }
   if (GlobalProcessCtx::IsThisProcessMaster()
       && Global<const ProfilerConf>::Get()->collect_act_event()) {
     Global<Profiler>::New();
@@ -107,6 +113,7 @@ SessionGlobalObjectsScope::~SessionGlobalObjectsScope() {
     Global<AvailableMemDesc>::Delete();
   }
   if (Global<Profiler>::Get() != nullptr) { Global<Profiler>::Delete(); }
+  if (Global<AsyncSnapshotWriter>::Get() != nullptr) { Global<AsyncSnapshotWriter>::Delete(); }
   Global<IDMgr>::Delete();
   Global<const ProfilerConf>::Delete();
   Global<const IOConf>::Delete();
@@ -27,7 +27,8 @@ REGISTER_FUNCTION_CONFIG_DEF()
 
 REGISTER_SCOPE_CONFIG_DEF()
     .Int64("ssp_num_stages", -1, "total number of ssp stages")
-    .Int64("ssp_stage_id", -1, "current ssp stage id ");
+    .Int64("ssp_stage_id", -1, "current ssp stage id ")
+    .Int64("ssp_stage_regst_num", -1, "min register num of the forward ops in current stage");
 
 }  // namespace
 
@@ -13,14 +13,13 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
-
-#ifdef WITH_CUDA
-
 #include "oneflow/core/job_rewriter/auto_mixed_precision_lists.h"
 
 #include <algorithm>
 
+#ifdef WITH_CUDA
 #include "oneflow/core/device/cuda_util.h"
+#endif
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/core/job_rewriter/job_pass.h"
 #include "oneflow/core/job_rewriter/pass_util.h"
@@ -53,11 +52,28 @@ bool FindInNoCastRegisry(const std::string& op_type, const OpArg& op_arg) {
   return false;
 }
 
-std::function<bool(OpNode*)> MakePredicatorIsAllowedToRunWithHalf(const OpGraph& op_graph) {
+// gpu nodes run in float16 and cpu nodes run in bfloat16
+DataType HalfDataType4Node(const OpNode* node) {
+  return node->parallel_desc().device_type() == DeviceType::kGPU ? DataType::kFloat16
+                                                                  : DataType::kBFloat16;
+}
+
+std::function<bool(OpNode*)> MakePredicatorIsAllowedToRunWithHalf(const OpGraph& op_graph,
+                                                                   const JobDesc& job_desc) {
+  const AMPList& cpu_bfloat16_list = AutoMixedPrecisionLists::CpuBFloat16List();
   auto allowed_set = std::make_shared<HashSet<OpNode*>>();
   op_graph.ForEachNode([&](OpNode* node) {
-    if (node->parallel_desc().device_type() != DeviceType::kGPU) { return; }
-    if (node->op().output_bns().size() > 0) { INSERT_CHECK(allowed_set->insert(node)); }
+    if (node->op().output_bns().empty()) { return; }
+    const DeviceType device_type = node->parallel_desc().device_type();
+    if (device_type == DeviceType::kGPU) {
+      if (!job_desc.enable_auto_mixed_precision()) { return; }
+    } else if (device_type == DeviceType::kCPU) {
+      if (!job_desc.enable_cpu_auto_mixed_precision()) { return; }
+      if (!IsNodeInList(cpu_bfloat16_list, node)) { return; }
+    } else {
+      return;
+    }
+    INSERT_CHECK(allowed_set->insert(node));
   });
   return [allowed_set](OpNode* node) -> bool { return IsKeyFound(*allowed_set, node); };
 }
@@ -86,25 +102,33 @@ void InsertCastOpImpl(bool f2h, const OpGraph& op_graph, const HashSet<OpNode*>&
             << Container2Str<HashSet<OpEdge*>, OpEdge*>(white_set_edges, EdgeName4Edge);
   }
 
-  HashMap<std::string, std::vector<OpEdge*>> edges_group_by_lbn;
+  // the half data type follows the device of the white node at either end of the edge
+  std::map<std::pair<std::string, DataType>, std::vector<OpEdge*>> edges_group_by_lbn;
   {
     for (OpEdge* edge : white_set_edges) {
       CHECK_EQ(1, edge->lbis().size());
       std::string lbn = GenLogicalBlobName(edge->lbis().front());
-      edges_group_by_lbn[lbn].push_back(edge);
+      const OpNode* white_node = f2h ? edge->dst_node() : edge->src_node();
+      edges_group_by_lbn[std::make_pair(lbn, HalfDataType4Node(white_node))].push_back(edge);
     }
   }
 
   HashMap<std::string, OperatorConf> dst_op_name2dst_op_confs;
   for (auto& pair : edges_group_by_lbn) {
-    const std::string& lbn = pair.first;
+    const std::string& lbn = pair.first.first;
+    const DataType half_data_type = pair.first.second;
     OpNode* src_node = pair.second.front()->src_node();
 
     const BlobDesc& blob_desc = src_node->LogicalBlobDesc4Lbi(GenLogicalBlobId(lbn));
     if (blob_desc.data_type() != DataType::kFloat) { continue; }
 
-    std::string cast_suffix = f2h ? "-cast_f2h" : "-cast_h2f";
-    DataType cast_data_type = f2h ? DataType::kFloat16 : DataType::kFloat;
+    std::string cast_suffix;
+    if (half_data_type == DataType::kFloat16) {
+      cast_suffix = f2h ? "-cast_f2h" : "-cast_h2f";
+    } else {
+      cast_suffix = f2h ? "-cast_f2bf" : "-cast_bf2f";
+    }
+    DataType cast_data_type = f2h ? half_data_type : DataType::kFloat;
     auto cast_op = user_op::UserOpConfWrapperBuilder(ReplaceSlashToDash4Lbn(lbn) + cast_suffix)
                        .Op("cast")
                        .Input("in", lbn)
@@ -164,16 +188,18 @@ class AutoMixedPrecision final : public JobPass {
   ~AutoMixedPrecision() = default;
 
   bool IsEnabled(const JobPassCtx& ctx) const {
-    return ctx.job_desc().enable_auto_mixed_precision();
+    return ctx.job_desc().enable_auto_mixed_precision()
+           || ctx.job_desc().enable_cpu_auto_mixed_precision();
   }
 
-  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+  Maybe<void> Apply(const OpGraph& op_graph, const JobDesc& job_desc,
+                    JobBuilder* job_builder) const;
 
   Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
     if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
     const OpGraph op_graph(*job);
     JobBuilder job_builder(job);
-    return Apply(op_graph, &job_builder);
+    return Apply(op_graph, ctx->job_desc(), &job_builder);
   }
 
  private:
@@ -193,14 +219,18 @@ class AutoMixedPrecision final : public JobPass {
   const AMPList& clear_list_;
 };
 
-Maybe<void> AutoMixedPrecision::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
-  CHECK_GE(CUDA_VERSION, 10000);
+Maybe<void> AutoMixedPrecision::Apply(const OpGraph& op_graph, const JobDesc& job_desc,
+                                      JobBuilder* job_builder) const {
+#ifdef WITH_CUDA
+  if (job_desc.enable_auto_mixed_precision()) { CHECK_GE(CUDA_VERSION, 10000); }
+#endif
   CHECK(GlobalJobDesc().DefaultDataType() == DataType::kFloat);
 
   VerifyAMPList(white_list_);
   VerifyAMPList(black_list_);
   VerifyAMPList(gray_list_);
   VerifyAMPList(clear_list_);
+  VerifyAMPList(AutoMixedPrecisionLists::CpuBFloat16List());
 
   std::function<std::string(OpNode* const&)> OpName4Node = [](OpNode* const& node) {
     return node->op().op_name();
@@ -212,7 +242,7 @@ Maybe<void> AutoMixedPrecision::Apply(const OpGraph& op_graph, JobBuilder* job_b
   VLOG(1) << "BlackSet include: "
           << Container2Str<HashSet<OpNode*>, OpNode*>(black_set, OpName4Node);
 
-  auto IsAllowedToRunWithHalf = MakePredicatorIsAllowedToRunWithHalf(op_graph);
+  auto IsAllowedToRunWithHalf = MakePredicatorIsAllowedToRunWithHalf(op_graph, job_desc);
   FillWhiteSet(op_graph, IsAllowedToRunWithHalf, black_set, &white_set);
   VLOG(2) << "WhiteSet Before Propagate include: "
           << Container2Str<HashSet<OpNode*>, OpNode*>(white_set, OpName4Node);
@@ -342,5 +372,3 @@ REGISTER_NO_CAST_REGISTRY("normalization_add_relu", "beta", 0)
 }  // namespace
 
 }  // namespace oneflow
-
-#endif  // WITH_CUDA
@@ -65,4 +65,14 @@ const AMPList& AutoMixedPrecisionLists::ClearList() {
   return clear_list;
 }
 
+const AMPList& AutoMixedPrecisionLists::CpuBFloat16List() {
+  static AMPList cpu_bfloat16_list = {"matmul",              "batch_matmul", "conv2d",
+                                      "add_n",               "relu",         "scalar_add",
+                                      "scalar_mul",          "sigmoid",      "gelu",
+                                      "reshape",             "identity",     "flatten",
+                                      "squeeze",             "expand_dims",  "parallel_cast",
+                                      "amp_white_identity"};
+  return cpu_bfloat16_list;
+}
+
 }  // namespace oneflow
@@ -30,6 +30,9 @@ class AutoMixedPrecisionLists final {
   static const AMPList& BlackList();
   static const AMPList& GrayList();
   static const AMPList& ClearList();
+  // op types that have bfloat16 cpu kernels for themselves and their gradients, cpu nodes of
+  // other types keep running in float
+  static const AMPList& CpuBFloat16List();
 };
 
 }  // namespace oneflow
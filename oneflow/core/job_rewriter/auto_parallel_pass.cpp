@@ -0,0 +1,443 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/job_rewriter/pass_util.h"
+
+namespace oneflow {
+
+namespace {
+
+struct AutoParallelProfile {
+  double flops_per_sec;
+  double bytes_per_sec;
+};
+
+bool IsPartitioned(const SbpParallel& sbp_parallel) {
+  return sbp_parallel.has_split_parallel() || sbp_parallel.has_partial_sum_parallel();
+}
+
+// The bytes received by one device to turn a blob of logical_bytes from src_sbp on src_desc into
+// dst_sbp on dst_desc, assuming boxing by collectives on the same devices and by copying parts
+// otherwise.
+double EstimateBoxingBytes(const SbpParallel& src_sbp, const ParallelDesc& src_desc,
+                           const SbpParallel& dst_sbp, const ParallelDesc& dst_desc,
+                           double logical_bytes) {
+  if (src_desc == dst_desc) {
+    if (src_sbp == dst_sbp || src_sbp.has_broadcast_parallel()) { return 0; }
+    if (dst_sbp.has_partial_sum_parallel()) { return 0; }
+    const double p = dst_desc.parallel_num();
+    if (src_sbp.has_split_parallel()) {
+      // all-to-all for another split axis, all-gather for broadcast
+      return dst_sbp.has_split_parallel() ? logical_bytes * (p - 1) / (p * p)
+                                          : logical_bytes * (p - 1) / p;
+    }
+    // reduce-scatter for split, all-reduce for broadcast
+    return dst_sbp.has_split_parallel() ? logical_bytes * (p - 1) / p
+                                        : 2 * logical_bytes * (p - 1) / p;
+  }
+  double bytes = dst_sbp.has_broadcast_parallel() ? logical_bytes
+                                                  : logical_bytes / dst_desc.parallel_num();
+  if (src_sbp.has_partial_sum_parallel()) {
+    const double q = src_desc.parallel_num();
+    bytes += logical_bytes * (q - 1) / q;
+  }
+  return bytes;
+}
+
+// Per device compute time, the work is assumed to be divided among the devices if any blob of the
+// op is split or partial.
+double EstimateComputeCost(const OpNode* op_node, const SbpSignature& sbp_signature,
+                           const AutoParallelProfile& profile) {
+  double flops = EstimateFlops4OpNode(op_node);
+  for (const auto& pair : sbp_signature.bn_in_op2sbp_parallel()) {
+    if (IsPartitioned(pair.second)) {
+      flops /= op_node->parallel_desc().parallel_num();
+      break;
+    }
+  }
+  return flops / profile.flops_per_sec;
+}
+
+std::string SbpSignatureToString(const Operator& op, const SbpSignature& sbp_signature) {
+  std::string str;
+  op.ForEachBnInOp([&](const std::string& bn) {
+    const auto it = sbp_signature.bn_in_op2sbp_parallel().find(bn);
+    if (it == sbp_signature.bn_in_op2sbp_parallel().end()) { return; }
+    if (!str.empty()) { str += ", "; }
+    str += bn + ":" + SbpParallelToString(it->second);
+  });
+  return str;
+}
+
+// The SBP signatures an op may take, filtered by the logical shapes of its inputs and by the
+// signature configured for it the same way Operator::InferSbpSignature does.
+Maybe<void> GetCandidateSbpSignatures(const OpNode* op_node, const SbpSignature& sbp_sig_conf,
+                                      std::vector<SbpSignature>* candidates) {
+  const Operator& op = op_node->op();
+  auto LogicalBlobDesc4Ibn = [&](const std::string& ibn) -> Maybe<const BlobDesc&> {
+    return Maybe<const BlobDesc&>(op_node->LogicalBlobDesc4Lbi(op.BnInOp2Lbi(ibn)));
+  };
+  SbpSignatureList sbp_sig_list;
+  JUST(op.GetSbpSignaturesIf(LogicalBlobDesc4Ibn, op_node->parallel_desc(), &sbp_sig_list));
+  SbpSignatureList filtered_sbp_sig_list;
+  FilterSbpSignatureList(sbp_sig_list, sbp_sig_conf, &filtered_sbp_sig_list);
+  const int64_t parallel_num = op_node->parallel_desc().parallel_num();
+  for (const SbpSignature& sbp_signature : filtered_sbp_sig_list.sbp_signature()) {
+    bool is_valid = true;
+    for (const std::string& ibn : op.input_bns()) {
+      const auto it = sbp_signature.bn_in_op2sbp_parallel().find(ibn);
+      CHECK_OR_RETURN(it != sbp_signature.bn_in_op2sbp_parallel().end());
+      if (!it->second.has_split_parallel()) { continue; }
+      const Shape& shape = op_node->LogicalBlobDesc4Lbi(op.BnInOp2Lbi(ibn)).shape();
+      const int64_t axis = it->second.split_parallel().axis();
+      if (axis >= shape.NumAxes() || shape.At(axis) < parallel_num) {
+        is_valid = false;
+        break;
+      }
+    }
+    if (is_valid
+        && std::find(candidates->begin(), candidates->end(), sbp_signature) == candidates->end()) {
+      candidates->push_back(sbp_signature);
+    }
+  }
+  return Maybe<void>::Ok();
+}
+
+// Chooses SBP signatures for the whole graph by minimizing the estimated per device compute time
+// of the ops plus the boxing time of the blobs. Starting from the signatures inferred greedily, it
+// repeatedly re-solves every chain of ops exactly by dynamic programming while the choices of the
+// other ops are fixed, until the total cost stops decreasing.
+class AutoParallelPlanner final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(AutoParallelPlanner);
+  explicit AutoParallelPlanner(const AutoParallelProfile& profile) : profile_(profile) {}
+  ~AutoParallelPlanner() = default;
+
+  Maybe<void> Init(const OpGraph& op_graph, const Job& job);
+  void Solve();
+  void ForEachPlannedOpNode(
+      const std::function<void(const OpNode*, const SbpSignature& greedy_sbp_signature,
+                               const SbpSignature& planned_sbp_signature)>& Handler) const;
+  double ComputeCost(bool is_planned) const;
+  double BoxingCost(bool is_planned) const;
+
+ private:
+  struct Node {
+    const OpNode* op_node;
+    bool is_free;
+    std::vector<SbpSignature> candidates;
+    std::vector<double> compute_costs;
+    int64_t greedy;
+    int64_t chosen;
+    std::vector<int64_t> in_edges;
+    std::vector<int64_t> out_edges;
+  };
+  struct Edge {
+    int64_t src;
+    int64_t dst;
+    // costs[i][j] is the boxing cost when src takes its i-th candidate and dst its j-th one
+    std::vector<std::vector<double>> costs;
+  };
+
+  bool IsFree(const OpNode* op_node, const HashSet<std::string>& identical_sbp_op_names) const;
+  void BuildChains();
+  // Returns the decrease of the total cost.
+  double SolveChain(const std::vector<int64_t>& chain);
+
+  const AutoParallelProfile profile_;
+  std::vector<Node> nodes_;
+  std::vector<Edge> edges_;
+  std::vector<std::vector<int64_t>> chains_;
+};
+
+bool AutoParallelPlanner::IsFree(const OpNode* op_node,
+                                 const HashSet<std::string>& identical_sbp_op_names) const {
+  const Operator& op = op_node->op();
+  const OperatorConf& op_conf = op.op_conf();
+  if (op_node->parallel_desc().parallel_num() <= 1) { return false; }
+  if (op_node->parallel_desc().hierarchy()->NumAxes() != 1) { return false; }
+  // only user ops infer their signatures by copy cost, the others have their own rules
+  if (!op_conf.has_user_conf()) { return false; }
+  const user_op::OpRegistryResult* val =
+      user_op::UserOpRegistryMgr::Get().GetOpRegistryResult(op_conf.user_conf().op_type_name());
+  if (val == nullptr || val->infer_sbp_signature_fn) { return false; }
+  // source ops are split at axis 0 by default
+  if (op.input_bns().empty()) { return false; }
+  if (identical_sbp_op_names.count(op.op_name()) > 0) { return false; }
+  for (const std::string& obn : op.output_bns()) {
+    if (CHECK_JUST(op.OptMirroredParallel4BnInOp(obn))->has_mirrored_parallel()) { return false; }
+  }
+  return true;
+}
+
+Maybe<void> AutoParallelPlanner::Init(const OpGraph& op_graph, const Job& job) {
+  HashSet<std::string> identical_sbp_op_names;
+  for (const auto& pair : job.helper().identical_sbp_oba_pairs().pair()) {
+    identical_sbp_op_names.insert(pair.first().op_name());
+    identical_sbp_op_names.insert(pair.second().op_name());
+  }
+  const auto& op_name2sbp_sig_conf = job.job_parallel_view_conf().op_name2sbp_signature_conf();
+  HashMap<const OpNode*, int64_t> op_node2index;
+  JUST(op_graph.TopoForEachNodeWithErrorCaptured([&](OpNode* op_node) -> Maybe<void> {
+    Node node;
+    node.op_node = op_node;
+    node.is_free = IsFree(op_node, identical_sbp_op_names);
+    if (node.is_free) {
+      SbpSignature sbp_sig_conf;
+      const auto it = op_name2sbp_sig_conf.find(op_node->op().op_name());
+      if (it != op_name2sbp_sig_conf.end()) { sbp_sig_conf = it->second; }
+      JUST(GetCandidateSbpSignatures(op_node, sbp_sig_conf, &node.candidates));
+    }
+    const auto greedy_it = std::find(node.candidates.begin(), node.candidates.end(),
+                                     op_node->sbp_signature());
+    node.greedy = greedy_it - node.candidates.begin();
+    if (greedy_it == node.candidates.end()) {
+      node.is_free = false;
+      node.candidates = {op_node->sbp_signature()};
+      node.greedy = 0;
+    }
+    if (node.candidates.size() == 1) { node.is_free = false; }
+    node.chosen = node.greedy;
+    for (const SbpSignature& candidate : node.candidates) {
+      node.compute_costs.push_back(EstimateComputeCost(op_node, candidate, profile_));
+    }
+    op_node2index.emplace(op_node, nodes_.size());
+    nodes_.push_back(std::move(node));
+    return Maybe<void>::Ok();
+  }));
+  FOR_RANGE(int64_t, dst, 0, nodes_.size()) {
+    const Node& dst_node = nodes_.at(dst);
+    for (const OpEdge* op_edge : dst_node.op_node->in_edges()) {
+      Edge edge;
+      edge.src = op_node2index.at(op_edge->src_node());
+      edge.dst = dst;
+      const Node& src_node = nodes_.at(edge.src);
+      const ParallelDesc& src_desc = src_node.op_node->parallel_desc();
+      const ParallelDesc& dst_desc = dst_node.op_node->parallel_desc();
+      edge.costs.assign(src_node.candidates.size(),
+                        std::vector<double>(dst_node.candidates.size(), 0));
+      for (const LogicalBlobId& lbi : op_edge->lbis()) {
+        const BlobDesc& blob_desc = src_node.op_node->LogicalBlobDesc4Lbi(lbi);
+        const double logical_bytes =
+            blob_desc.shape().elem_cnt() * GetSizeOfDataType(blob_desc.data_type());
+        const std::string& obn = op_edge->lbi2obn().at(lbi);
+        for (const std::string& ibn : op_edge->lbi2ibns().at(lbi)) {
+          FOR_RANGE(int64_t, i, 0, src_node.candidates.size()) {
+            const SbpParallel& src_sbp =
+                src_node.candidates.at(i).bn_in_op2sbp_parallel().at(obn);
+            FOR_RANGE(int64_t, j, 0, dst_node.candidates.size()) {
+              const SbpParallel& dst_sbp =
+                  dst_node.candidates.at(j).bn_in_op2sbp_parallel().at(ibn);
+              edge.costs.at(i).at(j) +=
+                  EstimateBoxingBytes(src_sbp, src_desc, dst_sbp, dst_desc, logical_bytes)
+                  / profile_.bytes_per_sec;
+            }
+          }
+        }
+      }
+      nodes_.at(edge.src).out_edges.push_back(edges_.size());
+      nodes_.at(edge.dst).in_edges.push_back(edges_.size());
+      edges_.push_back(std::move(edge));
+    }
+  }
+  BuildChains();
+  return Maybe<void>::Ok();
+}
+
+void AutoParallelPlanner::BuildChains() {
+  // node i continues the chain of its only producer if it is the only consumer of the producer
+  auto Predecessor = [&](int64_t i) -> int64_t {
+    const Node& node = nodes_.at(i);
+    if (!node.is_free || node.in_edges.size() != 1) { return -1; }
+    const int64_t src = edges_.at(node.in_edges.front()).src;
+    const Node& src_node = nodes_.at(src);
+    if (!src_node.is_free || src_node.out_edges.size() != 1) { return -1; }
+    return src;
+  };
+  std::vector<int64_t> successor(nodes_.size(), -1);
+  FOR_RANGE(int64_t, i, 0, nodes_.size()) {
+    const int64_t predecessor = Predecessor(i);
+    if (predecessor != -1) { successor.at(predecessor) = i; }
+  }
+  FOR_RANGE(int64_t, i, 0, nodes_.size()) {
+    if (!nodes_.at(i).is_free || Predecessor(i) != -1) { continue; }
+    std::vector<int64_t> chain;
+    for (int64_t j = i; j != -1; j = successor.at(j)) { chain.push_back(j); }
+    chains_.push_back(std::move(chain));
+  }
+}
+
+double AutoParallelPlanner::SolveChain(const std::vector<int64_t>& chain) {
+  HashMap<int64_t, int64_t> node2position;
+  FOR_RANGE(int64_t, k, 0, chain.size()) { node2position.emplace(chain.at(k), k); }
+  // costs[k][c] is the cost of chain[k] taking candidate c, with the edges to the ops off the chain
+  std::vector<std::vector<double>> costs(chain.size());
+  double old_cost = 0;
+  FOR_RANGE(int64_t, k, 0, chain.size()) {
+    const Node& node = nodes_.at(chain.at(k));
+    costs.at(k) = node.compute_costs;
+    old_cost += node.compute_costs.at(node.chosen);
+    for (const int64_t e : node.in_edges) {
+      const Edge& edge = edges_.at(e);
+      const auto it = node2position.find(edge.src);
+      if (it != node2position.end() && it->second == k - 1) {
+        old_cost += edge.costs.at(nodes_.at(edge.src).chosen).at(node.chosen);
+        continue;
+      }
+      FOR_RANGE(int64_t, c, 0, costs.at(k).size()) {
+        costs.at(k).at(c) += edge.costs.at(nodes_.at(edge.src).chosen).at(c);
+      }
+      old_cost += edge.costs.at(nodes_.at(edge.src).chosen).at(node.chosen);
+    }
+    for (const int64_t e : node.out_edges) {
+      const Edge& edge = edges_.at(e);
+      const auto it = node2position.find(edge.dst);
+      if (it != node2position.end() && it->second == k + 1) { continue; }
+      FOR_RANGE(int64_t, c, 0, costs.at(k).size()) {
+        costs.at(k).at(c) += edge.costs.at(c).at(nodes_.at(edge.dst).chosen);
+      }
+      old_cost += edge.costs.at(node.chosen).at(nodes_.at(edge.dst).chosen);
+    }
+  }
+  // Viterbi over the chain, the edge between chain[k - 1] and chain[k] is its only in edge
+  std::vector<std::vector<double>> best(chain.size());
+  std::vector<std::vector<int64_t>> prev_choice(chain.size());
+  best.front() = costs.front();
+  FOR_RANGE(int64_t, k, 1, chain.size()) {
+    const Edge& edge = edges_.at(nodes_.at(chain.at(k)).in_edges.front());
+    best.at(k).assign(costs.at(k).size(), std::numeric_limits<double>::max());
+    prev_choice.at(k).assign(costs.at(k).size(), 0);
+    FOR_RANGE(int64_t, c, 0, costs.at(k).size()) {
+      FOR_RANGE(int64_t, p, 0, best.at(k - 1).size()) {
+        const double cost = best.at(k - 1).at(p) + edge.costs.at(p).at(c) + costs.at(k).at(c);
+        if (cost < best.at(k).at(c)) {
+          best.at(k).at(c) = cost;
+          prev_choice.at(k).at(c) = p;
+        }
+      }
+    }
+  }
+  const auto min_it = std::min_element(best.back().begin(), best.back().end());
+  const double new_cost = *min_it;
+  // keep the current choices unless they are beaten clearly, so that the search terminates
+  if (new_cost >= old_cost * (1 - 1e-9)) { return 0; }
+  int64_t choice = min_it - best.back().begin();
+  for (int64_t k = chain.size() - 1; k >= 0; --k) {
+    nodes_.at(chain.at(k)).chosen = choice;
+    if (k > 0) { choice = prev_choice.at(k).at(choice); }
+  }
+  return old_cost - new_cost;
+}
+
+void AutoParallelPlanner::Solve() {
+  const int64_t kMaxNumRounds = 16;
+  FOR_RANGE(int64_t, round, 0, kMaxNumRounds) {
+    double decrease = 0;
+    for (const auto& chain : chains_) { decrease += SolveChain(chain); }
+    if (decrease == 0) { break; }
+  }
+}
+
+void AutoParallelPlanner::ForEachPlannedOpNode(
+    const std::function<void(const OpNode*, const SbpSignature&, const SbpSignature&)>& Handler)
+    const {
+  for (const Node& node : nodes_) {
+    if (!node.is_free) { continue; }
+    Handler(node.op_node, node.candidates.at(node.greedy), node.candidates.at(node.chosen));
+  }
+}
+
+double AutoParallelPlanner::ComputeCost(bool is_planned) const {
+  double cost = 0;
+  for (const Node& node : nodes_) {
+    cost += node.compute_costs.at(is_planned ? node.chosen : node.greedy);
+  }
+  return cost;
+}
+
+double AutoParallelPlanner::BoxingCost(bool is_planned) const {
+  double cost = 0;
+  for (const Edge& edge : edges_) {
+    const Node& src = nodes_.at(edge.src);
+    const Node& dst = nodes_.at(edge.dst);
+    cost += is_planned ? edge.costs.at(src.chosen).at(dst.chosen)
+                       : edge.costs.at(src.greedy).at(dst.greedy);
+  }
+  return cost;
+}
+
+class AutoParallelPass final : public JobPass {
+ public:
+  AutoParallelPass() = default;
+  ~AutoParallelPass() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    return ctx.job_desc().job_conf().enable_auto_parallel();
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, const AutoParallelProfile& profile,
+                    JobBuilder* job_builder) const;
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const JobConfigProto& job_conf = ctx->job_desc().job_conf();
+    AutoParallelProfile profile{};
+    profile.flops_per_sec = job_conf.auto_parallel_device_gflops() * 1e9;
+    profile.bytes_per_sec = job_conf.auto_parallel_bandwidth_gbyte_per_sec() * 1e9;
+    CHECK_GT_OR_RETURN(profile.flops_per_sec, 0);
+    CHECK_GT_OR_RETURN(profile.bytes_per_sec, 0);
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, profile, &job_builder);
+  }
+};
+
+Maybe<void> AutoParallelPass::Apply(const OpGraph& op_graph, const AutoParallelProfile& profile,
+                                    JobBuilder* job_builder) const {
+  AutoParallelPlanner planner(profile);
+  JUST(planner.Init(op_graph, job_builder->job()));
+  planner.Solve();
+  int64_t num_planned_ops = 0;
+  int64_t num_changed_ops = 0;
+  planner.ForEachPlannedOpNode([&](const OpNode* op_node, const SbpSignature& greedy_sbp_signature,
+                                   const SbpSignature& planned_sbp_signature) {
+    // every free op is pinned, otherwise its greedy choice may change with its producers
+    job_builder->AddSbpSignature4OpName(op_node->op().op_name(), planned_sbp_signature);
+    num_planned_ops += 1;
+    if (planned_sbp_signature == greedy_sbp_signature) { return; }
+    num_changed_ops += 1;
+    LOG(INFO) << "AutoParallelPass: " << op_node->op().op_name() << " ("
+              << SbpSignatureToString(op_node->op(), greedy_sbp_signature) << ") -> ("
+              << SbpSignatureToString(op_node->op(), planned_sbp_signature) << ")";
+  });
+  const double greedy_compute_cost = planner.ComputeCost(false);
+  const double greedy_boxing_cost = planner.BoxingCost(false);
+  const double planned_compute_cost = planner.ComputeCost(true);
+  const double planned_boxing_cost = planner.BoxingCost(true);
+  LOG(INFO) << "AutoParallelPass: planned " << num_planned_ops << " ops, changed "
+            << num_changed_ops << ", estimated time per iteration "
+            << (greedy_compute_cost + greedy_boxing_cost) * 1e3 << "ms (compute "
+            << greedy_compute_cost * 1e3 << "ms, boxing " << greedy_boxing_cost * 1e3
+            << "ms) -> " << (planned_compute_cost + planned_boxing_cost) * 1e3 << "ms (compute "
+            << planned_compute_cost * 1e3 << "ms, boxing " << planned_boxing_cost * 1e3 << "ms)";
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_JOB_PASS("AutoParallelPass", AutoParallelPass);
+
+}  // namespace oneflow
@@ -0,0 +1,298 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/framework/interpreter.h"
+#include "oneflow/core/framework/instructions_builder.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/scope.h"
+#include "oneflow/core/job/scope.cfg.h"
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/job_rewriter/pass_util.h"
+#include "oneflow/core/vm/symbol_storage.h"
+
+namespace oneflow {
+
+namespace {
+
+struct OpCost {
+  // seconds of forward compute on the devices of a stage
+  double time;
+  // bytes of the outputs on a device of a stage, kept until the backward ops consume them
+  double activation_bytes;
+};
+
+struct StageInfo {
+  int64_t num_ops;
+  double time;
+  double activation_bytes;
+  int64_t regst_num;
+};
+
+// Each line of the file is an op name and its average act time in nanoseconds, as dumped by
+// Profiler to op_act_time in the log dir.
+Maybe<void> LoadOpActTimes(const std::string& file_path,
+                           HashMap<std::string, double>* op_name2act_time) {
+  std::ifstream in_stream(file_path.c_str(), std::ifstream::in);
+  CHECK_OR_RETURN(in_stream.is_open()) << "Fail to open " << file_path;
+  std::string op_name;
+  double act_time = 0;
+  while (in_stream >> op_name >> act_time) { (*op_name2act_time)[op_name] = act_time * 1e-9; }
+  return Maybe<void>::Ok();
+}
+
+// Splits costs into num_stages non empty contiguous ranges minimizing the largest sum of a range,
+// returns the stage of each cost. The best split of a prefix into s ranges is no better for a
+// longer prefix, so the last cut is found by binary search.
+std::vector<int64_t> PartitionIntoBalancedStages(const std::vector<double>& costs,
+                                                 int64_t num_stages) {
+  const int64_t n = costs.size();
+  CHECK_GE(n, num_stages);
+  std::vector<double> prefix_sum(n + 1, 0);
+  FOR_RANGE(int64_t, i, 0, n) { prefix_sum.at(i + 1) = prefix_sum.at(i) + costs.at(i); }
+  // best.at(s).at(i): the largest range sum of the best split of the first i costs into s + 1
+  // ranges, last_cut.at(s).at(i): where the last range of it begins
+  std::vector<std::vector<double>> best(num_stages,
+                                        std::vector<double>(n + 1, GetMaxVal<double>()));
+  std::vector<std::vector<int64_t>> last_cut(num_stages, std::vector<int64_t>(n + 1, 0));
+  FOR_RANGE(int64_t, i, 1, n + 1) { best.at(0).at(i) = prefix_sum.at(i); }
+  FOR_RANGE(int64_t, s, 1, num_stages) {
+    FOR_RANGE(int64_t, i, s + 1, n + 1) {
+      // the first cut in [s, i) where the previous ranges cost no less than the last one
+      int64_t lo = s;
+      int64_t hi = i - 1;
+      while (lo < hi) {
+        const int64_t mid = (lo + hi) / 2;
+        if (best.at(s - 1).at(mid) >= prefix_sum.at(i) - prefix_sum.at(mid)) {
+          hi = mid;
+        } else {
+          lo = mid + 1;
+        }
+      }
+      for (int64_t cut : {lo - 1, lo}) {
+        if (cut < s) { continue; }
+        const double cost =
+            std::max(best.at(s - 1).at(cut), prefix_sum.at(i) - prefix_sum.at(cut));
+        if (cost < best.at(s).at(i)) {
+          best.at(s).at(i) = cost;
+          last_cut.at(s).at(i) = cut;
+        }
+      }
+    }
+  }
+  std::vector<int64_t> stages(n);
+  int64_t end = n;
+  for (int64_t s = num_stages - 1; s >= 0; --s) {
+    const int64_t begin = s == 0 ? 0 : last_cut.at(s).at(end);
+    FOR_RANGE(int64_t, i, begin, end) { stages.at(i) = s; }
+    end = begin;
+  }
+  return stages;
+}
+
+// The devices of a stage are a contiguous range of the parallel ids of the pipeline placement.
+Maybe<ParallelConf> StageParallelConf(const ParallelDesc& pipeline_desc, int64_t num_stages,
+                                      int64_t stage_id) {
+  const int64_t stage_parallel_num = pipeline_desc.parallel_num() / num_stages;
+  ParallelConf parallel_conf;
+  parallel_conf.set_device_tag(pipeline_desc.device_tag());
+  FOR_RANGE(int64_t, parallel_id, stage_id * stage_parallel_num,
+            (stage_id + 1) * stage_parallel_num) {
+    const int64_t machine_id = JUST(pipeline_desc.MachineId4ParallelId(parallel_id));
+    const int64_t device_id = JUST(pipeline_desc.DeviceId4ParallelId(parallel_id));
+    parallel_conf.add_device_name(std::to_string(machine_id) + ":" + std::to_string(device_id));
+  }
+  return parallel_conf;
+}
+
+// A child of the scope placed on the devices of the stage, with the ssp attributes read by
+// AddSspVariableProxy and by the compiler.
+Maybe<int64_t> NewStageScopeSymbolId(int64_t scope_symbol_id, const ParallelConf& parallel_conf,
+                                     int64_t num_stages, int64_t stage_id) {
+  const auto& scope = JUST(Global<symbol::Storage<Scope>>::Get()->MaybeGetPtr(scope_symbol_id));
+  const auto& cfg_parallel_conf = std::make_shared<cfg::ParallelConf>(parallel_conf);
+  const auto SetSspAttrs = [&](const std::shared_ptr<cfg::ScopeProto>& scope_proto) {
+    auto* attr_name2attr_value = scope_proto->mutable_attr_name2attr_value();
+    (*attr_name2attr_value)["ssp_num_stages"].set_at_int64(num_stages);
+    (*attr_name2attr_value)["ssp_stage_id"].set_at_int64(stage_id);
+    (*attr_name2attr_value)["ssp_stage_regst_num"].set_at_int64(num_stages - stage_id);
+  };
+  int64_t symbol_id = 0;
+  JUST(LogicalInterpreter().Run([&](InstructionsBuilder* builder) -> Maybe<void> {
+    const auto& stage_scope =
+        JUST(builder->BuildScopeWithNewParallelConf(scope, cfg_parallel_conf));
+    const auto& new_scope = JUST(builder->BuildScopeByProtoSetter(stage_scope, SetSspAttrs));
+    symbol_id = JUST(new_scope->symbol_id());
+    return Maybe<void>::Ok();
+  }));
+  return symbol_id;
+}
+
+// Splits the forward ops placed with the loss into pipeline stages on disjoint ranges of its
+// devices. The ops are cut in topological order into contiguous ranges balancing the estimated or
+// measured compute time, so no stage consumes the outputs of a later stage. The backward ops follow
+// the placements of the forward ops, the forward ops of stage i hold the activations of
+// num_stages - i iterations and, with enable_ssp, so do the variables of the stage.
+class AutoPipelinePass final : public JobPass {
+ public:
+  AutoPipelinePass() = default;
+  ~AutoPipelinePass() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    return ctx.job_desc().IsTrain() && ctx.job_desc().job_conf().auto_pipeline_num_stages() > 1;
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, const JobConfigProto& job_conf,
+                    JobBuilder* job_builder) const;
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, ctx->job_desc().job_conf(), &job_builder);
+  }
+};
+
+Maybe<void> AutoPipelinePass::Apply(const OpGraph& op_graph, const JobConfigProto& job_conf,
+                                    JobBuilder* job_builder) const {
+  const int64_t num_stages = job_conf.auto_pipeline_num_stages();
+  CHECK_GT_OR_RETURN(job_conf.train_conf().loss_lbn_size(), 0);
+  const ParallelDesc pipeline_desc =
+      op_graph.OpNode4OpName(GenLogicalBlobId(job_conf.train_conf().loss_lbn(0)).op_name())
+          ->parallel_desc();
+  CHECK_EQ_OR_RETURN(pipeline_desc.hierarchy()->NumAxes(), 1);
+  CHECK_EQ_OR_RETURN(pipeline_desc.parallel_num() % num_stages, 0)
+      << "the " << pipeline_desc.parallel_num() << " devices of the loss can not be divided into "
+      << num_stages << " stages";
+  const int64_t stage_parallel_num = pipeline_desc.parallel_num() / num_stages;
+  HashMap<std::string, double> op_name2act_time;
+  if (!job_conf.auto_pipeline_op_act_time_file().empty()) {
+    JUST(LoadOpActTimes(job_conf.auto_pipeline_op_act_time_file(), &op_name2act_time));
+  }
+  const double flops_per_sec = job_conf.auto_parallel_device_gflops() * 1e9;
+  CHECK_GT_OR_RETURN(flops_per_sec, 0);
+
+  std::vector<const OpNode*> op_nodes;
+  HashMap<const OpNode*, int64_t> op_node2index;
+  std::vector<OpCost> costs;
+  int64_t num_measured_ops = 0;
+  op_graph.TopoForEachNode([&](const OpNode* op_node) {
+    if (op_node->parallel_desc() != pipeline_desc) { return; }
+    OpCost cost{};
+    const auto it = op_name2act_time.find(op_node->op().op_name());
+    if (it != op_name2act_time.end()) {
+      cost.time = it->second;
+      num_measured_ops += 1;
+    } else {
+      cost.time = EstimateFlops4OpNode(op_node) / flops_per_sec / stage_parallel_num;
+    }
+    for (const std::string& obn : op_node->op().output_bns()) {
+      const BlobDesc& blob_desc = op_node->LogicalBlobDesc4Lbi(op_node->op().BnInOp2Lbi(obn));
+      cost.activation_bytes +=
+          blob_desc.shape().elem_cnt() * GetSizeOfDataType(blob_desc.data_type());
+    }
+    cost.activation_bytes /= stage_parallel_num;
+    op_node2index.emplace(op_node, op_nodes.size());
+    op_nodes.push_back(op_node);
+    costs.push_back(cost);
+  });
+  // the sources, e.g. variables, go along with their first consumer instead of taking a stage
+  std::vector<bool> is_source(op_nodes.size(), true);
+  std::vector<int64_t> chain;
+  std::vector<double> chain_times;
+  FOR_RANGE(size_t, i, 0, op_nodes.size()) {
+    op_nodes.at(i)->ForEachNodeOnInEdge([&](const OpNode* producer) {
+      if (op_node2index.count(producer) > 0) { is_source.at(i) = false; }
+    });
+    if (is_source.at(i)) { continue; }
+    chain.push_back(i);
+    chain_times.push_back(costs.at(i).time);
+  }
+  CHECK_GE_OR_RETURN(chain.size(), num_stages) << "too few ops for " << num_stages << " stages";
+  std::vector<int64_t> stages(op_nodes.size(), num_stages);
+  const std::vector<int64_t> chain_stages = PartitionIntoBalancedStages(chain_times, num_stages);
+  FOR_RANGE(size_t, i, 0, chain.size()) { stages.at(chain.at(i)) = chain_stages.at(i); }
+  FOR_RANGE(size_t, i, 0, op_nodes.size()) {
+    if (!is_source.at(i)) { continue; }
+    op_nodes.at(i)->ForEachNodeOnOutEdge([&](const OpNode* consumer) {
+      const auto it = op_node2index.find(consumer);
+      if (it == op_node2index.end()) { return; }
+      stages.at(i) = std::min(stages.at(i), stages.at(it->second));
+    });
+    if (stages.at(i) == num_stages) { stages.at(i) = 0; }
+  }
+
+  std::vector<StageInfo> stage_infos(num_stages, StageInfo{0, 0, 0, 0});
+  std::vector<ParallelConf> stage_parallel_confs;
+  FOR_RANGE(int64_t, stage_id, 0, num_stages) {
+    stage_infos.at(stage_id).regst_num = num_stages - stage_id;
+    stage_parallel_confs.push_back(*JUST(StageParallelConf(pipeline_desc, num_stages, stage_id)));
+  }
+  HashMap<std::pair<int64_t, int64_t>, int64_t> scope_and_stage2new_scope_symbol_id;
+  std::vector<OperatorConf> op_confs;
+  FOR_RANGE(size_t, i, 0, op_nodes.size()) {
+    const int64_t stage_id = stages.at(i);
+    StageInfo* stage_info = &stage_infos.at(stage_id);
+    stage_info->num_ops += 1;
+    stage_info->time += costs.at(i).time;
+    stage_info->activation_bytes += costs.at(i).activation_bytes * stage_info->regst_num;
+    const OperatorConf& op_conf = op_nodes.at(i)->op().op_conf();
+    job_builder->MutParallelConfOnlyOnce(op_conf.name(), stage_parallel_confs.at(stage_id));
+    if (!op_conf.has_scope_symbol_id()) { continue; }
+    const auto key = std::make_pair(op_conf.scope_symbol_id(), stage_id);
+    auto it = scope_and_stage2new_scope_symbol_id.find(key);
+    if (it == scope_and_stage2new_scope_symbol_id.end()) {
+      const int64_t new_scope_symbol_id = JUST(NewStageScopeSymbolId(
+          op_conf.scope_symbol_id(), stage_parallel_confs.at(stage_id), num_stages, stage_id));
+      it = scope_and_stage2new_scope_symbol_id.emplace(key, new_scope_symbol_id).first;
+    }
+    op_confs.push_back(op_conf);
+    op_confs.back().set_scope_symbol_id(it->second);
+  }
+  job_builder->MutOpsOnlyOnce(op_confs);
+
+  // In the steady state every stage runs once per iteration, the slowest one sets the pace and the
+  // others idle for the rest of it.
+  double max_stage_time = 0;
+  double total_time = 0;
+  for (const StageInfo& stage_info : stage_infos) {
+    max_stage_time = std::max(max_stage_time, stage_info.time);
+    total_time += stage_info.time;
+  }
+  const double bubble_ratio =
+      max_stage_time > 0 ? 1 - total_time / (max_stage_time * num_stages) : 0;
+  LOG(INFO) << "AutoPipelinePass: " << op_nodes.size() << " ops on " << pipeline_desc.device_tag()
+            << " " << pipeline_desc.parallel_num() << " devices into " << num_stages
+            << " stages, " << num_measured_ops << " ops with measured act time";
+  FOR_RANGE(int64_t, stage_id, 0, num_stages) {
+    const StageInfo& stage_info = stage_infos.at(stage_id);
+    std::string devices;
+    for (const std::string& device_name : stage_parallel_confs.at(stage_id).device_name()) {
+      devices += (devices.empty() ? "" : ",") + device_name;
+    }
+    LOG(INFO) << "AutoPipelinePass: stage " << stage_id << " (" << devices << ") "
+              << stage_info.num_ops << " ops, forward time " << stage_info.time * 1e3
+              << "ms, activation " << stage_info.activation_bytes / kMB
+              << "MB per device, regst num " << stage_info.regst_num;
+  }
+  LOG(INFO) << "AutoPipelinePass: estimated forward time per iteration " << max_stage_time * 1e3
+            << "ms, pipeline bubble " << bubble_ratio * 100 << "%";
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_JOB_PASS("AutoPipelinePass", AutoPipelinePass);
+
+}  // namespace oneflow
@@ -17,6 +17,7 @@ limitations under the License.
 #include "oneflow/core/job/job.pb.h"
 #include "oneflow/core/job/scope.h"
 #include "oneflow/core/job_rewriter/calculation_pass.h"
+#include "oneflow/core/job_rewriter/pass_util.h"
 #include "oneflow/core/vm/symbol_storage.h"
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/core/operator/operator.h"
@@ -36,12 +37,15 @@ class CheckpointingPass final : public JobPass {
     if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
     const OpGraph op_graph(*job);
     JobBuilder job_builder(job);
-    return Apply(op_graph, &job_builder);
+    const int64_t memory_budget =
+        ctx->job_desc().job_conf().auto_checkpointing_memory_budget_mbyte() * 1024 * 1024;
+    return Apply(op_graph, &job_builder, memory_budget);
   }
 
   bool IsEnabled(const JobPassCtx& ctx) const { return ctx.job_desc().IsTrain(); }
 
-  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder,
+                    int64_t memory_budget) const;
 };
 
 const std::string kCheckpointingFakeOpNamePrefix = "OneFlow-System-Checkpointing-Fake-Fw-Op_";
@@ -61,27 +65,309 @@ bool IsForwardPass7CheckpointingScope(const Scope& scope) {
   return IsForwardPassScope(scope) && scope.Bool("checkpointing");
 }
 
-void CollectAllCheckpointingOpsInForwardPass(
-    const OpGraph& op_graph, HashMap<std::string, const OpNode*>* checkpointing_op_name2op_node) {
+bool IsForwardPassNode(const OpNode* op_node) {
+  return op_node->op().op_conf().has_scope_symbol_id()
+         && IsForwardPassScope(Scope4OpNode(op_node));
+}
+
+bool IsIgnoredCheckpointingOpTypeName(const std::string& op_type_name) {
   // NOTE(chengcheng):
   //   ignore batch_norm ops because of recompute bn will repeat the calculation of 'm' and 'v'.
   //   in the future, we need to support the recomputation version of batch_norm which do NOT
   //   update forward variables.
-  HashSet<std::string> ignore_op_type_names = {"normalization", "normalization_add_relu",
-                                               "cudnn_fused_normalization_add_relu"};
+  static const HashSet<std::string> ignore_op_type_names = {
+      "normalization", "normalization_add_relu", "cudnn_fused_normalization_add_relu"};
+  return ignore_op_type_names.find(op_type_name) != ignore_op_type_names.end();
+}
+
+void CollectAllCheckpointingOpsInForwardPass(
+    const OpGraph& op_graph, HashMap<std::string, const OpNode*>* checkpointing_op_name2op_node) {
   op_graph.ForEachNode([&](const OpNode* op_node) {
     const OperatorConf& op_conf = op_node->op().op_conf();
     if (!op_conf.has_user_conf()) { return; }
-    if (ignore_op_type_names.find(op_conf.user_conf().op_type_name())
-        != ignore_op_type_names.end()) {
-      return;
-    }
+    if (IsIgnoredCheckpointingOpTypeName(op_conf.user_conf().op_type_name())) { return; }
     if (IsForwardPass7CheckpointingScope(Scope4OpNode(op_node))) {
       CHECK(checkpointing_op_name2op_node->emplace(op_conf.name(), op_node).second);
     }
   });
 }
 
+// Bytes of the outputs of op_node held by one of its devices.
+int64_t OutputBytesPerDevice(const OpNode* op_node) {
+  int64_t bytes = 0;
+  for (const std::string& obn : op_node->op().output_bns()) {
+    const BlobDesc& blob_desc = op_node->LogicalBlobDesc4Lbi(op_node->op().BnInOp2Lbi(obn));
+    int64_t elem_cnt = blob_desc.shape().elem_cnt();
+    for (const SbpParallel& sbp : op_node->ParallelDistribution4BnInOp(obn).sbp_parallel()) {
+      if (sbp.has_split_parallel()) {
+        const int64_t parallel_num = op_node->parallel_desc().parallel_num();
+        elem_cnt = (elem_cnt + parallel_num - 1) / parallel_num;
+        break;
+      }
+    }
+    bytes += elem_cnt * GetSizeOfDataType(blob_desc.data_type());
+  }
+  return bytes;
+}
+
+// Adds a value to a range of positions and keeps the maximum of all positions.
+class RangeAddMaxTree final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(RangeAddMaxTree);
+  explicit RangeAddMaxTree(int64_t size) : size_(size), max_(4 * size, 0), add_(4 * size, 0) {}
+  ~RangeAddMaxTree() = default;
+
+  // Adds value to the positions in [begin, end].
+  void Add(int64_t begin, int64_t end, int64_t value) { Add(1, 0, size_ - 1, begin, end, value); }
+  int64_t Max() const { return max_.at(1); }
+
+ private:
+  void Add(int64_t node, int64_t node_begin, int64_t node_end, int64_t begin, int64_t end,
+           int64_t value) {
+    if (end < node_begin || node_end < begin) { return; }
+    if (begin <= node_begin && node_end <= end) {
+      max_.at(node) += value;
+      add_.at(node) += value;
+      return;
+    }
+    const int64_t mid = (node_begin + node_end) / 2;
+    Add(2 * node, node_begin, mid, begin, end, value);
+    Add(2 * node + 1, mid + 1, node_end, begin, end, value);
+    max_.at(node) = std::max(max_.at(2 * node), max_.at(2 * node + 1)) + add_.at(node);
+  }
+
+  const int64_t size_;
+  std::vector<int64_t> max_;
+  std::vector<int64_t> add_;
+};
+
+// Estimates the peak memory of one device by the lifetimes of op outputs in topological order:
+// an output lives from its producer to its last consumer and variables live all the time. For a
+// recomputed op, the backward consumers read a copy which lives from right before the first of
+// them, and the original output is released after its last forward consumer. Inputs of the copy
+// have to live until it is recomputed.
+// Recomputing one more op only changes the lifetimes around it, so they are updated in place and
+// the peak is kept by a RangeAddMaxTree.
+class CheckpointingMemoryEstimator final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CheckpointingMemoryEstimator);
+  CheckpointingMemoryEstimator(const OpGraph& op_graph,
+                               const HashSet<const OpNode*>& recomputed_op_nodes)
+      : recomputed_op_nodes_(recomputed_op_nodes) {
+    op_graph.TopoForEachNode([&](const OpNode* op_node) {
+      op_node2order_.emplace(op_node, ordered_op_nodes_.size());
+      ordered_op_nodes_.push_back(op_node);
+      op_node2bytes_.emplace(op_node, OutputBytesPerDevice(op_node));
+      op_node2is_forward_.emplace(op_node, IsForwardPassNode(op_node));
+    });
+    bytes_tree_.reset(new RangeAddMaxTree(std::max<int64_t>(ordered_op_nodes_.size(), 1)));
+    for (auto it = ordered_op_nodes_.crbegin(); it != ordered_op_nodes_.crend(); ++it) {
+      if (IsRecomputed(*it)) { UpdateRecomputedLifetime(*it); }
+    }
+    for (const OpNode* op_node : ordered_op_nodes_) { UpdateLifetimes(op_node); }
+  }
+  ~CheckpointingMemoryEstimator() = default;
+
+  int64_t Order4OpNode(const OpNode* op_node) const { return op_node2order_.at(op_node); }
+  bool IsForward(const OpNode* op_node) const { return op_node2is_forward_.at(op_node); }
+  int64_t PeakBytes() const { return std::max<int64_t>(bytes_tree_->Max(), 0); }
+
+  void SetRecomputed(const OpNode* op_node, bool is_recomputed) {
+    if (is_recomputed) {
+      recomputed_op_nodes_.insert(op_node);
+      UpdateRecomputedLifetime(op_node);
+    } else {
+      recomputed_op_nodes_.erase(op_node);
+      op_node2recomputed_lifetime_.erase(op_node);
+    }
+    // the copies of the recomputed producers have to live until this one is recomputed
+    HashSet<const OpNode*> changed_op_nodes = {op_node};
+    std::vector<const OpNode*> stack = {op_node};
+    while (!stack.empty()) {
+      const OpNode* cur = stack.back();
+      stack.pop_back();
+      cur->ForEachNodeOnInEdge([&](const OpNode* producer) {
+        if (!IsRecomputed(producer) || !UpdateRecomputedLifetime(producer)) { return; }
+        if (changed_op_nodes.insert(producer).second) { stack.push_back(producer); }
+      });
+    }
+    HashSet<const OpNode*> updated_op_nodes;
+    auto TryUpdateLifetimes = [&](const OpNode* node) {
+      if (updated_op_nodes.insert(node).second) { UpdateLifetimes(node); }
+    };
+    for (const OpNode* changed : changed_op_nodes) {
+      TryUpdateLifetimes(changed);
+      changed->ForEachNodeOnInEdge(TryUpdateLifetimes);
+    }
+  }
+
+ private:
+  struct Lifetime {
+    int64_t begin;
+    int64_t end;
+    int64_t bytes;
+  };
+
+  bool IsRecomputed(const OpNode* op_node) const {
+    return recomputed_op_nodes_.find(op_node) != recomputed_op_nodes_.end();
+  }
+
+  // [begin, end] of the recomputed copy, end < 0 if nothing reads the copy. Returns whether it
+  // changed.
+  bool UpdateRecomputedLifetime(const OpNode* op_node) {
+    int64_t begin = ordered_op_nodes_.size();
+    int64_t end = -1;
+    op_node->ForEachNodeOnOutEdge([&](const OpNode* consumer) {
+      if (!IsForward(consumer)) {
+        begin = std::min(begin, Order4OpNode(consumer) - 1);
+        end = std::max(end, Order4OpNode(consumer));
+      } else if (IsRecomputed(consumer)) {
+        const auto& lifetime = op_node2recomputed_lifetime_.at(consumer);
+        if (lifetime.second < 0) { return; }
+        begin = std::min(begin, lifetime.first);
+        end = std::max(end, lifetime.first);
+      }
+    });
+    const auto lifetime = std::make_pair(begin, end);
+    const auto it = op_node2recomputed_lifetime_.find(op_node);
+    if (it != op_node2recomputed_lifetime_.end() && it->second == lifetime) { return false; }
+    op_node2recomputed_lifetime_[op_node] = lifetime;
+    return true;
+  }
+
+  // Replaces the lifetimes of the outputs of op_node in bytes_tree_.
+  void UpdateLifetimes(const OpNode* op_node) {
+    std::vector<Lifetime>* lifetimes = &op_node2lifetimes_[op_node];
+    for (const Lifetime& lifetime : *lifetimes) {
+      bytes_tree_->Add(lifetime.begin, lifetime.end, -lifetime.bytes);
+    }
+    lifetimes->clear();
+    const int64_t bytes = op_node2bytes_.at(op_node);
+    if (bytes == 0) { return; }
+    if (op_node->op().op_conf().has_variable_conf()) {
+      lifetimes->push_back(Lifetime{0, static_cast<int64_t>(ordered_op_nodes_.size()) - 1, bytes});
+    } else {
+      const bool is_recomputed = IsRecomputed(op_node);
+      const int64_t begin = Order4OpNode(op_node);
+      int64_t end = begin;
+      op_node->ForEachNodeOnOutEdge([&](const OpNode* consumer) {
+        if (is_recomputed && !IsForward(consumer)) { return; }
+        end = std::max(end, Order4OpNode(consumer));
+        const auto it = op_node2recomputed_lifetime_.find(consumer);
+        if (!is_recomputed && it != op_node2recomputed_lifetime_.end() && it->second.second >= 0) {
+          end = std::max(end, it->second.first);
+        }
+      });
+      lifetimes->push_back(Lifetime{begin, end, bytes});
+      if (is_recomputed) {
+        const auto& lifetime = op_node2recomputed_lifetime_.at(op_node);
+        if (lifetime.second >= 0) {
+          lifetimes->push_back(Lifetime{lifetime.first, lifetime.second, bytes});
+        }
+      }
+    }
+    for (const Lifetime& lifetime : *lifetimes) {
+      bytes_tree_->Add(lifetime.begin, lifetime.end, lifetime.bytes);
+    }
+  }
+
+  std::vector<const OpNode*> ordered_op_nodes_;
+  HashMap<const OpNode*, int64_t> op_node2order_;
+  HashMap<const OpNode*, int64_t> op_node2bytes_;
+  HashMap<const OpNode*, bool> op_node2is_forward_;
+  HashSet<const OpNode*> recomputed_op_nodes_;
+  HashMap<const OpNode*, std::pair<int64_t, int64_t>> op_node2recomputed_lifetime_;
+  HashMap<const OpNode*, std::vector<Lifetime>> op_node2lifetimes_;
+  std::unique_ptr<RangeAddMaxTree> bytes_tree_;
+};
+
+// Chooses forward ops to recompute until the estimated peak memory fits in memory_budget. The
+// candidates are visited in the order of the bytes they keep alive between forward and backward
+// per recomputed operation, and a candidate is kept only if it lowers the estimated peak, so cheap
+// ops with large outputs stored for a long time are recomputed first.
+void CollectAutoCheckpointingOps(
+    const OpGraph& op_graph, int64_t memory_budget,
+    HashMap<std::string, const OpNode*>* checkpointing_op_name2op_node) {
+  HashSet<const OpNode*> recomputed_op_nodes;
+  for (const auto& pair : *checkpointing_op_name2op_node) {
+    recomputed_op_nodes.insert(pair.second);
+  }
+  CheckpointingMemoryEstimator estimator(op_graph, recomputed_op_nodes);
+
+  struct Candidate {
+    const OpNode* op_node;
+    int64_t flops;
+    double score;
+  };
+  std::vector<Candidate> candidates;
+  int64_t forward_flops = 0;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    const OperatorConf& op_conf = op_node->op().op_conf();
+    if (!op_conf.has_user_conf() || !estimator.IsForward(op_node)) { return; }
+    const int64_t flops = EstimateFlops4OpNode(op_node);
+    forward_flops += flops;
+    if (recomputed_op_nodes.find(op_node) != recomputed_op_nodes.end()) { return; }
+    const std::string& op_type_name = op_conf.user_conf().op_type_name();
+    if (IsIgnoredCheckpointingOpTypeName(op_type_name)
+        || IsNondeterministicOpTypeName(op_type_name)) {
+      return;
+    }
+    if (op_node->op().input_bns().empty() || op_node->op().output_bns().empty()) { return; }
+    for (const std::string& ibn : op_node->op().input_bns()) {
+      if (op_node->op().InputBlobModifier4Ibn(ibn).is_mutable()) { return; }
+    }
+    int64_t last_forward_order = estimator.Order4OpNode(op_node);
+    int64_t first_backward_order = std::numeric_limits<int64_t>::max();
+    op_node->ForEachNodeOnOutEdge([&](const OpNode* consumer) {
+      const int64_t order = estimator.Order4OpNode(consumer);
+      if (estimator.IsForward(consumer)) {
+        last_forward_order = std::max(last_forward_order, order);
+      } else {
+        first_backward_order = std::min(first_backward_order, order);
+      }
+    });
+    if (first_backward_order == std::numeric_limits<int64_t>::max()) { return; }
+    const double stored_bytes = static_cast<double>(OutputBytesPerDevice(op_node))
+                                * std::max<int64_t>(first_backward_order - last_forward_order, 1);
+    candidates.push_back(Candidate{op_node, flops, stored_bytes / std::max<int64_t>(flops, 1)});
+  });
+  std::sort(candidates.begin(), candidates.end(), [](const Candidate& lhs, const Candidate& rhs) {
+    if (lhs.score != rhs.score) { return lhs.score > rhs.score; }
+    return lhs.op_node->op().op_name() < rhs.op_node->op().op_name();
+  });
+
+  const int64_t original_peak_bytes = estimator.PeakBytes();
+  int64_t peak_bytes = original_peak_bytes;
+  int64_t recomputed_flops = 0;
+  int64_t num_recomputed_ops = 0;
+  for (const Candidate& candidate : candidates) {
+    if (peak_bytes <= memory_budget) { break; }
+    estimator.SetRecomputed(candidate.op_node, true);
+    const int64_t new_peak_bytes = estimator.PeakBytes();
+    if (new_peak_bytes < peak_bytes) {
+      peak_bytes = new_peak_bytes;
+      recomputed_flops += candidate.flops;
+      num_recomputed_ops += 1;
+      CHECK(checkpointing_op_name2op_node
+                ->emplace(candidate.op_node->op().op_name(), candidate.op_node)
+                .second);
+    } else {
+      estimator.SetRecomputed(candidate.op_node, false);
+    }
+  }
+  const double kMByte = 1024.0 * 1024.0;
+  LOG(INFO) << "auto checkpointing recomputes " << num_recomputed_ops
+            << " forward ops, estimated peak memory per device " << original_peak_bytes / kMByte
+            << " MB -> " << peak_bytes / kMByte << " MB (budget " << memory_budget / kMByte
+            << " MB), extra computation " << recomputed_flops << " flops ("
+            << 100.0 * recomputed_flops / std::max<int64_t>(forward_flops, 1)
+            << "% of forward pass)";
+  if (peak_bytes > memory_budget) {
+    LOG(WARNING) << "auto checkpointing can not fit the job into the memory budget of "
+                 << memory_budget / kMByte << " MB";
+  }
+}
+
 void GenConnectedCheckpointingSubgraphs(
     const HashMap<std::string, const OpNode*>& checkpointing_op_name2op_node,
     std::vector<HashSet<const OpNode*>>* checkpointing_subgraphs) {
@@ -119,10 +405,14 @@ void GenConnectedCheckpointingSubgraphs(
   }
 }
 
-Maybe<void> CheckpointingPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+Maybe<void> CheckpointingPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder,
+                                     int64_t memory_budget) const {
   // step 1. collect all checkpointing ops in forwardpass.
   HashMap<std::string, const OpNode*> checkpointing_op_name2op_node;
   CollectAllCheckpointingOpsInForwardPass(op_graph, &checkpointing_op_name2op_node);
+  if (memory_budget > 0) {
+    CollectAutoCheckpointingOps(op_graph, memory_budget, &checkpointing_op_name2op_node);
+  }
   if (checkpointing_op_name2op_node.empty()) { return Maybe<void>::Ok(); }
 
   // step 2. get all connected subgraphs in checkpointing ops.
@@ -0,0 +1,131 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/job_rewriter/pass_util.h"
+
+namespace oneflow {
+
+namespace {
+
+class CommonSubexpressionEliminationPass final : public JobPass {
+ public:
+  CommonSubexpressionEliminationPass() = default;
+  ~CommonSubexpressionEliminationPass() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    return ctx.job_desc().job_conf().enable_common_subexpression_elimination();
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, &job_builder);
+  }
+};
+
+// Two user ops are the same expression when they have the same op type, attrs, placement and
+// (after replacing the inputs read from removed ops) the same inputs. Ops are visited in
+// topological order, so chains of duplicated ops collapse in a single run. Every duplicate is
+// removed and its consumers read the outputs of the first op instead.
+Maybe<void> CommonSubexpressionEliminationPass::Apply(const OpGraph& op_graph,
+                                                      JobBuilder* job_builder) const {
+  HashSet<std::string> ctrl_in_op_names;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    for (const std::string& ctrl_in_op_name : op_node->op().op_conf().ctrl_in_op_name()) {
+      ctrl_in_op_names.insert(ctrl_in_op_name);
+    }
+  });
+  const TrainConf& train_conf = job_builder->job().job_conf().train_conf();
+  const HashSet<std::string> loss_lbns(train_conf.loss_lbn().cbegin(),
+                                       train_conf.loss_lbn().cend());
+
+  HashMap<std::string, std::string> old_lbn2new_lbn;
+  auto NewLbn4Lbn = [&](const std::string& lbn) -> std::string {
+    const auto it = old_lbn2new_lbn.find(lbn);
+    return it == old_lbn2new_lbn.end() ? lbn : it->second;
+  };
+  HashMap<std::string, const OpNode*> key2node;
+  std::vector<std::string> del_op_names;
+  op_graph.TopoForEachNode([&](const OpNode* node) {
+    const OperatorConf& op_conf = node->op().op_conf();
+    if (!op_conf.has_user_conf()) { return; }
+    if (!op_conf.ctrl_in_op_name().empty()) { return; }
+    if (IsKeyFound(ctrl_in_op_names, op_conf.name())) { return; }
+    if (node->op().input_bns().empty() || node->op().output_bns().empty()) { return; }
+    if (IsNondeterministicOpTypeName(op_conf.user_conf().op_type_name())) { return; }
+    for (const std::string& ibn : node->op().input_bns()) {
+      if (node->op().InputBlobModifier4Ibn(ibn).is_mutable()) { return; }
+    }
+    for (const std::string& obn : node->op().output_bns()) {
+      if (IsKeyFound(loss_lbns, GenLogicalBlobName(node->op().BnInOp2Lbi(obn)))) { return; }
+    }
+    OperatorConf key_conf(op_conf);
+    key_conf.clear_name();
+    key_conf.clear_scope_symbol_id();
+    UserOpConf* user_conf = key_conf.mutable_user_conf();
+    for (auto& pair : *user_conf->mutable_input()) {
+      for (std::string& lbn : *pair.second.mutable_s()) { lbn = NewLbn4Lbn(lbn); }
+    }
+    for (auto& pair : *user_conf->mutable_output()) {
+      for (std::string& lbn : *pair.second.mutable_s()) { lbn.clear(); }
+    }
+    // text format prints map entries ordered by key, so equal confs give equal strings
+    const std::string key = PbMessage2TxtString(key_conf)
+                            + PbMessage2TxtString(node->parallel_desc().parallel_conf());
+    const auto it = key2node.find(key);
+    if (it == key2node.end()) {
+      key2node.emplace(key, node);
+      return;
+    }
+    const OpNode* kept = it->second;
+    for (const std::string& obn : node->op().output_bns()) {
+      old_lbn2new_lbn.emplace(GenLogicalBlobName(node->op().BnInOp2Lbi(obn)),
+                              GenLogicalBlobName(kept->op().BnInOp2Lbi(obn)));
+    }
+    del_op_names.push_back(op_conf.name());
+  });
+  if (del_op_names.empty()) { return Maybe<void>::Ok(); }
+
+  HashMap<std::string, OperatorConf> op_name2op_conf;
+  const HashSet<std::string> del_op_name_set(del_op_names.cbegin(), del_op_names.cend());
+  op_graph.ForEachNode([&](const OpNode* node) {
+    const std::string& op_name = node->op().op_name();
+    if (IsKeyFound(del_op_name_set, op_name)) { return; }
+    for (const std::string& ibn : node->op().input_bns()) {
+      const std::string lbn = GenLogicalBlobName(node->op().BnInOp2Lbi(ibn));
+      if (!IsKeyFound(old_lbn2new_lbn, lbn)) { continue; }
+      if (!IsKeyFound(op_name2op_conf, op_name)) {
+        op_name2op_conf.emplace(op_name, node->op().op_conf());
+      }
+      ReplaceInputLbnInOpCustomizedConf(&op_name2op_conf.at(op_name), ibn,
+                                        old_lbn2new_lbn.at(lbn));
+    }
+  });
+  for (const auto& pair : op_name2op_conf) { job_builder->MutOpsOnlyOnce({pair.second}); }
+  job_builder->DelOps(del_op_names);
+  LOG(INFO) << "CommonSubexpressionEliminationPass removed " << del_op_names.size()
+            << " duplicated ops";
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_JOB_PASS("CommonSubexpressionEliminationPass", CommonSubexpressionEliminationPass);
+
+}  // namespace oneflow
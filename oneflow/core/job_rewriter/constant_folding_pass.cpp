@@ -0,0 +1,235 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/job_rewriter/pass_util.h"
+
+namespace oneflow {
+
+namespace {
+
+// The value of a blob whose elements are all the same, which is what a constant op produces.
+struct ConstantValue {
+  bool is_floating_value;
+  double floating_value;
+  int64_t integer_value;
+
+  double AsDouble() const {
+    return is_floating_value ? floating_value : static_cast<double>(integer_value);
+  }
+  int64_t AsInt64() const {
+    return is_floating_value ? static_cast<int64_t>(floating_value) : integer_value;
+  }
+};
+
+ConstantValue MakeConstantValue(DataType data_type, double floating_value, int64_t integer_value) {
+  ConstantValue value{};
+  value.is_floating_value = IsFloatingDataType(data_type);
+  if (value.is_floating_value) {
+    value.floating_value = floating_value;
+  } else {
+    value.integer_value = integer_value;
+  }
+  return value;
+}
+
+bool IsFoldableDataType(DataType data_type) {
+  return data_type == DataType::kFloat || data_type == DataType::kDouble
+         || data_type == DataType::kInt8 || data_type == DataType::kInt32
+         || data_type == DataType::kInt64;
+}
+
+const HashSet<std::string>& ShapeOnlyOpTypeNames() {
+  static const HashSet<std::string> op_type_names = {"identity",    "reshape", "reshape_like",
+                                                     "expand_dims", "squeeze", "flatten"};
+  return op_type_names;
+}
+
+// Evaluates the output of `conf` from the constant values of its inputs, returns false if the op
+// is not foldable or some of its inputs are not constant.
+bool InferConstantValue(const user_op::UserOpConfWrapper& conf, DataType out_data_type,
+                        const HashMap<std::string, ConstantValue>& lbn2value,
+                        ConstantValue* value) {
+  const std::string& op_type_name = conf.op_type_name();
+  auto GetInput = [&](const std::string& arg_name, int32_t index) -> const ConstantValue* {
+    const auto it = lbn2value.find(conf.input(arg_name, index));
+    return it == lbn2value.end() ? nullptr : &it->second;
+  };
+  if (op_type_name == "constant") {
+    if (conf.attr<bool>("is_floating_value") != IsFloatingDataType(out_data_type)) {
+      return false;
+    }
+    *value = MakeConstantValue(out_data_type, conf.attr<double>("floating_value"),
+                               conf.attr<int64_t>("integer_value"));
+  } else if (ShapeOnlyOpTypeNames().count(op_type_name) > 0) {
+    // reshape_like only reads the shape of "like", which needs not to be constant
+    const ConstantValue* in = GetInput("in", 0);
+    if (in == nullptr) { return false; }
+    *value = *in;
+  } else if (op_type_name == "cast") {
+    const ConstantValue* in = GetInput("in", 0);
+    if (in == nullptr) { return false; }
+    *value = MakeConstantValue(out_data_type, in->AsDouble(), in->AsInt64());
+  } else if (op_type_name == "scalar_add" || op_type_name == "scalar_mul") {
+    const ConstantValue* in = GetInput("in", 0);
+    if (in == nullptr) { return false; }
+    const bool is_add = op_type_name == "scalar_add";
+    if (conf.attr<bool>("has_float_operand")) {
+      const double operand = conf.attr<double>("float_operand");
+      const double result = is_add ? in->AsDouble() + operand : in->AsDouble() * operand;
+      *value = MakeConstantValue(out_data_type, result, static_cast<int64_t>(result));
+    } else {
+      const int64_t operand = conf.attr<int64_t>("int_operand");
+      *value = MakeConstantValue(out_data_type,
+                                 is_add ? in->AsDouble() + operand : in->AsDouble() * operand,
+                                 is_add ? in->AsInt64() + operand : in->AsInt64() * operand);
+    }
+  } else if (op_type_name == "add_n" || op_type_name == "multiply") {
+    const bool is_add = op_type_name == "add_n";
+    const std::string arg_name = is_add ? "in" : "x";
+    std::vector<const ConstantValue*> args;
+    FOR_RANGE(int32_t, i, 0, conf.input_size(arg_name)) { args.push_back(GetInput(arg_name, i)); }
+    if (!is_add) { args.push_back(GetInput("y", 0)); }
+    double floating_value = is_add ? 0 : 1;
+    int64_t integer_value = is_add ? 0 : 1;
+    for (const ConstantValue* arg : args) {
+      if (arg == nullptr) { return false; }
+      floating_value = is_add ? floating_value + arg->AsDouble() : floating_value * arg->AsDouble();
+      integer_value = is_add ? integer_value + arg->AsInt64() : integer_value * arg->AsInt64();
+    }
+    *value = MakeConstantValue(out_data_type, floating_value, integer_value);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+class ConstantFoldingPass final : public JobPass {
+ public:
+  ConstantFoldingPass() = default;
+  ~ConstantFoldingPass() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    return ctx.job_desc().job_conf().enable_constant_folding();
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, &job_builder);
+  }
+};
+
+// Every op whose output only depends on constant ops through shape and elementwise arithmetic ops
+// is replaced by a constant op of the same name, so its consumers keep reading the same lbn. Since
+// the constant kernel fills its output only once, the folded subgraph costs nothing per iteration.
+// Constant producers left without any consumer are removed.
+Maybe<void> ConstantFoldingPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+  HashSet<std::string> ctrl_in_op_names;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    for (const std::string& ctrl_in_op_name : op_node->op().op_conf().ctrl_in_op_name()) {
+      ctrl_in_op_names.insert(ctrl_in_op_name);
+    }
+  });
+  const TrainConf& train_conf = job_builder->job().job_conf().train_conf();
+  const HashSet<std::string> loss_lbns(train_conf.loss_lbn().cbegin(),
+                                       train_conf.loss_lbn().cend());
+
+  HashMap<std::string, ConstantValue> lbn2value;
+  std::vector<const OpNode*> folded_nodes;
+  op_graph.TopoForEachNode([&](const OpNode* node) {
+    const OperatorConf& op_conf = node->op().op_conf();
+    if (!op_conf.has_user_conf()) { return; }
+    if (!op_conf.ctrl_in_op_name().empty()) { return; }
+    if (IsKeyFound(ctrl_in_op_names, op_conf.name())) { return; }
+    if (node->op().output_bns().size() != 1) { return; }
+    const std::string& obn = node->op().SoleObn();
+    // the shape attr of a mirrored constant op is the shape of each piece, not the logical one
+    if (CHECK_JUST(node->op().OptMirroredParallel4BnInOp(obn))->has_mirrored_parallel()) { return; }
+    const LogicalBlobId& out_lbi = node->op().BnInOp2Lbi(obn);
+    const BlobDesc& out = node->LogicalBlobDesc4Lbi(out_lbi);
+    if (out.is_dynamic() || !IsFoldableDataType(out.data_type())) { return; }
+    const user_op::UserOpConfWrapper conf(op_conf);
+    ConstantValue value{};
+    if (!InferConstantValue(conf, out.data_type(), lbn2value, &value)) { return; }
+    lbn2value.emplace(GenLogicalBlobName(out_lbi), value);
+    if (conf.op_type_name() != "constant") { folded_nodes.push_back(node); }
+  });
+  if (folded_nodes.empty()) { return Maybe<void>::Ok(); }
+
+  // a folded op does not read its inputs any more, so a producer whose consumers are all folded
+  // can be removed, as long as it is itself constant (either folded or a constant op). Other
+  // producers, e.g. the "like" input of a folded reshape_like, are kept untouched.
+  const HashSet<const OpNode*> folded_node_set(folded_nodes.cbegin(), folded_nodes.cend());
+  auto IsRemovable = [&](const OpNode* node) -> bool {
+    if (node->out_edges().empty()) { return false; }
+    for (const std::string& obn : node->op().output_bns()) {
+      const std::string lbn = GenLogicalBlobName(node->op().BnInOp2Lbi(obn));
+      if (!IsKeyFound(lbn2value, lbn) || IsKeyFound(loss_lbns, lbn)) { return false; }
+    }
+    for (const OpEdge* out_edge : node->out_edges()) {
+      if (!IsKeyFound(folded_node_set, out_edge->dst_node())) { return false; }
+    }
+    return true;
+  };
+
+  HashSet<std::string> del_op_names;
+  std::vector<OperatorConf> constant_op_confs;
+  for (const OpNode* node : folded_nodes) {
+    for (const OpEdge* in_edge : node->in_edges()) {
+      const OpNode* producer = in_edge->src_node();
+      if (!IsKeyFound(folded_node_set, producer) && IsRemovable(producer)) {
+        del_op_names.insert(producer->op().op_name());
+      }
+    }
+    if (IsRemovable(node)) {
+      del_op_names.insert(node->op().op_name());
+      continue;
+    }
+    const LogicalBlobId& out_lbi = node->op().BnInOp2Lbi(node->op().SoleObn());
+    const BlobDesc& out = node->LogicalBlobDesc4Lbi(out_lbi);
+    const ConstantValue& value = lbn2value.at(GenLogicalBlobName(out_lbi));
+    const auto constant_op = user_op::UserOpConfWrapperBuilder(node->op().op_name())
+                                 .Op("constant")
+                                 .Output("out")
+                                 .Attr<double>("floating_value", value.floating_value)
+                                 .Attr<int64_t>("integer_value", value.integer_value)
+                                 .Attr<bool>("is_floating_value", value.is_floating_value)
+                                 .Attr<DataType>("dtype", out.data_type())
+                                 .Attr<Shape>("shape", out.shape())
+                                 .ScopeSymbolId(node->op().op_conf().scope_symbol_id())
+                                 .Build();
+    CHECK_EQ_OR_RETURN(GenLogicalBlobName(out_lbi),
+                       GenLogicalBlobName(node->op().op_name(), "out_0"));
+    constant_op_confs.push_back(constant_op.op_conf());
+  }
+  if (!constant_op_confs.empty()) { job_builder->MutOpsOnlyOnce(constant_op_confs); }
+  if (!del_op_names.empty()) {
+    job_builder->DelOps(std::vector<std::string>(del_op_names.cbegin(), del_op_names.cend()));
+  }
+  LOG(INFO) << "ConstantFoldingPass folded " << folded_nodes.size() << " ops into "
+            << constant_op_confs.size() << " constant ops and removed " << del_op_names.size()
+            << " ops";
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_JOB_PASS("ConstantFoldingPass", ConstantFoldingPass);
+
+}  // namespace oneflow
@@ -0,0 +1,340 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/job_rewriter/pass_util.h"
+#include "oneflow/user/ops/math_binary_elementwise_seq.h"
+#include "oneflow/user/ops/math_unary_elementwise_seq.h"
+
+namespace oneflow {
+
+namespace {
+
+// One elementwise op as seen by the fused_elementwise kernel, ops with more than two inputs
+// (add_n) are folded left by repeating the instruction.
+struct ElementwiseOpSpec {
+  std::string instruction;
+  std::vector<std::string> input_lbns;
+  std::vector<int64_t> input_inner_sizes;
+  std::string output_lbn;
+  // kept in double until the data type is known, the fused op stores the scalars as float
+  double scalar = 0;
+};
+
+#define MAKE_OP_TYPE_NAME(op_type_name, func_prefix) op_type_name,
+
+const HashSet<std::string>& MathUnaryOpTypeNames() {
+  static const HashSet<std::string> op_type_names = {
+      OF_PP_FOR_EACH_TUPLE(MAKE_OP_TYPE_NAME, MATH_UNARY_ELEMENTWISE_FUNC_SEQ)};
+  return op_type_names;
+}
+
+const HashSet<std::string>& MathBinaryOpTypeNames() {
+  static const HashSet<std::string> op_type_names = {
+      OF_PP_FOR_EACH_TUPLE(MAKE_OP_TYPE_NAME, MATH_BINARY_ELEMENTWISE_FUNC_SEQ)};
+  return op_type_names;
+}
+
+#undef MAKE_OP_TYPE_NAME
+
+const HashMap<std::string, std::string>& BroadcastOpType2Instruction() {
+  static const HashMap<std::string, std::string> op_type2instruction = {
+      {"broadcast_add", "add"},
+      {"broadcast_sub", "sub"},
+      {"broadcast_mul", "mul"},
+      {"broadcast_div", "div"},
+      {"multiply", "mul"}};
+  return op_type2instruction;
+}
+
+bool GetElementwiseOpSpec(const OpNode* node, ElementwiseOpSpec* spec) {
+  if (node->parallel_desc().device_type() != DeviceType::kCPU) { return false; }
+  if (!node->op().op_conf().has_user_conf()) { return false; }
+  const user_op::UserOpConfWrapper conf(node->op().op_conf());
+  const std::string& op_type_name = conf.op_type_name();
+  auto SetInputs = [&](const std::string& arg_name) {
+    FOR_RANGE(int32_t, i, 0, conf.input_size(arg_name)) {
+      spec->input_lbns.push_back(conf.input(arg_name, i));
+      spec->input_inner_sizes.push_back(1);
+    }
+  };
+  if (MathUnaryOpTypeNames().count(op_type_name) > 0) {
+    spec->instruction = op_type_name;
+    SetInputs("x");
+    spec->output_lbn = conf.output("y", 0);
+  } else if (op_type_name == "relu" || op_type_name == "gelu" || op_type_name == "sigmoid") {
+    spec->instruction = op_type_name;
+    SetInputs("in");
+    spec->output_lbn = conf.output("out", 0);
+  } else if (op_type_name == "scalar_add" || op_type_name == "scalar_mul") {
+    spec->instruction = op_type_name;
+    spec->scalar = conf.attr<bool>("has_float_operand") ? conf.attr<double>("float_operand")
+                                                        : conf.attr<int64_t>("int_operand");
+    SetInputs("in");
+    spec->output_lbn = conf.output("out", 0);
+  } else if (op_type_name == "add_n") {
+    spec->instruction = "add";
+    SetInputs("in");
+    spec->output_lbn = conf.output("out", 0);
+  } else if (IsKeyFound(BroadcastOpType2Instruction(), op_type_name)) {
+    // only the same-shape case of broadcast ops, checked below
+    spec->instruction = BroadcastOpType2Instruction().at(op_type_name);
+    SetInputs("x");
+    SetInputs("y");
+    spec->output_lbn = conf.output(op_type_name == "multiply" ? "out" : "z", 0);
+  } else if (MathBinaryOpTypeNames().count(op_type_name) > 0) {
+    spec->instruction = op_type_name;
+    SetInputs("x");
+    SetInputs("y");
+    spec->output_lbn = conf.output("z", 0);
+  } else if (op_type_name == "bias_add") {
+    // the fused op is split along axis 0, so the bias has to repeat within one row
+    const int32_t axis = conf.attr<int32_t>("axis");
+    if (axis < 1) { return false; }
+    spec->instruction = "add";
+    SetInputs("a");
+    spec->input_lbns.push_back(conf.input("b", 0));
+    spec->input_inner_sizes.push_back(
+        node->LogicalBlobDesc4Lbi(GenLogicalBlobId(conf.input("a", 0))).shape().Count(axis + 1));
+    spec->output_lbn = conf.output("out", 0);
+  } else if (op_type_name == "dropout") {
+    if (conf.has_input("_add_to_output", 0)) { return false; }
+    spec->instruction = "dropout";
+    spec->scalar = conf.attr<float>("scale");
+    SetInputs("in");
+    SetInputs("mask");
+    spec->output_lbn = conf.output("out", 0);
+  } else {
+    return false;
+  }
+  const BlobDesc& out = node->LogicalBlobDesc4Lbi(GenLogicalBlobId(spec->output_lbn));
+  if (out.data_type() != DataType::kFloat && out.data_type() != DataType::kDouble) {
+    return false;
+  }
+  if (out.is_dynamic()) { return false; }
+  // a double op keeps its scalar in full precision unless the scalar is exact in float
+  if (out.data_type() == DataType::kDouble
+      && static_cast<double>(static_cast<float>(spec->scalar)) != spec->scalar) {
+    return false;
+  }
+  FOR_RANGE(size_t, i, 0, spec->input_lbns.size()) {
+    const BlobDesc& in = node->LogicalBlobDesc4Lbi(GenLogicalBlobId(spec->input_lbns.at(i)));
+    if (spec->input_inner_sizes.at(i) == 1 && in.shape() != out.shape()) { return false; }
+    if (in.data_type() != out.data_type()
+        && !(spec->instruction == "dropout" && in.data_type() == DataType::kInt8)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+class FuseElementwiseOpsPass final : public JobPass {
+ public:
+  FuseElementwiseOpsPass() = default;
+  ~FuseElementwiseOpsPass() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    return ctx.job_desc().job_conf().enable_fuse_elementwise_ops();
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, &job_builder);
+  }
+};
+
+// Every op whose only consumer is a compatible elementwise op is fused into that consumer, so a
+// group is a tree of elementwise ops whose intermediate results are not read anywhere else. The
+// root of the tree is replaced by a fused_elementwise op of the same name.
+Maybe<void> FuseElementwiseOpsPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+  HashSet<std::string> ctrl_in_op_names;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    for (const std::string& ctrl_in_op_name : op_node->op().op_conf().ctrl_in_op_name()) {
+      ctrl_in_op_names.insert(ctrl_in_op_name);
+    }
+  });
+  HashMap<const OpNode*, ElementwiseOpSpec> node2spec;
+  op_graph.ForEachNode([&](const OpNode* node) {
+    if (!node->op().op_conf().ctrl_in_op_name().empty()) { return; }
+    if (IsKeyFound(ctrl_in_op_names, node->op().op_name())) { return; }
+    ElementwiseOpSpec spec;
+    if (GetElementwiseOpSpec(node, &spec)) { node2spec.emplace(node, spec); }
+  });
+  auto IsFusedIntoConsumer = [&](const OpNode* node) -> bool {
+    if (node->out_edges().size() != 1) { return false; }
+    const OpNode* consumer = node->SoleOutEdge()->dst_node();
+    if (!IsKeyFound(node2spec, consumer)) { return false; }
+    if (consumer->parallel_desc() != node->parallel_desc()) { return false; }
+    const ElementwiseOpSpec& spec = node2spec.at(node);
+    const ElementwiseOpSpec& consumer_spec = node2spec.at(consumer);
+    FOR_RANGE(size_t, i, 0, consumer_spec.input_lbns.size()) {
+      if (consumer_spec.input_lbns.at(i) == spec.output_lbn
+          && consumer_spec.input_inner_sizes.at(i) != 1) {
+        return false;
+      }
+    }
+    const BlobDesc& out = node->LogicalBlobDesc4Lbi(GenLogicalBlobId(spec.output_lbn));
+    const BlobDesc& consumer_out =
+        consumer->LogicalBlobDesc4Lbi(GenLogicalBlobId(consumer_spec.output_lbn));
+    return out.shape() == consumer_out.shape() && out.data_type() == consumer_out.data_type();
+  };
+
+  HashMap<const OpNode*, std::vector<const OpNode*>> root2members;
+  HashSet<std::string> fused_op_names;
+  for (const auto& pair : node2spec) {
+    if (IsFusedIntoConsumer(pair.first)) { continue; }
+    std::vector<const OpNode*> members{pair.first};
+    FOR_RANGE(size_t, i, 0, members.size()) {
+      for (const std::string& lbn : node2spec.at(members.at(i)).input_lbns) {
+        const OpNode* producer = op_graph.OpNode4OpName(GenLogicalBlobId(lbn).op_name());
+        if (IsKeyFound(node2spec, producer) && IsFusedIntoConsumer(producer)
+            && std::find(members.cbegin(), members.cend(), producer) == members.cend()) {
+          members.push_back(producer);
+        }
+      }
+    }
+    if (members.size() < 2) { continue; }
+    for (const OpNode* member : members) { fused_op_names.insert(member->op().op_name()); }
+    root2members.emplace(pair.first, std::move(members));
+  }
+  if (root2members.empty()) { return Maybe<void>::Ok(); }
+
+  HashMap<std::string, std::string> old_lbn2new_lbn;
+  for (const auto& pair : root2members) {
+    const std::string& root_name = pair.first->op().op_name();
+    const std::string new_lbn = GenLogicalBlobName(root_name, "out_0");
+    const std::string& old_lbn = node2spec.at(pair.first).output_lbn;
+    if (old_lbn != new_lbn) { old_lbn2new_lbn.emplace(old_lbn, new_lbn); }
+  }
+  auto NewLbn4Lbn = [&](const std::string& lbn) -> std::string {
+    const auto it = old_lbn2new_lbn.find(lbn);
+    return it == old_lbn2new_lbn.end() ? lbn : it->second;
+  };
+
+  constexpr int32_t kNoOperand = std::numeric_limits<int32_t>::min();
+  int64_t removed_bytes = 0;
+  for (const auto& pair : root2members) {
+    const OpNode* root = pair.first;
+    const HashSet<const OpNode*> members(pair.second.cbegin(), pair.second.cend());
+    // operands are instruction indices while building and -(i + 1) for input i
+    std::vector<std::string> input_lbns;
+    std::vector<int64_t> input_inner_sizes;
+    std::vector<std::string> instructions;
+    std::vector<int32_t> operands;
+    std::vector<float> scalars;
+    std::map<std::pair<std::string, int64_t>, int32_t> input2operand;
+    std::function<int32_t(const ElementwiseOpSpec&)> Emit;
+    auto Operand4Input = [&](const std::string& lbn, int64_t inner_size) -> int32_t {
+      const auto key = std::make_pair(lbn, inner_size);
+      const auto it = input2operand.find(key);
+      if (it != input2operand.end()) { return it->second; }
+      const OpNode* producer = op_graph.OpNode4OpName(GenLogicalBlobId(lbn).op_name());
+      int32_t operand = 0;
+      if (IsKeyFound(members, producer)) {
+        operand = Emit(node2spec.at(producer));
+      } else {
+        input_lbns.push_back(NewLbn4Lbn(lbn));
+        input_inner_sizes.push_back(inner_size);
+        operand = -static_cast<int32_t>(input_lbns.size());
+      }
+      input2operand.emplace(key, operand);
+      return operand;
+    };
+    Emit = [&](const ElementwiseOpSpec& spec) -> int32_t {
+      std::vector<int32_t> args;
+      FOR_RANGE(size_t, i, 0, spec.input_lbns.size()) {
+        args.push_back(Operand4Input(spec.input_lbns.at(i), spec.input_inner_sizes.at(i)));
+      }
+      int32_t result = args.at(0);
+      FOR_RANGE(size_t, i, args.size() == 1 ? 0 : 1, args.size()) {
+        instructions.push_back(spec.instruction);
+        operands.push_back(result);
+        operands.push_back(args.size() == 1 ? kNoOperand : args.at(i));
+        scalars.push_back(static_cast<float>(spec.scalar));
+        result = instructions.size() - 1;
+      }
+      return result;
+    };
+    Emit(node2spec.at(root));
+
+    const int32_t num_inputs = input_lbns.size();
+    for (int32_t& operand : operands) {
+      if (operand == kNoOperand) {
+        operand = -1;
+      } else if (operand < 0) {
+        operand = -operand - 1;
+      } else {
+        operand += num_inputs;
+      }
+    }
+    user_op::UserOpConfWrapperBuilder fused_op_builder(root->op().op_name());
+    fused_op_builder.Op("fused_elementwise");
+    for (const std::string& lbn : input_lbns) { fused_op_builder.Input("in", lbn); }
+    const auto fused_op = fused_op_builder.Output("out")
+                              .Attr<std::vector<std::string>>("instructions", instructions)
+                              .Attr<std::vector<int32_t>>("operands", operands)
+                              .Attr<std::vector<float>>("scalars", scalars)
+                              .Attr<std::vector<int64_t>>("input_inner_sizes", input_inner_sizes)
+                              .ScopeSymbolId(root->op().op_conf().scope_symbol_id())
+                              .Build();
+    job_builder->MutOpsOnlyOnce({fused_op.op_conf()});
+    std::vector<std::string> del_op_names;
+    for (const OpNode* member : members) {
+      if (member == root) { continue; }
+      del_op_names.push_back(member->op().op_name());
+      const BlobDesc& out =
+          member->LogicalBlobDesc4Lbi(GenLogicalBlobId(node2spec.at(member).output_lbn));
+      removed_bytes += 2 * out.shape().elem_cnt() * GetSizeOfDataType(out.data_type());
+    }
+    job_builder->DelOps(del_op_names);
+  }
+
+  // consumers outside of the fused groups have to read the renamed outputs
+  HashMap<std::string, OperatorConf> op_name2op_conf;
+  for (const auto& pair : root2members) {
+    const OpNode* root = pair.first;
+    const LogicalBlobId old_lbi = GenLogicalBlobId(node2spec.at(root).output_lbn);
+    const std::string new_lbn = NewLbn4Lbn(node2spec.at(root).output_lbn);
+    if (GenLogicalBlobName(old_lbi) == new_lbn) { continue; }
+    for (const OpEdge* out_edge : root->out_edges()) {
+      const OpNode* consumer = out_edge->dst_node();
+      const std::string& consumer_op_name = consumer->op().op_name();
+      if (IsKeyFound(fused_op_names, consumer_op_name)) { continue; }
+      if (!IsKeyFound(op_name2op_conf, consumer_op_name)) {
+        op_name2op_conf.emplace(consumer_op_name, consumer->op().op_conf());
+      }
+      for (const std::string& ibn : consumer->op().input_bns()) {
+        if (consumer->op().BnInOp2Lbi(ibn) == old_lbi) {
+          ReplaceInputLbnInOpCustomizedConf(&op_name2op_conf.at(consumer_op_name), ibn, new_lbn);
+        }
+      }
+    }
+  }
+  for (const auto& pair : op_name2op_conf) { job_builder->MutOpsOnlyOnce({pair.second}); }
+  LOG(INFO) << "FuseElementwiseOpsPass fused " << fused_op_names.size() << " ops into "
+            << root2members.size() << " fused_elementwise ops, saving " << removed_bytes
+            << " bytes of intermediate memory traffic per iteration";
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_JOB_PASS("FuseElementwiseOpsPass", FuseElementwiseOpsPass);
+
+}  // namespace oneflow
@@ -42,27 +42,87 @@ bool IsUserOpWithTypeName(const OperatorConf& op_conf, const std::string& op_typ
   return op_conf.has_user_conf() && op_conf.user_conf().op_type_name() == op_type_name;
 };
 
+bool IsMultiTensorUpdateSupported(const std::string& op_type_name) {
+  return op_type_name == "sgd_update" || op_type_name == "adam_update";
+}
+
+// update ops are merged only when everything except their variables is the same
+std::string MultiTensorUpdateGroupKey(const OpNode* op_node,
+                                      const user_op::UserOpConfWrapper& user_op_conf) {
+  const LogicalBlobId model_lbi = GenLogicalBlobId(user_op_conf.input("model", 0));
+  std::ostringstream ss;
+  ss << std::hexfloat << user_op_conf.op_type_name() << "|"
+     << op_node->LogicalBlobDesc4Lbi(model_lbi).data_type() << "|"
+     << PbMessage2TxtString(op_node->parallel_desc().parallel_conf()) << "|"
+     << user_op_conf.input("learning_rate", 0) << "|";
+  if (user_op_conf.has_input("scale_by_tensor", 0)) {
+    ss << user_op_conf.input("scale_by_tensor", 0);
+  }
+  ss << "|";
+  if (user_op_conf.has_input("skip_if", 0)) { ss << user_op_conf.input("skip_if", 0); }
+  ss << "|" << user_op_conf.attr<double>("scale") << "|" << user_op_conf.attr<float>("l1") << "|"
+     << user_op_conf.attr<float>("l2") << "|" << user_op_conf.attr<float>("weight_decay");
+  if (user_op_conf.op_type_name() == "adam_update") {
+    ss << "|" << user_op_conf.attr<float>("beta1") << "|" << user_op_conf.attr<float>("beta2")
+       << "|" << user_op_conf.attr<float>("epsilon");
+  }
+  return ss.str();
+}
+
 class FuseUpdateOpsPass final : public JobPass {
  public:
   FuseUpdateOpsPass() = default;
   ~FuseUpdateOpsPass() override = default;
 
   bool IsEnabled(const JobPassCtx& ctx) const {
-    return ctx.job_desc().job_conf().enable_fuse_model_update_ops();
+    return ctx.job_desc().job_conf().enable_fuse_model_update_ops()
+           || ctx.job_desc().job_conf().enable_multi_tensor_model_update();
   }
-  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder,
+                    const JobConfigProto& job_conf) const;
 
   Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
     if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
     const OpGraph op_graph(*job);
     JobBuilder job_builder(job);
-    return Apply(op_graph, &job_builder);
+    return Apply(op_graph, &job_builder, ctx->job_desc().job_conf());
   }
+
+ private:
+  void FuseIntoUpdateOps(const OpGraph& op_graph,
+                         const std::function<bool(const OpNode*)>& IsSafeToDelete,
+                         HashMap<std::string, OperatorConf>* op_name2new_op_conf,
+                         std::vector<std::string>* del_op_names) const;
+  void MergeIntoMultiTensorUpdateOps(const OpGraph& op_graph,
+                                     const std::function<bool(const OpNode*)>& IsSafeToDelete,
+                                     HashMap<std::string, OperatorConf>* op_name2new_op_conf,
+                                     std::vector<std::string>* del_op_names,
+                                     JobBuilder* job_builder) const;
 };
 
-Maybe<void> FuseUpdateOpsPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+Maybe<void> FuseUpdateOpsPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder,
+                                     const JobConfigProto& job_conf) const {
   const auto IsSafeToDelete = MakePredicatorIsSafeToDelete(op_graph);
+  HashMap<std::string, OperatorConf> op_name2new_op_conf;
   std::vector<std::string> del_op_names;
+  if (job_conf.enable_fuse_model_update_ops()) {
+    FuseIntoUpdateOps(op_graph, IsSafeToDelete, &op_name2new_op_conf, &del_op_names);
+  }
+  if (job_conf.enable_multi_tensor_model_update()) {
+    MergeIntoMultiTensorUpdateOps(op_graph, IsSafeToDelete, &op_name2new_op_conf, &del_op_names,
+                                  job_builder);
+  }
+  std::vector<OperatorConf> mut_op_confs;
+  for (const auto& pair : op_name2new_op_conf) { mut_op_confs.push_back(pair.second); }
+  job_builder->MutOpsOnlyOnce(mut_op_confs);
+  job_builder->DelOps(del_op_names);
+  return Maybe<void>::Ok();
+}
+
+void FuseUpdateOpsPass::FuseIntoUpdateOps(
+    const OpGraph& op_graph, const std::function<bool(const OpNode*)>& IsSafeToDelete,
+    HashMap<std::string, OperatorConf>* op_name2new_op_conf,
+    std::vector<std::string>* del_op_names) const {
   op_graph.ForEachNode([&](const OpNode* op_node) {
     if (!op_node->op().op_conf().has_user_conf()) { return; }
     const user_op::UserOpConfWrapper user_op_conf(op_node->op().op_conf());
@@ -97,7 +157,7 @@ Maybe<void> FuseUpdateOpsPass::Apply(const OpGraph& op_graph, JobBuilder* job_bu
         l1 = l1_l2_regularize_gradient_op_conf.attr<float>("l1");
         l2 = l1_l2_regularize_gradient_op_conf.attr<float>("l2");
         model_diff_lbi = GenLogicalBlobId(l1_l2_regularize_gradient_op_conf.input("model_diff", 0));
-        del_op_names.push_back(producer->op().op_name());
+        del_op_names->push_back(producer->op().op_name());
         fused = true;
       } while (false);
 
@@ -108,7 +168,7 @@ Maybe<void> FuseUpdateOpsPass::Apply(const OpGraph& op_graph, JobBuilder* job_bu
         const user_op::UserOpConfWrapper scalar_mul_by_tensor_op_conf(producer->op().op_conf());
         model_diff_lbi = GenLogicalBlobId(scalar_mul_by_tensor_op_conf.input("x", 0));
         scale_by_tensor_lbn = scalar_mul_by_tensor_op_conf.input("scalar", 0);
-        del_op_names.push_back(producer->op().op_name());
+        del_op_names->push_back(producer->op().op_name());
         fused = true;
       } while (false);
 
@@ -125,7 +185,7 @@ Maybe<void> FuseUpdateOpsPass::Apply(const OpGraph& op_graph, JobBuilder* job_bu
           UNIMPLEMENTED();
         }
         model_diff_lbi = GenLogicalBlobId(scalar_mul_op_conf.input("in", 0));
-        del_op_names.push_back(producer->op().op_name());
+        del_op_names->push_back(producer->op().op_name());
         fused = true;
       } while (false);
 
@@ -140,7 +200,7 @@ Maybe<void> FuseUpdateOpsPass::Apply(const OpGraph& op_graph, JobBuilder* job_bu
           return;
         }
         model_diff_lbi = GenLogicalBlobId(cast_op_conf.input("in", 0));
-        del_op_names.push_back(producer->op().op_name());
+        del_op_names->push_back(producer->op().op_name());
         fused = true;
       } while (false);
     }();
@@ -192,10 +252,85 @@ Maybe<void> FuseUpdateOpsPass::Apply(const OpGraph& op_graph, JobBuilder* job_bu
     }
     OperatorConf new_op_conf = user_op_conf.op_conf();
     *new_op_conf.mutable_user_conf() = fused_op_builder.Build().op_conf().user_conf();
-    job_builder->MutOpsOnlyOnce({new_op_conf});
+    (*op_name2new_op_conf)[new_op_conf.name()] = new_op_conf;
   });
-  job_builder->DelOps(del_op_names);
-  return Maybe<void>::Ok();
+}
+
+void FuseUpdateOpsPass::MergeIntoMultiTensorUpdateOps(
+    const OpGraph& op_graph, const std::function<bool(const OpNode*)>& IsSafeToDelete,
+    HashMap<std::string, OperatorConf>* op_name2new_op_conf,
+    std::vector<std::string>* del_op_names, JobBuilder* job_builder) const {
+  std::map<std::string, std::vector<const OpNode*>> group_key2op_nodes;
+  op_graph.TopoForEachNode([&](const OpNode* op_node) {
+    const OperatorConf& op_conf = op_node->op().op_conf();
+    if (!op_conf.has_user_conf()) { return; }
+    if (!IsMultiTensorUpdateSupported(op_conf.user_conf().op_type_name())) { return; }
+    if (op_node->parallel_desc().device_type() != DeviceType::kCPU) { return; }
+    if (!IsSafeToDelete(op_node)) { return; }
+    const auto it = op_name2new_op_conf->find(op_conf.name());
+    const user_op::UserOpConfWrapper user_op_conf(
+        it == op_name2new_op_conf->end() ? op_conf : it->second);
+    const LogicalBlobId model_lbi = GenLogicalBlobId(user_op_conf.input("model", 0));
+    const LogicalBlobId model_diff_lbi = GenLogicalBlobId(user_op_conf.input("model_diff", 0));
+    const DataType data_type = op_node->LogicalBlobDesc4Lbi(model_lbi).data_type();
+    if (data_type != DataType::kFloat && data_type != DataType::kDouble) { return; }
+    if (op_graph.GetLogicalBlobDesc(model_diff_lbi).data_type() != data_type) { return; }
+    if (!op_node->SbpParallel4Lbi(model_lbi).has_broadcast_parallel()) { return; }
+    group_key2op_nodes[MultiTensorUpdateGroupKey(op_node, user_op_conf)].push_back(op_node);
+  });
+  for (const auto& pair : group_key2op_nodes) {
+    const std::vector<const OpNode*>& op_nodes = pair.second;
+    if (op_nodes.size() < 2) { continue; }
+    std::vector<OperatorConf> op_confs;
+    for (const OpNode* op_node : op_nodes) {
+      const std::string& op_name = op_node->op().op_name();
+      const auto it = op_name2new_op_conf->find(op_name);
+      if (it == op_name2new_op_conf->end()) {
+        op_confs.push_back(op_node->op().op_conf());
+      } else {
+        op_confs.push_back(it->second);
+        op_name2new_op_conf->erase(it);
+      }
+      del_op_names->push_back(op_name);
+    }
+    const user_op::UserOpConfWrapper first_op_conf(op_confs.front());
+    const std::string& op_type_name = first_op_conf.op_type_name();
+    user_op::UserOpConfWrapperBuilder multi_tensor_op_builder(
+        "System-MultiTensorUpdate-" + op_type_name + "_" + NewUniqueId());
+    multi_tensor_op_builder.OpTypeName("multi_tensor_" + op_type_name)
+        .Input("learning_rate", first_op_conf.input("learning_rate", 0))
+        .Attr<double>("scale", first_op_conf.attr<double>("scale"))
+        .Attr<float>("l1", first_op_conf.attr<float>("l1"))
+        .Attr<float>("l2", first_op_conf.attr<float>("l2"))
+        .Attr<float>("weight_decay", first_op_conf.attr<float>("weight_decay"));
+    if (first_op_conf.has_input("scale_by_tensor", 0)) {
+      multi_tensor_op_builder.Input("scale_by_tensor", first_op_conf.input("scale_by_tensor", 0));
+    }
+    if (first_op_conf.has_input("skip_if", 0)) {
+      multi_tensor_op_builder.Input("skip_if", first_op_conf.input("skip_if", 0));
+    }
+    if (op_type_name == "adam_update") {
+      multi_tensor_op_builder.Attr<float>("beta1", first_op_conf.attr<float>("beta1"))
+          .Attr<float>("beta2", first_op_conf.attr<float>("beta2"))
+          .Attr<float>("epsilon", first_op_conf.attr<float>("epsilon"));
+    }
+    for (const OperatorConf& op_conf : op_confs) {
+      const user_op::UserOpConfWrapper user_op_conf(op_conf);
+      multi_tensor_op_builder.Input("model", user_op_conf.input("model", 0))
+          .Input("model_diff", user_op_conf.input("model_diff", 0));
+      if (op_type_name == "adam_update") {
+        multi_tensor_op_builder.Input("m", user_op_conf.input("m", 0))
+            .Input("v", user_op_conf.input("v", 0));
+      }
+    }
+    const user_op::UserOpConfWrapper multi_tensor_op = multi_tensor_op_builder.Build();
+    OperatorConf multi_tensor_op_conf = op_confs.front();
+    multi_tensor_op_conf.set_name(multi_tensor_op.op_name());
+    *multi_tensor_op_conf.mutable_user_conf() = multi_tensor_op.op_conf().user_conf();
+    job_builder->AddOps(op_nodes.front()->parallel_desc().parallel_conf(), {multi_tensor_op_conf});
+    LOG(INFO) << "merge " << op_nodes.size() << " " << op_type_name << " ops into "
+              << multi_tensor_op_conf.name();
+  }
 }
 
 }  // namespace
@@ -0,0 +1,239 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/job_rewriter/pass_util.h"
+
+namespace oneflow {
+
+namespace {
+
+const std::string INT8_SCALE_SUFFIX = "-int8-in-scale";
+const std::string INT8_CALIBRATION_SUFFIX = "-int8-calibration";
+const std::string INT8_QUANTIZE_SUFFIX = "-int8-quantize";
+
+std::string OpTypeName4OpNode(const OpNode* node) {
+  const OperatorConf& op_conf = node->op().op_conf();
+  return op_conf.has_user_conf() ? op_conf.user_conf().op_type_name() : "";
+}
+
+bool IsVariableLbn(const OpGraph& op_graph, const std::string& lbn) {
+  const OpNode* producer = op_graph.OpNode4OpName(GenLogicalBlobId(lbn).op_name());
+  return producer->op().op_conf().has_variable_conf();
+}
+
+// The int8 kernels quantize the weight once and keep it, so only conv2d and matmul ops whose
+// weight comes straight from a variable are picked
+bool GetInt8ActivationLbn(const OpGraph& op_graph, const OpNode* node, std::string* in_lbn) {
+  if (node->parallel_desc().device_type() != DeviceType::kCPU) { return false; }
+  if (!node->op().op_conf().has_user_conf()) { return false; }
+  const user_op::UserOpConfWrapper conf(node->op().op_conf());
+  std::string weight_lbn;
+  if (conf.op_type_name() == "conv2d") {
+    if (conf.attr<std::string>("data_format") != "channels_first") { return false; }
+    if (conf.attr<int32_t>("groups") != 1) { return false; }
+    *in_lbn = conf.input("in", 0);
+    weight_lbn = conf.input("weight", 0);
+  } else if (conf.op_type_name() == "matmul") {
+    if (conf.attr<bool>("transpose_a")) { return false; }
+    if (conf.has_input("_add_to_output", 0)) { return false; }
+    *in_lbn = conf.input("a", 0);
+    weight_lbn = conf.input("b", 0);
+  } else {
+    return false;
+  }
+  if (node->LogicalBlobDesc4Lbi(GenLogicalBlobId(*in_lbn)).data_type() != DataType::kFloat) {
+    return false;
+  }
+  return IsVariableLbn(op_graph, weight_lbn);
+}
+
+// Both the calibration and the inference job declare the same variable, so the scales recorded
+// by the former are picked up by the latter through the checkpoint
+OperatorConf Int8ScaleVariableOpConf(const std::string& op_name, const int64_t scope_symbol_id) {
+  OperatorConf variable_op_conf{};
+  variable_op_conf.set_name(op_name + INT8_SCALE_SUFFIX);
+  variable_op_conf.set_scope_symbol_id(scope_symbol_id);
+  VariableOpConf* variable_conf = variable_op_conf.mutable_variable_conf();
+  variable_conf->set_out("out");
+  *variable_conf->mutable_shape()->mutable_dim()->Add() = 1;
+  variable_conf->set_data_type(DataType::kFloat);
+  variable_conf->mutable_split_axis()->clear_value();
+  variable_conf->mutable_initializer()->mutable_constant_conf()->set_value(0);
+  return variable_op_conf;
+}
+
+std::string VariableLbn(const OperatorConf& variable_op_conf) {
+  return GenLogicalBlobName(variable_op_conf.name(), variable_op_conf.variable_conf().out());
+}
+
+HashSet<std::string> CtrlInOpNames(const OpGraph& op_graph) {
+  HashSet<std::string> ctrl_in_op_names;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    for (const std::string& ctrl_in_op_name : op_node->op().op_conf().ctrl_in_op_name()) {
+      ctrl_in_op_names.insert(ctrl_in_op_name);
+    }
+  });
+  return ctrl_in_op_names;
+}
+
+class Int8Calibration final : public JobPass {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(Int8Calibration);
+  Int8Calibration() = default;
+  ~Int8Calibration() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    return ctx.job_desc().job_conf().enable_int8_calibration();
+  }
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override;
+};
+
+Maybe<void> Int8Calibration::Apply(Job* job, JobPassCtx* ctx) const {
+  if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+  CHECK_OR_RETURN(!ctx->job_desc().IsTrain()) << "int8 calibration runs in predict jobs only";
+  const OpGraph op_graph(*job);
+  JobBuilder job_builder(job);
+  op_graph.ForEachNode([&](const OpNode* node) {
+    std::string in_lbn;
+    if (!GetInt8ActivationLbn(op_graph, node, &in_lbn)) { return; }
+    const std::string& op_name = node->op().op_name();
+    const int64_t scope_symbol_id = node->op().op_conf().scope_symbol_id();
+    const OperatorConf scale_var = Int8ScaleVariableOpConf(op_name, scope_symbol_id);
+    const auto calibration_op = user_op::UserOpConfWrapperBuilder(op_name + INT8_CALIBRATION_SUFFIX)
+                                    .Op("int8_calibration")
+                                    .Input("in", in_lbn)
+                                    .Input("scale", VariableLbn(scale_var))
+                                    .ScopeSymbolId(scope_symbol_id)
+                                    .Build();
+    job_builder.AddOps(node->parallel_desc().parallel_conf(),
+                       {scale_var, calibration_op.op_conf()});
+  });
+  return Maybe<void>::Ok();
+}
+
+class Int8Inference final : public JobPass {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(Int8Inference);
+  Int8Inference() = default;
+  ~Int8Inference() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    return ctx.job_desc().job_conf().enable_int8_inference();
+  }
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override;
+};
+
+// conv2d / matmul -> [bias_add] -> [relu] is replaced by
+// quantize -> quantized_conv2d / quantized_matmul, the int8 op takes the name of the last op of
+// the pattern so that the consumers keep reading the same lbn
+Maybe<void> Int8Inference::Apply(Job* job, JobPassCtx* ctx) const {
+  if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+  CHECK_OR_RETURN(!ctx->job_desc().IsTrain()) << "int8 inference runs in predict jobs only";
+  const OpGraph op_graph(*job);
+  JobBuilder job_builder(job);
+  const HashSet<std::string> ctrl_in_op_names = CtrlInOpNames(op_graph);
+  auto IsFusible = [&](const OpNode* node) {
+    return node->op().op_conf().ctrl_in_op_name().empty()
+           && !IsKeyFound(ctrl_in_op_names, node->op().op_name());
+  };
+  auto SoleConsumer4Type = [&](const OpNode* node, const std::string& op_type_name) {
+    if (node->out_edges().size() != 1) { return static_cast<const OpNode*>(nullptr); }
+    const OpNode* consumer = node->SoleOutEdge()->dst_node();
+    if (OpTypeName4OpNode(consumer) != op_type_name || !IsFusible(consumer)
+        || consumer->parallel_desc() != node->parallel_desc()) {
+      return static_cast<const OpNode*>(nullptr);
+    }
+    return consumer;
+  };
+  op_graph.ForEachNode([&](const OpNode* node) {
+    std::string in_lbn;
+    if (!GetInt8ActivationLbn(op_graph, node, &in_lbn) || !IsFusible(node)) { return; }
+    const user_op::UserOpConfWrapper conf(node->op().op_conf());
+    const bool is_conv = conf.op_type_name() == "conv2d";
+    std::string bias_lbn = is_conv && conf.has_input("bias", 0) ? conf.input("bias", 0) : "";
+    std::vector<std::string> fused_op_names;
+    const OpNode* tail = node;
+    if (bias_lbn.empty()) {
+      const OpNode* bias_add = SoleConsumer4Type(tail, "bias_add");
+      if (bias_add != nullptr) {
+        const user_op::UserOpConfWrapper bias_add_conf(bias_add->op().op_conf());
+        if (bias_add_conf.attr<int32_t>("axis") == 1
+            && GenLogicalBlobId(bias_add_conf.input("a", 0)).op_name() == tail->op().op_name()) {
+          bias_lbn = bias_add_conf.input("b", 0);
+          fused_op_names.push_back(tail->op().op_name());
+          tail = bias_add;
+        }
+      }
+    }
+    const OpNode* relu = SoleConsumer4Type(tail, "relu");
+    if (relu != nullptr) {
+      fused_op_names.push_back(tail->op().op_name());
+      tail = relu;
+    }
+
+    const std::string& op_name = node->op().op_name();
+    const int64_t scope_symbol_id = node->op().op_conf().scope_symbol_id();
+    const OperatorConf scale_var = Int8ScaleVariableOpConf(op_name, scope_symbol_id);
+    const std::string scale_lbn = VariableLbn(scale_var);
+    const auto quantize_op = user_op::UserOpConfWrapperBuilder(op_name + INT8_QUANTIZE_SUFFIX)
+                                 .Op("quantize")
+                                 .Input("in", in_lbn)
+                                 .Input("scale", scale_lbn)
+                                 .Output("out")
+                                 .ScopeSymbolId(scope_symbol_id)
+                                 .Build();
+    user_op::UserOpConfWrapperBuilder int8_op_builder(tail->op().op_name());
+    if (is_conv) {
+      int8_op_builder.Op("quantized_conv2d")
+          .Input("in", quantize_op.output("out", 0))
+          .Input("in_scale", scale_lbn)
+          .Input("weight", conf.input("weight", 0))
+          .Attr<int32_t>("filters", conf.attr<int32_t>("filters"))
+          .Attr<std::vector<int32_t>>("padding_before",
+                                      conf.attr<std::vector<int32_t>>("padding_before"))
+          .Attr<std::string>("data_format", conf.attr<std::string>("data_format"))
+          .Attr<std::vector<int32_t>>("kernel_size", conf.attr<std::vector<int32_t>>("kernel_size"))
+          .Attr<std::vector<int32_t>>("strides", conf.attr<std::vector<int32_t>>("strides"))
+          .Attr<std::vector<int32_t>>("dilation_rate",
+                                      conf.attr<std::vector<int32_t>>("dilation_rate"));
+    } else {
+      int8_op_builder.Op("quantized_matmul")
+          .Input("a", quantize_op.output("out", 0))
+          .Input("a_scale", scale_lbn)
+          .Input("b", conf.input("b", 0))
+          .Attr<bool>("transpose_b", conf.attr<bool>("transpose_b"));
+    }
+    if (!bias_lbn.empty()) { int8_op_builder.Input("bias", bias_lbn); }
+    const auto int8_op = int8_op_builder.Output("out")
+                             .Attr<bool>("fuse_relu", relu != nullptr)
+                             .ScopeSymbolId(scope_symbol_id)
+                             .Build();
+    job_builder.AddOps(node->parallel_desc().parallel_conf(), {scale_var, quantize_op.op_conf()});
+    job_builder.MutOpsOnlyOnce({int8_op.op_conf()});
+    job_builder.DelOps(fused_op_names);
+  });
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_JOB_PASS("Int8Calibration", Int8Calibration);
+REGISTER_JOB_PASS("Int8Inference", Int8Inference);
+
+}  // namespace oneflow
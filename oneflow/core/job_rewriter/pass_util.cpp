@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/job_rewriter/pass_util.h"
+#include "oneflow/core/framework/framework.h"
 
 namespace oneflow {
 
@@ -54,4 +55,49 @@ void DfsTopoGraphTraversal(const OpGraph& graph, bool reversed,
   });
 }
 
+int64_t EstimateFlops4OpNode(const OpNode* op_node) {
+  const Operator& op = op_node->op();
+  int64_t out_elem_cnt = 0;
+  for (const std::string& obn : op.output_bns()) {
+    out_elem_cnt += op_node->LogicalBlobDesc4Lbi(op.BnInOp2Lbi(obn)).shape().elem_cnt();
+  }
+  if (op.op_conf().has_user_conf()) {
+    const user_op::UserOpConfWrapper conf(op.op_conf());
+    const std::string& op_type_name = conf.op_type_name();
+    auto Shape4Input = [&](const std::string& arg_name) -> const Shape& {
+      return op_node->LogicalBlobDesc4Lbi(GenLogicalBlobId(conf.input(arg_name, 0))).shape();
+    };
+    if (op_type_name == "matmul" || op_type_name == "batch_matmul") {
+      const Shape& a_shape = Shape4Input("a");
+      const int64_t num_axes = a_shape.NumAxes();
+      const int64_t k = a_shape.At(conf.attr<bool>("transpose_a") ? num_axes - 2 : num_axes - 1);
+      return 2 * out_elem_cnt * k;
+    } else if (op_type_name == "conv1d" || op_type_name == "conv2d"
+               || op_type_name == "conv3d") {
+      return 2 * out_elem_cnt * Shape4Input("weight").elem_cnt() / conf.attr<int32_t>("filters");
+    }
+  }
+  int64_t flops = out_elem_cnt;
+  for (const std::string& ibn : op.input_bns()) {
+    flops += op_node->LogicalBlobDesc4Lbi(op.BnInOp2Lbi(ibn)).shape().elem_cnt();
+  }
+  return flops;
+}
+
+bool IsNondeterministicOpTypeName(const std::string& op_type_name) {
+  // matched against whole words of the name, so that e.g. normalization and upsample are not taken
+  // for normal and sample
+  static const HashSet<std::string> keywords = {
+      "random", "dropout", "uniform", "normal",  "shuffle",     "permutation",
+      "coin",   "reader",  "decoder", "sample",  "calibration", "ssp"};
+  size_t begin = 0;
+  while (begin <= op_type_name.size()) {
+    size_t end = op_type_name.find('_', begin);
+    if (end == std::string::npos) { end = op_type_name.size(); }
+    if (IsKeyFound(keywords, op_type_name.substr(begin, end - begin))) { return true; }
+    begin = end + 1;
+  }
+  return false;
+}
+
 }  // namespace oneflow
@@ -52,6 +52,14 @@ void DfsTopoGraphTraversal(const OpGraph& graph, bool reversed,
                            std::function<bool(OpNode*)> IsFatherNodeSatisfied,
                            std::function<void(OpNode*)> NodeHandler);
 
+// A rough count of the floating point operations of op_node, only matmul and convolution are
+// distinguished from the ops costing one operation per element.
+int64_t EstimateFlops4OpNode(const OpNode* op_node);
+
+// Whether two instances of a user op with the same conf and inputs may give different outputs,
+// e.g. the random ops and the data readers. Such ops are neither merged nor recomputed.
+bool IsNondeterministicOpTypeName(const std::string& op_type_name);
+
 // make sure an op_conf can only be udpated once, cuz later update will override before
 class OpConfCache {
   std::map<std::string, OperatorConf> _op_confs_to_update;
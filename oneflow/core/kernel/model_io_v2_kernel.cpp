@@ -17,6 +17,7 @@ limitations under the License.
 #include "oneflow/core/kernel/kernel.h"
 #include "oneflow/core/register/tensor_slice_copier.h"
 #include "oneflow/core/device/cpu_device_context.h"
+#include "oneflow/core/persistence/async_snapshot_writer.h"
 
 namespace oneflow {
 
@@ -251,8 +252,11 @@ class ModelInitV2Kernel final : public KernelIf<device_type> {
     } else if (original_variable_conf.has_initialize_with_snapshot()) {
       const auto& snapshot_conf = original_variable_conf.initialize_with_snapshot();
       const std::string key = snapshot_conf.has_key() ? snapshot_conf.key() : var_lbn;
+      const double start_time = GetCurTime();
       const SnapshotReader reader(snapshot_conf.path());
       reader.Read(key, logical_blob_shape, slice, ref_accessor.host_blob());
+      VLOG(1) << "load " << key << " of " << ref->ByteSizeOfBlobBody() << " bytes from "
+              << snapshot_conf.path() << " in " << (GetCurTime() - start_time) / 1e6 << " ms";
     } else {
       UNIMPLEMENTED();
     }
@@ -297,8 +301,11 @@ class ModelLoadV2Kernel final : public KernelIf<device_type> {
     const TensorSliceView slice = GetPartSlice(this->kernel_conf());
     AutoSyncBlobAccessor<device_type> ref_accessor(ctx.device_ctx, ref, false, true);
     const std::string snapshot_path = SyncReadStringFromBlob<device_type>(ctx.device_ctx, path);
+    const double start_time = GetCurTime();
     SnapshotReader reader(snapshot_path);
     reader.Read(var_lbn, logical_blob_shape, slice, ref_accessor.host_blob());
+    VLOG(1) << "load " << var_lbn << " of " << ref->ByteSizeOfBlobBody() << " bytes from "
+            << snapshot_path << " in " << (GetCurTime() - start_time) / 1e6 << " ms";
   }
 };
 
@@ -331,31 +338,101 @@ class ModelSaveV2Kernel final : public KernelIf<device_type> {
     if (is_broadcast && parallel_ctx.parallel_id() != 0) { return; }
     const std::string snapshot_path =
         SyncReadStringFromBlob<device_type>(ctx.device_ctx, path_blob);
-    AutoSyncBlobAccessor<device_type> in_accessor(ctx.device_ctx, in_blob, true, false);
-    SnapshotWriter writer(snapshot_path);
     const std::string var_lbn =
         GenLogicalBlobName(conf.variable_op_name(), original_variable_conf.out());
+    const std::string done_key_prefix =
+        snapshot_path + "-" + var_lbn + "-Counter-" + std::to_string(*counter_);
+    std::vector<TensorSliceView> part_slices;
+    FOR_RANGE(int64_t, i, 0, parallel_ctx.parallel_num()) {
+      part_slices.push_back(GetPartSlice(this->kernel_conf(), i));
+    }
+    AsyncSnapshotWriter* async_writer = Global<AsyncSnapshotWriter>::Get();
+    if (async_writer == nullptr) {
+      AutoSyncBlobAccessor<device_type> in_accessor(ctx.device_ctx, in_blob, true, false);
+      SaveBlob(snapshot_path, var_lbn, is_broadcast, parallel_ctx, in_accessor.host_blob(),
+               logical_blob_shape, data_type, part_slices, done_key_prefix, false);
+      if (!is_broadcast) {
+        Global<CtrlClient>::Get()->Barrier(done_key_prefix, parallel_ctx.parallel_num());
+        if (parallel_ctx.parallel_id() == 0) {
+          MergeParts(snapshot_path, var_lbn, logical_blob_shape, data_type, part_slices,
+                     done_key_prefix, false);
+        }
+      }
+    } else {
+      // stage the blob so that the variable can be updated while the snapshot is being written
+      std::shared_ptr<OnDemandHostBlob> staged_blob(new OnDemandHostBlob(in_blob));
+      SyncCopyToHost<device_type>(ctx.device_ctx, in_blob->dptr(),
+                                  staged_blob->blob()->mut_dptr(), in_blob->ByteSizeOfBlobBody());
+      async_writer->AddIoWork([=]() {
+        SaveBlob(snapshot_path, var_lbn, is_broadcast, parallel_ctx, staged_blob->blob(),
+                 logical_blob_shape, data_type, part_slices, done_key_prefix, true);
+      });
+      if (!is_broadcast && parallel_ctx.parallel_id() == 0) {
+        async_writer->AddMergeWork([=]() {
+          MergeParts(snapshot_path, var_lbn, logical_blob_shape, data_type, part_slices,
+                     done_key_prefix, true);
+        });
+      }
+    }
+  }
+
+  static std::string GetPartDoneKey(const std::string& done_key_prefix, int64_t parallel_id) {
+    return done_key_prefix + "-PartDone-" + std::to_string(parallel_id);
+  }
+
+  static void SaveBlob(const std::string& snapshot_path, const std::string& var_lbn,
+                       bool is_broadcast, const ParallelContext& parallel_ctx, const Blob* blob,
+                       const Shape& logical_blob_shape, DataType data_type,
+                       const std::vector<TensorSliceView>& part_slices,
+                       const std::string& done_key_prefix, bool is_async) {
+    SnapshotWriter writer(snapshot_path);
     const std::string key = is_broadcast ? var_lbn : GetTmpPartKey(var_lbn, parallel_ctx);
-    writer.Write(key, in_accessor.host_blob());
-    if (!is_broadcast) {
-      const int64_t parallel_num = parallel_ctx.parallel_num();
-      Global<CtrlClient>::Get()->Barrier(
-          snapshot_path + "-" + var_lbn + "-Counter-" + std::to_string(*counter_), parallel_num);
-      if (parallel_ctx.parallel_id() != 0) { return; }
-      TensorSliceView total_slice(logical_blob_shape);
-      OnDemandHostBlob total_blob(logical_blob_shape, data_type);
-      SnapshotReader reader(snapshot_path);
+    if (is_async) {
+      writer.AtomicWrite(key, blob);
+    } else {
+      writer.Write(key, blob);
+    }
+    if (is_async && !is_broadcast) {
+      // parts are merged by another thread which never blocks the io threads, so a kv pair is
+      // used to signal the merger instead of a barrier
+      Global<CtrlClient>::Get()->PushKV(GetPartDoneKey(done_key_prefix, parallel_ctx.parallel_id()),
+                                        "");
+    }
+  }
+
+  static void MergeParts(const std::string& snapshot_path, const std::string& var_lbn,
+                         const Shape& logical_blob_shape, DataType data_type,
+                         const std::vector<TensorSliceView>& part_slices,
+                         const std::string& done_key_prefix, bool is_async) {
+    const int64_t parallel_num = part_slices.size();
+    if (is_async) {
       FOR_RANGE(int64_t, i, 0, parallel_num) {
-        const TensorSliceView part_slice = GetPartSlice(this->kernel_conf(), i);
-        const std::string part_key = GetTmpPartKey(var_lbn, i, parallel_num);
-        OnDemandHostBlob part_blob(part_slice.shape(), data_type);
-        reader.Read(part_key, part_blob.blob());
-        HostSliceCopy(total_blob.blob(), total_slice, part_blob.blob(), part_slice);
-        SnapshotFS()->RecursivelyDeleteDir(Dirname(JoinPath(snapshot_path, part_key)));
+        std::string done;
+        Global<CtrlClient>::Get()->PullKV(GetPartDoneKey(done_key_prefix, i), &done);
       }
+    }
+    TensorSliceView total_slice(logical_blob_shape);
+    OnDemandHostBlob total_blob(logical_blob_shape, data_type);
+    SnapshotReader reader(snapshot_path);
+    FOR_RANGE(int64_t, i, 0, parallel_num) {
+      const TensorSliceView& part_slice = part_slices.at(i);
+      const std::string part_key = GetTmpPartKey(var_lbn, i, parallel_num);
+      OnDemandHostBlob part_blob(part_slice.shape(), data_type);
+      reader.Read(part_key, part_blob.blob());
+      HostSliceCopy(total_blob.blob(), total_slice, part_blob.blob(), part_slice);
+      SnapshotFS()->RecursivelyDeleteDir(Dirname(JoinPath(snapshot_path, part_key)));
+    }
+    SnapshotWriter writer(snapshot_path);
+    if (is_async) {
+      writer.AtomicWrite(var_lbn, total_blob.blob());
+      FOR_RANGE(int64_t, i, 0, parallel_num) {
+        Global<CtrlClient>::Get()->ClearKV(GetPartDoneKey(done_key_prefix, i));
+      }
+    } else {
       writer.Write(var_lbn, total_blob.blob());
     }
   }
+
   std::unique_ptr<int64_t> counter_;
 };
 
@@ -14,9 +14,231 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/unique_kernel_util.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
+namespace {
+
+// inputs shorter than this are handled by a single table on the calling thread
+constexpr int64_t kParallelUniqueMinKeys = 1 << 16;
+constexpr int64_t kParallelUniqueMinKeysPerThread = 1 << 14;
+constexpr int32_t kNumPartitionBits = 8;
+constexpr int64_t kNumPartitions = 1 << kNumPartitionBits;
+
+template<typename KEY>
+uint64_t HashKey(KEY key) {
+  // +0.0 and -0.0 are the same key
+  if (key == 0) { key = 0; }
+  uint64_t bits = 0;
+  std::memcpy(&bits, &key, sizeof(KEY));
+  // finalizer of splitmix64
+  bits ^= bits >> 30;
+  bits *= 0xbf58476d1ce4e5b9ULL;
+  bits ^= bits >> 27;
+  bits *= 0x94d049bb133111ebULL;
+  bits ^= bits >> 31;
+  return bits;
+}
+
+int64_t TableCapacity(int64_t num_keys) {
+  int64_t capacity = 1;
+  while (capacity < 2 * num_keys) { capacity *= 2; }
+  return capacity;
+}
+
+// Open addressing with linear probing, every slot of table holds the id of a unique key or -1.
+// Returns the id of key, which is new_id if key is inserted by this call.
+template<typename KEY, typename IDX, typename KeyOfIdFn>
+IDX FindOrInsert(KEY key, uint64_t hash, IDX* table, int64_t capacity, IDX new_id,
+                 const KeyOfIdFn& KeyOfId) {
+  int64_t slot = hash & (capacity - 1);
+  while (true) {
+    const IDX id = table[slot];
+    if (id == -1) {
+      table[slot] = new_id;
+      return new_id;
+    }
+    if (KeyOfId(id) == key) { return id; }
+    slot = (slot + 1) & (capacity - 1);
+  }
+}
+
+// Workspace of the parallel unique, keys are first partitioned by the high bits of their hashes
+// and every partition is deduplicated by its own table.
+template<typename IDX>
+struct ParallelUniqueWorkspace {
+  ParallelUniqueWorkspace(int64_t n, void* ptr) {
+    positions = reinterpret_cast<IDX*>(ptr);
+    first_positions = positions + n;
+    counts = first_positions + n;
+    tables = counts + n;
+    is_first = reinterpret_cast<bool*>(tables + TotalTableCapacityUpperBound(n));
+  }
+
+  // the capacity of a table is less than 4 times of its number of keys
+  static int64_t TotalTableCapacityUpperBound(int64_t n) { return 4 * n; }
+  static int64_t SizeInBytes(int64_t n) {
+    return (3 * n + TotalTableCapacityUpperBound(n)) * sizeof(IDX) + n * sizeof(bool);
+  }
+
+  // ids of keys in the order of partitions, each partition keeps the order of input
+  IDX* positions;
+  // position of the first appearance of every unique key, at the same offset as its partition
+  IDX* first_positions;
+  IDX* counts;
+  IDX* tables;
+  bool* is_first;
+};
+
+template<typename KEY, typename IDX>
+IDX UniqueSerially(int64_t n, const KEY* in, KEY* unique_out, IDX* idx_out, IDX* count,
+                   IDX* table) {
+  const int64_t capacity = TableCapacity(n);
+  std::fill(table, table + capacity, -1);
+  IDX num_unique = 0;
+  FOR_RANGE(int64_t, i, 0, n) {
+    const KEY key = in[i];
+    const IDX id = FindOrInsert(key, HashKey(key), table, capacity, num_unique,
+                                [&](IDX id) { return unique_out[id]; });
+    if (id == num_unique) {
+      unique_out[id] = key;
+      if (count != nullptr) { count[id] = 1; }
+      num_unique += 1;
+    } else if (count != nullptr) {
+      count[id] += 1;
+    }
+    idx_out[i] = id;
+  }
+  return num_unique;
+}
+
+// The ids are assigned in the order of the first appearance of keys, the same as UniqueSerially:
+// every partition numbers its keys locally, then the rank of a first appearance among all first
+// appearances becomes the id of the key.
+template<typename KEY, typename IDX>
+IDX UniqueParallelly(int64_t n, const KEY* in, KEY* unique_out, IDX* idx_out, IDX* count,
+                     void* workspace) {
+  ParallelUniqueWorkspace<IDX> ws(n, workspace);
+  const int64_t num_threads = std::min<int64_t>(Global<ThreadPool>::Get()->thread_num(),
+                                                n / kParallelUniqueMinKeysPerThread);
+  const BalancedSplitter chunks(n, num_threads);
+  auto PartitionOf = [](uint64_t hash) -> int64_t { return hash >> (64 - kNumPartitionBits); };
+
+  // step 1. scatter positions of keys into partitions, stable within every partition
+  std::vector<int64_t> offsets(num_threads * kNumPartitions, 0);
+  MultiThreadLoop(num_threads, [&](size_t t) {
+    const Range range = chunks.At(t);
+    int64_t* histogram = offsets.data() + t * kNumPartitions;
+    FOR_RANGE(int64_t, i, range.begin(), range.end()) {
+      histogram[PartitionOf(HashKey(in[i]))] += 1;
+    }
+    std::fill(ws.is_first + range.begin(), ws.is_first + range.end(), false);
+  });
+  std::vector<int64_t> partition_offsets(kNumPartitions + 1, 0);
+  std::vector<int64_t> table_offsets(kNumPartitions + 1, 0);
+  int64_t offset = 0;
+  FOR_RANGE(int64_t, p, 0, kNumPartitions) {
+    partition_offsets.at(p) = offset;
+    FOR_RANGE(int64_t, t, 0, num_threads) {
+      const int64_t num_keys = offsets.at(t * kNumPartitions + p);
+      offsets.at(t * kNumPartitions + p) = offset;
+      offset += num_keys;
+    }
+    const int64_t num_keys = offset - partition_offsets.at(p);
+    table_offsets.at(p + 1) = table_offsets.at(p) + (num_keys == 0 ? 0 : TableCapacity(num_keys));
+  }
+  partition_offsets.at(kNumPartitions) = offset;
+  CHECK_LE(table_offsets.at(kNumPartitions), ws.TotalTableCapacityUpperBound(n));
+  MultiThreadLoop(num_threads, [&](size_t t) {
+    const Range range = chunks.At(t);
+    int64_t* cursors = offsets.data() + t * kNumPartitions;
+    FOR_RANGE(int64_t, i, range.begin(), range.end()) {
+      ws.positions[cursors[PartitionOf(HashKey(in[i]))]++] = i;
+    }
+  });
+
+  // step 2. deduplicate every partition, idx_out holds the local ids
+  std::vector<IDX> partition_num_unique(kNumPartitions, 0);
+  MultiThreadLoop(kNumPartitions, [&](size_t p) {
+    const int64_t begin = partition_offsets.at(p);
+    const int64_t end = partition_offsets.at(p + 1);
+    if (begin == end) { return; }
+    IDX* table = ws.tables + table_offsets.at(p);
+    const int64_t capacity = table_offsets.at(p + 1) - table_offsets.at(p);
+    IDX* first_positions = ws.first_positions + begin;
+    IDX* counts = ws.counts + begin;
+    std::fill(table, table + capacity, -1);
+    IDX num_unique = 0;
+    FOR_RANGE(int64_t, j, begin, end) {
+      const IDX i = ws.positions[j];
+      const KEY key = in[i];
+      const IDX id = FindOrInsert(key, HashKey(key), table, capacity, num_unique,
+                                  [&](IDX id) { return in[first_positions[id]]; });
+      if (id == num_unique) {
+        first_positions[id] = i;
+        counts[id] = 1;
+        ws.is_first[i] = true;
+        num_unique += 1;
+      } else {
+        counts[id] += 1;
+      }
+      idx_out[i] = id;
+    }
+    partition_num_unique.at(p) = num_unique;
+  });
+
+  // step 3. rank the first appearances, the tables are reused to hold the rank of every position
+  IDX* ranks = ws.tables;
+  std::vector<IDX> chunk_num_first(num_threads + 1, 0);
+  MultiThreadLoop(num_threads, [&](size_t t) {
+    const Range range = chunks.At(t);
+    chunk_num_first.at(t + 1) =
+        std::count(ws.is_first + range.begin(), ws.is_first + range.end(), true);
+  });
+  FOR_RANGE(int64_t, t, 0, num_threads) { chunk_num_first.at(t + 1) += chunk_num_first.at(t); }
+  MultiThreadLoop(num_threads, [&](size_t t) {
+    const Range range = chunks.At(t);
+    IDX rank = chunk_num_first.at(t);
+    FOR_RANGE(int64_t, i, range.begin(), range.end()) {
+      if (ws.is_first[i]) { ranks[i] = rank++; }
+    }
+  });
+
+  // step 4. replace the local ids by the global ones
+  MultiThreadLoop(kNumPartitions, [&](size_t p) {
+    const int64_t begin = partition_offsets.at(p);
+    const int64_t end = partition_offsets.at(p + 1);
+    IDX* local_id2id = ws.first_positions + begin;
+    FOR_RANGE(IDX, local_id, 0, partition_num_unique.at(p)) {
+      const IDX first_position = local_id2id[local_id];
+      const IDX id = ranks[first_position];
+      unique_out[id] = in[first_position];
+      if (count != nullptr) { count[id] = ws.counts[begin + local_id]; }
+      local_id2id[local_id] = id;
+    }
+    FOR_RANGE(int64_t, j, begin, end) {
+      const IDX i = ws.positions[j];
+      idx_out[i] = local_id2id[idx_out[i]];
+    }
+  });
+  return chunk_num_first.at(num_threads);
+}
+
+bool IsParallelUnique(int64_t n) {
+  return n >= kParallelUniqueMinKeys && Global<ThreadPool>::Get() != nullptr
+         && Global<ThreadPool>::Get()->thread_num() > 1;
+}
+
+template<typename IDX>
+int64_t UniqueWorkspaceSizeInBytes(int64_t n) {
+  if (n >= kParallelUniqueMinKeys) { return ParallelUniqueWorkspace<IDX>::SizeInBytes(n); }
+  return std::max<int64_t>(TableCapacity(n) * sizeof(IDX), 1);
+}
+
+}  // namespace
+
 template<typename KEY, typename IDX>
 struct UniqueKernelUtil<DeviceType::kCPU, KEY, IDX> {
   static void Unique(DeviceCtx* ctx, int64_t n, const KEY* in, IDX* num_unique, KEY* unique_out,
@@ -27,31 +249,21 @@ struct UniqueKernelUtil<DeviceType::kCPU, KEY, IDX> {
   static void UniqueWithCounts(DeviceCtx* ctx, int64_t n, const KEY* in, IDX* num_unique,
                                KEY* unique_out, IDX* idx_out, IDX* count, void* workspace,
                                int64_t workspace_size_in_bytes) {
-    HashMap<KEY, IDX> map;
-    FOR_RANGE(int64_t, i, 0, n) {
-      KEY in_i = in[i];
-      auto it = map.find(in_i);
-      if (it == map.end()) {
-        IDX idx = map.size();
-        if (count != nullptr) { count[idx] = 1; }
-        idx_out[i] = idx;
-        unique_out[idx] = in_i;
-        map[in_i] = idx;
-      } else {
-        IDX idx = it->second;
-        if (count != nullptr) { count[idx] += 1; }
-        idx_out[i] = idx;
-      }
+    CHECK_GE(workspace_size_in_bytes, UniqueWorkspaceSizeInBytes<IDX>(n));
+    if (IsParallelUnique(n)) {
+      *num_unique = UniqueParallelly(n, in, unique_out, idx_out, count, workspace);
+    } else {
+      *num_unique =
+          UniqueSerially(n, in, unique_out, idx_out, count, reinterpret_cast<IDX*>(workspace));
     }
-    *num_unique = map.size();
   }
   static void GetUniqueWorkspaceSizeInBytes(DeviceCtx* ctx, int64_t n,
                                             int64_t* workspace_size_in_bytes) {
-    *workspace_size_in_bytes = 1;
+    *workspace_size_in_bytes = UniqueWorkspaceSizeInBytes<IDX>(n);
   }
   static void GetUniqueWithCountsWorkspaceSizeInBytes(DeviceCtx* ctx, int64_t n,
                                                       int64_t* workspace_size_in_bytes) {
-    *workspace_size_in_bytes = 1;
+    *workspace_size_in_bytes = UniqueWorkspaceSizeInBytes<IDX>(n);
   }
 };
 
@@ -198,6 +198,7 @@ MUL_BY_SCALAR(double);
 MUL_BY_SCALAR(int8_t);
 MUL_BY_SCALAR(int32_t);
 MUL_BY_SCALAR(int64_t);
+MUL_BY_SCALAR(bfloat16);
 
 #undef MUL_BY_SCALAR
 
@@ -212,6 +213,7 @@ ADD_BY_SCALAR(double);
 ADD_BY_SCALAR(int8_t);
 ADD_BY_SCALAR(int32_t);
 ADD_BY_SCALAR(int64_t);
+ADD_BY_SCALAR(bfloat16);
 
 #undef ADD_BY_SCALAR
 
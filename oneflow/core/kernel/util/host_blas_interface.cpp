@@ -15,6 +15,8 @@ limitations under the License.
 */
 #include "oneflow/core/kernel/util/host_blas_interface.h"
 #include "oneflow/core/register/blob.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/core/common/cpu_isa.h"
 
 namespace oneflow {
 
@@ -66,6 +68,89 @@ void BatchedGemmImpl(DeviceCtx* ctx, const enum CBLAS_ORDER order,
   }
 }
 
+#ifdef OF_WITH_AVX512BF16_DISPATCH
+
+// dot product of two bfloat16 vectors of length k accumulated in float by vdpbf16ps
+OF_TARGET_ISA("avx512f,avx512bw,avx512bf16")
+float BFloat16Dot(const bfloat16* x, const bfloat16* y, const int k) {
+  const int tail = k % 32;
+  const __mmask32 tail_mask = (1U << tail) - 1U;
+  __m512 acc = _mm512_setzero_ps();
+  int p = 0;
+  for (; p + 32 <= k; p += 32) {
+    acc = _mm512_dpbf16_ps(acc, (__m512bh)_mm512_loadu_si512(x + p),
+                           (__m512bh)_mm512_loadu_si512(y + p));
+  }
+  if (tail > 0) {
+    acc = _mm512_dpbf16_ps(acc, (__m512bh)_mm512_maskz_loadu_epi16(tail_mask, x + p),
+                           (__m512bh)_mm512_maskz_loadu_epi16(tail_mask, y + p));
+  }
+  return _mm512_reduce_add_ps(acc);
+}
+
+// Rows of op(a) and columns of op(b) are made contiguous along k, every element of c is then a
+// BFloat16Dot of the two.
+void BFloat16DotGemm(enum CBLAS_TRANSPOSE trans_a, enum CBLAS_TRANSPOSE trans_b, const int m,
+                     const int n, const int k, const float alpha, const bfloat16* a,
+                     const bfloat16* b, const float beta, bfloat16* c) {
+  std::vector<bfloat16> a_buf;
+  const bfloat16* a_rows = a;
+  if (trans_a == CblasTrans) {
+    a_buf.resize(static_cast<size_t>(m) * k);
+    FOR_RANGE(int, p, 0, k) {
+      FOR_RANGE(int, i, 0, m) { a_buf[i * k + p] = a[p * m + i]; }
+    }
+    a_rows = a_buf.data();
+  }
+  std::vector<bfloat16> b_buf;
+  const bfloat16* b_cols = b;
+  if (trans_b == CblasNoTrans) {
+    b_buf.resize(static_cast<size_t>(n) * k);
+    FOR_RANGE(int, p, 0, k) {
+      FOR_RANGE(int, j, 0, n) { b_buf[j * k + p] = b[p * n + j]; }
+    }
+    b_cols = b_buf.data();
+  }
+  auto ComputeRow = [&](size_t i) {
+    const bfloat16* a_row = a_rows + i * k;
+    bfloat16* c_row = c + i * n;
+    FOR_RANGE(int, j, 0, n) {
+      float value = alpha * BFloat16Dot(a_row, b_cols + j * k, k);
+      if (beta != 0.f) { value += beta * static_cast<float>(c_row[j]); }
+      c_row[j] = bfloat16(value);
+    }
+  };
+  if (Global<ThreadPool>::Get() != nullptr && m > 1) {
+    MultiThreadLoop(m, ComputeRow);
+  } else {
+    FOR_RANGE(int, i, 0, m) { ComputeRow(i); }
+  }
+}
+
+#endif  // OF_WITH_AVX512BF16_DISPATCH
+
+// c = alpha * op(a) * op(b) + beta * c with float accumulation, cblas has no bfloat16 gemm so
+// on cpus without AVX512-BF16 the operands are widened to float and handed to sgemm.
+void BFloat16Gemm(enum CBLAS_TRANSPOSE trans_a, enum CBLAS_TRANSPOSE trans_b, const int m,
+                  const int n, const int k, const float alpha, const bfloat16* a,
+                  const bfloat16* b, const float beta, bfloat16* c) {
+#ifdef OF_WITH_AVX512BF16_DISPATCH
+  if (CpuHasAvx512Bf16()) {
+    BFloat16DotGemm(trans_a, trans_b, m, n, k, alpha, a, b, beta, c);
+    return;
+  }
+#endif
+  std::vector<float> a_float(static_cast<size_t>(m) * k);
+  std::vector<float> b_float(static_cast<size_t>(k) * n);
+  std::vector<float> c_float(static_cast<size_t>(m) * n);
+  BFloat16ToFloat(a, a_float.data(), a_float.size());
+  BFloat16ToFloat(b, b_float.data(), b_float.size());
+  if (beta != 0.f) { BFloat16ToFloat(c, c_float.data(), c_float.size()); }
+  Gemm<float>(nullptr, CblasRowMajor, trans_a, trans_b, m, n, k, alpha, a_float.data(),
+              b_float.data(), beta, c_float.data());
+  FloatToBFloat16(c_float.data(), c, c_float.size());
+}
+
 }  // namespace
 
 void BlasIf<DeviceType::kCPU>::BlobGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans_a,
@@ -94,6 +179,13 @@ void BlasIf<DeviceType::kCPU>::OFGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans
   Gemm<double>(ctx, CblasRowMajor, trans_a, trans_b, m, n, k, alpha, a, b, beta, c);
 }
 
+void BlasIf<DeviceType::kCPU>::OFGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans_a,
+                                      enum CBLAS_TRANSPOSE trans_b, const int m, const int n,
+                                      const int k, const bfloat16 alpha, const bfloat16* a,
+                                      const bfloat16* b, const bfloat16 beta, bfloat16* c) {
+  BFloat16Gemm(trans_a, trans_b, m, n, k, alpha, a, b, beta, c);
+}
+
 void BlasIf<DeviceType::kCPU>::OFBatchedGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans_a,
                                              enum CBLAS_TRANSPOSE trans_b, const int batch_size,
                                              const int m, const int n, const int k,
@@ -112,6 +204,16 @@ void BlasIf<DeviceType::kCPU>::OFBatchedGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOS
                           beta, c, buf);
 }
 
+void BlasIf<DeviceType::kCPU>::OFBatchedGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans_a,
+                                             enum CBLAS_TRANSPOSE trans_b, const int batch_size,
+                                             const int m, const int n, const int k,
+                                             const bfloat16 alpha, const bfloat16* a,
+                                             const bfloat16* b, const bfloat16 beta, bfloat16* c,
+                                             bfloat16** buf) {
+  BatchedGemmImpl<bfloat16>(ctx, CblasRowMajor, trans_a, trans_b, batch_size, m, n, k, alpha, a,
+                            b, beta, c, buf);
+}
+
 void BlasIf<DeviceType::kCPU>::Axpy(DeviceCtx* ctx, const int n, const float alpha, const float* x,
                                     const int incx, float* y, const int incy) {
   AxpyImpl<float>(ctx, n, alpha, x, incx, y, incy);
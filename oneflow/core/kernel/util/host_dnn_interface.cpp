@@ -54,6 +54,11 @@ void DnnIf<DeviceType::kCPU>::Relu(DeviceCtx* ctx, const int64_t n, const double
   ReluImpl<double>(ctx, n, x, y);
 }
 
+void DnnIf<DeviceType::kCPU>::Relu(DeviceCtx* ctx, const int64_t n, const bfloat16* x,
+                                   bfloat16* y) {
+  ReluImpl<bfloat16>(ctx, n, x, y);
+}
+
 void DnnIf<DeviceType::kCPU>::ReluBackward(DeviceCtx* ctx, const int64_t n, const float* x,
                                            const float* y, const float* dy, float* dx) {
   ReluBackwardImpl<float>(ctx, n, x, y, dy, dx);
@@ -64,6 +69,11 @@ void DnnIf<DeviceType::kCPU>::ReluBackward(DeviceCtx* ctx, const int64_t n, cons
   ReluBackwardImpl<double>(ctx, n, x, y, dy, dx);
 }
 
+void DnnIf<DeviceType::kCPU>::ReluBackward(DeviceCtx* ctx, const int64_t n, const bfloat16* x,
+                                           const bfloat16* y, const bfloat16* dy, bfloat16* dx) {
+  ReluBackwardImpl<bfloat16>(ctx, n, x, y, dy, dx);
+}
+
 void DnnIf<DeviceType::kCPU>::Sigmoid(DeviceCtx* ctx, int64_t n, const float* x, float* y) {
   SigmoidImpl<float>(ctx, n, x, y);
 }
@@ -72,6 +82,10 @@ void DnnIf<DeviceType::kCPU>::Sigmoid(DeviceCtx* ctx, int64_t n, const double* x
   SigmoidImpl<double>(ctx, n, x, y);
 }
 
+void DnnIf<DeviceType::kCPU>::Sigmoid(DeviceCtx* ctx, int64_t n, const bfloat16* x, bfloat16* y) {
+  SigmoidImpl<bfloat16>(ctx, n, x, y);
+}
+
 void DnnIf<DeviceType::kCPU>::SigmoidBackward(DeviceCtx* ctx, const int64_t n, const float* x,
                                               const float* y, const float* dy, float* dx) {
   SigmoidBackwardImpl<float>(ctx, n, x, y, dy, dx);
@@ -82,4 +96,10 @@ void DnnIf<DeviceType::kCPU>::SigmoidBackward(DeviceCtx* ctx, const int64_t n, c
   SigmoidBackwardImpl<double>(ctx, n, x, y, dy, dx);
 }
 
+void DnnIf<DeviceType::kCPU>::SigmoidBackward(DeviceCtx* ctx, const int64_t n, const bfloat16* x,
+                                              const bfloat16* y, const bfloat16* dy,
+                                              bfloat16* dx) {
+  SigmoidBackwardImpl<bfloat16>(ctx, n, x, y, dy, dx);
+}
+
 }  // namespace oneflow
@@ -0,0 +1,51 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/persistence/async_snapshot_writer.h"
+
+namespace oneflow {
+
+AsyncSnapshotWriter::AsyncSnapshotWriter(int32_t io_thread_num)
+    : pending_work_cnt_(0), io_thread_pool_(io_thread_num), merge_thread_pool_(1) {}
+
+AsyncSnapshotWriter::~AsyncSnapshotWriter() { WaitUntilAllDone(); }
+
+std::function<void()> AsyncSnapshotWriter::WrapWork(const std::function<void()>& work) {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    pending_work_cnt_ += 1;
+  }
+  return [this, work]() {
+    work();
+    std::unique_lock<std::mutex> lock(mutex_);
+    pending_work_cnt_ -= 1;
+    if (pending_work_cnt_ == 0) { cond_.notify_all(); }
+  };
+}
+
+void AsyncSnapshotWriter::AddIoWork(const std::function<void()>& work) {
+  io_thread_pool_.AddWork(WrapWork(work));
+}
+
+void AsyncSnapshotWriter::AddMergeWork(const std::function<void()>& work) {
+  merge_thread_pool_.AddWork(WrapWork(work));
+}
+
+void AsyncSnapshotWriter::WaitUntilAllDone() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this]() { return pending_work_cnt_ == 0; });
+}
+
+}  // namespace oneflow
@@ -0,0 +1,49 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_PERSISTENCE_ASYNC_SNAPSHOT_WRITER_H_
+#define ONEFLOW_CORE_PERSISTENCE_ASYNC_SNAPSHOT_WRITER_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+
+// Runs model saving off the actor threads. Io works never block on other processes, merge works
+// may wait for io works of other processes and therefore run on their own thread, so that waiting
+// merges can never starve the io works they depend on.
+class AsyncSnapshotWriter final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(AsyncSnapshotWriter);
+  explicit AsyncSnapshotWriter(int32_t io_thread_num);
+  ~AsyncSnapshotWriter();
+
+  void AddIoWork(const std::function<void()>& work);
+  void AddMergeWork(const std::function<void()>& work);
+  void WaitUntilAllDone();
+
+ private:
+  std::function<void()> WrapWork(const std::function<void()>& work);
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  int64_t pending_work_cnt_;
+  ThreadPool io_thread_pool_;
+  ThreadPool merge_thread_pool_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_PERSISTENCE_ASYNC_SNAPSHOT_WRITER_H_
@@ -14,42 +14,40 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/persistence/binary_in_stream_with_local_copy.h"
-#include "oneflow/core/persistence/binary_in_stream_without_local_copy.h"
-#include "oneflow/core/common/str_util.h"
 
 namespace oneflow {
 
 BinaryInStreamWithLocalCopy::BinaryInStreamWithLocalCopy(fs::FileSystem* fs,
                                                          const std::string& file_path)
-    : once_read_(false) {
+    : cur_file_pos_(0) {
   LOG(INFO) << "New BinaryInStreamWithLocalCopy " << file_path;
-  in_stream_.reset(new BinaryInStreamWithoutLocalCopy(fs, file_path));
-  local_copy_path_ = JoinPath(FLAGS_log_dir, "global_fs_buffer", file_path);
-  out_stream_.reset(new PersistentOutStream(LocalFS(), local_copy_path_));
-  read_mthd_ = &BinaryInStreamWithLocalCopy::ReadAndWriteToLocal;
-}
-
-int32_t BinaryInStreamWithLocalCopy::ReadAndWriteToLocal(char* s, size_t n) {
-  if (Restart()) {
-    CopyToLocalFinish();
-    return Read(s, n);
-  } else {
-    int32_t ret = in_stream_->Read(s, n);
-    CHECK_EQ(ret, 0);
-    out_stream_->Write(s, n);
-    once_read_ = true;
-    return 0;
+#ifdef OF_PLATFORM_POSIX
+  cache_entry_ = LocalFileCache::Get()->Open(fs, file_path);
+  if (cache_entry_) {
+    file_size_ = cache_entry_->file_size();
+    return;
   }
+  LOG(WARNING) << file_path << " can not be cached locally, read it remotely";
+#endif
+  file_size_ = fs->GetFileSize(file_path);
+  fs->NewRandomAccessFile(file_path, &remote_file_);
 }
 
-bool BinaryInStreamWithLocalCopy::Restart() {
-  return in_stream_->cur_file_pos() == 0 && once_read_;
-}
+BinaryInStreamWithLocalCopy::~BinaryInStreamWithLocalCopy() = default;
 
-void BinaryInStreamWithLocalCopy::CopyToLocalFinish() {
-  out_stream_.reset();
-  in_stream_.reset(new BinaryInStreamWithoutLocalCopy(LocalFS(), local_copy_path_));
-  read_mthd_ = &BinaryInStreamWithLocalCopy::ReadFromLocal;
+int32_t BinaryInStreamWithLocalCopy::Read(char* s, size_t n) {
+  if (IsEof()) { return -1; }
+  CHECK_LE(cur_file_pos_ + n, file_size_);
+#ifdef OF_PLATFORM_POSIX
+  if (cache_entry_) {
+    cache_entry_->Read(cur_file_pos_, n, s);
+    cur_file_pos_ += n;
+    return 0;
+  }
+#endif
+  remote_file_->Read(cur_file_pos_, n, s);
+  cur_file_pos_ += n;
+  return 0;
 }
 
 }  // namespace oneflow
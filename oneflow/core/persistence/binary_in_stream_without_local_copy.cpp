@@ -22,16 +22,45 @@ namespace oneflow {
 int32_t BinaryInStreamWithoutLocalCopy::Read(char* s, size_t n) {
   if (IsEof()) return -1;
   CHECK_LE(cur_file_pos_ + n, file_size_);
-  file_->Read(cur_file_pos_, n, s);
+  if (!ReadFromReadahead(s, n)) { file_->Read(cur_file_pos_, n, s); }
   cur_file_pos_ += n;
+  if (file_->SupportsAsyncRead() && !IsEof()) { StartReadahead(n); }
   return 0;
 }
 
 BinaryInStreamWithoutLocalCopy::BinaryInStreamWithoutLocalCopy(fs::FileSystem* fs,
                                                                const std::string& file_path)
-    : cur_file_pos_(0) {
+    : cur_file_pos_(0), readahead_pos_(0), readahead_size_(0) {
   fs->NewRandomAccessFile(file_path, &file_);
   file_size_ = fs->GetFileSize(file_path);
 }
 
+BinaryInStreamWithoutLocalCopy::~BinaryInStreamWithoutLocalCopy() {
+  if (readahead_counter_) { readahead_counter_->WaitUntilCntEqualZero(); }
+}
+
+// The stream is mostly read in pieces of the same size, so the next piece is guessed to be as large
+// as the last one.
+void BinaryInStreamWithoutLocalCopy::StartReadahead(size_t n) {
+  CHECK(!readahead_counter_);
+  readahead_pos_ = cur_file_pos_;
+  readahead_size_ = std::min<uint64_t>(n, file_size_ - cur_file_pos_);
+  if (readahead_buffer_.size() < readahead_size_) { readahead_buffer_.resize(readahead_size_); }
+  std::shared_ptr<BlockingCounter> counter(new BlockingCounter(1));
+  file_->AsyncReadMany({fs::ReadRequest{readahead_pos_, readahead_size_, readahead_buffer_.data()}},
+                       [counter]() { counter->Decrease(); });
+  readahead_counter_ = counter;
+}
+
+bool BinaryInStreamWithoutLocalCopy::ReadFromReadahead(char* s, size_t n) {
+  if (!readahead_counter_) { return false; }
+  readahead_counter_->WaitUntilCntEqualZero();
+  readahead_counter_.reset();
+  if (cur_file_pos_ < readahead_pos_ || cur_file_pos_ + n > readahead_pos_ + readahead_size_) {
+    return false;
+  }
+  std::memcpy(s, readahead_buffer_.data() + (cur_file_pos_ - readahead_pos_), n);
+  return true;
+}
+
 }  // namespace oneflow
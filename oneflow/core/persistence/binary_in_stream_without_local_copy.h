@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "oneflow/core/persistence/file_system.h"
 #include "oneflow/core/persistence/binary_in_stream.h"
+#include "oneflow/core/common/blocking_counter.h"
 
 namespace oneflow {
 
@@ -25,7 +26,7 @@ class BinaryInStreamWithoutLocalCopy final : public BinaryInStream {
  public:
   OF_DISALLOW_COPY_AND_MOVE(BinaryInStreamWithoutLocalCopy);
   BinaryInStreamWithoutLocalCopy() = delete;
-  virtual ~BinaryInStreamWithoutLocalCopy() = default;
+  virtual ~BinaryInStreamWithoutLocalCopy();
 
   BinaryInStreamWithoutLocalCopy(fs::FileSystem*, const std::string& file_path);
   int32_t Read(char* s, size_t n) override;
@@ -36,9 +37,17 @@ class BinaryInStreamWithoutLocalCopy final : public BinaryInStream {
   bool IsEof() const override { return cur_file_pos_ == file_size_; }
 
  private:
+  void StartReadahead(size_t n);
+  bool ReadFromReadahead(char* s, size_t n);
+
   std::unique_ptr<fs::RandomAccessFile> file_;
   uint64_t file_size_;
   uint64_t cur_file_pos_;
+  // when the file reads asynchronously, the bytes after each read are fetched in background
+  std::vector<char> readahead_buffer_;
+  uint64_t readahead_pos_;
+  size_t readahead_size_;
+  std::shared_ptr<BlockingCounter> readahead_counter_;
 };
 
 }  // namespace oneflow
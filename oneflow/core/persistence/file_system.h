@@ -24,6 +24,13 @@ namespace oneflow {
 
 namespace fs {
 
+// A read of `n` bytes starting at `offset` to `result`.
+struct ReadRequest {
+  uint64_t offset;
+  size_t n;
+  char* result;
+};
+
 // A file abstraction for randomly reading the contents of a file.
 class RandomAccessFile {
  public:
@@ -37,9 +44,46 @@ class RandomAccessFile {
   // Safe for concurrent use by multiple threads.
   virtual void Read(uint64_t offset, size_t n, char* result) const = 0;
 
+  // Reads all the `requests`, implementations may serve them with fewer system calls.
+  //
+  // Safe for concurrent use by multiple threads.
+  virtual void ReadMany(const std::vector<ReadRequest>& requests) const {
+    for (const ReadRequest& request : requests) {
+      Read(request.offset, request.n, request.result);
+    }
+  }
+
+  // Returns true if AsyncReadMany() returns before the reads are done.
+  virtual bool SupportsAsyncRead() const { return false; }
+
+  // Starts reading the `requests` and calls `done`, maybe in another thread, once all of them are
+  // read. The file and the results must outlive the reads.
+  virtual void AsyncReadMany(const std::vector<ReadRequest>& requests,
+                             const std::function<void()>& done) const {
+    ReadMany(requests);
+    done();
+  }
+
  private:
 };
 
+// A readonly memmapped file abstraction.
+//
+// The implementation must guarantee that all memory is accessible when the
+// object exists, independently from the FileSystem that created it.
+class ReadOnlyMemoryRegion {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ReadOnlyMemoryRegion);
+  ReadOnlyMemoryRegion() = default;
+  virtual ~ReadOnlyMemoryRegion() = default;
+
+  // Returns a pointer to the memory region.
+  virtual const char* data() const = 0;
+
+  // Returns the length of the memory region in bytes.
+  virtual uint64_t length() const = 0;
+};
+
 //  A file abstraction for sequential writing.
 //
 // The implementation must provide buffering since callers may append
@@ -70,6 +114,10 @@ class WritableFile {
   // persisted, depending on the implementation.
   virtual void Flush() = 0;
 
+  // Flushes the file and makes sure its contents reach the storage device, file systems
+  // without a stronger guarantee fall back to Flush().
+  virtual void Sync() { Flush(); }
+
  private:
 };
 
@@ -90,6 +138,19 @@ class FileSystem {
   virtual void NewRandomAccessFile(const std::string& fname,
                                    std::unique_ptr<RandomAccessFile>* result) = 0;
 
+  // Returns true if NewReadOnlyMemoryRegionFromFile() is implemented.
+  virtual bool SupportsReadOnlyMemoryRegion() const { return false; }
+
+  // Creates a readonly region of memory with the file context.
+  //
+  // On success, it returns a pointer to read-only memory region
+  // from the content of file fname. The ownership of the region is passed to
+  // the caller.
+  virtual void NewReadOnlyMemoryRegionFromFile(const std::string& fname,
+                                               std::unique_ptr<ReadOnlyMemoryRegion>* result) {
+    UNIMPLEMENTED();
+  }
+
   // Creates an object that writes to a new file with the specified
   // name.
   //
@@ -149,6 +210,9 @@ class FileSystem {
   // Returns the size of `fname`.
   virtual uint64_t GetFileSize(const std::string& fname) = 0;
 
+  // Returns the last modification time of the file in nanoseconds, 0 if not supported.
+  virtual int64_t GetFileModificationTime(const std::string& fname) { return 0; }
+
   // Overwrites the target if it exists.
   virtual void RenameFile(const std::string& old_name, const std::string& new_name) = 0;
 
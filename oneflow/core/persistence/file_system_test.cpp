@@ -17,6 +17,8 @@ limitations under the License.
 #include "oneflow/core/common/process_state.h"
 #include "oneflow/core/common/str_util.h"
 #include "oneflow/core/persistence/posix/posix_file_system.h"
+#include "oneflow/core/common/blocking_counter.h"
+#include "oneflow/core/job/job_set.pb.h"
 
 namespace oneflow {
 
@@ -86,6 +88,43 @@ void TestDirOperation(FileSystem* file_system) {
   ASSERT_TRUE(!file_system->IsDirectory(test_root_path));
 }
 
+void TestReadMany(FileSystem* file_system) {
+  std::string current_dir = GetCwd();
+  StringReplace(&current_dir, '\\', '/');
+  std::string file_name = JoinPath(current_dir, "/tmp_test_read_many_file");
+  std::vector<char> content(3 * 1024 * 1024 + 17);
+  FOR_RANGE(size_t, i, 0, content.size()) { content.at(i) = static_cast<char>(i * 7 + i / 4096); }
+  std::unique_ptr<WritableFile> writable_file;
+  file_system->NewWritableFile(file_name, &writable_file);
+  writable_file->Append(content.data(), content.size());
+  writable_file->Close();
+  std::unique_ptr<RandomAccessFile> file;
+  file_system->NewRandomAccessFile(file_name, &file);
+  const std::vector<std::pair<uint64_t, size_t>> ranges = {
+      {0, 1}, {1, 4095}, {4095, 2}, {12345, 2 * 1024 * 1024}, {content.size() - 3, 3}, {100, 0}};
+  std::vector<std::vector<char>> results(ranges.size());
+  std::vector<ReadRequest> requests;
+  FOR_RANGE(size_t, i, 0, ranges.size()) {
+    results.at(i).resize(ranges.at(i).second);
+    requests.push_back(ReadRequest{ranges.at(i).first, ranges.at(i).second, results.at(i).data()});
+  }
+  auto CheckResults = [&]() {
+    FOR_RANGE(size_t, i, 0, ranges.size()) {
+      ASSERT_TRUE(std::equal(results.at(i).begin(), results.at(i).end(),
+                             content.begin() + ranges.at(i).first));
+      std::fill(results.at(i).begin(), results.at(i).end(), 0);
+    }
+  };
+  file->ReadMany(requests);
+  CheckResults();
+  BlockingCounter counter(1);
+  file->AsyncReadMany(requests, [&counter]() { counter.Decrease(); });
+  counter.WaitUntilCntEqualZero();
+  CheckResults();
+  file.reset();
+  file_system->DelFile(file_name);
+}
+
 void TestFileSystem(FileSystem* file_system) {
   TestFileOperation(file_system);
   TestDirOperation(file_system);
@@ -100,4 +139,22 @@ TEST(file_system, write_and_read) {
 #endif
 }
 
+TEST(file_system, read_many) {
+#ifdef OF_PLATFORM_POSIX
+  for (bool enable_io_uring : {false, true}) {
+    for (bool enable_direct_io : {false, true}) {
+      IOConf io_conf;
+      io_conf.mutable_data_fs_conf()->mutable_localfs_conf();
+      io_conf.mutable_snapshot_fs_conf()->mutable_localfs_conf();
+      io_conf.set_enable_io_uring(enable_io_uring);
+      io_conf.set_enable_direct_io(enable_direct_io);
+      Global<const IOConf>::New(io_conf);
+      fs::PosixFileSystem file_system;
+      fs::TestReadMany(&file_system);
+      Global<const IOConf>::Delete();
+    }
+  }
+#endif
+}
+
 }  // namespace oneflow
@@ -334,6 +334,17 @@ uint64_t HadoopFileSystem::GetFileSize(const std::string& fname) {
   return ret;
 }
 
+int64_t HadoopFileSystem::GetFileModificationTime(const std::string& fname) {
+  hdfsFS fs = nullptr;
+  CHECK(Connect(&fs));
+
+  hdfsFileInfo* info = hdfs_->hdfsGetPathInfo(fs, TranslateName(fname).c_str());
+  PCHECK(info != nullptr) << fname;
+  int64_t ret = static_cast<int64_t>(info->mLastMod) * 1000000000;
+  hdfs_->hdfsFreeFileInfo(info, 1);
+  return ret;
+}
+
 void HadoopFileSystem::RenameFile(const std::string& old_name, const std::string& new_name) {
   hdfsFS fs = nullptr;
   CHECK(Connect(&fs));
@@ -101,6 +101,8 @@ class HadoopFileSystem final : public FileSystem {
 
   uint64_t GetFileSize(const std::string& fname) override;
 
+  int64_t GetFileModificationTime(const std::string& fname) override;
+
   void RenameFile(const std::string& old_name, const std::string& new_name) override;
 
   bool IsDirectory(const std::string& fname) override;
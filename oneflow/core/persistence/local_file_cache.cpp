@@ -0,0 +1,308 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/persistence/local_file_cache.h"
+
+#ifdef OF_PLATFORM_POSIX
+
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/job/job_set.pb.h"
+#include "oneflow/core/job/resource_desc.h"
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace oneflow {
+
+namespace {
+
+constexpr uint64_t kMetaMagic = 0x4f46434143484531;  // "OFCACHE1"
+constexpr size_t kDefaultBlockSize = 4 * 1024 * 1024;
+
+struct MetaHeader {
+  uint64_t magic;
+  uint64_t file_size;
+  int64_t modification_time;
+  uint64_t block_size;
+  uint64_t path_size;
+};
+
+void PReadFully(int fd, char* dst, size_t n, uint64_t offset) {
+  while (n > 0) {
+    const ssize_t r = pread(fd, dst, n, static_cast<off_t>(offset));
+    if (r > 0) {
+      dst += r;
+      n -= r;
+      offset += r;
+    } else {
+      CHECK_NE(r, 0) << "Read EOF";
+      PCHECK(errno == EINTR || errno == EAGAIN);
+    }
+  }
+}
+
+void PWriteFully(int fd, const char* src, size_t n, uint64_t offset) {
+  while (n > 0) {
+    const ssize_t r = pwrite(fd, src, n, static_cast<off_t>(offset));
+    if (r >= 0) {
+      src += r;
+      n -= r;
+      offset += r;
+    } else {
+      PCHECK(errno == EINTR || errno == EAGAIN);
+    }
+  }
+}
+
+// FNV-1a, stable across processes and builds unlike std::hash
+void HashBytes(const void* data, size_t size, uint64_t* hash) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  FOR_RANGE(size_t, i, 0, size) {
+    *hash ^= bytes[i];
+    *hash *= 1099511628211ULL;
+  }
+}
+
+std::string GenEntryKey(const std::string& path, uint64_t file_size, int64_t modification_time,
+                        uint64_t block_size) {
+  uint64_t hash = 14695981039346656037ULL;
+  HashBytes(path.data(), path.size(), &hash);
+  HashBytes(&file_size, sizeof(file_size), &hash);
+  HashBytes(&modification_time, sizeof(modification_time), &hash);
+  HashBytes(&block_size, sizeof(block_size), &hash);
+  char key[17];
+  snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(hash));
+  return std::string(key);
+}
+
+bool HasSuffix(const std::string& str, const std::string& suffix) {
+  return str.size() >= suffix.size()
+         && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+class FileLockGuard final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(FileLockGuard);
+  explicit FileLockGuard(int fd) : fd_(fd) { PCHECK(flock(fd_, LOCK_EX) == 0); }
+  ~FileLockGuard() { PCHECK(flock(fd_, LOCK_UN) == 0); }
+
+ private:
+  int fd_;
+};
+
+}  // namespace
+
+LocalFileCacheEntry::LocalFileCacheEntry(fs::FileSystem* fs, const std::string& path,
+                                         uint64_t file_size, size_t block_size, int data_fd,
+                                         int meta_fd, uint64_t flags_offset)
+    : fs_(fs),
+      path_(path),
+      file_size_(file_size),
+      block_size_(block_size),
+      data_fd_(data_fd),
+      meta_fd_(meta_fd),
+      flags_offset_(flags_offset),
+      filled_(RoundUp(file_size, block_size) / block_size, false) {}
+
+LocalFileCacheEntry::~LocalFileCacheEntry() {
+  // closing the data file drops the shared lock which protects the entry from eviction
+  PCHECK(close(data_fd_) == 0);
+  PCHECK(close(meta_fd_) == 0);
+}
+
+void LocalFileCacheEntry::Read(uint64_t offset, size_t n, char* result) {
+  CHECK_LE(offset + n, file_size_);
+  if (n == 0) { return; }
+  FOR_RANGE(int64_t, block_id, offset / block_size_, (offset + n - 1) / block_size_ + 1) {
+    EnsureBlock(block_id);
+  }
+  PReadFully(data_fd_, result, n, offset);
+}
+
+void LocalFileCacheEntry::EnsureBlock(int64_t block_id) {
+  if (filled_.at(block_id)) { return; }
+  if (!IsBlockFilled(block_id)) {
+    // the processes reading the same block wait for the first one to fetch it
+    LockBlock(block_id, true);
+    if (!IsBlockFilled(block_id)) {
+      const uint64_t offset = block_id * block_size_;
+      const size_t size = std::min<uint64_t>(block_size_, file_size_ - offset);
+      if (!remote_file_) { fs_->NewRandomAccessFile(path_, &remote_file_); }
+      block_buffer_.resize(block_size_);
+      remote_file_->Read(offset, size, block_buffer_.data());
+      PWriteFully(data_fd_, block_buffer_.data(), size, offset);
+      const char filled = 1;
+      PWriteFully(meta_fd_, &filled, 1, flags_offset_ + block_id);
+    }
+    LockBlock(block_id, false);
+  }
+  filled_.at(block_id) = true;
+}
+
+bool LocalFileCacheEntry::IsBlockFilled(int64_t block_id) const {
+  char filled = 0;
+  PReadFully(meta_fd_, &filled, 1, flags_offset_ + block_id);
+  return filled != 0;
+}
+
+void LocalFileCacheEntry::LockBlock(int64_t block_id, bool lock) const {
+  struct flock fl;
+  std::memset(&fl, 0, sizeof(fl));
+  fl.l_type = lock ? F_WRLCK : F_UNLCK;
+  fl.l_whence = SEEK_SET;
+  fl.l_start = flags_offset_ + block_id;
+  fl.l_len = 1;
+  // open file description locks also exclude the other threads of this process
+#ifdef F_OFD_SETLKW
+  const int cmd = F_OFD_SETLKW;
+#else
+  const int cmd = F_SETLKW;
+#endif
+  while (fcntl(meta_fd_, cmd, &fl) != 0) { PCHECK(errno == EINTR); }
+}
+
+LocalFileCache::LocalFileCache(const std::string& dir, uint64_t capacity, size_t block_size)
+    : dir_(dir), capacity_(capacity), block_size_(block_size) {
+  CHECK_GT(block_size_, 0);
+  LocalFS()->RecursivelyCreateDirIfNotExist(dir_);
+  const std::string lock_path = JoinPath(dir_, ".lock");
+  lock_fd_ = open(lock_path.c_str(), O_RDWR | O_CREAT, 0644);
+  PCHECK(lock_fd_ != -1) << "Fail to open " << lock_path;
+}
+
+LocalFileCache::~LocalFileCache() { close(lock_fd_); }
+
+LocalFileCache* LocalFileCache::Get() {
+  static LocalFileCache* cache = []() {
+    IOConf io_conf;
+    if (Global<const IOConf>::Get() != nullptr) { io_conf = *Global<const IOConf>::Get(); }
+    const std::string dir = io_conf.data_cache_dir().empty()
+                                ? JoinPath(FLAGS_log_dir, "global_fs_buffer")
+                                : io_conf.data_cache_dir();
+    return new LocalFileCache(dir, io_conf.data_cache_mbyte() * kMB, kDefaultBlockSize);
+  }();
+  return cache;
+}
+
+std::unique_ptr<LocalFileCacheEntry> LocalFileCache::Open(fs::FileSystem* fs,
+                                                          const std::string& path) {
+  const uint64_t file_size = fs->GetFileSize(path);
+  const int64_t modification_time = fs->GetFileModificationTime(path);
+  if (file_size > capacity_) { return nullptr; }
+  const std::string key = GenEntryKey(path, file_size, modification_time, block_size_);
+  const std::string data_path = JoinPath(dir_, key + ".data");
+  const std::string meta_path = JoinPath(dir_, key + ".meta");
+  MetaHeader header;
+  header.magic = kMetaMagic;
+  header.file_size = file_size;
+  header.modification_time = modification_time;
+  header.block_size = block_size_;
+  header.path_size = path.size();
+  const uint64_t flags_offset = sizeof(MetaHeader) + path.size();
+  std::unique_lock<std::mutex> lock(mutex_);
+  FileLockGuard dir_lock(lock_fd_);
+  int meta_fd = open(meta_path.c_str(), O_RDWR);
+  if (meta_fd == -1) {
+    PCHECK(errno == ENOENT);
+    if (!EvictUntilFit(file_size)) { return nullptr; }
+    int data_fd = open(data_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    PCHECK(data_fd != -1) << "Fail to create " << data_path;
+    PCHECK(ftruncate(data_fd, file_size) == 0);
+    PCHECK(close(data_fd) == 0);
+    // the meta file appears at last, so an entry with a meta file is always complete
+    const std::string tmp_meta_path = meta_path + ".tmp";
+    int tmp_meta_fd = open(tmp_meta_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    PCHECK(tmp_meta_fd != -1) << "Fail to create " << tmp_meta_path;
+    std::string meta(reinterpret_cast<const char*>(&header), sizeof(header));
+    meta += path;
+    meta.append(RoundUp(file_size, block_size_) / block_size_, '\0');
+    PWriteFully(tmp_meta_fd, meta.data(), meta.size(), 0);
+    PCHECK(close(tmp_meta_fd) == 0);
+    PCHECK(rename(tmp_meta_path.c_str(), meta_path.c_str()) == 0);
+    meta_fd = open(meta_path.c_str(), O_RDWR);
+    PCHECK(meta_fd != -1) << "Fail to open " << meta_path;
+  }
+  MetaHeader cached_header;
+  std::string cached_path(path.size(), '\0');
+  PReadFully(meta_fd, reinterpret_cast<char*>(&cached_header), sizeof(cached_header), 0);
+  if (cached_header.path_size == path.size()) {
+    PReadFully(meta_fd, &cached_path.at(0), path.size(), sizeof(cached_header));
+  }
+  if (std::memcmp(&cached_header, &header, sizeof(header)) != 0 || cached_path != path) {
+    LOG(WARNING) << "local cache entry " << meta_path << " does not match " << path;
+    PCHECK(close(meta_fd) == 0);
+    return nullptr;
+  }
+  int data_fd = open(data_path.c_str(), O_RDWR);
+  PCHECK(data_fd != -1) << "Fail to open " << data_path;
+  // held until the entry is closed, the evictor skips the entries locked
+  PCHECK(flock(data_fd, LOCK_SH) == 0);
+  // the modification time of the meta file records the last use
+  PCHECK(futimens(meta_fd, nullptr) == 0);
+  return std::unique_ptr<LocalFileCacheEntry>(new LocalFileCacheEntry(
+      fs, path, file_size, block_size_, data_fd, meta_fd, flags_offset));
+}
+
+bool LocalFileCache::EvictUntilFit(uint64_t reserved_size) {
+  struct Candidate {
+    int64_t last_use_time;
+    uint64_t size;
+    std::string key;
+  };
+  std::vector<Candidate> candidates;
+  uint64_t total_size = 0;
+  for (const std::string& name : LocalFS()->ListDir(dir_)) {
+    if (HasSuffix(name, ".tmp")) {
+      unlink(JoinPath(dir_, name).c_str());
+      continue;
+    }
+    if (!HasSuffix(name, ".data")) { continue; }
+    struct stat data_stat;
+    if (stat(JoinPath(dir_, name).c_str(), &data_stat) != 0) { continue; }
+    Candidate candidate;
+    candidate.key = name.substr(0, name.size() - std::string(".data").size());
+    candidate.size = data_stat.st_size;
+    // a data file without meta file is left by a crash during creation, it goes first
+    struct stat meta_stat;
+    candidate.last_use_time = 0;
+    if (stat(JoinPath(dir_, candidate.key + ".meta").c_str(), &meta_stat) == 0) {
+      candidate.last_use_time =
+          static_cast<int64_t>(meta_stat.st_mtim.tv_sec) * 1000000000 + meta_stat.st_mtim.tv_nsec;
+    }
+    candidates.push_back(candidate);
+    total_size += candidate.size;
+  }
+  std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+    return a.last_use_time < b.last_use_time;
+  });
+  for (const Candidate& candidate : candidates) {
+    if (total_size + reserved_size <= capacity_) { break; }
+    const std::string data_path = JoinPath(dir_, candidate.key + ".data");
+    int data_fd = open(data_path.c_str(), O_RDWR);
+    if (data_fd == -1) { continue; }
+    if (flock(data_fd, LOCK_EX | LOCK_NB) == 0) {
+      unlink(JoinPath(dir_, candidate.key + ".meta").c_str());
+      unlink(data_path.c_str());
+      total_size -= candidate.size;
+    }
+    PCHECK(close(data_fd) == 0);
+  }
+  return total_size + reserved_size <= capacity_;
+}
+
+}  // namespace oneflow
+
+#endif  // OF_PLATFORM_POSIX
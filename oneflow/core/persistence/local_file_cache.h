@@ -0,0 +1,88 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_PERSISTENCE_LOCAL_FILE_CACHE_H_
+#define ONEFLOW_CORE_PERSISTENCE_LOCAL_FILE_CACHE_H_
+
+#include "oneflow/core/persistence/file_system.h"
+
+#ifdef OF_PLATFORM_POSIX
+
+namespace oneflow {
+
+// A cached copy of a remote file, filled block by block on first read. The blocks are fetched once
+// no matter how many processes read them at the same time. Not thread safe.
+class LocalFileCacheEntry final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(LocalFileCacheEntry);
+  ~LocalFileCacheEntry();
+
+  uint64_t file_size() const { return file_size_; }
+  void Read(uint64_t offset, size_t n, char* result);
+
+ private:
+  friend class LocalFileCache;
+  LocalFileCacheEntry(fs::FileSystem* fs, const std::string& path, uint64_t file_size,
+                      size_t block_size, int data_fd, int meta_fd, uint64_t flags_offset);
+  void EnsureBlock(int64_t block_id);
+  bool IsBlockFilled(int64_t block_id) const;
+  void LockBlock(int64_t block_id, bool lock) const;
+
+  fs::FileSystem* fs_;
+  std::string path_;
+  uint64_t file_size_;
+  size_t block_size_;
+  int data_fd_;
+  int meta_fd_;
+  // the meta file has a byte per block from here, set once the block is filled
+  uint64_t flags_offset_;
+  std::unique_ptr<fs::RandomAccessFile> remote_file_;
+  std::vector<char> block_buffer_;
+  // blocks known to be filled, they stay filled while the entry is open
+  std::vector<bool> filled_;
+};
+
+// A content-addressed cache of remote files in a local directory, shared by the processes of a
+// node and by later sessions. Entries are keyed by the path, size and modification time of the
+// remote file, the least recently used ones are evicted to keep the cache within its byte budget.
+// Entries being read are never evicted.
+class LocalFileCache final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(LocalFileCache);
+  LocalFileCache(const std::string& dir, uint64_t capacity, size_t block_size);
+  ~LocalFileCache();
+
+  // The cache configured by IOConf.
+  static LocalFileCache* Get();
+
+  // Returns nullptr if the file can not be cached, e.g. it does not fit in the budget.
+  std::unique_ptr<LocalFileCacheEntry> Open(fs::FileSystem* fs, const std::string& path);
+
+ private:
+  bool EvictUntilFit(uint64_t reserved_size);
+
+  std::string dir_;
+  uint64_t capacity_;
+  size_t block_size_;
+  // guards the directory among the threads of this process, lock_fd_ among processes
+  std::mutex mutex_;
+  int lock_fd_;
+};
+
+}  // namespace oneflow
+
+#endif  // OF_PLATFORM_POSIX
+
+#endif  // ONEFLOW_CORE_PERSISTENCE_LOCAL_FILE_CACHE_H_
@@ -0,0 +1,168 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/local_file_cache.h"
+#include "oneflow/core/persistence/posix/posix_file_system.h"
+
+#ifdef OF_PLATFORM_POSIX
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+namespace oneflow {
+
+namespace {
+
+constexpr size_t kBlockSize = 1024 * 1024;
+
+std::string TestDir(const std::string& name) {
+  std::string current_dir = GetCwd();
+  StringReplace(&current_dir, '\\', '/');
+  const std::string dir = JoinPath(current_dir, "tmp_local_file_cache_test_" + name);
+  if (LocalFS()->IsDirectory(dir)) { LocalFS()->RecursivelyDeleteDir(dir); }
+  LocalFS()->RecursivelyCreateDir(dir);
+  return dir;
+}
+
+std::string WriteFile(fs::FileSystem* file_system, const std::string& file_name, size_t size,
+                      char seed) {
+  std::string content(size, '\0');
+  FOR_RANGE(size_t, i, 0, size) { content.at(i) = static_cast<char>(seed + i * 7 + i / 4096); }
+  std::unique_ptr<fs::WritableFile> file;
+  file_system->NewWritableFile(file_name, &file);
+  file->Append(content.data(), content.size());
+  file->Close();
+  return content;
+}
+
+std::string ReadAll(LocalFileCacheEntry* entry) {
+  std::string result(entry->file_size(), '\0');
+  entry->Read(0, result.size(), &result.at(0));
+  return result;
+}
+
+size_t CountEntries(const std::string& cache_dir) {
+  size_t count = 0;
+  for (const std::string& name : LocalFS()->ListDir(cache_dir)) {
+    if (name.size() > 5 && name.substr(name.size() - 5) == ".data") { count += 1; }
+  }
+  return count;
+}
+
+}  // namespace
+
+TEST(local_file_cache, read) {
+  fs::PosixFileSystem file_system;
+  const std::string src_dir = TestDir("read_src");
+  const std::string cache_dir = TestDir("read_cache");
+  const std::string file_name = JoinPath(src_dir, "file");
+  const std::string content = WriteFile(&file_system, file_name, 10 * kBlockSize + 123, 1);
+  LocalFileCache cache(cache_dir, 64 * kBlockSize, kBlockSize);
+  {
+    std::unique_ptr<LocalFileCacheEntry> entry = cache.Open(&file_system, file_name);
+    ASSERT_TRUE(entry);
+    ASSERT_EQ(entry->file_size(), content.size());
+    const std::vector<std::pair<uint64_t, size_t>> ranges = {
+        {0, 1}, {kBlockSize - 1, 2}, {3 * kBlockSize + 5, 4 * kBlockSize}, {content.size() - 3, 3}};
+    for (const auto& range : ranges) {
+      std::string result(range.second, '\0');
+      entry->Read(range.first, range.second, &result.at(0));
+      ASSERT_EQ(result, content.substr(range.first, range.second));
+    }
+    ASSERT_EQ(ReadAll(entry.get()), content);
+  }
+  // the cached blocks are not fetched again, even if the remote file changes in place
+  struct stat src_stat;
+  ASSERT_EQ(stat(file_name.c_str(), &src_stat), 0);
+  WriteFile(&file_system, file_name, content.size(), 2);
+  struct timespec times[2] = {src_stat.st_atim, src_stat.st_mtim};
+  ASSERT_EQ(utimensat(AT_FDCWD, file_name.c_str(), times, 0), 0);
+  {
+    LocalFileCache other_cache(cache_dir, 64 * kBlockSize, kBlockSize);
+    std::unique_ptr<LocalFileCacheEntry> entry = other_cache.Open(&file_system, file_name);
+    ASSERT_TRUE(entry);
+    ASSERT_EQ(ReadAll(entry.get()), content);
+  }
+  ASSERT_EQ(CountEntries(cache_dir), 1);
+  LocalFS()->RecursivelyDeleteDir(src_dir);
+  LocalFS()->RecursivelyDeleteDir(cache_dir);
+}
+
+TEST(local_file_cache, evict) {
+  fs::PosixFileSystem file_system;
+  const std::string src_dir = TestDir("evict_src");
+  const std::string cache_dir = TestDir("evict_cache");
+  std::vector<std::string> file_names;
+  std::vector<std::string> contents;
+  FOR_RANGE(int32_t, i, 0, 3) {
+    file_names.push_back(JoinPath(src_dir, "file_" + std::to_string(i)));
+    contents.push_back(WriteFile(&file_system, file_names.back(), kBlockSize + kBlockSize / 2, i));
+  }
+  LocalFileCache cache(cache_dir, 3 * kBlockSize, kBlockSize);
+  const std::string large_file_name = JoinPath(src_dir, "large_file");
+  WriteFile(&file_system, large_file_name, 3 * kBlockSize + 1, 0);
+  ASSERT_FALSE(cache.Open(&file_system, large_file_name));
+  // the entries in use are not evicted
+  std::unique_ptr<LocalFileCacheEntry> entry_0 = cache.Open(&file_system, file_names.at(0));
+  std::unique_ptr<LocalFileCacheEntry> entry_1 = cache.Open(&file_system, file_names.at(1));
+  ASSERT_TRUE(entry_0);
+  ASSERT_TRUE(entry_1);
+  ASSERT_FALSE(cache.Open(&file_system, file_names.at(2)));
+  entry_0.reset();
+  entry_1.reset();
+  // the least recently used entry is evicted, the mtime resolution may be a few milliseconds
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_EQ(ReadAll(cache.Open(&file_system, file_names.at(0)).get()), contents.at(0));
+  std::unique_ptr<LocalFileCacheEntry> entry_2 = cache.Open(&file_system, file_names.at(2));
+  ASSERT_TRUE(entry_2);
+  ASSERT_EQ(ReadAll(entry_2.get()), contents.at(2));
+  ASSERT_EQ(CountEntries(cache_dir), 2);
+  ASSERT_EQ(ReadAll(cache.Open(&file_system, file_names.at(0)).get()), contents.at(0));
+  entry_2.reset();
+  LocalFS()->RecursivelyDeleteDir(src_dir);
+  LocalFS()->RecursivelyDeleteDir(cache_dir);
+}
+
+TEST(local_file_cache, concurrent_read) {
+  fs::PosixFileSystem file_system;
+  const std::string src_dir = TestDir("concurrent_src");
+  const std::string cache_dir = TestDir("concurrent_cache");
+  const std::string file_name = JoinPath(src_dir, "file");
+  const std::string content = WriteFile(&file_system, file_name, 8 * kBlockSize + 7, 3);
+  LocalFileCache cache(cache_dir, 64 * kBlockSize, kBlockSize);
+  std::vector<std::thread> threads;
+  std::atomic<int32_t> mismatch_cnt(0);
+  FOR_RANGE(int32_t, i, 0, 8) {
+    threads.emplace_back([&, i]() {
+      std::unique_ptr<LocalFileCacheEntry> entry = cache.Open(&file_system, file_name);
+      const uint64_t offset = i * 997;
+      const size_t n = content.size() - 2 * offset;
+      std::string result(n, '\0');
+      entry->Read(offset, n, &result.at(0));
+      if (result != content.substr(offset, n)) { mismatch_cnt += 1; }
+    });
+  }
+  for (std::thread& thread : threads) { thread.join(); }
+  ASSERT_EQ(mismatch_cnt, 0);
+  LocalFS()->RecursivelyDeleteDir(src_dir);
+  LocalFS()->RecursivelyDeleteDir(cache_dir);
+}
+
+}  // namespace oneflow
+
+#endif  // OF_PLATFORM_POSIX
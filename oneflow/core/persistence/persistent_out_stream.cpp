@@ -36,4 +36,6 @@ PersistentOutStream& PersistentOutStream::Write(const char* s, size_t n) {
 
 void PersistentOutStream::Flush() { file_->Flush(); }
 
+void PersistentOutStream::Sync() { file_->Sync(); }
+
 }  // namespace oneflow
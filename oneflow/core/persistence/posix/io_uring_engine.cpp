@@ -0,0 +1,327 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/persistence/posix/io_uring_engine.h"
+
+#ifdef OF_PLATFORM_POSIX
+
+#ifdef OF_WITH_IO_URING
+#include <sys/uio.h>
+#endif  // OF_WITH_IO_URING
+
+namespace oneflow {
+
+namespace fs {
+
+#ifdef OF_WITH_IO_URING
+
+namespace {
+
+constexpr uint32_t kSqEntries = 256;
+constexpr size_t kDirectIoAlignment = 4096;
+constexpr size_t kDirectIoBufferSize = 1024 * 1024;
+constexpr int64_t kDirectIoBufferNum = 16;
+// the user_data of the NOP which stops the completion thread
+constexpr uint64_t kStopUserData = 0;
+
+uint64_t AlignDown(uint64_t val, uint64_t alignment) { return val / alignment * alignment; }
+
+}  // namespace
+
+struct IoUringEngine::Batch {
+  std::atomic<int64_t> pending_cnt;
+  std::function<void()> done;
+};
+
+// The next read of an op is [offset, offset + size) to buf, it finishes once needed bytes are read.
+// A direct io op reads whole blocks to a bounce buffer and copies n bytes from buf_offset to dst.
+struct IoUringEngine::Op {
+  Batch* batch;
+  int fd;
+  uint64_t offset;
+  char* buf;
+  size_t size;
+  size_t needed;
+  int64_t buffer_id;
+  size_t buf_offset;
+  char* dst;
+  size_t n;
+  iovec iov;
+};
+
+IoUringEngine* IoUringEngine::Get() {
+  static std::unique_ptr<IoUringEngine> engine = []() {
+    std::unique_ptr<IoUringEngine> new_engine(new IoUringEngine());
+    if (!new_engine->Init()) { new_engine.reset(); }
+    return new_engine;
+  }();
+  return engine.get();
+}
+
+IoUringEngine::IoUringEngine() : inflight_cnt_(0), direct_io_buffers_registered_(false) {}
+
+bool IoUringEngine::Init() {
+  if (!ring_.Init(kSqEntries)) {
+    LOG(WARNING) << "fall back to pread";
+    return false;
+  }
+  completion_thread_ = std::thread(&IoUringEngine::PollCompletions, this);
+  return true;
+}
+
+IoUringEngine::~IoUringEngine() {
+  if (completion_thread_.joinable()) {
+    {
+      std::unique_lock<std::mutex> lock(sq_mutex_);
+      io_uring_sqe sqe;
+      std::memset(&sqe, 0, sizeof(sqe));
+      sqe.opcode = IORING_OP_NOP;
+      sqe.user_data = kStopUserData;
+      ring_.PushSqe(sqe);
+      ring_.EnterUntilSubmitted(1);
+    }
+    completion_thread_.join();
+  }
+  if (direct_io_buffers_registered_) {
+    PCHECK(ring_.Register(IORING_UNREGISTER_BUFFERS, nullptr, 0) == 0);
+  }
+  for (char* buffer : direct_io_buffers_) { free(buffer); }
+}
+
+void IoUringEngine::AsyncReadMany(int fd, bool is_direct_fd,
+                                  const std::vector<ReadRequest>& requests,
+                                  const std::function<void()>& done) {
+  std::vector<Op*> ops;
+  auto* batch = new Batch;
+  batch->done = done;
+  for (const ReadRequest& request : requests) {
+    if (request.n == 0) { continue; }
+    if (!is_direct_fd) {
+      auto* op = new Op;
+      op->batch = batch;
+      op->fd = fd;
+      op->offset = request.offset;
+      op->buf = request.result;
+      op->size = request.n;
+      op->needed = request.n;
+      op->buffer_id = -1;
+      ops.push_back(op);
+      continue;
+    }
+    // every piece fits in a bounce buffer after being extended to whole blocks
+    uint64_t offset = request.offset;
+    const uint64_t end = request.offset + request.n;
+    while (offset < end) {
+      const uint64_t aligned_offset = AlignDown(offset, kDirectIoAlignment);
+      const uint64_t piece_end = std::min<uint64_t>(end, aligned_offset + kDirectIoBufferSize);
+      auto* op = new Op;
+      op->batch = batch;
+      op->fd = fd;
+      op->offset = aligned_offset;
+      op->buf = nullptr;
+      op->size = RoundUp(piece_end - aligned_offset, kDirectIoAlignment);
+      op->needed = piece_end - aligned_offset;
+      op->buffer_id = -1;
+      op->buf_offset = offset - aligned_offset;
+      op->dst = request.result + (offset - request.offset);
+      op->n = piece_end - offset;
+      ops.push_back(op);
+      offset = piece_end;
+    }
+  }
+  if (ops.empty()) {
+    delete batch;
+    done();
+    return;
+  }
+  batch->pending_cnt = ops.size();
+  if (!is_direct_fd) {
+    Submit(ops);
+    return;
+  }
+  std::call_once(direct_io_buffers_once_, [this]() { InitDirectIoBuffers(); });
+  // a batch larger than the pool of bounce buffers is submitted in parts, the buffers are freed by
+  // the completion thread
+  std::vector<Op*> part;
+  for (Op* op : ops) {
+    op->buffer_id = TryAcquireDirectIoBuffer();
+    if (op->buffer_id == -1) {
+      Submit(part);
+      part.clear();
+      op->buffer_id = AcquireDirectIoBuffer();
+    }
+    op->buf = direct_io_buffers_.at(op->buffer_id);
+    part.push_back(op);
+  }
+  Submit(part);
+}
+
+void IoUringEngine::Submit(const std::vector<Op*>& ops) {
+  std::unique_lock<std::mutex> lock(sq_mutex_);
+  uint32_t to_submit = 0;
+  for (Op* op : ops) {
+    // bounding the inflight ops keeps the completion queue from overflowing
+    if (inflight_cnt_ + to_submit >= ring_.cq_entries() || to_submit == ring_.sq_entries()) {
+      ring_.EnterUntilSubmitted(to_submit);
+      inflight_cnt_ += to_submit;
+      to_submit = 0;
+      sq_cond_.wait(lock, [this]() { return inflight_cnt_ < ring_.cq_entries(); });
+    }
+    PrepareSqe(op);
+    to_submit += 1;
+  }
+  ring_.EnterUntilSubmitted(to_submit);
+  inflight_cnt_ += to_submit;
+}
+
+void IoUringEngine::Resubmit(Op* op) {
+  // the op keeps its inflight slot
+  std::unique_lock<std::mutex> lock(sq_mutex_);
+  PrepareSqe(op);
+  ring_.EnterUntilSubmitted(1);
+}
+
+void IoUringEngine::PrepareSqe(Op* op) {
+  io_uring_sqe sqe;
+  std::memset(&sqe, 0, sizeof(sqe));
+  sqe.fd = op->fd;
+  sqe.off = op->offset;
+  sqe.user_data = reinterpret_cast<uint64_t>(op);
+  if (op->buffer_id >= 0 && direct_io_buffers_registered_) {
+    sqe.opcode = IORING_OP_READ_FIXED;
+    sqe.addr = reinterpret_cast<uint64_t>(op->buf);
+    sqe.len = op->size;
+    sqe.buf_index = op->buffer_id;
+  } else {
+    op->iov.iov_base = op->buf;
+    op->iov.iov_len = op->size;
+    sqe.opcode = IORING_OP_READV;
+    sqe.addr = reinterpret_cast<uint64_t>(&op->iov);
+    sqe.len = 1;
+  }
+  ring_.PushSqe(sqe);
+}
+
+void IoUringEngine::PollCompletions() {
+  bool stopped = false;
+  std::vector<io_uring_cqe> cqes;
+  while (!stopped) {
+    if (ring_.Enter(0, 1) < 0) { PCHECK(errno == EINTR || errno == EAGAIN || errno == EBUSY); }
+    cqes.clear();
+    // the entries are released before handling them, which may resubmit
+    ring_.ReapCqes(&cqes);
+    for (const io_uring_cqe& cqe : cqes) {
+      if (cqe.user_data == kStopUserData) {
+        stopped = true;
+      } else {
+        OnCompletion(reinterpret_cast<Op*>(cqe.user_data), cqe.res);
+      }
+    }
+  }
+}
+
+void IoUringEngine::OnCompletion(Op* op, int32_t res) {
+  if (res < 0) {
+    CHECK(res == -EINTR || res == -EAGAIN) << "Fail to read file: " << std::strerror(-res);
+    Resubmit(op);
+    return;
+  }
+  CHECK_GT(res, 0) << "Read EOF";
+  op->offset += res;
+  op->buf += res;
+  op->size -= res;
+  op->needed -= std::min<size_t>(op->needed, res);
+  if (op->needed > 0) {
+    Resubmit(op);
+    return;
+  }
+  if (op->buffer_id >= 0) {
+    std::memcpy(op->dst, direct_io_buffers_.at(op->buffer_id) + op->buf_offset, op->n);
+    ReleaseDirectIoBuffer(op->buffer_id);
+  }
+  Batch* batch = op->batch;
+  delete op;
+  {
+    std::unique_lock<std::mutex> lock(sq_mutex_);
+    inflight_cnt_ -= 1;
+  }
+  sq_cond_.notify_all();
+  if (batch->pending_cnt.fetch_sub(1) == 1) {
+    batch->done();
+    delete batch;
+  }
+}
+
+void IoUringEngine::InitDirectIoBuffers() {
+  std::vector<iovec> iovecs(kDirectIoBufferNum);
+  FOR_RANGE(int64_t, i, 0, kDirectIoBufferNum) {
+    void* buffer = nullptr;
+    CHECK_EQ(posix_memalign(&buffer, kDirectIoAlignment, kDirectIoBufferSize), 0);
+    direct_io_buffers_.push_back(static_cast<char*>(buffer));
+    free_direct_io_buffer_ids_.push_back(i);
+    iovecs.at(i).iov_base = buffer;
+    iovecs.at(i).iov_len = kDirectIoBufferSize;
+  }
+  // pinning the buffers may exceed RLIMIT_MEMLOCK, they are still usable without registration
+  if (ring_.Register(IORING_REGISTER_BUFFERS, iovecs.data(), iovecs.size()) == 0) {
+    direct_io_buffers_registered_ = true;
+  } else {
+    PLOG(WARNING) << "registering io_uring buffers failed";
+  }
+}
+
+int64_t IoUringEngine::TryAcquireDirectIoBuffer() {
+  std::unique_lock<std::mutex> lock(direct_io_buffer_mutex_);
+  if (free_direct_io_buffer_ids_.empty()) { return -1; }
+  const int64_t buffer_id = free_direct_io_buffer_ids_.back();
+  free_direct_io_buffer_ids_.pop_back();
+  return buffer_id;
+}
+
+int64_t IoUringEngine::AcquireDirectIoBuffer() {
+  std::unique_lock<std::mutex> lock(direct_io_buffer_mutex_);
+  direct_io_buffer_cond_.wait(lock, [this]() { return !free_direct_io_buffer_ids_.empty(); });
+  const int64_t buffer_id = free_direct_io_buffer_ids_.back();
+  free_direct_io_buffer_ids_.pop_back();
+  return buffer_id;
+}
+
+void IoUringEngine::ReleaseDirectIoBuffer(int64_t buffer_id) {
+  {
+    std::unique_lock<std::mutex> lock(direct_io_buffer_mutex_);
+    free_direct_io_buffer_ids_.push_back(buffer_id);
+  }
+  direct_io_buffer_cond_.notify_one();
+}
+
+#else
+
+IoUringEngine* IoUringEngine::Get() { return nullptr; }
+
+IoUringEngine::~IoUringEngine() = default;
+
+void IoUringEngine::AsyncReadMany(int fd, bool is_direct_fd,
+                                  const std::vector<ReadRequest>& requests,
+                                  const std::function<void()>& done) {
+  UNIMPLEMENTED();
+}
+
+#endif  // OF_WITH_IO_URING
+
+}  // namespace fs
+
+}  // namespace oneflow
+
+#endif  // OF_PLATFORM_POSIX
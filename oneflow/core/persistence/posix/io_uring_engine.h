@@ -0,0 +1,80 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_PERSISTENCE_POSIX_IO_URING_ENGINE_H_
+#define ONEFLOW_CORE_PERSISTENCE_POSIX_IO_URING_ENGINE_H_
+
+#include "oneflow/core/persistence/file_system.h"
+#include "oneflow/core/common/io_uring.h"
+
+#ifdef OF_PLATFORM_POSIX
+
+namespace oneflow {
+
+namespace fs {
+
+// Reads files through one io_uring shared by the process. The reads of a batch are submitted by
+// a single io_uring_enter and their completions are reaped by a background thread, short reads are
+// resubmitted there. Files opened with O_DIRECT are read in whole blocks to aligned bounce buffers
+// registered to the ring.
+class IoUringEngine final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(IoUringEngine);
+  ~IoUringEngine();
+
+  // Returns nullptr if io_uring is not available, e.g. on old kernels or under seccomp.
+  static IoUringEngine* Get();
+
+  // Calls `done` in the background thread after all the `requests` are read from `fd`.
+  void AsyncReadMany(int fd, bool is_direct_fd, const std::vector<ReadRequest>& requests,
+                     const std::function<void()>& done);
+
+ private:
+  struct Batch;
+  struct Op;
+  IoUringEngine();
+  bool Init();
+  void Submit(const std::vector<Op*>& ops);
+  void Resubmit(Op* op);
+  void PrepareSqe(Op* op);
+  void PollCompletions();
+  void OnCompletion(Op* op, int32_t res);
+  void InitDirectIoBuffers();
+  int64_t TryAcquireDirectIoBuffer();
+  int64_t AcquireDirectIoBuffer();
+  void ReleaseDirectIoBuffer(int64_t buffer_id);
+
+  IoUring ring_;
+
+  std::mutex sq_mutex_;
+  std::condition_variable sq_cond_;
+  uint32_t inflight_cnt_;
+  std::thread completion_thread_;
+
+  std::once_flag direct_io_buffers_once_;
+  bool direct_io_buffers_registered_;
+  std::vector<char*> direct_io_buffers_;
+  std::mutex direct_io_buffer_mutex_;
+  std::condition_variable direct_io_buffer_cond_;
+  std::vector<int64_t> free_direct_io_buffer_ids_;
+};
+
+}  // namespace fs
+
+}  // namespace oneflow
+
+#endif  // OF_PLATFORM_POSIX
+
+#endif  // ONEFLOW_CORE_PERSISTENCE_POSIX_IO_URING_ENGINE_H_
@@ -14,6 +14,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/persistence/posix/posix_file_system.h"
+#include "oneflow/core/persistence/posix/io_uring_engine.h"
+#include "oneflow/core/common/blocking_counter.h"
+#include "oneflow/core/job/job_set.pb.h"
 
 #ifdef OF_PLATFORM_POSIX
 
@@ -32,14 +35,53 @@ namespace oneflow {
 
 namespace fs {
 
+namespace {
+
+bool IsIoUringEnabled() {
+  return Global<const IOConf>::Get() != nullptr && Global<const IOConf>::Get()->enable_io_uring();
+}
+
+bool IsDirectIoEnabled() {
+  return IsIoUringEnabled() && Global<const IOConf>::Get()->enable_direct_io();
+}
+
+}  // namespace
+
 class PosixRandomAccessFile : public RandomAccessFile {
  private:
   std::string fname_;
   int fd_;
+  // opened with O_DIRECT, -1 if direct io is disabled or not supported by the file system
+  int direct_fd_;
+  IoUringEngine* io_uring_engine_;
 
  public:
-  PosixRandomAccessFile(const std::string& fname, int fd) : fname_(fname), fd_(fd) {}
-  ~PosixRandomAccessFile() override { close(fd_); }
+  PosixRandomAccessFile(const std::string& fname, int fd, int direct_fd,
+                        IoUringEngine* io_uring_engine)
+      : fname_(fname), fd_(fd), direct_fd_(direct_fd), io_uring_engine_(io_uring_engine) {}
+  ~PosixRandomAccessFile() override {
+    close(fd_);
+    if (direct_fd_ != -1) { close(direct_fd_); }
+  }
+
+  void ReadMany(const std::vector<ReadRequest>& requests) const override {
+    if (io_uring_engine_ == nullptr) { return RandomAccessFile::ReadMany(requests); }
+    BlockingCounter counter(1);
+    AsyncReadMany(requests, [&counter]() { counter.Decrease(); });
+    counter.WaitUntilCntEqualZero();
+  }
+
+  bool SupportsAsyncRead() const override { return io_uring_engine_ != nullptr; }
+
+  void AsyncReadMany(const std::vector<ReadRequest>& requests,
+                     const std::function<void()>& done) const override {
+    if (io_uring_engine_ == nullptr) { return RandomAccessFile::AsyncReadMany(requests, done); }
+    if (direct_fd_ != -1) {
+      io_uring_engine_->AsyncReadMany(direct_fd_, true, requests, done);
+    } else {
+      io_uring_engine_->AsyncReadMany(fd_, false, requests, done);
+    }
+  }
 
   void Read(uint64_t offset, size_t n, char* result) const override {
     char* dst = result;
@@ -62,6 +104,22 @@ class PosixRandomAccessFile : public RandomAccessFile {
   }
 };
 
+class PosixReadOnlyMemoryRegion : public ReadOnlyMemoryRegion {
+ public:
+  PosixReadOnlyMemoryRegion(const void* address, uint64_t length)
+      : address_(address), length_(length) {}
+  ~PosixReadOnlyMemoryRegion() override {
+    if (length_ > 0) { munmap(const_cast<void*>(address_), length_); }
+  }
+
+  const char* data() const override { return static_cast<const char*>(address_); }
+  uint64_t length() const override { return length_; }
+
+ private:
+  const void* const address_;
+  const uint64_t length_;
+};
+
 class PosixWritableFile : public WritableFile {
  private:
   std::string fname_;
@@ -85,6 +143,11 @@ class PosixWritableFile : public WritableFile {
   }
 
   void Flush() override { PCHECK(fflush(file_) == 0) << "Fail to flush file " << fname_; }
+
+  void Sync() override {
+    Flush();
+    PCHECK(fsync(fileno(file_)) == 0) << "Fail to sync file " << fname_;
+  }
 };
 
 void PosixFileSystem::NewRandomAccessFile(const std::string& fname,
@@ -92,10 +155,34 @@ void PosixFileSystem::NewRandomAccessFile(const std::string& fname,
   std::string translated_fname = TranslateName(fname);
   int fd = open(translated_fname.c_str(), O_RDONLY);
   PCHECK(fd >= 0) << "Fail to open file " << fname;
-  result->reset(new PosixRandomAccessFile(fname, fd));
+  IoUringEngine* io_uring_engine = IsIoUringEnabled() ? IoUringEngine::Get() : nullptr;
+  int direct_fd = -1;
+  if (io_uring_engine != nullptr && IsDirectIoEnabled()) {
+    // e.g. tmpfs does not support O_DIRECT
+    direct_fd = open(translated_fname.c_str(), O_RDONLY | O_DIRECT);
+  }
+  result->reset(new PosixRandomAccessFile(fname, fd, direct_fd, io_uring_engine));
   CHECK_NOTNULL(result->get());
 }
 
+void PosixFileSystem::NewReadOnlyMemoryRegionFromFile(
+    const std::string& fname, std::unique_ptr<ReadOnlyMemoryRegion>* result) {
+  std::string translated_fname = TranslateName(fname);
+  int fd = open(translated_fname.c_str(), O_RDONLY);
+  PCHECK(fd >= 0) << "Fail to open file " << fname;
+  struct stat st;
+  PCHECK(fstat(fd, &st) == 0) << "Fail to stat file " << fname;
+  const void* address = nullptr;
+  if (st.st_size > 0) {
+    address = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    PCHECK(address != MAP_FAILED) << "Fail to mmap file " << fname;
+    // start the readahead of the whole file in background
+    madvise(const_cast<void*>(address), st.st_size, MADV_WILLNEED);
+  }
+  close(fd);
+  result->reset(new PosixReadOnlyMemoryRegion(address, st.st_size));
+}
+
 void PosixFileSystem::NewWritableFile(const std::string& fname,
                                       std::unique_ptr<WritableFile>* result) {
   std::string translated_fname = TranslateName(fname);
@@ -152,6 +239,12 @@ uint64_t PosixFileSystem::GetFileSize(const std::string& fname) {
   return sbuf.st_size;
 }
 
+int64_t PosixFileSystem::GetFileModificationTime(const std::string& fname) {
+  struct stat sbuf;
+  PCHECK(stat(TranslateName(fname).c_str(), &sbuf) == 0) << "Fail to load statistics of " << fname;
+  return static_cast<int64_t>(sbuf.st_mtim.tv_sec) * 1000000000 + sbuf.st_mtim.tv_nsec;
+}
+
 void PosixFileSystem::RenameFile(const std::string& old_name, const std::string& new_name) {
   PCHECK(rename(TranslateName(old_name).c_str(), TranslateName(new_name).c_str()) == 0)
       << "Fail to rename file from " << old_name << " to " << new_name;
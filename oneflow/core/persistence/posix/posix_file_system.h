@@ -33,6 +33,11 @@ class PosixFileSystem final : public FileSystem {
   void NewRandomAccessFile(const std::string& fname,
                            std::unique_ptr<RandomAccessFile>* result) override;
 
+  bool SupportsReadOnlyMemoryRegion() const override { return true; }
+
+  void NewReadOnlyMemoryRegionFromFile(const std::string& fname,
+                                       std::unique_ptr<ReadOnlyMemoryRegion>* result) override;
+
   void NewWritableFile(const std::string& fname, std::unique_ptr<WritableFile>* result) override;
 
   void NewAppendableFile(const std::string& fname, std::unique_ptr<WritableFile>* result) override;
@@ -49,6 +54,8 @@ class PosixFileSystem final : public FileSystem {
 
   uint64_t GetFileSize(const std::string& fname) override;
 
+  int64_t GetFileModificationTime(const std::string& fname) override;
+
   void RenameFile(const std::string& old_name, const std::string& new_name) override;
 
   bool IsDirectory(const std::string& fname) override;
@@ -15,10 +15,9 @@ limitations under the License.
 */
 #include "oneflow/core/persistence/snapshot.h"
 #include "oneflow/core/common/str_util.h"
-#include "oneflow/core/persistence/persistent_in_stream.h"
+#include "oneflow/core/job/job_set.pb.h"
 #include "oneflow/core/persistence/persistent_out_stream.h"
-#include "oneflow/core/register/tensor_slice_copier.h"
-#include "oneflow/core/device/cpu_device_context.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
@@ -28,6 +27,151 @@ std::string GenDataFilePath(const std::string& root, const std::string& key) {
   return JoinPath(root, key);
 }
 
+// runs separated by at most this many bytes are fetched by a single read
+constexpr size_t kMaxCoalesceGapBytes = 256 * 1024;
+constexpr size_t kMaxReadChunkBytes = 16 * 1024 * 1024;
+
+struct SliceReadRequest {
+  uint64_t file_offset;
+  size_t size;
+  // for a direct request the bytes are read to dst + dst_offset, otherwise run_cnt runs starting
+  // from first_run are scattered from the fetched span
+  size_t dst_offset;
+  int64_t first_run;
+  int64_t run_cnt;
+};
+
+// Reads the slice of a row major tensor file into a dense buffer. The slice is decomposed into
+// runs contiguous in the file, neighbouring runs are coalesced into large reads which are issued in
+// parallel, or all at once by ReadMany if given.
+void ReadSlice(const std::function<void(uint64_t offset, size_t n, char* result)>& ReadBytes,
+               const std::function<void(const std::vector<fs::ReadRequest>&)>& ReadMany,
+               size_t max_coalesce_gap_bytes, const Shape& logical_blob_shape, DataType data_type,
+               const TensorSliceView& slice, char* dst) {
+  const int64_t num_axes = logical_blob_shape.NumAxes();
+  const size_t elem_size = GetSizeOfDataType(data_type);
+  if (slice.shape().elem_cnt() == 0) { return; }
+  // axes after run_axis are fully covered by the slice, so each run spans a sub range of run_axis
+  int64_t run_axis = 0;
+  FOR_RANGE(int64_t, i, 0, num_axes) {
+    if (slice.At(i).size() != logical_blob_shape.At(i)) { run_axis = i; }
+  }
+  const size_t run_bytes =
+      (num_axes == 0 ? 1 : slice.At(run_axis).size() * logical_blob_shape.Count(run_axis + 1))
+      * elem_size;
+  const int64_t run_cnt = num_axes == 0 ? 1 : slice.shape().Count(0, run_axis);
+  auto RunFileOffset = [&](int64_t run_id) -> uint64_t {
+    if (num_axes == 0) { return 0; }
+    int64_t offset = slice.At(run_axis).begin() * logical_blob_shape.Count(run_axis + 1);
+    int64_t remainder = run_id;
+    for (int64_t i = run_axis - 1; i >= 0; --i) {
+      const Range& range = slice.At(i);
+      offset += (range.begin() + remainder % range.size()) * logical_blob_shape.Count(i + 1);
+      remainder /= range.size();
+    }
+    return offset * elem_size;
+  };
+  std::vector<SliceReadRequest> requests;
+  auto AddDirectRequests = [&](uint64_t file_offset, size_t size, size_t dst_offset) {
+    for (size_t pos = 0; pos < size; pos += kMaxReadChunkBytes) {
+      const size_t chunk_size = std::min(kMaxReadChunkBytes, size - pos);
+      requests.push_back(SliceReadRequest{file_offset + pos, chunk_size, dst_offset + pos, 0, 0});
+    }
+  };
+  int64_t run_id = 0;
+  while (run_id < run_cnt) {
+    const uint64_t begin = RunFileOffset(run_id);
+    uint64_t end = begin + run_bytes;
+    int64_t end_run_id = run_id + 1;
+    while (end_run_id < run_cnt) {
+      const uint64_t next_begin = RunFileOffset(end_run_id);
+      if (next_begin - end > max_coalesce_gap_bytes
+          || next_begin + run_bytes - begin > kMaxReadChunkBytes) {
+        break;
+      }
+      end = next_begin + run_bytes;
+      end_run_id += 1;
+    }
+    const int64_t group_run_cnt = end_run_id - run_id;
+    if (end - begin == group_run_cnt * run_bytes) {
+      AddDirectRequests(begin, end - begin, run_id * run_bytes);
+    } else {
+      requests.push_back(SliceReadRequest{begin, end - begin, 0, run_id, group_run_cnt});
+    }
+    run_id = end_run_id;
+  }
+  auto ScatterRuns = [&](const SliceReadRequest& request, const char* buffer) {
+    FOR_RANGE(int64_t, j, request.first_run, request.first_run + request.run_cnt) {
+      std::memcpy(dst + j * run_bytes, buffer + (RunFileOffset(j) - request.file_offset),
+                  run_bytes);
+    }
+  };
+  auto DoRequest = [&](size_t i) {
+    const SliceReadRequest& request = requests.at(i);
+    if (request.run_cnt == 0) {
+      ReadBytes(request.file_offset, request.size, dst + request.dst_offset);
+    } else {
+      std::vector<char> buffer(request.size);
+      ReadBytes(request.file_offset, request.size, buffer.data());
+      ScatterRuns(request, buffer.data());
+    }
+  };
+  if (ReadMany) {
+    std::vector<std::vector<char>> buffers(requests.size());
+    std::vector<fs::ReadRequest> reads;
+    FOR_RANGE(size_t, i, 0, requests.size()) {
+      const SliceReadRequest& request = requests.at(i);
+      if (request.run_cnt == 0) {
+        reads.push_back(
+            fs::ReadRequest{request.file_offset, request.size, dst + request.dst_offset});
+      } else {
+        buffers.at(i).resize(request.size);
+        reads.push_back(fs::ReadRequest{request.file_offset, request.size, buffers.at(i).data()});
+      }
+    }
+    ReadMany(reads);
+    FOR_RANGE(size_t, i, 0, requests.size()) {
+      if (requests.at(i).run_cnt != 0) { ScatterRuns(requests.at(i), buffers.at(i).data()); }
+    }
+  } else if (requests.size() > 1 && Global<ThreadPool>::Get() != nullptr) {
+    MultiThreadLoop(requests.size(), DoRequest);
+  } else {
+    SingleThreadLoop(requests.size(), DoRequest);
+  }
+}
+
+// variables sharded over several devices of one process share the mapping of their file
+std::shared_ptr<const fs::ReadOnlyMemoryRegion> GetOrMapFile(const std::string& path) {
+  static std::mutex mutex;
+  static HashMap<std::string, std::weak_ptr<const fs::ReadOnlyMemoryRegion>> path2region;
+  std::unique_lock<std::mutex> lock(mutex);
+  auto it = path2region.find(path);
+  if (it != path2region.end()) {
+    std::shared_ptr<const fs::ReadOnlyMemoryRegion> region = it->second.lock();
+    if (region) { return region; }
+  }
+  // the entries of files no longer read are dropped before a new one is added, so the map only
+  // holds the mappings in use
+  for (auto iter = path2region.begin(); iter != path2region.end();) {
+    if (iter->second.expired()) {
+      iter = path2region.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+  std::unique_ptr<fs::ReadOnlyMemoryRegion> new_region;
+  SnapshotFS()->NewReadOnlyMemoryRegionFromFile(path, &new_region);
+  std::shared_ptr<const fs::ReadOnlyMemoryRegion> region(new_region.release());
+  path2region[path] = region;
+  return region;
+}
+
+bool IsMmapModelLoadEnabled() {
+  return Global<const IOConf>::Get() != nullptr
+         && Global<const IOConf>::Get()->enable_mmap_model_load()
+         && SnapshotFS()->SupportsReadOnlyMemoryRegion();
+}
+
 }  // namespace
 
 SnapshotReader::SnapshotReader(const std::string& snapshot_root_path)
@@ -52,19 +196,26 @@ void SnapshotReader::Read(const std::string& key, const Shape& logical_blob_shap
   const int64_t logical_blob_size = logical_blob_shape.elem_cnt() * GetSizeOfDataType(data_type);
   CHECK_EQ(SnapshotFS()->GetFileSize(path), logical_blob_size)
       << "unexpected model snapshot size, path: " << path;
-  if (slice.shape().Count(1) == logical_blob_shape.Count(1)) {
-    PersistentInStream in_stream(
-        SnapshotFS(), path,
-        slice.At(0).begin() * slice.shape().Count(1) * GetSizeOfDataType(data_type));
-    in_stream.ReadFully(dst, slice.shape().elem_cnt() * GetSizeOfDataType(data_type));
+  if (IsMmapModelLoadEnabled()) {
+    std::shared_ptr<const fs::ReadOnlyMemoryRegion> region = GetOrMapFile(path);
+    CHECK_EQ(region->length(), logical_blob_size);
+    // copying from the mapping needs no staging buffer, so only adjacent runs are merged
+    ReadSlice(
+        [&](uint64_t offset, size_t n, char* result) {
+          std::memcpy(result, region->data() + offset, n);
+        },
+        nullptr, 0, logical_blob_shape, data_type, slice, dst);
   } else {
-    std::vector<char> buffer(logical_blob_size);
-    PersistentInStream in_stream(SnapshotFS(), path);
-    in_stream.ReadFully(buffer.data(), logical_blob_size);
-    TensorSliceCopier copier(slice, logical_blob_slice, data_type);
-    CpuDeviceCtx device_ctx;
-    std::unique_ptr<MemoryCopier> host_memory_copier(NewDefaultMemoryCopier(DeviceType::kCPU));
-    copier.Copy(&device_ctx, *host_memory_copier, dst, buffer.data());
+    std::unique_ptr<fs::RandomAccessFile> file;
+    SnapshotFS()->NewRandomAccessFile(path, &file);
+    std::function<void(const std::vector<fs::ReadRequest>&)> ReadMany;
+    // an asynchronous file issues all the reads together without the thread pool
+    if (file->SupportsAsyncRead()) {
+      ReadMany = [&](const std::vector<fs::ReadRequest>& reads) { file->ReadMany(reads); };
+    }
+    ReadSlice(
+        [&](uint64_t offset, size_t n, char* result) { file->Read(offset, n, result); }, ReadMany,
+        kMaxCoalesceGapBytes, logical_blob_shape, data_type, slice, dst);
   }
 }
 
@@ -99,10 +250,27 @@ void SnapshotWriter::Write(const std::string& key, const char* data, size_t size
   out_stream.Write(data, size);
 }
 
+void SnapshotWriter::AtomicWrite(const std::string& key, const char* data, size_t size) {
+  const std::string path = GenDataFilePath(root_path_, key);
+  const std::string tmp_path = path + ".tmp";
+  SnapshotFS()->CreateDirIfNotExist(Dirname(path));
+  CHECK(!SnapshotFS()->FileExists(path));
+  {
+    PersistentOutStream out_stream(SnapshotFS(), tmp_path);
+    out_stream.Write(data, size);
+    out_stream.Sync();
+  }
+  SnapshotFS()->RenameFile(tmp_path, path);
+}
+
 void SnapshotWriter::Write(const std::string& key, const Blob* blob) {
   Write(key, blob->dptr<char>(), blob->ByteSizeOfBlobBody());
 }
 
+void SnapshotWriter::AtomicWrite(const std::string& key, const Blob* blob) {
+  AtomicWrite(key, blob->dptr<char>(), blob->ByteSizeOfBlobBody());
+}
+
 void SnapshotWriter::Close() {
   PersistentOutStream out_stream(SnapshotFS(), JoinPath(root_path_, "snapshot_done"));
 }
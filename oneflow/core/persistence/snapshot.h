@@ -52,6 +52,10 @@ class SnapshotWriter final {
 
   void Write(const std::string& key, const char* data, size_t size);
   void Write(const std::string& key, const Blob* blob);
+  // writes to a temporary file which is synced and then renamed to the final path, so readers
+  // never observe a partially written file
+  void AtomicWrite(const std::string& key, const char* data, size_t size);
+  void AtomicWrite(const std::string& key, const Blob* blob);
   void Close();
 
  private:
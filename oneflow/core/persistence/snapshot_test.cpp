@@ -0,0 +1,202 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/job/job_set.pb.h"
+#include "oneflow/core/persistence/async_snapshot_writer.h"
+#include "oneflow/core/persistence/file_system.h"
+#include "oneflow/core/persistence/snapshot.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+
+namespace {
+
+class SnapshotTestScope final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(SnapshotTestScope);
+  explicit SnapshotTestScope(const std::string& name, bool enable_mmap_model_load = false) {
+    IOConf io_conf;
+    io_conf.set_enable_mmap_model_load(enable_mmap_model_load);
+    io_conf.mutable_data_fs_conf()->mutable_localfs_conf();
+    io_conf.mutable_snapshot_fs_conf()->mutable_localfs_conf();
+    Global<const IOConf>::New(io_conf);
+    Global<ThreadPool>::New(4);
+    std::string current_dir = GetCwd();
+    StringReplace(&current_dir, '\\', '/');
+    root_path_ = JoinPath(current_dir, name);
+    if (SnapshotFS()->IsDirectory(root_path_)) { SnapshotFS()->RecursivelyDeleteDir(root_path_); }
+  }
+  ~SnapshotTestScope() {
+    SnapshotFS()->RecursivelyDeleteDir(root_path_);
+    Global<ThreadPool>::Delete();
+    Global<const IOConf>::Delete();
+  }
+
+  const std::string& root_path() const { return root_path_; }
+
+ private:
+  std::string root_path_;
+};
+
+std::vector<float> GenSequence(int64_t size) {
+  std::vector<float> data(size);
+  FOR_RANGE(int64_t, i, 0, size) { data.at(i) = static_cast<float>(i); }
+  return data;
+}
+
+std::vector<float> NaiveSlice(const std::vector<float>& data, const Shape& shape,
+                              const TensorSliceView& slice) {
+  std::vector<float> ret;
+  FOR_RANGE(int64_t, i, 0, shape.elem_cnt()) {
+    int64_t remainder = i;
+    bool in_slice = true;
+    for (int64_t axis = shape.NumAxes() - 1; axis >= 0; --axis) {
+      const int64_t idx = remainder % shape.At(axis);
+      remainder /= shape.At(axis);
+      if (idx < slice.At(axis).begin() || idx >= slice.At(axis).end()) { in_slice = false; }
+    }
+    if (in_slice) { ret.push_back(data.at(i)); }
+  }
+  return ret;
+}
+
+void TestReadSlice(const SnapshotReader& reader, const std::string& key,
+                   const std::vector<float>& data, const Shape& shape,
+                   const TensorSliceView& slice) {
+  std::vector<float> expected = NaiveSlice(data, shape, slice);
+  std::vector<float> result(slice.shape().elem_cnt());
+  reader.Read(key, shape, DataType::kFloat, slice, reinterpret_cast<char*>(result.data()));
+  ASSERT_EQ(expected, result);
+}
+
+void TestReadSlice(bool enable_mmap_model_load) {
+  SnapshotTestScope scope("tmp_snapshot_read_slice_test", enable_mmap_model_load);
+  const Shape shape({6, 5, 4});
+  const std::vector<float> data = GenSequence(shape.elem_cnt());
+  SnapshotWriter writer(scope.root_path());
+  writer.Write("var", reinterpret_cast<const char*>(data.data()), data.size() * sizeof(float));
+  SnapshotReader reader(scope.root_path());
+  TestReadSlice(reader, "var", data, shape, TensorSliceView(shape));
+  TestReadSlice(reader, "var", data, shape, TensorSliceView({{2, 5}, {0, 5}, {0, 4}}));
+  TestReadSlice(reader, "var", data, shape, TensorSliceView({{0, 6}, {1, 3}, {0, 4}}));
+  TestReadSlice(reader, "var", data, shape, TensorSliceView({{0, 6}, {0, 5}, {2, 4}}));
+  TestReadSlice(reader, "var", data, shape, TensorSliceView({{1, 4}, {2, 5}, {1, 2}}));
+  TestReadSlice(reader, "var", data, shape, TensorSliceView({{3, 3}, {0, 5}, {0, 4}}));
+}
+
+void TestReadSplitEmbedding(bool enable_mmap_model_load) {
+  SnapshotTestScope scope("tmp_snapshot_read_split_embedding_test", enable_mmap_model_load);
+  const int64_t parallel_num = 4;
+  const Shape shape({65536, 128});
+  const std::vector<float> data = GenSequence(shape.elem_cnt());
+  SnapshotWriter writer(scope.root_path());
+  writer.Write("embedding", reinterpret_cast<const char*>(data.data()),
+               data.size() * sizeof(float));
+  SnapshotReader reader(scope.root_path());
+  const int64_t part_size = shape.At(1) / parallel_num;
+  double split_time = 0;
+  FOR_RANGE(int64_t, i, 0, parallel_num) {
+    const TensorSliceView slice({{0, shape.At(0)}, {i * part_size, (i + 1) * part_size}});
+    std::vector<float> result(slice.shape().elem_cnt());
+    const double start = GetCurTime();
+    reader.Read("embedding", shape, DataType::kFloat, slice,
+                reinterpret_cast<char*>(result.data()));
+    split_time += GetCurTime() - start;
+    ASSERT_EQ(NaiveSlice(data, shape, slice), result);
+  }
+  std::vector<float> result(shape.elem_cnt());
+  const double start = GetCurTime();
+  reader.Read("embedding", shape, DataType::kFloat, TensorSliceView(shape),
+              reinterpret_cast<char*>(result.data()));
+  const double full_time = GetCurTime() - start;
+  LOG(INFO) << (enable_mmap_model_load ? "mmap" : "pread") << " read " << parallel_num
+            << " S(1) parts of a " << shape.ToString() << " embedding in " << split_time / 1e6
+            << " ms, full read in " << full_time / 1e6 << " ms";
+}
+
+std::vector<std::string> SortedListDir(const std::string& dir) {
+  std::vector<std::string> names = SnapshotFS()->ListDir(dir);
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+}  // namespace
+
+TEST(SnapshotReader, read_slice) { TestReadSlice(false); }
+
+TEST(SnapshotReader, read_split_embedding) { TestReadSplitEmbedding(false); }
+
+TEST(SnapshotReader, mmap_read_slice) {
+#ifdef OF_PLATFORM_POSIX
+  TestReadSlice(true);
+#endif
+}
+
+TEST(SnapshotReader, mmap_read_split_embedding) {
+#ifdef OF_PLATFORM_POSIX
+  TestReadSplitEmbedding(true);
+#endif
+}
+
+TEST(SnapshotWriter, atomic_write) {
+  SnapshotTestScope scope("tmp_snapshot_atomic_write_test");
+  const Shape shape({6, 5, 4});
+  const std::vector<float> data = GenSequence(shape.elem_cnt());
+  SnapshotWriter writer(scope.root_path());
+  writer.AtomicWrite("var/out", reinterpret_cast<const char*>(data.data()),
+                     data.size() * sizeof(float));
+  writer.Close();
+  // the temporary file is renamed to the final path, nothing else is left behind
+  ASSERT_EQ(SortedListDir(scope.root_path()), std::vector<std::string>({"snapshot_done", "var"}));
+  ASSERT_EQ(SortedListDir(JoinPath(scope.root_path(), "var")), std::vector<std::string>({"out"}));
+  SnapshotReader reader(scope.root_path());
+  TestReadSlice(reader, "var/out", data, shape, TensorSliceView(shape));
+}
+
+TEST(SnapshotWriter, async_atomic_write) {
+  SnapshotTestScope scope("tmp_snapshot_async_atomic_write_test");
+  const int64_t var_num = 16;
+  const Shape shape({64, 32, 16});
+  std::vector<std::vector<float>> datas(var_num);
+  FOR_RANGE(int64_t, i, 0, var_num) {
+    datas.at(i) = GenSequence(shape.elem_cnt());
+    for (float& value : datas.at(i)) { value += i; }
+  }
+  // the io works of enable_async_model_save, every variable is written by an io thread
+  AsyncSnapshotWriter async_writer(4);
+  SnapshotWriter writer(scope.root_path());
+  FOR_RANGE(int64_t, i, 0, var_num) {
+    async_writer.AddIoWork([&writer, &datas, i]() {
+      writer.AtomicWrite("var_" + std::to_string(i) + "/out",
+                         reinterpret_cast<const char*>(datas.at(i).data()),
+                         datas.at(i).size() * sizeof(float));
+    });
+  }
+  async_writer.WaitUntilAllDone();
+  writer.Close();
+  ASSERT_EQ(SortedListDir(scope.root_path()).size(), static_cast<size_t>(var_num + 1));
+  SnapshotReader reader(scope.root_path());
+  FOR_RANGE(int64_t, i, 0, var_num) {
+    const std::string var_name = "var_" + std::to_string(i);
+    ASSERT_EQ(SortedListDir(JoinPath(scope.root_path(), var_name)),
+              std::vector<std::string>({"out"}));
+    TestReadSlice(reader, var_name + "/out", datas.at(i), shape, TensorSliceView(shape));
+  }
+}
+
+}  // namespace oneflow
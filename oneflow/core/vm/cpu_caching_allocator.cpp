@@ -0,0 +1,228 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/vm/cpu_caching_allocator.h"
+
+namespace oneflow {
+namespace vm {
+
+namespace {
+
+const size_t kCpuMemAllocAlignSize = 64;
+const size_t kMinBlockSize = 2 << 20;         // 2MiB
+const size_t kMaxGrowthBlockSize = 64 << 20;  // 64MiB
+const size_t kPieceSplitThreshold = 1 << 20;  // 1MiB
+
+inline size_t CpuMemAlignedBytes(size_t bytes) { return RoundUp(bytes, kCpuMemAllocAlignSize); }
+
+}  // namespace
+
+CpuCachingAllocator::CpuCachingAllocator(std::unique_ptr<Allocator>&& backend_allocator)
+    : Allocator(), backend_allocator_(std::move(backend_allocator)), recycle_piece_list_(nullptr) {
+  bins_.resize(kBinNumSize);
+}
+
+CpuCachingAllocator::~CpuCachingAllocator() {
+  if (stats_.allocate_count > 0) {
+    LOG(INFO) << "CpuCachingAllocator allocate count: " << stats_.allocate_count
+              << ", backend allocate count: " << stats_.backend_allocate_count
+              << ", peak allocated bytes: " << stats_.peak_allocated_bytes
+              << ", reserved bytes: " << stats_.reserved_bytes;
+  }
+  for (auto& pair : mem_ptr2block_) {
+    backend_allocator_->Deallocate(pair.first, pair.second.size + kCpuMemAllocAlignSize);
+  }
+}
+
+int32_t CpuCachingAllocator::BinNum4Size(size_t size) const {
+  uint64_t value = std::max(size, kCpuMemAllocAlignSize) >> 6;
+  return std::min(kBinNumSize - 1, static_cast<int32_t>(63 ^ __builtin_clzll(value)));
+}
+
+void CpuCachingAllocator::InsertPiece2Bin(Piece* piece) {
+  CHECK(piece->is_free && piece->bin_num == kInvalidBinNum);
+  int32_t bin_num = BinNum4Size(piece->size);
+  piece->bin_num = bin_num;
+  CHECK(bins_.at(bin_num).pieces.insert(piece).second);
+}
+
+void CpuCachingAllocator::RemovePieceFromBin(Piece* piece) {
+  CHECK(piece->is_free);
+  CHECK_NE(piece->bin_num, kInvalidBinNum);
+  CHECK_GT(bins_.at(piece->bin_num).pieces.erase(piece), 0);
+  piece->bin_num = kInvalidBinNum;
+}
+
+CpuCachingAllocator::Piece* CpuCachingAllocator::AllocatePiece() {
+  if (recycle_piece_list_) {
+    Piece* ret = recycle_piece_list_;
+    recycle_piece_list_ = recycle_piece_list_->next;
+    return ret;
+  } else {
+    pieces_.emplace_back(new Piece());
+    return pieces_.back().get();
+  }
+}
+
+void CpuCachingAllocator::DeallocatePiece(Piece* piece) {
+  piece->ptr = nullptr;
+  piece->size = 0;
+  piece->bin_num = kInvalidBinNum;
+  piece->is_free = true;
+  piece->prev = nullptr;
+  piece->next = recycle_piece_list_;
+  recycle_piece_list_ = piece;
+}
+
+CpuCachingAllocator::Piece* CpuCachingAllocator::FindPiece(size_t aligned_size) {
+  for (int32_t bin_num = BinNum4Size(aligned_size); bin_num < kBinNumSize; ++bin_num) {
+    Bin* bin = &bins_.at(bin_num);
+    Piece key;
+    key.size = aligned_size;
+    auto it = bin->pieces.lower_bound(&key);
+    if (it == bin->pieces.end()) { continue; }
+    Piece* piece = *it;
+    bin->pieces.erase(it);
+    piece->bin_num = kInvalidBinNum;
+    piece->is_free = false;
+    if (piece->size >= aligned_size * 2 || piece->size - aligned_size >= kPieceSplitThreshold) {
+      Piece* new_piece = AllocatePiece();
+      new_piece->ptr = piece->ptr + aligned_size;
+      new_piece->size = piece->size - aligned_size;
+      piece->size = aligned_size;
+      new_piece->prev = piece;
+      new_piece->next = piece->next;
+      if (piece->next != nullptr) { piece->next->prev = new_piece; }
+      piece->next = new_piece;
+      new_piece->is_free = true;
+      new_piece->bin_num = kInvalidBinNum;
+      InsertPiece2Bin(new_piece);
+      CHECK(ptr2piece_.emplace(new_piece->ptr, new_piece).second);
+    }
+    return piece;
+  }
+  return nullptr;
+}
+
+void CpuCachingAllocator::MergeNeighbourFreePiece(Piece* lhs, Piece* rhs) {
+  CHECK(lhs->is_free);
+  CHECK(rhs->is_free);
+  CHECK(lhs->next == rhs);
+  CHECK(lhs->ptr + lhs->size == rhs->ptr);
+  lhs->size += rhs->size;
+  lhs->next = rhs->next;
+  if (rhs->next != nullptr) { rhs->next->prev = lhs; }
+  CHECK_EQ(ptr2piece_.erase(rhs->ptr), 1);
+  DeallocatePiece(rhs);
+}
+
+bool CpuCachingAllocator::AllocateBlockToExtendTotalMem(size_t aligned_size) {
+  // grow geometrically with the reserved bytes so that the number of blocks stays small
+  size_t allocate_bytes = std::min(stats_.reserved_bytes, kMaxGrowthBlockSize);
+  allocate_bytes = CpuMemAlignedBytes(std::max({allocate_bytes, kMinBlockSize, aligned_size}));
+  // the backend only guarantees malloc alignment, the block start is aligned here so that every
+  // piece split from it is kCpuMemAllocAlignSize aligned
+  char* mem_ptr = nullptr;
+  backend_allocator_->Allocate(&mem_ptr, allocate_bytes + kCpuMemAllocAlignSize);
+  if (mem_ptr == nullptr) { return false; }
+  stats_.reserved_bytes += allocate_bytes;
+  stats_.backend_allocate_count += 1;
+  char* aligned_ptr =
+      reinterpret_cast<char*>(RoundUp(reinterpret_cast<uintptr_t>(mem_ptr), kCpuMemAllocAlignSize));
+
+  Piece* piece = AllocatePiece();
+  piece->size = allocate_bytes;
+  piece->ptr = aligned_ptr;
+  piece->prev = nullptr;
+  piece->next = nullptr;
+  piece->is_free = true;
+  piece->bin_num = kInvalidBinNum;
+  InsertPiece2Bin(piece);
+  CHECK(ptr2piece_.emplace(aligned_ptr, piece).second);
+  Block block;
+  block.size = allocate_bytes;
+  block.start_piece = piece;
+  CHECK(mem_ptr2block_.emplace(mem_ptr, block).second);
+  return true;
+}
+
+bool CpuCachingAllocator::DeallocateFreeBlocks() {
+  bool released = false;
+  for (auto it = mem_ptr2block_.begin(); it != mem_ptr2block_.end();) {
+    Piece* piece = it->second.start_piece;
+    // a free Block is one sole free Piece since free neighbours are always merged
+    if (!(piece->is_free && piece->next == nullptr)) {
+      ++it;
+      continue;
+    }
+    CHECK_EQ(piece->size, it->second.size);
+    RemovePieceFromBin(piece);
+    CHECK_EQ(ptr2piece_.erase(piece->ptr), 1);
+    DeallocatePiece(piece);
+    backend_allocator_->Deallocate(it->first, it->second.size + kCpuMemAllocAlignSize);
+    stats_.reserved_bytes -= it->second.size;
+    stats_.backend_deallocate_count += 1;
+    it = mem_ptr2block_.erase(it);
+    released = true;
+  }
+  return released;
+}
+
+void CpuCachingAllocator::Allocate(char** mem_ptr, std::size_t size) {
+  if (size == 0) {
+    *mem_ptr = nullptr;
+    return;
+  }
+  size_t aligned_size = CpuMemAlignedBytes(size);
+  Piece* piece = FindPiece(aligned_size);
+  if (piece == nullptr && AllocateBlockToExtendTotalMem(aligned_size)) {
+    piece = FindPiece(aligned_size);
+  }
+  if (piece == nullptr && DeallocateFreeBlocks() && AllocateBlockToExtendTotalMem(aligned_size)) {
+    piece = FindPiece(aligned_size);
+  }
+  CHECK(piece != nullptr) << "Error! : Out of memory when allocate size : " << size;
+  stats_.allocate_count += 1;
+  stats_.allocated_bytes += piece->size;
+  stats_.peak_allocated_bytes = std::max(stats_.peak_allocated_bytes, stats_.allocated_bytes);
+  *mem_ptr = piece->ptr;
+}
+
+void CpuCachingAllocator::Deallocate(char* mem_ptr, std::size_t size) {
+  if (mem_ptr == nullptr) { return; }
+  auto it = ptr2piece_.find(mem_ptr);
+  CHECK(it != ptr2piece_.end()) << "Error! : Try deallocate mem_ptr non-existent. mem ptr = "
+                                << mem_ptr << " size = " << size;
+  Piece* piece = it->second;
+  CHECK(!piece->is_free);
+  stats_.allocated_bytes -= piece->size;
+  piece->is_free = true;
+  Piece* last_piece_insert_to_bin = piece;
+  Piece* next_p = piece->next;
+  Piece* prev_p = piece->prev;
+  if (next_p != nullptr && next_p->is_free) {
+    RemovePieceFromBin(next_p);
+    MergeNeighbourFreePiece(piece, next_p);
+  }
+  if (prev_p != nullptr && prev_p->is_free) {
+    RemovePieceFromBin(prev_p);
+    MergeNeighbourFreePiece(prev_p, piece);
+    last_piece_insert_to_bin = prev_p;
+  }
+  InsertPiece2Bin(last_piece_insert_to_bin);
+}
+
+}  // namespace vm
+}  // namespace oneflow
@@ -0,0 +1,105 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_VM_CPU_CACHING_ALLOCATOR_H_
+#define ONEFLOW_CORE_VM_CPU_CACHING_ALLOCATOR_H_
+
+#include <cstdint>
+#include "oneflow/core/vm/allocator.h"
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+namespace vm {
+
+struct CpuCachingAllocatorStats {
+  size_t allocated_bytes = 0;
+  size_t peak_allocated_bytes = 0;
+  size_t reserved_bytes = 0;
+  int64_t allocate_count = 0;
+  int64_t backend_allocate_count = 0;
+  int64_t backend_deallocate_count = 0;
+};
+
+// CpuCachingAllocator is the host counterpart of CudaAllocator. Memory is taken from the backend
+// allocator in large Blocks which are split into Pieces, freed Pieces are coalesced with their
+// free neighbours and kept in size-class Bins for reuse, so short-lived eager tensors do not pay
+// for malloc and page faults again and again.
+class CpuCachingAllocator final : public Allocator {
+ public:
+  explicit CpuCachingAllocator(std::unique_ptr<Allocator>&& backend_allocator);
+  ~CpuCachingAllocator() override;
+
+  void Allocate(char** mem_ptr, std::size_t size) override;
+  void Deallocate(char* mem_ptr, std::size_t size) override;
+
+  const CpuCachingAllocatorStats& stats() const { return stats_; }
+
+ private:
+  static constexpr int32_t kInvalidBinNum = -1;
+  static constexpr int32_t kBinNumSize = 24;
+
+  // Pieces on the same Block form a linked list in address order
+  struct Piece {
+    size_t size = 0;
+    char* ptr = nullptr;
+    bool is_free = false;
+    Piece* prev = nullptr;
+    Piece* next = nullptr;
+    int32_t bin_num = kInvalidBinNum;
+  };
+
+  // Bin i holds the free Pieces whose size is in [64 << i, 64 << (i + 1)), the last Bin holds
+  // all the larger ones
+  struct Bin {
+    struct PieceCmp {
+      bool operator()(const Piece* lhs, const Piece* rhs) const {
+        if (lhs->size != rhs->size) { return lhs->size < rhs->size; }
+        return lhs->ptr < rhs->ptr;
+      }
+    };
+    std::set<Piece*, PieceCmp> pieces;
+  };
+
+  // Blocks are keyed by the pointer from the backend, size excludes the alignment padding
+  struct Block {
+    size_t size = 0;
+    Piece* start_piece = nullptr;
+  };
+
+  int32_t BinNum4Size(size_t size) const;
+
+  Piece* FindPiece(size_t aligned_size);
+  void InsertPiece2Bin(Piece* piece);
+  void RemovePieceFromBin(Piece* piece);
+  Piece* AllocatePiece();
+  void DeallocatePiece(Piece* piece);
+  void MergeNeighbourFreePiece(Piece* lhs, Piece* rhs);
+
+  bool AllocateBlockToExtendTotalMem(size_t aligned_size);
+  bool DeallocateFreeBlocks();
+
+  std::unique_ptr<Allocator> backend_allocator_;
+  CpuCachingAllocatorStats stats_;
+  HashMap<char*, Block> mem_ptr2block_;
+  std::vector<Bin> bins_;
+  std::vector<std::unique_ptr<Piece>> pieces_;
+  HashMap<char*, Piece*> ptr2piece_;
+  Piece* recycle_piece_list_;
+};
+
+}  // namespace vm
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_VM_CPU_CACHING_ALLOCATOR_H_
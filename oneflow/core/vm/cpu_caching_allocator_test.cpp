@@ -0,0 +1,66 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/vm/cpu_allocator.h"
+#include "oneflow/core/vm/cpu_caching_allocator.h"
+
+namespace oneflow {
+namespace vm {
+
+TEST(CpuCachingAllocator, allocate_and_reuse) {
+  CpuCachingAllocator allocator(std::unique_ptr<Allocator>(new CpuAllocator()));
+  std::vector<char*> ptrs;
+  for (int i = 0; i < 512; ++i) {
+    char* ptr = nullptr;
+    allocator.Allocate(&ptr, 1);
+    ASSERT_TRUE(ptr != nullptr);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(ptr) % 64, 0);
+    ptrs.push_back(ptr);
+  }
+  std::sort(ptrs.begin(), ptrs.end());
+  for (int i = 0; i < 512; ++i) {
+    if (i > 0) { ASSERT_TRUE(ptrs.at(i) - ptrs.at(i - 1) >= 64); }
+    allocator.Deallocate(ptrs.at(i), 1);
+  }
+  ASSERT_EQ(allocator.stats().allocated_bytes, 0);
+  ASSERT_EQ(allocator.stats().backend_allocate_count, 1);
+
+  // freed pieces are coalesced, so a block-sized request fits into the cached block
+  char* big_ptr = nullptr;
+  allocator.Allocate(&big_ptr, allocator.stats().reserved_bytes);
+  ASSERT_TRUE(big_ptr != nullptr);
+  ASSERT_EQ(allocator.stats().backend_allocate_count, 1);
+  allocator.Deallocate(big_ptr, allocator.stats().reserved_bytes);
+
+  char* data_ptr_1 = nullptr;
+  allocator.Allocate(&data_ptr_1, 2048 * sizeof(float));
+  char* data_ptr_2 = nullptr;
+  allocator.Allocate(&data_ptr_2, 4096 * sizeof(double));
+  ASSERT_TRUE(data_ptr_1 != data_ptr_2);
+  if (data_ptr_1 < data_ptr_2) {
+    ASSERT_TRUE(data_ptr_1 + 2048 * sizeof(float) <= data_ptr_2);
+  } else {
+    ASSERT_TRUE(data_ptr_2 + 4096 * sizeof(double) <= data_ptr_1);
+  }
+  std::memset(data_ptr_1, 0, 2048 * sizeof(float));
+  std::memset(data_ptr_2, 0, 4096 * sizeof(double));
+  allocator.Deallocate(data_ptr_2, 4096 * sizeof(double));
+  allocator.Deallocate(data_ptr_1, 2048 * sizeof(float));
+  ASSERT_EQ(allocator.stats().allocated_bytes, 0);
+  ASSERT_GE(allocator.stats().peak_allocated_bytes, 512 * 64);
+}
+
+}  // namespace vm
+}  // namespace oneflow
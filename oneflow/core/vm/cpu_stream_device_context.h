@@ -0,0 +1,57 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_VM_CPU_STREAM_DEVICE_CONTEXT_H_
+#define ONEFLOW_CORE_VM_CPU_STREAM_DEVICE_CONTEXT_H_
+
+#include "oneflow/core/kernel/kernel_context.h"
+#include "oneflow/core/device/device_context.h"
+#include "oneflow/core/vm/cpu_allocator.h"
+#include "oneflow/core/vm/cpu_caching_allocator.h"
+#include "oneflow/core/vm/thread_safe_allocator.h"
+
+namespace oneflow {
+namespace vm {
+
+// DeviceCtx of the eager cpu streams, memory is cached per stream by a CpuCachingAllocator
+class CpuStreamDeviceCtx final : public DeviceCtx {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuStreamDeviceCtx);
+  CpuStreamDeviceCtx()
+      : caching_allocator_(
+          new CpuCachingAllocator(std::unique_ptr<Allocator>(new CpuAllocator()))),
+        cpu_allocator_(new ThreadSafeAllocator(std::unique_ptr<Allocator>(caching_allocator_))) {}
+  ~CpuStreamDeviceCtx() override = default;
+
+  void SyncDevice() override {}
+  void AddCallBack(std::function<void()> callback) const override { callback(); }
+
+  vm::Allocator* mut_allocator() override { return cpu_allocator_.get(); }
+
+  // not synchronized with allocations, read it when the stream is idle
+  const CpuCachingAllocatorStats& caching_allocator_stats() const {
+    return caching_allocator_->stats();
+  }
+
+ private:
+  // owned by cpu_allocator_
+  CpuCachingAllocator* caching_allocator_;
+  std::unique_ptr<Allocator> cpu_allocator_;
+};
+
+}  // namespace vm
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_VM_CPU_STREAM_DEVICE_CONTEXT_H_
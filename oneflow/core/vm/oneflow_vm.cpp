@@ -18,18 +18,67 @@ limitations under the License.
 namespace oneflow {
 
 OneflowVM::OneflowVM(const Resource& resource, int64_t this_machine_id)
-    : vm_(ObjectMsgPtr<vm::VirtualMachine>::New(vm::MakeVmDesc(resource, this_machine_id).Get())) {
+    : vm_(ObjectMsgPtr<vm::VirtualMachine>::New(vm::MakeVmDesc(resource, this_machine_id).Get())),
+      received_ticket_(0),
+      done_ticket_(0),
+      exiting_(false) {
   OBJECT_MSG_LIST_UNSAFE_FOR_EACH_PTR(vm_->mut_thread_ctx_list(), thread_ctx) {
-    auto thread_pool = std::make_unique<ThreadPool>(1);
-    CHECK(thread_ctx2thread_pool_.emplace(thread_ctx, std::move(thread_pool)).second);
+    worker_threads_.emplace_back([thread_ctx]() { thread_ctx->LoopRun(); });
   }
+  schedule_thread_ = std::thread([this]() { ScheduleLoop(); });
 }
 
-void OneflowVM::TryReceiveAndRun() {
-  for (auto& pair : thread_ctx2thread_pool_) {
-    vm::ThreadCtx* thread_ctx = pair.first;
-    if (thread_ctx->mut_pending_instruction_list()->Empty()) { continue; }
-    pair.second->AddWork([thread_ctx]() { thread_ctx->TryReceiveAndRun(); });
+OneflowVM::~OneflowVM() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    exiting_ = true;
+  }
+  received_cond_.notify_one();
+  schedule_thread_.join();
+  OBJECT_MSG_LIST_UNSAFE_FOR_EACH_PTR(vm_->mut_thread_ctx_list(), thread_ctx) {
+    thread_ctx->mut_pending_instruction_list()->Close();
+  }
+  for (auto& worker_thread : worker_threads_) { worker_thread.join(); }
+}
+
+int64_t OneflowVM::Receive(vm::VirtualMachine::InstructionMsgList* instr_list) {
+  int64_t ticket = 0;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    vm_->Receive(instr_list);
+    ticket = ++received_ticket_;
+  }
+  received_cond_.notify_one();
+  return ticket;
+}
+
+void OneflowVM::WaitUntilDone(int64_t ticket) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cond_.wait(lock, [this, ticket]() { return done_ticket_ >= ticket; });
+}
+
+void OneflowVM::WaitUntilAllDone() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  const int64_t ticket = received_ticket_;
+  done_cond_.wait(lock, [this, ticket]() { return done_ticket_ >= ticket; });
+}
+
+void OneflowVM::ScheduleLoop() {
+  while (true) {
+    int64_t ticket = 0;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      received_cond_.wait(lock, [this]() { return exiting_ || received_ticket_ > done_ticket_; });
+      if (received_ticket_ == done_ticket_) { break; }
+      ticket = received_ticket_;
+    }
+    // all the instructions received before `ticket` was taken are finished once the vm is empty
+    while (!vm_->Empty()) { vm_->Schedule(); }
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      done_ticket_ = ticket;
+    }
+    done_cond_.notify_all();
   }
 }
 
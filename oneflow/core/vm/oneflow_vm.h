@@ -19,28 +19,37 @@ limitations under the License.
 #include "oneflow/core/vm/interpret_type.h"
 #include "oneflow/core/vm/vm_desc.msg.h"
 #include "oneflow/core/vm/virtual_machine.msg.h"
-#include "oneflow/core/thread/thread_pool.h"
 
 namespace oneflow {
 
-namespace vm {
-
-class ThreadCtx;
-}
-
 class OneflowVM final {
  public:
   OneflowVM(const OneflowVM&) = delete;
   OneflowVM(OneflowVM&&) = delete;
   OneflowVM(const Resource& resource, int64_t this_machine_id);
-  ~OneflowVM() = default;
+  ~OneflowVM();
 
   vm::VirtualMachine* mut_vm() { return vm_.Mutable(); }
-  void TryReceiveAndRun();
+
+  // Hands instructions over to the scheduler thread and returns immediately. The returned ticket
+  // can be waited on with WaitUntilDone.
+  int64_t Receive(vm::VirtualMachine::InstructionMsgList* instr_list);
+  void WaitUntilDone(int64_t ticket);
+  // Waits until every instruction received so far is finished.
+  void WaitUntilAllDone();
 
  private:
+  void ScheduleLoop();
+
   ObjectMsgPtr<vm::VirtualMachine> vm_;
-  HashMap<vm::ThreadCtx*, std::unique_ptr<ThreadPool>> thread_ctx2thread_pool_;
+  std::vector<std::thread> worker_threads_;
+  std::thread schedule_thread_;
+  std::mutex mutex_;
+  std::condition_variable received_cond_;
+  std::condition_variable done_cond_;
+  int64_t received_ticket_;
+  int64_t done_ticket_;
+  bool exiting_;
 };
 
 }  // namespace oneflow
@@ -0,0 +1,89 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/vm/recorded_instruction_list.h"
+
+namespace oneflow {
+namespace vm {
+
+namespace {
+
+Operand* MutObjectOperand(InstructionOperand* instr_operand) {
+  if (instr_operand->has_const_operand()) {
+    return instr_operand->mut_const_operand()->mutable_operand();
+  } else if (instr_operand->has_mut_operand()) {
+    return instr_operand->mut_mut_operand()->mutable_operand();
+  } else if (instr_operand->has_mut2_operand()) {
+    return instr_operand->mut_mut2_operand()->mutable_operand();
+  } else if (instr_operand->has_symbol_operand()) {
+    return instr_operand->mut_symbol_operand()->mutable_operand();
+  } else if (instr_operand->has_init_symbol_operand()) {
+    return instr_operand->mut_init_symbol_operand()->mutable_operand();
+  } else {
+    return nullptr;
+  }
+}
+
+// InstructionMsg's copy shares the operand list, rebinding needs operands of its own so that the
+// recorded template and instructions replayed before stay untouched
+ObjectMsgPtr<InstructionMsg> CloneWithOwnedOperands(const InstructionMsg& instr_msg) {
+  auto cloned = ObjectMsgPtr<InstructionMsg>::New(instr_msg);
+  cloned->clear_operand_list();
+  auto* operand_vec = cloned->mutable_operand();
+  operand_vec->reserve(instr_msg.operand().size());
+  for (const auto& operand : instr_msg.operand()) { operand_vec->push_back(operand); }
+  return cloned;
+}
+
+}  // namespace
+
+RecordedInstructionList::RecordedInstructionList(
+    const InstructionListProto& instruction_list_proto) {
+  for (const auto& instr_proto : instruction_list_proto.instruction()) {
+    auto instr_msg = ObjectMsgPtr<InstructionMsg>::New(instr_proto);
+    std::vector<int32_t> object_operand_indexes;
+    FOR_RANGE(int32_t, i, 0, instr_msg->operand().size()) {
+      if (MutObjectOperand(instr_msg->mut_operand()->at(i).Mutable()) != nullptr) {
+        object_operand_indexes.push_back(i);
+      }
+    }
+    instr_msgs_.push_back(std::move(instr_msg));
+    object_operand_indexes_.push_back(std::move(object_operand_indexes));
+  }
+}
+
+void RecordedInstructionList::Replay(InstructionMsgList* instr_msg_list) const {
+  for (const auto& instr_msg : instr_msgs_) {
+    instr_msg_list->EmplaceBack(ObjectMsgPtr<InstructionMsg>::New(instr_msg.Get()));
+  }
+}
+
+void RecordedInstructionList::Replay(
+    const HashMap<int64_t, int64_t>& logical_object_id2rebound_id,
+    InstructionMsgList* instr_msg_list) const {
+  FOR_RANGE(size_t, i, 0, instr_msgs_.size()) {
+    auto instr_msg = CloneWithOwnedOperands(instr_msgs_.at(i).Get());
+    for (int32_t operand_index : object_operand_indexes_.at(i)) {
+      Operand* operand = MutObjectOperand(instr_msg->mut_operand()->at(operand_index).Mutable());
+      const auto& iter = logical_object_id2rebound_id.find(operand->logical_object_id());
+      if (iter == logical_object_id2rebound_id.end()) { continue; }
+      operand->set_logical_object_id(iter->second);
+    }
+    instr_msg_list->EmplaceBack(std::move(instr_msg));
+  }
+}
+
+}  // namespace vm
+}  // namespace oneflow
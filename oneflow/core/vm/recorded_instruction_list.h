@@ -0,0 +1,52 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_VM_RECORDED_INSTRUCTION_LIST_H_
+#define ONEFLOW_CORE_VM_RECORDED_INSTRUCTION_LIST_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/vm/instruction.msg.h"
+
+namespace oneflow {
+namespace vm {
+
+// An instruction list parsed once and turned into fresh InstructionMsgs many times. Replaying skips
+// proto parsing and instruction type lookup, only the logical object ids of operands are rebound.
+// The replayed instructions still go through the dependency analysis of VirtualMachine::Schedule,
+// since they depend on instructions in flight that are not known at record time.
+class RecordedInstructionList final {
+ public:
+  using InstructionMsgList = OBJECT_MSG_LIST(InstructionMsg, instr_msg_link);
+
+  OF_DISALLOW_COPY_AND_MOVE(RecordedInstructionList);
+  explicit RecordedInstructionList(const InstructionListProto& instruction_list_proto);
+  ~RecordedInstructionList() = default;
+
+  size_t size() const { return instr_msgs_.size(); }
+
+  void Replay(InstructionMsgList* instr_msg_list) const;
+  void Replay(const HashMap<int64_t, int64_t>& logical_object_id2rebound_id,
+              InstructionMsgList* instr_msg_list) const;
+
+ private:
+  std::vector<ObjectMsgPtr<InstructionMsg>> instr_msgs_;
+  // indexes of the operands referring to a logical object, per instruction
+  std::vector<std::vector<int32_t>> object_operand_indexes_;
+};
+
+}  // namespace vm
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_VM_RECORDED_INSTRUCTION_LIST_H_
@@ -0,0 +1,99 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/vm/recorded_instruction_list.h"
+#include "oneflow/core/vm/instruction.pb.h"
+
+namespace oneflow {
+namespace vm {
+namespace test {
+
+namespace {
+
+using InstructionMsgList = OBJECT_MSG_LIST(InstructionMsg, instr_msg_link);
+
+InstructionListProto MakeNopInstructionListProto(int64_t instr_num, int64_t object_num) {
+  InstructionListProto instruction_list_proto;
+  FOR_RANGE(int64_t, i, 0, instr_num) {
+    auto* instr_proto = instruction_list_proto.add_instruction();
+    instr_proto->set_instr_type_name("Nop");
+    instr_proto->add_operand()->mutable_const_operand()->set_logical_object_id(i % object_num);
+    instr_proto->add_operand()->mutable_separator();
+    auto* mut_operand = instr_proto->add_operand()->mutable_mut_operand();
+    mut_operand->set_logical_object_id((i + 1) % object_num);
+    mut_operand->mutable_sole_mirrored_object();
+    instr_proto->add_operand()->set_int64_operand(i);
+  }
+  return instruction_list_proto;
+}
+
+}  // namespace
+
+TEST(RecordedInstructionList, replay_with_rebinding) {
+  const InstructionListProto proto = MakeNopInstructionListProto(4, 2);
+  RecordedInstructionList recorded(proto);
+  ASSERT_EQ(recorded.size(), 4);
+  InstructionMsgList list;
+  recorded.Replay({{0, 100}}, &list);
+  ASSERT_EQ(list.size(), 4);
+  int64_t i = 0;
+  OBJECT_MSG_LIST_FOR_EACH_PTR(&list, instr_msg) {
+    ASSERT_TRUE(instr_msg->instr_type_id() == LookupInstrTypeId("Nop"));
+    ASSERT_EQ(instr_msg->operand().size(), 4);
+    const int64_t const_id = i % 2 == 0 ? 100 : 1;
+    const int64_t mut_id = (i + 1) % 2 == 0 ? 100 : 1;
+    ASSERT_EQ(instr_msg->operand().at(0)->const_operand().logical_object_id(), const_id);
+    ASSERT_TRUE(instr_msg->operand().at(1)->has_separator());
+    ASSERT_EQ(instr_msg->operand().at(2)->mut_operand().logical_object_id(), mut_id);
+    ASSERT_TRUE(instr_msg->operand().at(2)->mut_operand().operand().has_sole_mirrored_object());
+    ASSERT_EQ(instr_msg->operand().at(3)->int64_operand(), i);
+    ++i;
+  }
+  InstructionMsgList rebound_again_list;
+  recorded.Replay({{0, 200}}, &rebound_again_list);
+  ASSERT_EQ(rebound_again_list.Begin()->operand().at(0)->const_operand().logical_object_id(), 200);
+  ASSERT_EQ(list.Begin()->operand().at(0)->const_operand().logical_object_id(), 100);
+  InstructionMsgList unbound_list;
+  recorded.Replay(&unbound_list);
+  ASSERT_EQ(unbound_list.Begin()->operand().at(0)->const_operand().logical_object_id(), 0);
+}
+
+TEST(RecordedInstructionList, replay_throughput) {
+  const int64_t instr_num = 1024;
+  const int64_t step_num = 64;
+  const InstructionListProto proto = MakeNopInstructionListProto(instr_num, 16);
+  RecordedInstructionList recorded(proto);
+  double start = GetCurTime();
+  FOR_RANGE(int64_t, step, 0, step_num) {
+    InstructionMsgList list;
+    for (const auto& instr_proto : proto.instruction()) {
+      list.EmplaceBack(ObjectMsgPtr<InstructionMsg>::New(instr_proto));
+    }
+  }
+  double rebuild_time = GetCurTime() - start;
+  start = GetCurTime();
+  FOR_RANGE(int64_t, step, 0, step_num) {
+    InstructionMsgList list;
+    recorded.Replay({{0, 100}, {1, 101}}, &list);
+  }
+  double replay_time = GetCurTime() - start;
+  LOG(INFO) << "instructions per second, rebuild from proto: "
+            << instr_num * step_num / (rebuild_time / 1e9)
+            << ", replay: " << instr_num * step_num / (replay_time / 1e9);
+}
+
+}  // namespace test
+}  // namespace vm
+}  // namespace oneflow
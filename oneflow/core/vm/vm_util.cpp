@@ -41,18 +41,28 @@ Maybe<void> Run(const std::string& instruction_list_str) {
 }
 
 Maybe<void> Run(const InstructionListProto& instruction_list_proto) {
+  return Wait(JUST(RunAsync(instruction_list_proto)));
+}
+
+Maybe<int64_t> RunAsync(const InstructionListProto& instruction_list_proto) {
   InstructionMsgList instr_msg_list;
   for (const auto& instr_proto : instruction_list_proto.instruction()) {
     auto instr_msg = ObjectMsgPtr<InstructionMsg>::New(instr_proto);
     instr_msg_list.EmplaceBack(std::move(instr_msg));
   }
   auto* oneflow_vm = JUST(GlobalMaybe<OneflowVM>());
-  auto* vm = oneflow_vm->mut_vm();
-  vm->Receive(&instr_msg_list);
-  while (!vm->Empty()) {
-    vm->Schedule();
-    oneflow_vm->TryReceiveAndRun();
-  }
+  return oneflow_vm->Receive(&instr_msg_list);
+}
+
+Maybe<void> Wait(int64_t ticket) {
+  auto* oneflow_vm = JUST(GlobalMaybe<OneflowVM>());
+  oneflow_vm->WaitUntilDone(ticket);
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> Sync() {
+  auto* oneflow_vm = JUST(GlobalMaybe<OneflowVM>());
+  oneflow_vm->WaitUntilAllDone();
   return Maybe<void>::Ok();
 }
 
@@ -29,6 +29,12 @@ ObjectMsgPtr<InstructionMsg> NewInstruction(const std::string& instr_type_name);
 
 Maybe<void> Run(const std::string& instruction_list_proto_str);
 Maybe<void> Run(const InstructionListProto& instruction_list_proto);
+// Submits instructions to the vm scheduler thread without waiting for them. The returned ticket
+// is done once all the instructions submitted up to it are finished.
+Maybe<int64_t> RunAsync(const InstructionListProto& instruction_list_proto);
+Maybe<void> Wait(int64_t ticket);
+// Waits for all the instructions submitted so far.
+Maybe<void> Sync();
 
 }  // namespace vm
 }  // namespace oneflow
@@ -52,6 +52,7 @@ locals()["dtype"] = oneflow_api.dtype
 locals()["char"] = oneflow_api.char
 locals()["float16"] = oneflow_api.float16
 locals()["half"] = oneflow_api.float16
+locals()["bfloat16"] = oneflow_api.bfloat16
 locals()["float32"] = oneflow_api.float32
 locals()["float"] = oneflow_api.float
 locals()["double"] = oneflow_api.double
@@ -270,6 +270,41 @@ def use_rdma(val=True):
     sess.config_proto.resource.use_rdma = val
 
 
+@oneflow_export("config.use_shm_comm_net")
+def api_use_shm_comm_net(val: bool = True) -> None:
+    r"""Whether the processes on the same host exchange data through shared memory
+          instead of sockets or not.
+
+    Args:
+        val (bool, optional):  Defaults to True.
+    """
+    return enable_if.unique([use_shm_comm_net, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def use_shm_comm_net(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.use_shm_comm_net = val
+
+
+@oneflow_export("config.shm_comm_net_ring_mbyte")
+def api_shm_comm_net_ring_mbyte(val: int) -> None:
+    r"""Set up the size of the shared memory ring between two processes on a host.
+
+    Args:
+        val (int): buffer size, e.g. 4(mb)
+    """
+    return enable_if.unique([shm_comm_net_ring_mbyte, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def shm_comm_net_ring_mbyte(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.shm_comm_net_ring_mbyte = val
+
+
 @oneflow_export("config.thread_enable_local_message_queue")
 def api_thread_enable_local_message_queue(val: bool) -> None:
     """Whether or not enable thread using local  message queue.
@@ -378,6 +413,115 @@ def enable_model_io_v2(val):
     sess.config_proto.io_conf.enable_model_io_v2 = val
 
 
+@oneflow_export("config.enable_async_model_save")
+def api_enable_async_model_save(val: bool = True):
+    r"""Whether or not save model v2 snapshots in background threads.
+    Use `oneflow.wait_for_async_model_save` to wait until all pending saves of this process are done.
+
+    Args:
+        val (bool): True or False
+    """
+    return enable_if.unique([enable_async_model_save, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_async_model_save(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.io_conf.enable_async_model_save = val
+
+
+@oneflow_export("config.enable_mmap_model_load")
+def api_enable_mmap_model_load(val: bool = True):
+    r"""Whether or not load model v2 snapshots through memory mapped files.
+    Mapped files are read with parallel copies and share the page cache between processes.
+
+    Args:
+        val (bool): True or False
+    """
+    return enable_if.unique([enable_mmap_model_load, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_mmap_model_load(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.io_conf.enable_mmap_model_load = val
+
+
+@oneflow_export("config.enable_io_uring")
+def api_enable_io_uring(val: bool = True):
+    r"""Whether or not use io_uring for local files and the sockets between machines.
+    Batches of reads are submitted by one system call and data files are read ahead in
+    background. The sockets are watched by multishot polls of io_uring instead of epoll,
+    their reads and writes are still plain system calls.
+
+    Args:
+        val (bool): True or False
+    """
+    return enable_if.unique([enable_io_uring, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_io_uring(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.io_conf.enable_io_uring = val
+
+
+@oneflow_export("config.enable_direct_io")
+def api_enable_direct_io(val: bool = True):
+    r"""Whether or not bypass the page cache when reading local files through io_uring.
+
+    Args:
+        val (bool): True or False
+    """
+    return enable_if.unique([enable_direct_io, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_direct_io(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.io_conf.enable_direct_io = val
+
+
+@oneflow_export("config.data_cache_dir")
+def api_data_cache_dir(val: str) -> None:
+    r"""Set the directory caching the downloaded data files, shared by the processes
+    on a node. Defaults to global_fs_buffer under the log directory.
+
+    Args:
+        val (str): path of the directory
+    """
+    return enable_if.unique([data_cache_dir, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def data_cache_dir(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is str
+    sess.config_proto.io_conf.data_cache_dir = val
+
+
+@oneflow_export("config.data_cache_mbyte")
+def api_data_cache_mbyte(val: int) -> None:
+    r"""Set the size limit of the data file cache, the least recently used files are
+    evicted.
+
+    Args:
+        val (int): size in MByte
+    """
+    return enable_if.unique([data_cache_mbyte, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def data_cache_mbyte(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.io_conf.data_cache_mbyte = val
+
+
 @oneflow_export("config.collect_act_event")
 def api_collect_act_event(val: bool = True) -> None:
     r"""Whether or not collect active event.
@@ -396,6 +396,68 @@ def set_cudnn_buf_limit_mbyte(func_desc, value):
     func_desc.job_config_proto.set_cudnn_buf_limit_mbyte(value)
 
 
+@oneflow_function_config("auto_checkpointing_memory_budget_mbyte")
+def set_auto_checkpointing_memory_budget_mbyte(func_desc, value):
+    r"""Set the device memory budget of automatic checkpointing, e.g. 4096mb.
+            If set, forward ops are chosen to be recomputed in backward pass until the estimated peak memory of a device fits in the budget.
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_auto_checkpointing_memory_budget_mbyte(value)
+
+
+@oneflow_function_config("enable_auto_parallel")
+def set_enable_auto_parallel(func_desc, value=True):
+    r"""Whether enable auto_parallel.
+            If enabled, the sbp signatures of ops are chosen to minimize the estimated compute and boxing time of the whole job instead of op by op.
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_enable_auto_parallel(value)
+
+
+@oneflow_function_config("auto_parallel_profile")
+def set_auto_parallel_profile(func_desc, device_gflops, bandwidth_gbyte_per_sec):
+    r"""Set the device and network performance auto_parallel estimates time by, e.g. 10000 gflops and 10 gbyte/s.
+
+    Args:
+        func_desc ([type]): [description]
+        device_gflops ([type]): [description]
+        bandwidth_gbyte_per_sec ([type]): [description]
+    """
+    func_desc.job_config_proto.set_auto_parallel_device_gflops(device_gflops)
+    func_desc.job_config_proto.set_auto_parallel_bandwidth_gbyte_per_sec(
+        bandwidth_gbyte_per_sec
+    )
+
+
+@oneflow_function_config("auto_pipeline_num_stages")
+def set_auto_pipeline_num_stages(func_desc, value):
+    r"""Split the ops placed with the loss into pipeline stages on disjoint devices.
+            The ops are cut in topological order balancing the estimated compute time of the stages, set it with enable_ssp to pipeline the variables too.
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_auto_pipeline_num_stages(value)
+
+
+@oneflow_function_config("auto_pipeline_op_act_time_file")
+def set_auto_pipeline_op_act_time_file(func_desc, value):
+    r"""Set the op_act_time file dumped by a profiled run, auto_pipeline balances the stages by the measured op time in it instead of the estimated one.
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_auto_pipeline_op_act_time_file(value)
+
+
 @oneflow_function_config("cudnn_conv_force_fwd_algo")
 def set_cudnn_conv_force_fwd_algo(func_desc, value):
     r"""Set value to cudnn conv_force_forward algorithm
@@ -475,6 +537,42 @@ def set_enable_fuse_cast_scale(func_desc, value=True):
     func_desc.job_config_proto.set_enable_fuse_cast_scale(value)
 
 
+@oneflow_function_config("enable_fuse_elementwise_ops")
+def set_enable_fuse_elementwise_ops(func_desc, value=True):
+    r"""Whether enable fuse_elementwise_ops.
+            If enabled, try to fuse chains of elementwise ops placed on cpu into a single fused_elementwise op.
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_enable_fuse_elementwise_ops(value)
+
+
+@oneflow_function_config("enable_constant_folding")
+def set_enable_constant_folding(func_desc, value=True):
+    r"""Whether enable constant_folding.
+            If enabled, ops computing from constants only (e.g. reshape, cast or scalar_mul of a constant) are replaced by constant ops at compile time.
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_enable_constant_folding(value)
+
+
+@oneflow_function_config("enable_common_subexpression_elimination")
+def set_enable_common_subexpression_elimination(func_desc, value=True):
+    r"""Whether enable common_subexpression_elimination.
+            If enabled, ops with the same type, attributes, placement and inputs are computed only once.
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_enable_common_subexpression_elimination(value)
+
+
 @oneflow_function_config("cudnn_conv_use_deterministic_algo_only")
 def set_cudnn_conv_use_deterministic_algo_only(func_desc, value):
     r"""Set value to cudnn conv_use_deterministic_only algorithm
@@ -737,6 +835,28 @@ def set_qat_symmetric(func_desc, value: str):
     func_desc.job_config_proto.mutable_qat_config().set_target_backend(value)
 
 
+@oneflow_function_config("enable_int8_calibration")
+def set_enable_int8_calibration(func_desc, value=True):
+    r"""If true, then the job records the int8 scales of the inputs of conv2d and matmul ops placed on cpu, the scales are saved as variables and used by int8 inference.
+
+    Args:
+        func_desc ([type]): [description]
+        value (bool, optional): [description]. Defaults to True.
+    """
+    func_desc.job_config_proto.set_enable_int8_calibration(value)
+
+
+@oneflow_function_config("enable_int8_inference")
+def set_enable_int8_inference(func_desc, value=True):
+    r"""If true, then conv2d and matmul ops placed on cpu, together with the following bias_add and relu, are replaced by int8 ops using the calibrated scales.
+
+    Args:
+        func_desc ([type]): [description]
+        value (bool, optional): [description]. Defaults to True.
+    """
+    func_desc.job_config_proto.set_enable_int8_inference(value)
+
+
 @oneflow_function_config("enable_auto_mixed_precision")
 def set_enable_auto_mixed_precision(func_desc, value=True):
     r"""If true, then job will use mixed precision mode, it means use both float16 and float32 during model training.
@@ -748,6 +868,17 @@ def set_enable_auto_mixed_precision(func_desc, value=True):
     func_desc.job_config_proto.set_enable_auto_mixed_precision(value)
 
 
+@oneflow_function_config("enable_cpu_auto_mixed_precision")
+def set_enable_cpu_auto_mixed_precision(func_desc, value=True):
+    r"""If true, ops placed on cpu will use mixed precision mode, the ops picked by the same white, gray and clear lists as the gpu mode run in bfloat16.
+
+    Args:
+        func_desc ([type]): [description]
+        value (bool, optional): [description]. Defaults to True.
+    """
+    func_desc.job_config_proto.set_enable_cpu_auto_mixed_precision(value)
+
+
 @oneflow_function_config("enable_keep_header_only")
 def set_enable_keep_header_only(func_desc, value=True):
     r"""deprecated api.
@@ -813,6 +944,18 @@ def set_enable_fuse_model_update_ops(func_desc, value=True):
     func_desc.job_config_proto.set_enable_fuse_model_update_ops(value)
 
 
+
+@oneflow_function_config("enable_multi_tensor_model_update")
+def set_enable_multi_tensor_model_update(func_desc, value=True):
+    r"""Whether enable multi-tensor model update.
+            If enabled, the sgd and adam update ops of cpu variables sharing the same hyper parameters are merged into one op, which updates all of them in a single vectorized and multi-threaded kernel.
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_enable_multi_tensor_model_update(value)
+
 @oneflow_function_config("enable_gradients_stats_aggregation")
 def set_enable_gradients_stats_aggregation(func_desc, value=True):
     r"""Whether enable gradients_stats_aggregation.
@@ -235,6 +235,8 @@ class Session(object):
         del self.job_name2module_name2module_
         self.ReleaseLazyRefBlob()
         self.ForceReleaseEagerBlobs()
+        # eager instructions run asynchronously, wait for them before tearing down
+        oneflow_api.eager.Sync()
         oneflow_api.StopLazyGlobalSession()
         oneflow_api.DestroyLazyGlobalSession()
         self.status_ = SessionStatus.CLOSED
@@ -488,6 +490,14 @@ def sync_default_session() -> None:
     session_ctx.GetDefaultSession().Sync()
 
 
+@oneflow_export("wait_for_async_model_save")
+def api_wait_for_async_model_save() -> None:
+    r"""Block until every model snapshot saved asynchronously by this process is written.
+    Only saves of the local process are waited for.
+    """
+    oneflow_api.WaitForAsyncModelSave()
+
+
 def _TryCompleteConfigProto(config_proto):
     if config_proto.resource.machine_num == 0:
         config_proto.resource.machine_num = len(env_util.default_env_proto.machine)
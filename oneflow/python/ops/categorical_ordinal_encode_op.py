@@ -29,6 +29,7 @@ def categorical_ordinal_encode(
     size: oneflow_api.BlobDesc,
     input_tensor: oneflow_api.BlobDesc,
     hash_precomputed: bool = True,
+    allow_overflow: bool = False,
     name: Optional[str] = None,
 ) -> oneflow_api.BlobDesc:
     """This operator maintains a hash table to encode the categorical ordinal Blob. It converts a discrete input value into a continuous integer ID. 
@@ -38,6 +39,7 @@ def categorical_ordinal_encode(
         size (oneflow_api.BlobDesc): The size of hash table. 
         input_tensor (oneflow_api.BlobDesc): The input Blob. 
         hash_precomputed (bool, optional): We currently only support the 'True' mode. The internal hash value will no longer be computed. Defaults to True.
+        allow_overflow (bool, optional): Whether to keep encoding new values after the hash table is full, they are kept in memory and are not saved with the table. Only supported on cpu. Defaults to False.
         name (Optional[str], optional): The name for the operation. Defaults to None.
 
     Returns:
@@ -96,6 +98,7 @@ def categorical_ordinal_encode(
         .Input("size", [size])
         .Output("out")
         .Attr("hash_precomputed", hash_precomputed)
+        .Attr("allow_overflow", allow_overflow)
         .Build()
         .InferAndTryRun()
         .RemoteBlobList()[0]
@@ -107,6 +110,7 @@ def categorical_ordinal_encoder(
     input_tensor: oneflow_api.BlobDesc,
     capacity: int,
     hash_precomputed: bool = True,
+    allow_overflow: bool = False,
     name: str = "CategoricalOrdinalEncoder",
 ) -> oneflow_api.BlobDesc:
     """This operator uses `oneflow.categorical_ordinal_encode` to encapsulate a categorical_ordinal_encoder. More details please refer to `oneflow.categorical_ordinal_encode`
@@ -115,6 +119,7 @@ def categorical_ordinal_encoder(
         input_tensor (oneflow_api.BlobDesc): The input Blob. 
         capacity (int): The capacity of hash table. 
         hash_precomputed (bool, optional): We currently only support the 'True' mode. The internal hash value will no longer be computed. Defaults to True.
+        allow_overflow (bool, optional): Whether to keep encoding new values after the hash table is full. Defaults to False.
         name (str, optional): The name for the operation. Defaults to "CategoricalOrdinalEncoder".
 
     Returns:
@@ -164,5 +169,9 @@ def categorical_ordinal_encoder(
             reuse=False,
         )
         return categorical_ordinal_encode(
-            table=table, size=size, input_tensor=input_tensor, name="Encode",
+            table=table,
+            size=size,
+            input_tensor=input_tensor,
+            allow_overflow=allow_overflow,
+            name="Encode",
         )
@@ -0,0 +1,135 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+from __future__ import absolute_import
+from typing import Optional
+from oneflow.python.oneflow_export import oneflow_export
+
+import oneflow as flow
+import oneflow.python.framework.id_util as id_util
+import oneflow_api
+
+
+@oneflow_export("experimental.embedding_lookup")
+def embedding_lookup(
+    ids: oneflow_api.BlobDesc,
+    path: str,
+    num_rows: int,
+    embedding_dim: int,
+    cache_capacity: int = 1 << 20,
+    initializer_range: float = 0.05,
+    seed: int = 0,
+    optimizer: str = "sgd",
+    learning_rate: float = 0.001,
+    beta1: float = 0.9,
+    beta2: float = 0.999,
+    epsilon: float = 1e-8,
+    prefetch: bool = True,
+    name: str = "EmbeddingLookup",
+) -> oneflow_api.BlobDesc:
+    r"""Looks up the rows of an embedding table kept in the file at `path` instead of a variable, for tables too large for memory. The most recently used `cache_capacity` rows are cached in memory and evicted rows are written back to the file in the background. Rows never trained are initialized uniformly in [-initializer_range, initializer_range].
+
+    In a training job, the rows looked up are updated in place right after the backward pass by `optimizer` ("sgd" or "adam") with `learning_rate`, `beta1`, `beta2` and `epsilon`, independently of the optimizer of the job. Adam only updates the rows looked up and its moments are not bias corrected. The table is not saved by `flow.checkpoint`, all its rows are in the file once the session is closed.
+
+    Only supported on cpu with one device.
+
+    Args:
+        ids (oneflow_api.BlobDesc): The int64 row ids.
+        path (str): The file of the table, created if it does not exist.
+        num_rows (int): The number of rows of the table.
+        embedding_dim (int): The size of every row.
+        cache_capacity (int, optional): The number of rows cached in memory. Defaults to 1 << 20.
+        initializer_range (float, optional): The range of the initial values. Defaults to 0.05.
+        seed (int, optional): The seed of the initial values. Defaults to 0.
+        optimizer (str, optional): "sgd" or "adam". Defaults to "sgd".
+        learning_rate (float, optional): Defaults to 0.001.
+        beta1 (float, optional): Defaults to 0.9.
+        beta2 (float, optional): Defaults to 0.999.
+        epsilon (float, optional): Defaults to 1e-8.
+        prefetch (bool, optional): Whether to start loading the rows of ids as soon as ids is ready, so that the rows of the next batch are loaded while the current batch is computed. Defaults to True.
+        name (str, optional): The name for the operation. Defaults to "EmbeddingLookup".
+
+    Returns:
+        oneflow_api.BlobDesc: The embeddings of shape ids.shape + (embedding_dim,).
+
+    For example:
+
+    .. code-block:: python
+
+        import oneflow as flow
+        import oneflow.typing as tp
+
+        @flow.global_function(type="train")
+        def train_job(ids: tp.Numpy.Placeholder((64,), dtype=flow.int64)) -> tp.Numpy:
+            embeddings = flow.experimental.embedding_lookup(
+                ids, "/tmp/embedding_table", num_rows=100000000, embedding_dim=16,
+                learning_rate=0.1,
+            )
+            loss = flow.math.reduce_mean(embeddings)
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [0.1]), momentum=0
+            ).minimize(loss)
+            return loss
+
+    """
+    assert optimizer in ("sgd", "adam")
+
+    def AddStoreAttrs(builder):
+        return (
+            builder.Attr("path", path)
+            .Attr("num_rows", num_rows)
+            .Attr("embedding_dim", embedding_dim)
+            .Attr("cache_capacity", cache_capacity)
+            .Attr("initializer_range", float(initializer_range))
+            .Attr("seed", seed)
+            .Attr("optimizer", optimizer)
+        )
+
+    with flow.scope.namespace(name):
+        if prefetch:
+            ids = (
+                AddStoreAttrs(
+                    flow.user_op_builder(id_util.UniqueStr("Prefetch_"))
+                    .Op("embedding_prefetch")
+                    .Input("ids", [ids])
+                    .Output("out")
+                )
+                .Build()
+                .InferAndTryRun()
+                .RemoteBlobList()[0]
+            )
+        shadow = flow.get_variable(
+            name="shadow",
+            shape=(1,),
+            dtype=flow.float,
+            initializer=flow.zeros_initializer(),
+            trainable=True,
+        )
+        return (
+            AddStoreAttrs(
+                flow.user_op_builder(id_util.UniqueStr("Lookup_"))
+                .Op("embedding_lookup")
+                .Input("shadow", [shadow])
+                .Input("ids", [ids])
+                .Output("embeddings")
+            )
+            .Attr("learning_rate", float(learning_rate))
+            .Attr("beta1", float(beta1))
+            .Attr("beta2", float(beta2))
+            .Attr("epsilon", float(epsilon))
+            .Build()
+            .InferAndTryRun()
+            .RemoteBlobList()[0]
+        )
@@ -356,3 +356,69 @@ def fake_quantization(
         .InferAndTryRun()
         .SoleOutputBlob()
     )
+
+
+@oneflow_export("quantization.quantize")
+def quantize(
+    input: oneflow_api.BlobDesc,
+    scale: oneflow_api.BlobDesc,
+    name: Optional[str] = None,
+) -> oneflow_api.BlobDesc:
+    r"""Quantize a float32 tensor to int8 with a symmetric per-layer scale.
+
+    The output will be computed as:
+
+        .. math::
+
+            & clamp(round(x / scale), -127, 127)
+
+    Args:
+        input (oneflow_api.BlobDesc): input tensor.
+        scale (oneflow_api.BlobDesc): float32 tensor of shape (1,).
+        name (Optional[str]): This operator's name. Defaults to None.
+
+    Returns:
+        oneflow_api.BlobDesc: int8 tensor.
+    """
+    return (
+        flow.user_op_builder(
+            name if name is not None else id_util.UniqueStr("Quantize_")
+        )
+        .Op("quantize")
+        .Input("in", [input])
+        .Input("scale", [scale])
+        .Output("out")
+        .Build()
+        .InferAndTryRun()
+        .SoleOutputBlob()
+    )
+
+
+@oneflow_export("quantization.dequantize")
+def dequantize(
+    input: oneflow_api.BlobDesc,
+    scale: oneflow_api.BlobDesc,
+    name: Optional[str] = None,
+) -> oneflow_api.BlobDesc:
+    r"""Dequantize an int8 tensor produced by `quantization.quantize` back to float32.
+
+    Args:
+        input (oneflow_api.BlobDesc): int8 input tensor.
+        scale (oneflow_api.BlobDesc): float32 tensor of shape (1,).
+        name (Optional[str]): This operator's name. Defaults to None.
+
+    Returns:
+        oneflow_api.BlobDesc: float32 tensor equal to input * scale.
+    """
+    return (
+        flow.user_op_builder(
+            name if name is not None else id_util.UniqueStr("Dequantize_")
+        )
+        .Op("dequantize")
+        .Input("in", [input])
+        .Input("scale", [scale])
+        .Output("out")
+        .Build()
+        .InferAndTryRun()
+        .SoleOutputBlob()
+    )
@@ -0,0 +1,52 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import oneflow as flow
+import oneflow_api
+import oneflow.python.framework.c_api_util as c_api_util
+
+
+def MakeGlobalFunction(name, job_func, function_config, function_type="predict"):
+    # jobs built from the same job_func are told apart by their names
+    job_func.__name__ = name
+    return flow.global_function(type=function_type, function_config=function_config)(
+        job_func
+    )
+
+
+def GetCompiledJob(job_name):
+    # the job passes rewrite the jobs in the job set when the session starts
+    for job in c_api_util.GetJobSet().job:
+        if job.job_conf.job_name == job_name:
+            return job
+    raise ValueError("job {} not found".format(job_name))
+
+
+def UserOpTypeNames(job):
+    return [op.user_conf.op_type_name for op in job.net.op if op.HasField("user_conf")]
+
+
+def OpName2DeviceNames(job):
+    op_name2device_names = {}
+    for placement_group in job.placement.placement_group:
+        device_names = list(placement_group.parallel_conf.device_name)
+        for op_name in placement_group.op_set.op_name:
+            op_name2device_names[op_name] = device_names
+    return op_name2device_names
+
+
+def ScopeAttrName2AttrValue(scope_symbol_id):
+    scope_proto = oneflow_api.GetScopeSymbol(scope_symbol_id).MakeChildScopeProto()
+    return dict(scope_proto.attr_name2attr_value().items())
@@ -0,0 +1,91 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.typing as tp
+from job_rewrite_test_util import GetCompiledJob, MakeGlobalFunction
+
+# the prefix of the ops that recompute the forward ops for the backward pass
+CHECKPOINTING_FAKE_OP_NAME_PREFIX = "OneFlow-System-Checkpointing-Fake-Fw-Op_"
+
+SHAPE = (256, 512)
+
+
+def _make_job(name, func_config, diffs):
+    def Job(x: tp.Numpy.Placeholder(SHAPE)) -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            # variables are shared by the jobs and left unchanged by the zero learning rate
+            x = x + flow.get_variable(
+                "x_offset",
+                shape=SHAPE,
+                dtype=flow.float32,
+                initializer=flow.zeros_initializer(),
+            )
+            flow.watch_diff(x, lambda diff: diffs.append(diff.numpy()))
+            h = x
+            for i in range(3):
+                h = flow.layers.dense(
+                    h,
+                    SHAPE[1],
+                    activation=flow.math.tanh,
+                    kernel_initializer=flow.random_uniform_initializer(-0.1, 0.1),
+                    name="dense{}".format(i),
+                )
+                h = flow.math.sigmoid(h) * h
+            loss = flow.math.reduce_mean(h * h)
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [0.0]), momentum=0
+            ).minimize(loss)
+            return loss
+
+    return MakeGlobalFunction(name, Job, func_config, function_type="train")
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestAutoCheckpointing(flow.unittest.TestCase):
+    def test_auto_checkpointing(test_case):
+        flow.clear_default_session()
+        plain_diffs = []
+        recomputed_diffs = []
+        recomputed_config = flow.FunctionConfig()
+        recomputed_config.auto_checkpointing_memory_budget_mbyte(1)
+        recomputed_job = _make_job(
+            "AutoCheckpointingJob", recomputed_config, recomputed_diffs
+        )
+        plain_job = _make_job("PlainJob", flow.FunctionConfig(), plain_diffs)
+
+        x = np.random.uniform(-1, 1, SHAPE).astype(np.float32)
+        test_case.assertTrue(np.allclose(recomputed_job(x), plain_job(x), rtol=1e-5))
+        test_case.assertTrue(
+            np.allclose(recomputed_diffs[0], plain_diffs[0], rtol=1e-5, atol=1e-6)
+        )
+
+        def RecomputeOpNames(job_name):
+            return [
+                op.name
+                for op in GetCompiledJob(job_name).net.op
+                if op.name.startswith(CHECKPOINTING_FAKE_OP_NAME_PREFIX)
+            ]
+
+        test_case.assertGreater(len(RecomputeOpNames("AutoCheckpointingJob")), 0)
+        test_case.assertEqual(len(RecomputeOpNames("PlainJob")), 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
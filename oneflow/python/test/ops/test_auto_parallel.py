@@ -0,0 +1,78 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.typing as tp
+from job_rewrite_test_util import GetCompiledJob, MakeGlobalFunction
+
+
+def _make_job(name, func_config):
+    func_config.default_data_type(flow.float)
+    func_config.default_placement_scope(flow.scope.placement("cpu", "0:0-1"))
+
+    def Job(x: tp.Numpy.Placeholder((64, 32))) -> tp.Numpy:
+        # variables are shared by the jobs
+        h = x
+        for i, units in enumerate([1024, 16, 1024]):
+            h = flow.layers.dense(
+                h,
+                units,
+                activation=flow.math.relu,
+                kernel_initializer=flow.random_uniform_initializer(-0.1, 0.1),
+                name="dense{}".format(i),
+            )
+        return flow.math.reduce_sum(h, axis=[1])
+
+    return MakeGlobalFunction(name, Job, func_config)
+
+
+@flow.unittest.skip_unless_1n2d()
+class TestAutoParallel(flow.unittest.TestCase):
+    def test_auto_parallel(test_case):
+        flow.clear_default_session()
+        flow.config.cpu_device_num(2)
+        planned_config = flow.FunctionConfig()
+        planned_config.enable_auto_parallel(True)
+        planned_config.auto_parallel_profile(100, 1)
+        planned_job = _make_job("AutoParallelJob", planned_config)
+        plain_job = _make_job("PlainJob", flow.FunctionConfig())
+
+        x = np.random.uniform(-1, 1, (64, 32)).astype(np.float32)
+        test_case.assertTrue(
+            np.allclose(planned_job(x), plain_job(x), rtol=1e-4, atol=1e-5)
+        )
+
+        planned_op_name2sbp_signature = GetCompiledJob(
+            "AutoParallelJob"
+        ).job_parallel_view_conf.op_name2sbp_signature_conf
+        plain_op_name2sbp_signature = GetCompiledJob(
+            "PlainJob"
+        ).job_parallel_view_conf.op_name2sbp_signature_conf
+        # the ops of the dense layers share names and so are compared one by one
+        changed_op_names = [
+            op_name
+            for op_name, sbp_signature in planned_op_name2sbp_signature.items()
+            if op_name in plain_op_name2sbp_signature
+            and sbp_signature != plain_op_name2sbp_signature[op_name]
+        ]
+        test_case.assertGreater(len(changed_op_names), 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,91 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.typing as tp
+from job_rewrite_test_util import (
+    GetCompiledJob,
+    MakeGlobalFunction,
+    OpName2DeviceNames,
+    ScopeAttrName2AttrValue,
+)
+
+
+def _make_train_job(name, func_config):
+    func_config.default_data_type(flow.float)
+    func_config.default_placement_scope(flow.scope.placement("cpu", "0:0-1"))
+
+    def Job(x: tp.Numpy.Placeholder((64, 32))) -> tp.Numpy:
+        h = x
+        for i, units in enumerate([64, 128, 64, 16]):
+            h = flow.layers.dense(
+                h,
+                units,
+                activation=flow.math.relu,
+                kernel_initializer=flow.constant_initializer(0.01 * (i + 1)),
+                name="{}_dense{}".format(name, i),
+            )
+        loss = flow.math.reduce_mean(h)
+        flow.optimizer.SGD(
+            flow.optimizer.PiecewiseConstantScheduler([], [0.1]), momentum=0
+        ).minimize(loss)
+        return loss
+
+    return MakeGlobalFunction(name, Job, func_config, function_type="train")
+
+
+@flow.unittest.skip_unless_1n2d()
+class TestAutoPipeline(flow.unittest.TestCase):
+    def test_auto_pipeline(test_case):
+        flow.clear_default_session()
+        flow.config.cpu_device_num(2)
+        pipelined_config = flow.FunctionConfig()
+        pipelined_config.auto_pipeline_num_stages(2)
+        pipelined_job = _make_train_job("AutoPipelineJob", pipelined_config)
+        plain_job = _make_train_job("PlainJob", flow.FunctionConfig())
+
+        x = np.random.uniform(0, 1, (64, 32)).astype(np.float32)
+        for _ in range(3):
+            test_case.assertTrue(
+                np.allclose(pipelined_job(x), plain_job(x), rtol=1e-4, atol=1e-5)
+            )
+
+        job = GetCompiledJob("AutoPipelineJob")
+        op_name2device_names = OpName2DeviceNames(job)
+        op_name2stage_id = {}
+        for op in job.net.op:
+            if not op.name.startswith("AutoPipelineJob_dense"):
+                continue
+            attr_name2attr_value = ScopeAttrName2AttrValue(op.scope_symbol_id)
+            if "ssp_stage_id" not in attr_name2attr_value:
+                continue
+            stage_id = attr_name2attr_value["ssp_stage_id"].at_int64()
+            test_case.assertEqual(attr_name2attr_value["ssp_num_stages"].at_int64(), 2)
+            # each of the two stages takes one of the two devices
+            test_case.assertEqual(
+                op_name2device_names[op.name], ["0:{}".format(stage_id)]
+            )
+            op_name2stage_id[op.name] = stage_id
+        test_case.assertEqual(set(op_name2stage_id.values()), {0, 1})
+        test_case.assertEqual(op_name2stage_id["AutoPipelineJob_dense0-matmul"], 0)
+        test_case.assertEqual(op_name2stage_id["AutoPipelineJob_dense3-matmul"], 1)
+
+
+if __name__ == "__main__":
+    unittest.main()
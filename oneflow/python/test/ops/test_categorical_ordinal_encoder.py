@@ -23,7 +23,14 @@ import os
 
 
 def _test_categorical_ordinal_encoder(
-    test_case, device_tag, dtype, size, capacity, num_tokens, num_iters
+    test_case,
+    device_tag,
+    dtype,
+    size,
+    capacity,
+    num_tokens,
+    num_iters,
+    allow_overflow=False,
 ):
     flow.clear_default_session()
     func_config = flow.FunctionConfig()
@@ -35,9 +42,11 @@ def _test_categorical_ordinal_encoder(
         x: oft.Numpy.Placeholder(shape=(size,), dtype=dtype)
     ) -> typing.Tuple[oft.Numpy, oft.Numpy]:
         with flow.scope.placement(device_tag, "0:0"):
-            y = flow.layers.categorical_ordinal_encoder(x, capacity=capacity)
+            y = flow.layers.categorical_ordinal_encoder(
+                x, capacity=capacity, allow_overflow=allow_overflow
+            )
             z = flow.layers.categorical_ordinal_encoder(
-                x, capacity=capacity, name="encode1"
+                x, capacity=capacity, allow_overflow=allow_overflow, name="encode1"
             )
             # z = flow.layers.categorical_ordinal_encoder(x, capacity=320)
             return y, z
@@ -121,6 +130,18 @@ class TestCategoricalOrdinalEncoder(flow.unittest.TestCase):
             num_iters=100,
         )
 
+    def test_categorical_ordinal_encoder_cpu_overflow(test_case):
+        _test_categorical_ordinal_encoder(
+            test_case=test_case,
+            device_tag="cpu",
+            dtype=flow.int64,
+            size=50000,
+            capacity=1024,
+            num_tokens=4096,
+            num_iters=10,
+            allow_overflow=True,
+        )
+
 
 if __name__ == "__main__":
     unittest.main()
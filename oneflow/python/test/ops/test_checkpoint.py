@@ -194,6 +194,36 @@ def _TestRoundTrip(test_case, model_getter, dtype):
         test_case.assertTrue(np.array_equal(res1, res2))
 
 
+def _TestAsyncModelSave(test_case, model_getter, dtype):
+    """
+    Save weights by model io v2 with async model save, load them back,
+    and check the equality and that no temporary file is left behind.
+    """
+    with tempfile.TemporaryDirectory() as save_dir:
+
+        def RefreshModelIoV2Session():
+            refresh_session()
+            flow.config.enable_legacy_model_io(True)
+            flow.config.enable_model_io_v2(True)
+            flow.config.enable_async_model_save(True)
+
+        RefreshModelIoV2Session()
+        model1 = get_checkpoint_ready_model(model_getter, dtype)
+        flow.train.CheckPoint().save(save_dir)
+        flow.wait_for_async_model_save()
+        res1 = model1()
+        for _, _, file_names in os.walk(save_dir):
+            for file_name in file_names:
+                test_case.assertFalse(file_name.endswith(".tmp"))
+
+        RefreshModelIoV2Session()
+        model2 = get_checkpoint_ready_model(model_getter, dtype)
+        flow.train.CheckPoint().load(save_dir)
+        flow.sync_default_session()
+        res2 = model2()
+        test_case.assertTrue(np.array_equal(res1, res2))
+
+
 def _TestLoadCorrectness(test_case, model_getter, dtype, legacy_api):
     """
     Save weights by legacy model io, load weights by new model io,
@@ -391,6 +421,14 @@ class TestCheckpoint(flow.unittest.TestCase):
     def test_load_correctness_2node(test_case):
         _TestLoadCorrectness(test_case, get_large_model, flow.float, False)
 
+    @flow.unittest.skip_unless_1n4d()
+    @unittest.skipIf(
+        flow.unittest.env.eager_execution_enabled(),
+        "legacy model io doesn't work in eager mode",
+    )
+    def test_async_model_save(test_case):
+        _TestAsyncModelSave(test_case, get_simple_model, flow.float)
+
     @flow.unittest.skip_unless_1n4d()
     def test_assignment_between_memory(test_case):
         _TestAssignmentBetweenMemory(test_case, flow.float)
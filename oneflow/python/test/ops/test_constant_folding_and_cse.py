@@ -0,0 +1,104 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.typing as tp
+from job_rewrite_test_util import GetCompiledJob, MakeGlobalFunction, UserOpTypeNames
+
+SHAPE = (4, 16)
+
+
+def _build(x):
+    c = flow.constant(3, dtype=flow.int32, shape=(SHAPE[0] * SHAPE[1],))
+    c = flow.reshape(c, SHAPE)
+    c = flow.cast(c, flow.float32)
+    c = (c + 1.0) * 0.5
+    y0 = flow.math.tanh(x) * c
+    y1 = flow.math.tanh(x) * c
+    return flow.math.sigmoid(y0) + flow.math.sigmoid(y1)
+
+
+def _make_job(name, func_config):
+    def Job(x: tp.Numpy.Placeholder(SHAPE)) -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            return _build(x)
+
+    return MakeGlobalFunction(name, Job, func_config)
+
+
+def _make_reshape_like_job(name, func_config):
+    def Job(x: tp.Numpy.Placeholder(SHAPE)) -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            c = flow.constant(2.0, dtype=flow.float32, shape=(SHAPE[0] * SHAPE[1],))
+            # square is only read by reshape_like for its shape and is not constant
+            c = flow.reshape_like(c, like=flow.math.square(x))
+            return x * c
+
+    return MakeGlobalFunction(name, Job, func_config)
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestConstantFoldingAndCse(flow.unittest.TestCase):
+    def test_constant_folding_and_cse(test_case):
+        flow.clear_default_session()
+        optimized_config = flow.FunctionConfig()
+        optimized_config.enable_constant_folding(True)
+        optimized_config.enable_common_subexpression_elimination(True)
+        optimized_job = _make_job("ConstantFoldingAndCseJob", optimized_config)
+        plain_job = _make_job("PlainJob", flow.FunctionConfig())
+
+        x = np.random.uniform(-1, 1, SHAPE).astype(np.float32)
+        expected = 2 / (1 + np.exp(-np.tanh(x) * 2.0))
+        test_case.assertTrue(
+            np.allclose(plain_job(x), expected, rtol=1e-5, atol=1e-5)
+        )
+        test_case.assertTrue(
+            np.allclose(optimized_job(x), expected, rtol=1e-5, atol=1e-5)
+        )
+
+        optimized_op_type_names = UserOpTypeNames(
+            GetCompiledJob("ConstantFoldingAndCseJob")
+        )
+        plain_op_type_names = UserOpTypeNames(GetCompiledJob("PlainJob"))
+        # the ops computing c from the constant are folded into a single constant op
+        for op_type_name in ["reshape", "cast", "scalar_add", "scalar_mul"]:
+            test_case.assertIn(op_type_name, plain_op_type_names)
+            test_case.assertNotIn(op_type_name, optimized_op_type_names)
+        test_case.assertEqual(optimized_op_type_names.count("constant"), 1)
+        # y0 and y1 are merged, so are the sigmoid ops reading them
+        for op_type_name in ["tanh", "sigmoid"]:
+            test_case.assertEqual(plain_op_type_names.count(op_type_name), 2)
+            test_case.assertEqual(optimized_op_type_names.count(op_type_name), 1)
+
+    def test_keep_non_constant_like_producer(test_case):
+        flow.clear_default_session()
+        func_config = flow.FunctionConfig()
+        func_config.enable_constant_folding(True)
+        job = _make_reshape_like_job("ConstantFoldingReshapeLikeJob", func_config)
+
+        x = np.random.uniform(-1, 1, SHAPE).astype(np.float32)
+        test_case.assertTrue(np.allclose(job(x), x * 2.0, rtol=1e-5, atol=1e-5))
+
+        op_type_names = UserOpTypeNames(GetCompiledJob("ConstantFoldingReshapeLikeJob"))
+        test_case.assertNotIn("reshape_like", op_type_names)
+        test_case.assertIn("square", op_type_names)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,86 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+from job_rewrite_test_util import GetCompiledJob, MakeGlobalFunction
+
+
+def _cast_op_names(job):
+    return [
+        op.name
+        for op in job.net.op
+        if op.HasField("user_conf") and op.user_conf.op_type_name == "cast"
+    ]
+
+
+def compare_with_float(test_case, op_name, a_shape, b_shape):
+    def make_job(name, enable_cpu_amp):
+        func_config = flow.FunctionConfig()
+        func_config.default_data_type(flow.float)
+        func_config.enable_cpu_auto_mixed_precision(enable_cpu_amp)
+
+        def Job(
+            a: oft.Numpy.Placeholder(a_shape), b: oft.Numpy.Placeholder(b_shape)
+        ) -> oft.Numpy:
+            with flow.scope.placement("cpu", "0:0"):
+                if op_name == "conv2d":
+                    out = flow.nn.conv2d(a, b, strides=1, padding="VALID")
+                    return flow.nn.relu(out)
+                out = flow.matmul(a, b)
+                if op_name == "matmul_elementwise":
+                    return flow.math.gelu(flow.math.sigmoid(out * 2.0 + 1.0))
+                return flow.nn.relu(out)
+
+        return MakeGlobalFunction(name, Job, func_config)
+
+    flow.clear_default_session()
+    plain_job = make_job("PlainJob", False)
+    cpu_amp_job = make_job("CpuAmpJob", True)
+    a = np.random.uniform(-1, 1, size=a_shape).astype(np.float32)
+    b = np.random.uniform(-1, 1, size=b_shape).astype(np.float32)
+    expected = plain_job(a, b)
+    out = cpu_amp_job(a, b)
+    test_case.assertTrue(out.dtype == np.float32)
+    # bfloat16 keeps 8 significant bits
+    test_case.assertTrue(np.allclose(out, expected, rtol=1e-2, atol=1e-2))
+
+    test_case.assertEqual(_cast_op_names(GetCompiledJob("PlainJob")), [])
+    cast_op_names = _cast_op_names(GetCompiledJob("CpuAmpJob"))
+    # only the two inputs and the final output are cast, the chain runs in bfloat16
+    f2bf_names = [name for name in cast_op_names if name.endswith("-cast_f2bf")]
+    bf2f_names = [name for name in cast_op_names if name.endswith("-cast_bf2f")]
+    test_case.assertEqual(len(f2bf_names), 2)
+    test_case.assertEqual(len(bf2f_names), 1)
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestCpuAutoMixedPrecision(flow.unittest.TestCase):
+    def test_matmul(test_case):
+        for m, k, n in [(16, 64, 24), (33, 97, 5)]:
+            compare_with_float(test_case, "matmul", (m, k), (k, n))
+
+    def test_matmul_elementwise(test_case):
+        compare_with_float(test_case, "matmul_elementwise", (16, 64), (64, 24))
+
+    def test_conv2d(test_case):
+        compare_with_float(test_case, "conv2d", (2, 8, 12, 12), (16, 8, 3, 3))
+
+
+if __name__ == "__main__":
+    unittest.main()
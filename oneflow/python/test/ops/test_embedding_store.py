@@ -0,0 +1,95 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import tempfile
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.typing as tp
+
+NUM_ROWS = 1000
+EMBEDDING_DIM = 8
+BATCH_SIZE = 256
+
+
+def _make_train_job(path, optimizer, learning_rate):
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+
+    @flow.global_function(type="train", function_config=func_config)
+    def EmbeddingStoreJob(
+        ids: tp.Numpy.Placeholder((BATCH_SIZE,), dtype=flow.int64)
+    ) -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            # fewer cached rows than ids so that rows are evicted and reloaded
+            embeddings = flow.experimental.embedding_lookup(
+                ids,
+                path,
+                num_rows=NUM_ROWS,
+                embedding_dim=EMBEDDING_DIM,
+                cache_capacity=64,
+                optimizer=optimizer,
+                learning_rate=learning_rate,
+            )
+            loss = flow.math.reduce_sum(embeddings)
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [0.1]), momentum=0
+            ).minimize(loss)
+            return embeddings
+
+    return EmbeddingStoreJob
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestEmbeddingStore(flow.unittest.TestCase):
+    def test_sgd(test_case):
+        flow.clear_default_session()
+        learning_rate = 0.5
+        with tempfile.TemporaryDirectory() as tmp_dir:
+            job = _make_train_job(os.path.join(tmp_dir, "table"), "sgd", learning_rate)
+            ids = np.random.randint(0, NUM_ROWS, size=(BATCH_SIZE,)).astype(np.int64)
+            before = job(ids)
+            test_case.assertTrue(np.all(np.abs(before) <= 0.05))
+            flow.sync_default_session()
+            after = job(ids)
+            flow.sync_default_session()
+            # the gradient of every looked up element is 1
+            counts = np.bincount(ids, minlength=NUM_ROWS)[ids].reshape(-1, 1)
+            test_case.assertTrue(
+                np.allclose(after, before - learning_rate * counts, atol=1e-5)
+            )
+            flow.clear_default_session()
+
+    def test_adam(test_case):
+        flow.clear_default_session()
+        learning_rate = 0.01
+        with tempfile.TemporaryDirectory() as tmp_dir:
+            job = _make_train_job(os.path.join(tmp_dir, "table"), "adam", learning_rate)
+            ids = np.arange(BATCH_SIZE, dtype=np.int64)
+            before = job(ids)
+            flow.sync_default_session()
+            after = job(ids)
+            flow.sync_default_session()
+            # the first step of adam without bias correction with a gradient of 1
+            step = learning_rate * 0.1 / (np.sqrt(0.001) + 1e-8)
+            test_case.assertTrue(np.allclose(after, before - step, atol=1e-5))
+            flow.clear_default_session()
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,99 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.typing as tp
+from job_rewrite_test_util import GetCompiledJob, MakeGlobalFunction, UserOpTypeNames
+
+SHAPE = (4, 16, 8, 8)
+
+
+def _build_elementwise_chain(x, y):
+    bias = flow.get_variable(
+        "bias",
+        shape=(SHAPE[1],),
+        dtype=flow.float32,
+        initializer=flow.random_uniform_initializer(minval=-1, maxval=1),
+    )
+    z = flow.math.add_n([x * 2.0, y])
+    z = flow.math.relu(z)
+    z = flow.nn.bias_add(z, bias)
+    z = flow.math.gelu(z)
+    z = flow.math.tanh(z + 1.0)
+    return flow.math.sigmoid(z) * y
+
+
+def _make_job(name, func_config):
+    def Job(
+        x: tp.Numpy.Placeholder(SHAPE), y: tp.Numpy.Placeholder(SHAPE)
+    ) -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            return _build_elementwise_chain(x, y)
+
+    return MakeGlobalFunction(name, Job, func_config)
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestFuseElementwiseOps(flow.unittest.TestCase):
+    def test_fuse_elementwise_ops(test_case):
+        flow.clear_default_session()
+        fused_config = flow.FunctionConfig()
+        fused_config.enable_fuse_elementwise_ops(True)
+        fused_job = _make_job("FusedElementwiseJob", fused_config)
+        plain_job = _make_job("PlainElementwiseJob", flow.FunctionConfig())
+
+        x = np.random.uniform(-1, 1, SHAPE).astype(np.float32)
+        y = np.random.uniform(-1, 1, SHAPE).astype(np.float32)
+        test_case.assertTrue(
+            np.allclose(fused_job(x, y), plain_job(x, y), rtol=1e-5, atol=1e-5)
+        )
+
+        fused_op_type_names = UserOpTypeNames(GetCompiledJob("FusedElementwiseJob"))
+        plain_op_type_names = UserOpTypeNames(GetCompiledJob("PlainElementwiseJob"))
+        test_case.assertIn("fused_elementwise", fused_op_type_names)
+        test_case.assertNotIn("fused_elementwise", plain_op_type_names)
+        for op_type_name in ["relu", "gelu", "tanh", "sigmoid"]:
+            test_case.assertIn(op_type_name, plain_op_type_names)
+            test_case.assertNotIn(op_type_name, fused_op_type_names)
+
+    def test_double_scalar_not_exact_in_float(test_case):
+        flow.clear_default_session()
+        func_config = flow.FunctionConfig()
+        func_config.default_data_type(flow.double)
+        func_config.enable_fuse_elementwise_ops(True)
+
+        def Job(
+            x: tp.Numpy.Placeholder(SHAPE, dtype=flow.double),
+            y: tp.Numpy.Placeholder(SHAPE, dtype=flow.double),
+        ) -> tp.Numpy:
+            with flow.scope.placement("cpu", "0:0"):
+                return flow.math.tanh(flow.math.relu(x * 0.1) + y)
+
+        job = MakeGlobalFunction("DoubleScalarJob", Job, func_config)
+        x = np.random.uniform(-1, 1, SHAPE)
+        y = np.random.uniform(-1, 1, SHAPE)
+        expected = np.tanh(np.maximum(x * 0.1, 0) + y)
+        test_case.assertTrue(np.allclose(job(x, y), expected, rtol=1e-12, atol=1e-12))
+        # 0.1 would lose precision in the float scalars of fused_elementwise
+        op_type_names = UserOpTypeNames(GetCompiledJob("DoubleScalarJob"))
+        test_case.assertIn("scalar_mul", op_type_names)
+
+
+if __name__ == "__main__":
+    unittest.main()
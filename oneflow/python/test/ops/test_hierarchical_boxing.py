@@ -0,0 +1,92 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import unittest
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+
+
+def _test_hierarchical_boxing(test_case, device_type):
+    flow.clear_default_session()
+    flow.config.machine_num(2)
+    if device_type == "gpu":
+        flow.config.gpu_device_num(2)
+    else:
+        flow.config.cpu_device_num(2)
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_logical_view(flow.scope.consistent_view())
+    # both ends of every boxing are on the same placement spanning two machines with two
+    # devices each, which is the case the hierarchical boxing builder handles
+    machine_device_ids = ["0:0-1", "1:0-1"]
+
+    def split_to_broadcast(x):
+        with flow.scope.placement(device_type, machine_device_ids):
+            src = flow.identity(x.with_distribute(flow.distribute.split(0)))
+            return flow.identity(src.with_distribute(flow.distribute.broadcast()))
+
+    def partial_sum(x):
+        with flow.scope.placement(device_type, machine_device_ids):
+            src = flow.identity(x.with_distribute(flow.distribute.split(0)))
+            return flow.math.reduce_sum(src, axis=0)
+
+    def partial_sum_to_split(x, axis):
+        with flow.scope.placement(device_type, machine_device_ids):
+            return flow.identity(
+                partial_sum(x).with_distribute(flow.distribute.split(axis))
+            )
+
+    def partial_sum_to_broadcast(x):
+        with flow.scope.placement(device_type, machine_device_ids):
+            return flow.identity(
+                partial_sum(x).with_distribute(flow.distribute.broadcast())
+            )
+
+    @flow.global_function(function_config=func_config)
+    def HierarchicalBoxingJob(
+        x: oft.Numpy.Placeholder((96, 96)), y: oft.Numpy.Placeholder((8, 96, 96))
+    ):
+        return (
+            split_to_broadcast(x),
+            partial_sum_to_split(y, 0),
+            partial_sum_to_split(y, 1),
+            partial_sum_to_broadcast(y),
+        )
+
+    x = np.random.rand(96, 96).astype(np.float32)
+    y = np.random.uniform(-1, 1, (8, 96, 96)).astype(np.float32)
+    s2b, p2s_0, p2s_1, p2b = HierarchicalBoxingJob(x, y).get()
+    test_case.assertTrue(np.array_equal(s2b.numpy(), x))
+    y_sum = np.sum(y, axis=0)
+    test_case.assertTrue(np.allclose(p2s_0.numpy(), y_sum, atol=1e-5))
+    test_case.assertTrue(np.allclose(p2s_1.numpy(), y_sum, atol=1e-5))
+    test_case.assertTrue(np.allclose(p2b.numpy(), y_sum, atol=1e-5))
+
+
+@flow.unittest.skip_unless_2n2d()
+class TestHierarchicalBoxing(flow.unittest.TestCase):
+    @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
+    def test_hierarchical_boxing_gpu(test_case):
+        _test_hierarchical_boxing(test_case, "gpu")
+
+    def test_hierarchical_boxing_cpu(test_case):
+        _test_hierarchical_boxing(test_case, "cpu")
+
+
+if __name__ == "__main__":
+    unittest.main()
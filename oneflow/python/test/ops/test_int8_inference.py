@@ -0,0 +1,79 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.typing as tp
+
+INPUT_SHAPE = (4, 3, 16, 16)
+
+
+def _build_model(x):
+    initializer = flow.random_uniform_initializer(minval=-0.5, maxval=0.5)
+    y = flow.layers.conv2d(
+        x,
+        8,
+        3,
+        padding="SAME",
+        activation=flow.nn.relu,
+        kernel_initializer=initializer,
+        name="conv1",
+    )
+    y = flow.layers.conv2d(
+        y, 8, 3, strides=2, padding="VALID", kernel_initializer=initializer, name="conv2"
+    )
+    y = flow.reshape(y, (y.shape[0], -1))
+    y = flow.layers.dense(
+        y, 16, activation=flow.nn.relu, kernel_initializer=initializer, name="fc1"
+    )
+    return flow.layers.dense(y, 10, kernel_initializer=initializer, name="fc2")
+
+
+def _make_job(name, func_config):
+    def Job(x: tp.Numpy.Placeholder(INPUT_SHAPE)) -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            return _build_model(x)
+
+    Job.__name__ = name
+    return flow.global_function(type="predict", function_config=func_config)(Job)
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestInt8Inference(flow.unittest.TestCase):
+    def test_int8_inference(test_case):
+        flow.clear_default_session()
+        calibration_config = flow.FunctionConfig()
+        calibration_config.enable_int8_calibration(True)
+        int8_config = flow.FunctionConfig()
+        int8_config.enable_int8_inference(True)
+        calibration_job = _make_job("Int8CalibrationJob", calibration_config)
+        int8_job = _make_job("Int8InferenceJob", int8_config)
+        fp32_job = _make_job("Fp32InferenceJob", flow.FunctionConfig())
+
+        for _ in range(4):
+            calibration_job(np.random.uniform(-1, 1, INPUT_SHAPE).astype(np.float32))
+
+        x = np.random.uniform(-1, 1, INPUT_SHAPE).astype(np.float32)
+        fp32_out = fp32_job(x)
+        int8_out = int8_job(x)
+        relative_error = np.abs(int8_out - fp32_out).mean() / np.abs(fp32_out).mean()
+        test_case.assertLess(relative_error, 0.05)
+
+
+if __name__ == "__main__":
+    unittest.main()
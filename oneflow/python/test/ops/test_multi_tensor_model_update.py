@@ -0,0 +1,133 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import time
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.typing as tp
+from job_rewrite_test_util import GetCompiledJob, MakeGlobalFunction, UserOpTypeNames
+
+
+def _bert_param_shapes(num_layers, hidden, intermediate, vocab_size, max_position=512):
+    shapes = [(vocab_size, hidden), (max_position, hidden), (2, hidden)]
+    shapes += [(hidden,), (hidden,)]
+    for _ in range(num_layers):
+        # query, key, value and attention output projections
+        shapes += [(hidden, hidden), (hidden,)] * 4
+        shapes += [(hidden,), (hidden,)]
+        shapes += [(hidden, intermediate), (intermediate,)]
+        shapes += [(intermediate, hidden), (hidden,)]
+        shapes += [(hidden,), (hidden,)]
+    shapes += [(hidden, hidden), (hidden,)]
+    return shapes
+
+
+def _make_train_job(name, shapes, optimizer, multi_tensor):
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float32)
+    func_config.enable_multi_tensor_model_update(multi_tensor)
+
+    def Job() -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            losses = []
+            for i, shape in enumerate(shapes):
+                var = flow.get_variable(
+                    name="{}_var_{}".format(name, i),
+                    shape=shape,
+                    dtype=flow.float32,
+                    initializer=flow.random_normal_initializer(stddev=0.02, seed=i),
+                    trainable=True,
+                )
+                losses.append(flow.math.reduce_sum(flow.math.square(var)))
+            loss = flow.math.add_n(losses)
+            lr_scheduler = flow.optimizer.PiecewiseConstantScheduler([], [0.01])
+            if optimizer == "sgd":
+                flow.optimizer.SGD(lr_scheduler, momentum=0).minimize(loss)
+            else:
+                flow.optimizer.Adam(lr_scheduler).minimize(loss)
+            return loss
+
+    return MakeGlobalFunction(name, Job, func_config, function_type="train")
+
+
+def _run(job, iters):
+    losses = [job() for _ in range(iters)]
+    return np.array(losses).flatten()
+
+
+def _timeit(job, iters):
+    job()
+    start = time.time()
+    for _ in range(iters):
+        job()
+    return (time.time() - start) / iters
+
+
+def _compare_with_per_variable_update(test_case, optimizer):
+    flow.clear_default_session()
+    shapes = _bert_param_shapes(2, 64, 256, 1000)
+    job = _make_train_job("{}_job".format(optimizer), shapes, optimizer, False)
+    multi_tensor_job = _make_train_job(
+        "multi_tensor_{}_job".format(optimizer), shapes, optimizer, True
+    )
+    losses = _run(job, 5)
+    multi_tensor_losses = _run(multi_tensor_job, 5)
+    test_case.assertTrue(np.allclose(losses, multi_tensor_losses, rtol=1e-4, atol=1e-4))
+    update_op_type_name = "{}_update".format(optimizer)
+    multi_tensor_update_op_type_name = "multi_tensor_{}_update".format(optimizer)
+    op_type_names = UserOpTypeNames(GetCompiledJob("{}_job".format(optimizer)))
+    test_case.assertEqual(op_type_names.count(update_op_type_name), len(shapes))
+    test_case.assertNotIn(multi_tensor_update_op_type_name, op_type_names)
+    multi_tensor_op_type_names = UserOpTypeNames(
+        GetCompiledJob("multi_tensor_{}_job".format(optimizer))
+    )
+    test_case.assertIn(multi_tensor_update_op_type_name, multi_tensor_op_type_names)
+    test_case.assertNotIn(update_op_type_name, multi_tensor_op_type_names)
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestMultiTensorModelUpdate(flow.unittest.TestCase):
+    def test_multi_tensor_sgd_update(test_case):
+        _compare_with_per_variable_update(test_case, "sgd")
+
+    def test_multi_tensor_adam_update(test_case):
+        _compare_with_per_variable_update(test_case, "adam")
+
+    @unittest.skipIf(
+        os.getenv("ONEFLOW_TEST_BERT_BASE_OPTIMIZER_BENCHMARK") is None,
+        "needs several gigabytes of host memory",
+    )
+    def test_bert_base_adam_throughput(test_case):
+        flow.clear_default_session()
+        shapes = _bert_param_shapes(12, 768, 3072, 30522)
+        num_params = sum(int(np.prod(shape)) for shape in shapes)
+        job = _make_train_job("bert_base_adam_job", shapes, "adam", False)
+        multi_tensor_job = _make_train_job(
+            "bert_base_multi_tensor_adam_job", shapes, "adam", True
+        )
+        step_time = _timeit(job, 5)
+        multi_tensor_step_time = _timeit(multi_tensor_job, 5)
+        print("bert-base: {} variables, {} params".format(len(shapes), num_params))
+        print("per-variable adam: {:.1f} ms/step".format(step_time * 1e3))
+        print("multi-tensor adam: {:.1f} ms/step".format(multi_tensor_step_time * 1e3))
+        test_case.assertLess(multi_tensor_step_time, step_time)
+
+
+if __name__ == "__main__":
+    unittest.main()
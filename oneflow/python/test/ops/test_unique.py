@@ -23,7 +23,7 @@ func_config = flow.FunctionConfig()
 func_config.default_data_type(flow.float)
 
 
-def _check_unique(test_case, x, y, idx, count, num_unique):
+def _check_unique(test_case, x, y, idx, count, num_unique, device):
     ref_y, ref_count = np.unique(x, return_counts=True)
     sorted_idx = np.argsort(ref_y)
     ref_y = ref_y[sorted_idx]
@@ -36,6 +36,10 @@ def _check_unique(test_case, x, y, idx, count, num_unique):
     test_case.assertTrue(np.array_equal(ref_y, y[sorted_idx]))
     count = count[0:num_unique]
     test_case.assertTrue(np.array_equal(count[sorted_idx], ref_count))
+    if device == "cpu":
+        # the cpu kernel keeps unique values in the order of their first appearance
+        _, first_idx = np.unique(x, return_index=True)
+        test_case.assertTrue(np.array_equal(y, x[np.sort(first_idx)]))
 
 
 def _run_test(test_case, x, dtype, device):
@@ -46,7 +50,13 @@ def _run_test(test_case, x, dtype, device):
 
     y, idx, count, num_unique = UniqueWithCountsJob(x).get()
     _check_unique(
-        test_case, x, y.numpy(), idx.numpy(), count.numpy(), num_unique.numpy()
+        test_case,
+        x,
+        y.numpy(),
+        idx.numpy(),
+        count.numpy(),
+        num_unique.numpy(),
+        device,
     )
 
 
@@ -75,6 +85,11 @@ class TestUnique(flow.unittest.TestCase):
         np.random.shuffle(x)
         _run_test(test_case, x, flow.int32, "cpu")
 
+    def test_unique_with_counts_large_cpu(test_case):
+        # large enough to be partitioned across threads
+        x = np.random.randint(0, 1 << 20, 1 << 18).astype(np.int64)
+        _run_test(test_case, x, flow.int64, "cpu")
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -43,6 +43,35 @@ struct CopyTensor<DeviceType::kGPU, T, U> {
   }
 };
 
+template<>
+struct CopyTensor<DeviceType::kCPU, float, bfloat16> {
+  static void Call(DeviceCtx* ctx, const Tensor* src, Tensor* dst) {
+    FloatToBFloat16(src->dptr<float>(), dst->mut_dptr<bfloat16>(), src->shape().elem_cnt());
+  }
+};
+
+template<>
+struct CopyTensor<DeviceType::kCPU, bfloat16, float> {
+  static void Call(DeviceCtx* ctx, const Tensor* src, Tensor* dst) {
+    BFloat16ToFloat(src->dptr<bfloat16>(), dst->mut_dptr<float>(), src->shape().elem_cnt());
+  }
+};
+
+using CaseHandlerMap = std::map<std::pair<DataType, DataType>,
+                                std::function<void(DeviceCtx*, const Tensor*, Tensor*)>>;
+
+template<DeviceType device_type>
+void AddDeviceCaseHandlers(CaseHandlerMap* case_handler) {}
+
+// bfloat16 is a cpu only data type
+template<>
+void AddDeviceCaseHandlers<DeviceType::kCPU>(CaseHandlerMap* case_handler) {
+  case_handler->emplace(std::make_pair(DataType::kFloat, DataType::kBFloat16),
+                        CopyTensor<DeviceType::kCPU, float, bfloat16>::Call);
+  case_handler->emplace(std::make_pair(DataType::kBFloat16, DataType::kFloat),
+                        CopyTensor<DeviceType::kCPU, bfloat16, float>::Call);
+}
+
 }  // namespace
 
 #define MAKE_CASE_HANDLER_ENTRY(in_type_pair, out_type_pair)                          \
@@ -54,15 +83,17 @@ template<DeviceType device_type>
 struct CastUtil final {
   static void SwitchCopyTensor(const std::pair<DataType, DataType>& key, DeviceCtx* ctx,
                                const Tensor* src, Tensor* dst) {
-    static const std::map<std::pair<DataType, DataType>,
-                          std::function<void(DeviceCtx*, const Tensor*, Tensor*)>>
-        case_handler{
-            // clang-format off
-          OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(MAKE_CASE_HANDLER_ENTRY, POD_DATA_TYPE_SEQ, POD_DATA_TYPE_SEQ)
-          MAKE_CASE_HANDLER_ENTRY((float, DataType::kFloat), (float16, DataType::kFloat16))
-          MAKE_CASE_HANDLER_ENTRY((float16, DataType::kFloat16), (float, DataType::kFloat))
-            // clang-format on
-        };
+    static const CaseHandlerMap case_handler = []() {
+      CaseHandlerMap case_handler{
+          // clang-format off
+        OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(MAKE_CASE_HANDLER_ENTRY, POD_DATA_TYPE_SEQ, POD_DATA_TYPE_SEQ)
+        MAKE_CASE_HANDLER_ENTRY((float, DataType::kFloat), (float16, DataType::kFloat16))
+        MAKE_CASE_HANDLER_ENTRY((float16, DataType::kFloat16), (float, DataType::kFloat))
+          // clang-format on
+      };
+      AddDeviceCaseHandlers<device_type>(&case_handler);
+      return case_handler;
+    }();
     case_handler.at(key)(ctx, src, dst);
   }
 };
@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/user/kernels/categorical_ordinal_encode_kernel_util.h"
+#include "oneflow/user/kernels/op_kernel_state_wrapper.h"
 
 namespace oneflow {
 
@@ -24,8 +25,16 @@ class CategoricalOrdinalEncodeKernel final : public user_op::OpKernel {
   CategoricalOrdinalEncodeKernel() = default;
   ~CategoricalOrdinalEncodeKernel() override = default;
 
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    if (!ctx->Attr<bool>("allow_overflow")) { return nullptr; }
+    CHECK_EQ(ctx->device_type(), DeviceType::kCPU)
+        << "allow_overflow is not supported by the gpu kernel";
+    return std::make_shared<OpKernelStateWrapper<CategoricalOrdinalEncodeOverflow<T>>>();
+  }
+
  private:
-  void Compute(user_op::KernelComputeContext* ctx) const override {
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
     bool hash_precomputed = ctx->Attr<bool>("hash_precomputed");
     CHECK(hash_precomputed);
     const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
@@ -35,9 +44,14 @@ class CategoricalOrdinalEncodeKernel final : public user_op::OpKernel {
     const int64_t table_elem_cnt = table->shape().elem_cnt();
     CHECK_EQ(table_elem_cnt % 2, 0);
     const int64_t capacity = table_elem_cnt / 2;
+    CategoricalOrdinalEncodeOverflow<T>* overflow = nullptr;
+    if (state != nullptr) {
+      using OverflowState = OpKernelStateWrapper<CategoricalOrdinalEncodeOverflow<T>>;
+      overflow = dynamic_cast<OverflowState*>(state)->Mutable();
+    }
     CategoricalOrdinalEncodeKernelUtil<device_type, T>::Encode(
         ctx->device_ctx(), capacity, table->mut_dptr<T>(), size->mut_dptr<T>(),
-        in->shape().elem_cnt(), in->dptr<T>(), out->mut_dptr<T>());
+        in->shape().elem_cnt(), in->dptr<T>(), out->mut_dptr<T>(), overflow);
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
 };
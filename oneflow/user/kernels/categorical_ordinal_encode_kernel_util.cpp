@@ -14,38 +14,146 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/user/kernels/categorical_ordinal_encode_kernel_util.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
+namespace {
+
+constexpr int64_t kEncodeMinKeysPerThread = 1 << 14;
+// lookups of the following keys are issued ahead to hide cache misses on large tables
+constexpr int64_t kEncodePrefetchDistance = 16;
+
+// The table is a flat array of (key, value) pairs probed linearly from hash % capacity, the key 0
+// marks an empty slot. The layout is shared with the gpu kernel and saved as a variable, so only
+// the way of probing is specialized for power of two capacities.
+template<typename T>
+class EncodeTable final {
+ public:
+  EncodeTable(int64_t capacity, T* table, T* size, CategoricalOrdinalEncodeOverflow<T>* overflow)
+      : capacity_(capacity),
+        mask_((capacity & (capacity - 1)) == 0 ? capacity - 1 : 0),
+        table_(table),
+        size_(size),
+        overflow_(overflow) {}
+
+  void Prefetch(T hash) const { __builtin_prefetch(table_ + HomeSlot(hash) * 2); }
+
+  // Returns false if hash has not been inserted.
+  bool Find(T hash, T* out) const {
+    int64_t slot = -1;
+    return Lookup(hash, out, &slot);
+  }
+
+  void FindOrInsert(T hash, T* out) {
+    int64_t slot = -1;
+    if (Lookup(hash, out, &slot)) { return; }
+    const T value = *size_ + 1;
+    if (slot >= 0) {
+      T* key = table_ + slot * 2;
+      *key = hash;
+      *(key + 1) = value;
+    } else {
+      CHECK(overflow_ != nullptr) << "the table of CategoricalOrdinalEncode is full, its capacity "
+                                  << capacity_ << " is too small";
+      if (overflow_->key2value.empty()) {
+        LOG(WARNING) << "the table of CategoricalOrdinalEncode with capacity " << capacity_
+                     << " is full, new keys will not be saved with it";
+      }
+      overflow_->key2value.emplace(hash, value);
+    }
+    *size_ = value;
+    *out = value;
+  }
+
+ private:
+  // On a miss, *slot is the empty slot where hash would be inserted, or -1 if the table is full.
+  // Once the table is full the overflow map is looked up first, a key found there would otherwise
+  // cost a probe over the whole table.
+  bool Lookup(T hash, T* out, int64_t* slot) const {
+    *slot = -1;
+    if (hash == 0) {
+      *out = 0;
+      return true;
+    }
+    if (overflow_ != nullptr && static_cast<int64_t>(*size_) >= capacity_) {
+      const auto it = overflow_->key2value.find(hash);
+      if (it != overflow_->key2value.end()) {
+        *out = it->second;
+        return true;
+      }
+    }
+    *slot = Probe(hash);
+    if (*slot < 0) { return false; }
+    const T* key = table_ + *slot * 2;
+    if (*key != hash) { return false; }
+    *out = *(key + 1);
+    return true;
+  }
+
+  int64_t HomeSlot(T hash) const {
+    const size_t h = static_cast<size_t>(hash);
+    return mask_ != 0 ? h & mask_ : h % static_cast<size_t>(capacity_);
+  }
+
+  // Returns the slot holding hash or the empty slot where it would be inserted, -1 if the table is
+  // full without hash.
+  int64_t Probe(T hash) const {
+    int64_t slot = HomeSlot(hash);
+    for (int64_t count = 0; count < capacity_; ++count) {
+      const T key = table_[slot * 2];
+      if (key == hash || key == 0) { return slot; }
+      slot += 1;
+      if (slot == capacity_) { slot = 0; }
+    }
+    return -1;
+  }
+
+  const int64_t capacity_;
+  const size_t mask_;
+  T* table_;
+  T* size_;
+  CategoricalOrdinalEncodeOverflow<T>* overflow_;
+};
+
+}  // namespace
+
 template<typename T>
 struct CategoricalOrdinalEncodeKernelUtil<DeviceType::kCPU, T> {
   static void Encode(DeviceCtx* ctx, int64_t capacity, T* table, T* size, int64_t n, const T* hash,
-                     T* out) {
-    for (int64_t i = 0; i < n; ++i) {
-      const T h = hash[i];
-      bool success = false;
-      for (int64_t count = 0; count < capacity; ++count) {
-        size_t idx =
-            (static_cast<size_t>(h) + static_cast<size_t>(count)) % static_cast<size_t>(capacity);
-        T* k_ptr = table + idx * 2;
-        T* v_ptr = k_ptr + 1;
-        if (*k_ptr == h) {
-          out[i] = *v_ptr;
-          success = true;
-          break;
-        } else if (*k_ptr == 0) {
-          T new_size = *size + 1;
-          *k_ptr = h;
-          *v_ptr = new_size;
-          out[i] = new_size;
-          *size = new_size;
-          success = true;
-          break;
-        } else {
-          continue;
+                     T* out, CategoricalOrdinalEncodeOverflow<T>* overflow) {
+    EncodeTable<T> encode_table(capacity, table, size, overflow);
+    const int64_t num_threads =
+        Global<ThreadPool>::Get() == nullptr
+            ? 1
+            : std::min<int64_t>(Global<ThreadPool>::Get()->thread_num(),
+                                n / kEncodeMinKeysPerThread);
+    if (num_threads <= 1) {
+      FOR_RANGE(int64_t, i, 0, n) {
+        if (i + kEncodePrefetchDistance < n) {
+          encode_table.Prefetch(hash[i + kEncodePrefetchDistance]);
+        }
+        encode_table.FindOrInsert(hash[i], out + i);
+      }
+      return;
+    }
+    // Keys already in the table are looked up by all threads, then the missing ones are inserted
+    // in the order of input, so a key is numbered the same as the sequential way.
+    const BalancedSplitter bs(n, num_threads);
+    std::vector<std::vector<int64_t>> thread_missing_indices(num_threads);
+    MultiThreadLoop(num_threads, [&](size_t thread_id) {
+      const Range range = bs.At(thread_id);
+      std::vector<int64_t>* missing_indices = &thread_missing_indices.at(thread_id);
+      FOR_RANGE(int64_t, i, range.begin(), range.end()) {
+        if (i + kEncodePrefetchDistance < range.end()) {
+          encode_table.Prefetch(hash[i + kEncodePrefetchDistance]);
         }
+        if (!encode_table.Find(hash[i], out + i)) { missing_indices->push_back(i); }
       }
-      CHECK(success);
+    });
+    for (const std::vector<int64_t>& missing_indices : thread_missing_indices) {
+      for (int64_t i : missing_indices) { encode_table.FindOrInsert(hash[i], out + i); }
     }
   }
 };
@@ -108,7 +108,8 @@ __global__ void EncodeGpu(const size_t capacity, T* table, T* size, const int64_
 template<typename T>
 struct CategoricalOrdinalEncodeKernelUtil<DeviceType::kGPU, T> {
   static void Encode(DeviceCtx* ctx, int64_t capacity, T* table, T* size, int64_t n, const T* hash,
-                     T* out) {
+                     T* out, CategoricalOrdinalEncodeOverflow<T>* overflow) {
+    CHECK(overflow == nullptr) << "allow_overflow is not supported by the gpu kernel";
     EncodeGpu<T><<<BlocksNum4ThreadsNum(n), kCudaThreadsNumPerBlock, 0, ctx->cuda_stream()>>>(
         capacity, table, size, n, hash, out);
   }
@@ -20,10 +20,17 @@ limitations under the License.
 
 namespace oneflow {
 
+// Keys arriving after the table is full, they are numbered after the keys of the table but are not
+// saved with it. Only the cpu kernel supports it.
+template<typename T>
+struct CategoricalOrdinalEncodeOverflow {
+  HashMap<T, T> key2value;
+};
+
 template<DeviceType device_type, typename T>
 struct CategoricalOrdinalEncodeKernelUtil {
   static void Encode(DeviceCtx* ctx, int64_t capacity, T* table, T* size, int64_t n, const T* hash,
-                     T* out);
+                     T* out, CategoricalOrdinalEncodeOverflow<T>* overflow);
 };
 
 }  // namespace oneflow
@@ -485,6 +485,20 @@ REGISTER_CONV_KERNEL(conv3d, float, 3);
 REGISTER_CONV_KERNEL(conv1d, double, 1);
 REGISTER_CONV_KERNEL(conv2d, double, 2);
 REGISTER_CONV_KERNEL(conv3d, double, 3);
+REGISTER_CONV_KERNEL(conv1d, bfloat16, 1);
+REGISTER_CONV_KERNEL(conv2d, bfloat16, 2);
+REGISTER_CONV_KERNEL(conv3d, bfloat16, 3);
+
+template<typename T>
+void AddToOutput(DeviceCtx* ctx, int64_t n, T* out, const T* in) {
+  KernelUtil<DeviceType::kCPU, T>::Addition(ctx, n, out, out, in);
+}
+
+// KernelUtil<DeviceType::kCPU, T> is only defined for float, double and the integral types
+template<>
+void AddToOutput<bfloat16>(DeviceCtx* ctx, int64_t n, bfloat16* out, const bfloat16* in) {
+  FOR_RANGE(int64_t, i, 0, n) { out[i] = static_cast<float>(out[i]) + static_cast<float>(in[i]); }
+}
 
 template<typename T>
 class ConvDataGradCpuKernel final : public user_op::OpKernel {
@@ -535,9 +549,8 @@ class ConvDataGradCpuKernel final : public user_op::OpKernel {
       const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
       CHECK_EQ(add_to_output->data_type(), dx->data_type());
       CHECK_EQ(add_to_output->shape(), dx->shape());
-      KernelUtil<DeviceType::kCPU, T>::Addition(
-          ctx->device_ctx(), add_to_output->shape().elem_cnt(), dx->mut_dptr<T>(), dx->dptr<T>(),
-          add_to_output->dptr<T>());
+      AddToOutput<T>(ctx->device_ctx(), add_to_output->shape().elem_cnt(), dx->mut_dptr<T>(),
+                     add_to_output->dptr<T>());
     }
   }
 };
@@ -561,6 +574,7 @@ class ConvDataGradCpuKernel final : public user_op::OpKernel {
 
 REGISTER_CONV_DATA_GRAD_KERNEL(conv_data_grad, float);
 REGISTER_CONV_DATA_GRAD_KERNEL(conv_data_grad, double);
+REGISTER_CONV_DATA_GRAD_KERNEL(conv_data_grad, bfloat16);
 
 template<typename T>
 class ConvFilterGradCpuKernel final : public user_op::OpKernel {
@@ -630,6 +644,7 @@ class ConvFilterGradCpuKernel final : public user_op::OpKernel {
 
 REGISTER_CONV_FILTER_GRAD_KERNEL(conv_filter_grad, float);
 REGISTER_CONV_FILTER_GRAD_KERNEL(conv_filter_grad, double);
+REGISTER_CONV_FILTER_GRAD_KERNEL(conv_filter_grad, bfloat16);
 
 template<typename T>
 class ConvBiasGradCpuKernel final : public user_op::OpKernel {
@@ -694,6 +709,7 @@ class ConvBiasGradCpuKernel final : public user_op::OpKernel {
 
 REGISTER_CONV_BIAS_GRAD_KERNEL(conv_bias_grad, float);
 REGISTER_CONV_BIAS_GRAD_KERNEL(conv_bias_grad, double);
+REGISTER_CONV_BIAS_GRAD_KERNEL(conv_bias_grad, bfloat16);
 }  // namespace
 
 }  // namespace oneflow
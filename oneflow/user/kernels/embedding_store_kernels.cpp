@@ -0,0 +1,143 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/embedding/embedding_store.h"
+#include "oneflow/user/kernels/op_kernel_state_wrapper.h"
+
+namespace oneflow {
+
+namespace {
+
+using EmbeddingStoreState = OpKernelStateWrapper<std::shared_ptr<EmbeddingStore>>;
+
+std::shared_ptr<user_op::OpKernelState> CreateEmbeddingStoreState(
+    user_op::KernelInitContext* ctx) {
+  EmbeddingStoreOptions options;
+  options.path = ctx->Attr<std::string>("path");
+  options.num_rows = ctx->Attr<int64_t>("num_rows");
+  options.embedding_dim = ctx->Attr<int64_t>("embedding_dim");
+  const bool is_adam = ctx->Attr<std::string>("optimizer") == "adam";
+  options.state_dim = is_adam ? 2 * options.embedding_dim : 0;
+  options.cache_capacity = ctx->Attr<int64_t>("cache_capacity");
+  options.initializer_range = ctx->Attr<float>("initializer_range");
+  options.seed = ctx->Attr<int64_t>("seed");
+  return std::make_shared<EmbeddingStoreState>(EmbeddingStoreMgr::Get()->GetOrCreate(options));
+}
+
+EmbeddingStore* GetEmbeddingStore(user_op::OpKernelState* state) {
+  return dynamic_cast<EmbeddingStoreState*>(state)->Get().get();
+}
+
+}  // namespace
+
+class EmbeddingPrefetchKernel final : public user_op::OpKernel {
+ public:
+  EmbeddingPrefetchKernel() = default;
+  ~EmbeddingPrefetchKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return CreateEmbeddingStoreState(ctx);
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const user_op::Tensor* ids = ctx->Tensor4ArgNameAndIndex("ids", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const int64_t n = ids->shape().elem_cnt();
+    std::copy(ids->dptr<int64_t>(), ids->dptr<int64_t>() + n, out->mut_dptr<int64_t>());
+    GetEmbeddingStore(state)->Prefetch(
+        std::vector<int64_t>(ids->dptr<int64_t>(), ids->dptr<int64_t>() + n));
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+class EmbeddingLookupKernel final : public user_op::OpKernel {
+ public:
+  EmbeddingLookupKernel() = default;
+  ~EmbeddingLookupKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return CreateEmbeddingStoreState(ctx);
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const user_op::Tensor* ids = ctx->Tensor4ArgNameAndIndex("ids", 0);
+    user_op::Tensor* embeddings = ctx->Tensor4ArgNameAndIndex("embeddings", 0);
+    GetEmbeddingStore(state)->Lookup(ids->shape().elem_cnt(), ids->dptr<int64_t>(),
+                                     embeddings->mut_dptr<float>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+class EmbeddingUpdateKernel final : public user_op::OpKernel {
+ public:
+  EmbeddingUpdateKernel() = default;
+  ~EmbeddingUpdateKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return CreateEmbeddingStoreState(ctx);
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const user_op::Tensor* ids = ctx->Tensor4ArgNameAndIndex("ids", 0);
+    const user_op::Tensor* embedding_diff = ctx->Tensor4ArgNameAndIndex("embedding_diff", 0);
+    user_op::Tensor* shadow_diff = ctx->Tensor4ArgNameAndIndex("shadow_diff", 0);
+    *shadow_diff->mut_dptr<float>() = 0;
+    const int64_t dim = ctx->Attr<int64_t>("embedding_dim");
+    const float learning_rate = ctx->Attr<float>("learning_rate");
+    std::function<void(float*, const float*)> UpdateLine;
+    if (ctx->Attr<std::string>("optimizer") == "adam") {
+      const float beta1 = ctx->Attr<float>("beta1");
+      const float beta2 = ctx->Attr<float>("beta2");
+      const float epsilon = ctx->Attr<float>("epsilon");
+      UpdateLine = [=](float* line, const float* diff) {
+        float* m = line + dim;
+        float* v = m + dim;
+        FOR_RANGE(int64_t, i, 0, dim) {
+          m[i] = beta1 * m[i] + (1 - beta1) * diff[i];
+          v[i] = beta2 * v[i] + (1 - beta2) * diff[i] * diff[i];
+          line[i] -= learning_rate * m[i] / (std::sqrt(v[i]) + epsilon);
+        }
+      };
+    } else {
+      UpdateLine = [=](float* line, const float* diff) {
+        FOR_RANGE(int64_t, i, 0, dim) { line[i] -= learning_rate * diff[i]; }
+      };
+    }
+    GetEmbeddingStore(state)->Update(ids->shape().elem_cnt(), ids->dptr<int64_t>(),
+                                     embedding_diff->dptr<float>(), UpdateLine);
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+REGISTER_USER_KERNEL("embedding_prefetch")
+    .SetCreateFn<EmbeddingPrefetchKernel>()
+    .SetIsMatchedHob(user_op::HobDeviceTag() == "cpu");
+
+REGISTER_USER_KERNEL("embedding_lookup")
+    .SetCreateFn<EmbeddingLookupKernel>()
+    .SetIsMatchedHob(user_op::HobDeviceTag() == "cpu");
+
+REGISTER_USER_KERNEL("embedding_update")
+    .SetCreateFn<EmbeddingUpdateKernel>()
+    .SetIsMatchedHob(user_op::HobDeviceTag() == "cpu");
+
+}  // namespace oneflow
@@ -0,0 +1,271 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/kernels/math_unary_elementwise_func.h"
+#include "oneflow/user/kernels/math_binary_elementwise_func.h"
+
+namespace oneflow {
+
+namespace {
+
+// Every instruction runs over a tile small enough for all live registers to stay in cache, so
+// only the inputs and the output of the fused chain go through memory.
+constexpr int64_t kTileSize = 512;
+constexpr int64_t kMinTileCntPerThread = 16;
+
+template<typename T>
+using UnaryFn = void (*)(int64_t n, const T* x, T scalar, T* y);
+
+template<typename T>
+using BinaryFn = void (*)(int64_t n, const T* x, const T* y, T scalar, T* z);
+
+template<typename T, template<typename> class Functor>
+void MathUnary(int64_t n, const T* x, T scalar, T* y) {
+  FOR_RANGE(int64_t, i, 0, n) { y[i] = Functor<T>::Forward(x[i]); }
+}
+
+template<typename T, template<typename> class Functor>
+void MathBinary(int64_t n, const T* x, const T* y, T scalar, T* z) {
+  FOR_RANGE(int64_t, i, 0, n) { z[i] = Functor<T>::Forward(x[i], y[i]); }
+}
+
+template<typename T>
+void Relu(int64_t n, const T* x, T scalar, T* y) {
+  FOR_RANGE(int64_t, i, 0, n) { y[i] = x[i] > static_cast<T>(0) ? x[i] : static_cast<T>(0); }
+}
+
+template<typename T>
+void Gelu(int64_t n, const T* x, T scalar, T* y) {
+  const T inv_sqrt2 = std::sqrt(0.5);
+  FOR_RANGE(int64_t, i, 0, n) { y[i] = 0.5 * x[i] * (1.0 + std::erf(inv_sqrt2 * x[i])); }
+}
+
+template<typename T>
+void Sigmoid(int64_t n, const T* x, T scalar, T* y) {
+  FOR_RANGE(int64_t, i, 0, n) { y[i] = static_cast<T>(1) / (static_cast<T>(1) + std::exp(-x[i])); }
+}
+
+template<typename T>
+void ScalarAdd(int64_t n, const T* x, T scalar, T* y) {
+  FOR_RANGE(int64_t, i, 0, n) { y[i] = x[i] + scalar; }
+}
+
+template<typename T>
+void ScalarMul(int64_t n, const T* x, T scalar, T* y) {
+  FOR_RANGE(int64_t, i, 0, n) { y[i] = x[i] * scalar; }
+}
+
+template<typename T>
+void Add(int64_t n, const T* x, const T* y, T scalar, T* z) {
+  FOR_RANGE(int64_t, i, 0, n) { z[i] = x[i] + y[i]; }
+}
+
+template<typename T>
+void Sub(int64_t n, const T* x, const T* y, T scalar, T* z) {
+  FOR_RANGE(int64_t, i, 0, n) { z[i] = x[i] - y[i]; }
+}
+
+template<typename T>
+void Mul(int64_t n, const T* x, const T* y, T scalar, T* z) {
+  FOR_RANGE(int64_t, i, 0, n) { z[i] = x[i] * y[i]; }
+}
+
+template<typename T>
+void Div(int64_t n, const T* x, const T* y, T scalar, T* z) {
+  FOR_RANGE(int64_t, i, 0, n) { z[i] = x[i] / y[i]; }
+}
+
+// y is the dropout mask loaded as T
+template<typename T>
+void Dropout(int64_t n, const T* x, const T* y, T scalar, T* z) {
+  FOR_RANGE(int64_t, i, 0, n) { z[i] = x[i] * y[i] * scalar; }
+}
+
+#define MAKE_MATH_UNARY_ENTRY(op_type_name, func_prefix) \
+  {op_type_name, &MathUnary<T, func_prefix##Functor>},
+
+#define MAKE_MATH_BINARY_ENTRY(op_type_name, func_prefix) \
+  {op_type_name, &MathBinary<T, func_prefix##Functor>},
+
+template<typename T>
+const HashMap<std::string, UnaryFn<T>>& UnaryFn4Instruction() {
+  static const HashMap<std::string, UnaryFn<T>> instruction2fn = {
+      OF_PP_FOR_EACH_TUPLE(MAKE_MATH_UNARY_ENTRY, MATH_UNARY_ELEMENTWISE_FUNC_SEQ)  // math
+      {"relu", &Relu<T>},
+      {"gelu", &Gelu<T>},
+      {"sigmoid", &Sigmoid<T>},
+      {"scalar_add", &ScalarAdd<T>},
+      {"scalar_mul", &ScalarMul<T>}};
+  return instruction2fn;
+}
+
+template<typename T>
+const HashMap<std::string, BinaryFn<T>>& BinaryFn4Instruction() {
+  static const HashMap<std::string, BinaryFn<T>> instruction2fn = {
+      OF_PP_FOR_EACH_TUPLE(MAKE_MATH_BINARY_ENTRY, MATH_BINARY_ELEMENTWISE_FUNC_SEQ)  // math
+      {"add", &Add<T>},
+      {"sub", &Sub<T>},
+      {"mul", &Mul<T>},
+      {"div", &Div<T>},
+      {"dropout", &Dropout<T>}};
+  return instruction2fn;
+}
+
+#undef MAKE_MATH_UNARY_ENTRY
+#undef MAKE_MATH_BINARY_ENTRY
+
+template<typename T>
+struct FusedInstruction {
+  UnaryFn<T> unary;
+  BinaryFn<T> binary;
+  int32_t x;
+  int32_t y;
+  T scalar;
+};
+
+template<typename T>
+class FusedElementwiseProgram final : public user_op::OpKernelState {
+ public:
+  explicit FusedElementwiseProgram(user_op::KernelInitContext* ctx) {
+    const auto& instructions = ctx->Attr<std::vector<std::string>>("instructions");
+    const auto& operands = ctx->Attr<std::vector<int32_t>>("operands");
+    const auto& scalars = ctx->Attr<std::vector<float>>("scalars");
+    FOR_RANGE(size_t, i, 0, instructions.size()) {
+      FusedInstruction<T> instruction{};
+      instruction.x = operands.at(2 * i);
+      instruction.y = operands.at(2 * i + 1);
+      instruction.scalar = static_cast<T>(scalars.at(i));
+      if (instruction.y < 0) {
+        instruction.unary = UnaryFn4Instruction<T>().at(instructions.at(i));
+      } else {
+        instruction.binary = BinaryFn4Instruction<T>().at(instructions.at(i));
+      }
+      instructions_.push_back(instruction);
+    }
+  }
+  ~FusedElementwiseProgram() = default;
+
+  const std::vector<FusedInstruction<T>>& instructions() const { return instructions_; }
+
+ private:
+  std::vector<FusedInstruction<T>> instructions_;
+};
+
+template<typename T, typename U>
+void GatherInput(const U* in, int64_t in_elem_cnt, int64_t inner_size, int64_t offset, int64_t n,
+                 T* reg) {
+  FOR_RANGE(int64_t, i, 0, n) {
+    reg[i] = static_cast<T>(in[((offset + i) / inner_size) % in_elem_cnt]);
+  }
+}
+
+// Same-shape inputs of type T are read in place, broadcast inputs and dropout masks are gathered
+// into the register tile
+template<typename T>
+const T* LoadInput(const user_op::Tensor* in, int64_t inner_size, int64_t out_elem_cnt,
+                   int64_t offset, int64_t n, T* reg) {
+  const int64_t in_elem_cnt = in->shape().elem_cnt();
+  if (in->data_type() == GetDataType<T>::value) {
+    if (inner_size == 1 && in_elem_cnt == out_elem_cnt) { return in->dptr<T>() + offset; }
+    GatherInput<T, T>(in->dptr<T>(), in_elem_cnt, inner_size, offset, n, reg);
+  } else if (in->data_type() == DataType::kInt8) {
+    GatherInput<T, int8_t>(in->dptr<int8_t>(), in_elem_cnt, inner_size, offset, n, reg);
+  } else {
+    UNIMPLEMENTED();
+  }
+  return reg;
+}
+
+template<typename T>
+class CpuFusedElementwiseKernel final : public user_op::OpKernel {
+ public:
+  CpuFusedElementwiseKernel() = default;
+  ~CpuFusedElementwiseKernel() = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return std::make_shared<FusedElementwiseProgram<T>>(ctx);
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const auto* program = dynamic_cast<FusedElementwiseProgram<T>*>(state);
+    CHECK_NOTNULL(program);
+    const std::vector<FusedInstruction<T>>& instructions = program->instructions();
+    const auto& input_inner_sizes = ctx->Attr<std::vector<int64_t>>("input_inner_sizes");
+    const int32_t num_inputs = input_inner_sizes.size();
+    const int32_t num_registers = num_inputs + instructions.size();
+    std::vector<const user_op::Tensor*> ins(num_inputs);
+    FOR_RANGE(int32_t, i, 0, num_inputs) { ins[i] = ctx->Tensor4ArgNameAndIndex("in", i); }
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    T* out_ptr = out->mut_dptr<T>();
+    const int64_t elem_cnt = out->shape().elem_cnt();
+    const int64_t num_tiles = RoundUp(elem_cnt, kTileSize) / kTileSize;
+
+    auto ComputeTiles = [&](int64_t begin, int64_t end) {
+      std::vector<T> tiles(num_registers * kTileSize);
+      std::vector<const T*> registers(num_registers);
+      FOR_RANGE(int64_t, tile, begin, end) {
+        const int64_t offset = tile * kTileSize;
+        const int64_t n = std::min(kTileSize, elem_cnt - offset);
+        FOR_RANGE(int32_t, i, 0, num_inputs) {
+          registers[i] = LoadInput<T>(ins[i], input_inner_sizes[i], elem_cnt, offset, n,
+                                      tiles.data() + i * kTileSize);
+        }
+        FOR_RANGE(size_t, i, 0, instructions.size()) {
+          const FusedInstruction<T>& instruction = instructions[i];
+          T* dst = i + 1 == instructions.size() ? out_ptr + offset
+                                                : tiles.data() + (num_inputs + i) * kTileSize;
+          if (instruction.unary != nullptr) {
+            instruction.unary(n, registers[instruction.x], instruction.scalar, dst);
+          } else {
+            instruction.binary(n, registers[instruction.x], registers[instruction.y],
+                               instruction.scalar, dst);
+          }
+          registers[num_inputs + i] = dst;
+        }
+      }
+    };
+    const int64_t num_threads =
+        Global<ThreadPool>::Get() == nullptr
+            ? 1
+            : std::min<int64_t>(Global<ThreadPool>::Get()->thread_num(),
+                                RoundUp(num_tiles, kMinTileCntPerThread) / kMinTileCntPerThread);
+    if (num_threads > 1) {
+      BalancedSplitter bs(num_tiles, num_threads);
+      MultiThreadLoop(num_threads,
+                      [&](size_t i) { ComputeTiles(bs.At(i).begin(), bs.At(i).end()); });
+    } else {
+      ComputeTiles(0, num_tiles);
+    }
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+}  // namespace
+
+#define REGISTER_CPU_FUSED_ELEMENTWISE_KERNEL(dtype)                                    \
+  REGISTER_USER_KERNEL("fused_elementwise")                                             \
+      .SetCreateFn<CpuFusedElementwiseKernel<dtype>>()                                  \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == DeviceType::kCPU)                    \
+                       & (user_op::HobDataType("out", 0) == GetDataType<dtype>::value));
+
+REGISTER_CPU_FUSED_ELEMENTWISE_KERNEL(float)
+REGISTER_CPU_FUSED_ELEMENTWISE_KERNEL(double)
+
+}  // namespace oneflow
@@ -46,6 +46,7 @@ class CpuGeluKernel final : public user_op::OpKernel {
 
 REGISTER_CPU_GELU_KERNEL(float)
 REGISTER_CPU_GELU_KERNEL(double)
+REGISTER_CPU_GELU_KERNEL(bfloat16)
 
 template<typename T>
 class CpuGeluGradKernel final : public user_op::OpKernel {
@@ -83,5 +84,6 @@ class CpuGeluGradKernel final : public user_op::OpKernel {
 
 REGISTER_CPU_GELU_GRAD_KERNEL(float)
 REGISTER_CPU_GELU_GRAD_KERNEL(double)
+REGISTER_CPU_GELU_GRAD_KERNEL(bfloat16)
 
 }  // namespace oneflow
@@ -85,6 +85,7 @@ class MatmulFloatingKernel final : public user_op::OpKernel {
 
 REGISTER_MATMUL_KERNEL(DeviceType::kCPU, float);
 REGISTER_MATMUL_KERNEL(DeviceType::kCPU, double);
+REGISTER_MATMUL_KERNEL(DeviceType::kCPU, bfloat16);
 #ifdef WITH_CUDA
 REGISTER_MATMUL_KERNEL(DeviceType::kGPU, float);
 REGISTER_MATMUL_KERNEL(DeviceType::kGPU, double);
@@ -194,6 +195,7 @@ class BatchMatmulFloatingKernel final : public user_op::OpKernel {
 
 REGISTER_BATCH_MATMUL_KERNEL(DeviceType::kCPU, float);
 REGISTER_BATCH_MATMUL_KERNEL(DeviceType::kCPU, double);
+REGISTER_BATCH_MATMUL_KERNEL(DeviceType::kCPU, bfloat16);
 #ifdef WITH_CUDA
 REGISTER_BATCH_MATMUL_KERNEL(DeviceType::kGPU, float);
 REGISTER_BATCH_MATMUL_KERNEL(DeviceType::kGPU, double);
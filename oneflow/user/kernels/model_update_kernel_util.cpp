@@ -15,6 +15,9 @@ limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/user/kernels/model_update_kernel_util.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/core/common/cpu_isa.h"
 
 namespace oneflow {
 
@@ -320,4 +323,222 @@ void LarsUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(
 template struct LarsUpdateKernelUtil<DeviceType::kCPU, float, float>;
 template struct LarsUpdateKernelUtil<DeviceType::kCPU, double, double>;
 
+namespace {
+
+// below this many elements per thread, handing work to the thread pool costs more than the update
+constexpr int64_t kMultiTensorUpdateMinElemCntPerThread = 32 * 1024;
+
+// cuts the concatenation of all tensors into balanced element ranges, one per compute thread, so
+// thousands of small variables and a few huge embeddings keep every thread equally busy
+void ForEachMultiTensorUpdatePiece(
+    int64_t num_tensors, const int64_t* sizes,
+    const std::function<void(int64_t tensor_id, int64_t offset, int64_t size)>& Handler) {
+  std::vector<int64_t> tensor_offsets(num_tensors + 1, 0);
+  FOR_RANGE(int64_t, i, 0, num_tensors) { tensor_offsets[i + 1] = tensor_offsets[i] + sizes[i]; }
+  const int64_t elem_cnt = tensor_offsets.back();
+  if (elem_cnt == 0) { return; }
+  int64_t num_parts = 1;
+  if (Global<ThreadPool>::Get() != nullptr) {
+    num_parts = std::min<int64_t>(Global<ThreadPool>::Get()->thread_num(),
+                                  elem_cnt / kMultiTensorUpdateMinElemCntPerThread);
+    num_parts = std::max<int64_t>(num_parts, 1);
+  }
+  const BalancedSplitter bs(elem_cnt, num_parts);
+  auto DoPart = [&](size_t part_id) {
+    const Range range = bs.At(part_id);
+    int64_t tensor_id =
+        std::upper_bound(tensor_offsets.begin(), tensor_offsets.end(), range.begin())
+        - tensor_offsets.begin() - 1;
+    int64_t pos = range.begin();
+    while (pos < range.end()) {
+      const int64_t end = std::min(range.end(), tensor_offsets.at(tensor_id + 1));
+      if (end > pos) { Handler(tensor_id, pos - tensor_offsets.at(tensor_id), end - pos); }
+      pos = end;
+      tensor_id += 1;
+    }
+  };
+  if (num_parts > 1) {
+    MultiThreadLoop(num_parts, DoPart);
+  } else {
+    DoPart(0);
+  }
+}
+
+// returns how many leading values were updated with SIMD, the rest go through the functors
+template<typename T>
+int64_t SGDUpdateVectorized(int64_t n, T scale, float l1, float l2, float weight_decay,
+                            float learning_rate, const T* model_diff, T* model) {
+  return 0;
+}
+
+template<typename T>
+int64_t AdamUpdateVectorized(int64_t n, T scale, float l1, float l2, float beta1, float beta2,
+                             float epsilon, float weight_decay, float learning_rate,
+                             const T* model_diff, T* model, T* m, T* v) {
+  return 0;
+}
+
+#ifdef OF_WITH_AVX512F_DISPATCH
+
+OF_TARGET_ISA("avx512f")
+__m512 RegularizeGradient(__m512 model_diff, __m512 model, __m512 scale, __m512 l1, __m512 l2) {
+  const __m512 zero = _mm512_setzero_ps();
+  const __mmask16 positive = _mm512_cmp_ps_mask(model, zero, _CMP_GT_OQ);
+  const __mmask16 negative = _mm512_cmp_ps_mask(model, zero, _CMP_LT_OQ);
+  const __m512 sign = _mm512_mask_blend_ps(
+      negative, _mm512_mask_blend_ps(positive, zero, _mm512_set1_ps(1.f)), _mm512_set1_ps(-1.f));
+  return _mm512_fmadd_ps(l2, model, _mm512_fmadd_ps(l1, sign, _mm512_mul_ps(model_diff, scale)));
+}
+
+OF_TARGET_ISA("avx512f")
+int64_t SGDUpdateAvx512(int64_t n, float scale, float l1, float l2, float weight_decay,
+                        float learning_rate, const float* model_diff, float* model) {
+  const __m512 scale_v = _mm512_set1_ps(scale);
+  const __m512 l1_v = _mm512_set1_ps(l1);
+  const __m512 l2_v = _mm512_set1_ps(l2);
+  const __m512 weight_decay_v = _mm512_set1_ps(weight_decay);
+  const __m512 learning_rate_v = _mm512_set1_ps(learning_rate);
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m512 model_v = _mm512_loadu_ps(model + i);
+    const __m512 model_diff_v =
+        RegularizeGradient(_mm512_loadu_ps(model_diff + i), model_v, scale_v, l1_v, l2_v);
+    const __m512 update_v = _mm512_fmadd_ps(weight_decay_v, model_v, model_diff_v);
+    _mm512_storeu_ps(model + i, _mm512_fnmadd_ps(learning_rate_v, update_v, model_v));
+  }
+  return i;
+}
+
+OF_TARGET_ISA("avx512f")
+int64_t AdamUpdateAvx512(int64_t n, float scale, float l1, float l2, float beta1, float beta2,
+                         float epsilon, float weight_decay, float learning_rate,
+                         const float* model_diff, float* model, float* m, float* v) {
+  const __m512 scale_v = _mm512_set1_ps(scale);
+  const __m512 l1_v = _mm512_set1_ps(l1);
+  const __m512 l2_v = _mm512_set1_ps(l2);
+  const __m512 beta1_v = _mm512_set1_ps(beta1);
+  const __m512 beta2_v = _mm512_set1_ps(beta2);
+  const __m512 one_minus_beta1_v = _mm512_set1_ps(1 - beta1);
+  const __m512 one_minus_beta2_v = _mm512_set1_ps(1 - beta2);
+  const __m512 epsilon_v = _mm512_set1_ps(epsilon);
+  const __m512 weight_decay_v = _mm512_set1_ps(weight_decay);
+  const __m512 learning_rate_v = _mm512_set1_ps(learning_rate);
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m512 model_v = _mm512_loadu_ps(model + i);
+    const __m512 model_diff_v =
+        RegularizeGradient(_mm512_loadu_ps(model_diff + i), model_v, scale_v, l1_v, l2_v);
+    const __m512 m_v = _mm512_fmadd_ps(beta1_v, _mm512_loadu_ps(m + i),
+                                       _mm512_mul_ps(one_minus_beta1_v, model_diff_v));
+    const __m512 square_v = _mm512_mul_ps(model_diff_v, model_diff_v);
+    const __m512 v_v = _mm512_fmadd_ps(beta2_v, _mm512_loadu_ps(v + i),
+                                       _mm512_mul_ps(one_minus_beta2_v, square_v));
+    _mm512_storeu_ps(m + i, m_v);
+    _mm512_storeu_ps(v + i, v_v);
+    const __m512 denom_v = _mm512_add_ps(_mm512_sqrt_ps(v_v), epsilon_v);
+    const __m512 update_v = _mm512_fmadd_ps(weight_decay_v, model_v, _mm512_div_ps(m_v, denom_v));
+    _mm512_storeu_ps(model + i, _mm512_fnmadd_ps(learning_rate_v, update_v, model_v));
+  }
+  return i;
+}
+
+template<>
+int64_t SGDUpdateVectorized<float>(int64_t n, float scale, float l1, float l2, float weight_decay,
+                                   float learning_rate, const float* model_diff, float* model) {
+  if (!CpuHasAvx512F()) { return 0; }
+  return SGDUpdateAvx512(n, scale, l1, l2, weight_decay, learning_rate, model_diff, model);
+}
+
+template<>
+int64_t AdamUpdateVectorized<float>(int64_t n, float scale, float l1, float l2, float beta1,
+                                    float beta2, float epsilon, float weight_decay,
+                                    float learning_rate, const float* model_diff, float* model,
+                                    float* m, float* v) {
+  if (!CpuHasAvx512F()) { return 0; }
+  return AdamUpdateAvx512(n, scale, l1, l2, beta1, beta2, epsilon, weight_decay, learning_rate,
+                          model_diff, model, m, v);
+}
+
+#endif  // OF_WITH_AVX512F_DISPATCH
+
+template<typename T>
+void SGDUpdateRange(int64_t n, T scale, float l1, float l2, float weight_decay,
+                    float learning_rate, const T* model_diff, T* model) {
+  const int64_t vectorized =
+      SGDUpdateVectorized<T>(n, scale, l1, l2, weight_decay, learning_rate, model_diff, model);
+  FOR_RANGE(int64_t, i, vectorized, n) {
+    SGDUpdateFunctor<T, T>()(model_diff + i, model + i, scale, l1, l2, weight_decay,
+                             learning_rate);
+  }
+}
+
+template<typename T>
+void AdamUpdateRange(int64_t n, T scale, float l1, float l2, float beta1, float beta2,
+                     float epsilon, float weight_decay, float learning_rate, const T* model_diff,
+                     T* model, T* m, T* v) {
+  const int64_t vectorized =
+      AdamUpdateVectorized<T>(n, scale, l1, l2, beta1, beta2, epsilon, weight_decay,
+                              learning_rate, model_diff, model, m, v);
+  FOR_RANGE(int64_t, i, vectorized, n) {
+    AdamUpdateFunctor<T, T>()(model_diff + i, model + i, m + i, v + i, scale, l1, l2, beta1, beta2,
+                              epsilon, weight_decay, learning_rate);
+  }
+}
+
+}  // namespace
+
+template<typename T>
+struct MultiTensorSGDUpdateKernelUtil<DeviceType::kCPU, T> {
+  static void Update(DeviceCtx* ctx, int64_t num_tensors, const int64_t* sizes, T scale, float l1,
+                     float l2, float weight_decay, const float* learning_rate,
+                     const T* scale_by_ptr, const int64_t* skip_if, const T* const* model_diffs,
+                     T* const* models);
+};
+
+template<typename T>
+void MultiTensorSGDUpdateKernelUtil<DeviceType::kCPU, T>::Update(
+    DeviceCtx* ctx, int64_t num_tensors, const int64_t* sizes, T scale, float l1, float l2,
+    float weight_decay, const float* learning_rate, const T* scale_by_ptr, const int64_t* skip_if,
+    const T* const* model_diffs, T* const* models) {
+  if (skip_if != nullptr && *skip_if != 0) { return; }
+  const float lr = *learning_rate;
+  if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
+  ForEachMultiTensorUpdatePiece(
+      num_tensors, sizes, [&](int64_t tensor_id, int64_t offset, int64_t size) {
+        SGDUpdateRange<T>(size, scale, l1, l2, weight_decay, lr, model_diffs[tensor_id] + offset,
+                          models[tensor_id] + offset);
+      });
+}
+
+template struct MultiTensorSGDUpdateKernelUtil<DeviceType::kCPU, float>;
+template struct MultiTensorSGDUpdateKernelUtil<DeviceType::kCPU, double>;
+
+template<typename T>
+struct MultiTensorAdamUpdateKernelUtil<DeviceType::kCPU, T> {
+  static void Update(DeviceCtx* ctx, int64_t num_tensors, const int64_t* sizes, T scale, float l1,
+                     float l2, float beta1, float beta2, float epsilon, float weight_decay,
+                     const float* learning_rate, const T* scale_by_ptr, const int64_t* skip_if,
+                     const T* const* model_diffs, T* const* models, T* const* ms, T* const* vs);
+};
+
+template<typename T>
+void MultiTensorAdamUpdateKernelUtil<DeviceType::kCPU, T>::Update(
+    DeviceCtx* ctx, int64_t num_tensors, const int64_t* sizes, T scale, float l1, float l2,
+    float beta1, float beta2, float epsilon, float weight_decay, const float* learning_rate,
+    const T* scale_by_ptr, const int64_t* skip_if, const T* const* model_diffs, T* const* models,
+    T* const* ms, T* const* vs) {
+  if (skip_if != nullptr && *skip_if != 0) { return; }
+  const float lr = *learning_rate;
+  if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
+  ForEachMultiTensorUpdatePiece(
+      num_tensors, sizes, [&](int64_t tensor_id, int64_t offset, int64_t size) {
+        AdamUpdateRange<T>(size, scale, l1, l2, beta1, beta2, epsilon, weight_decay, lr,
+                           model_diffs[tensor_id] + offset, models[tensor_id] + offset,
+                           ms[tensor_id] + offset, vs[tensor_id] + offset);
+      });
+}
+
+template struct MultiTensorAdamUpdateKernelUtil<DeviceType::kCPU, float>;
+template struct MultiTensorAdamUpdateKernelUtil<DeviceType::kCPU, double>;
+
 }  // namespace oneflow
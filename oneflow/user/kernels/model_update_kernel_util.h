@@ -233,6 +233,22 @@ struct LarsUpdateKernelUtil {
                      const G* model_diff, T* model, T* momentum, T* data_tmp, T* model_diff_tmp);
 };
 
+template<DeviceType device_type, typename T>
+struct MultiTensorSGDUpdateKernelUtil {
+  static void Update(DeviceCtx* ctx, int64_t num_tensors, const int64_t* sizes, T scale, float l1,
+                     float l2, float weight_decay, const float* learning_rate,
+                     const T* scale_by_ptr, const int64_t* skip_if, const T* const* model_diffs,
+                     T* const* models);
+};
+
+template<DeviceType device_type, typename T>
+struct MultiTensorAdamUpdateKernelUtil {
+  static void Update(DeviceCtx* ctx, int64_t num_tensors, const int64_t* sizes, T scale, float l1,
+                     float l2, float beta1, float beta2, float epsilon, float weight_decay,
+                     const float* learning_rate, const T* scale_by_ptr, const int64_t* skip_if,
+                     const T* const* model_diffs, T* const* models, T* const* ms, T* const* vs);
+};
+
 #endif
 
 }  // namespace oneflow
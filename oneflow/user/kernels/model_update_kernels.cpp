@@ -805,6 +805,121 @@ REGISTER_LARS_UPDATE_KERNEL(DeviceType::kGPU, float, float);
 REGISTER_LARS_UPDATE_KERNEL(DeviceType::kGPU, double, double);
 #endif  // WITH_CUDA
 
+template<DeviceType device_type, typename T>
+class MultiTensorSGDUpdateKernel final : public user_op::OpKernel {
+ public:
+  MultiTensorSGDUpdateKernel() = default;
+  ~MultiTensorSGDUpdateKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* learning_rate = ctx->Tensor4ArgNameAndIndex("learning_rate", 0);
+    const int64_t num_tensors = ctx->user_op_conf().input_size("model");
+    std::vector<int64_t> sizes(num_tensors);
+    std::vector<const T*> model_diffs(num_tensors);
+    std::vector<T*> models(num_tensors);
+    FOR_RANGE(int64_t, i, 0, num_tensors) {
+      const user_op::Tensor* model_diff = ctx->Tensor4ArgNameAndIndex("model_diff", i);
+      user_op::Tensor* model = ctx->Tensor4ArgNameAndIndex("model", i);
+      sizes.at(i) = model->shape().elem_cnt();
+      model_diffs.at(i) = model_diff->dptr<T>();
+      models.at(i) = model->mut_dptr<T>();
+    }
+    const auto scale = ctx->Attr<double>("scale");
+    const auto l1 = ctx->Attr<float>("l1");
+    const auto l2 = ctx->Attr<float>("l2");
+    const auto weight_decay = ctx->Attr<float>("weight_decay");
+    const T* scale_by_ptr = nullptr;
+    if (ctx->user_op_conf().has_input("scale_by_tensor", 0)) {
+      const user_op::Tensor* scale_by_tensor = ctx->Tensor4ArgNameAndIndex("scale_by_tensor", 0);
+      CHECK_EQ(scale_by_tensor->data_type(), GetDataType<T>::value);
+      CHECK_EQ(scale_by_tensor->shape().elem_cnt(), 1);
+      scale_by_ptr = scale_by_tensor->dptr<T>();
+    }
+    const int64_t* skip_if_ptr = nullptr;
+    if (ctx->user_op_conf().has_input("skip_if", 0)) {
+      const user_op::Tensor* skip_if = ctx->Tensor4ArgNameAndIndex("skip_if", 0);
+      CHECK_EQ(skip_if->shape().elem_cnt(), 1);
+      skip_if_ptr = skip_if->dptr<int64_t>();
+    }
+    MultiTensorSGDUpdateKernelUtil<device_type, T>::Update(
+        ctx->device_ctx(), num_tensors, sizes.data(), static_cast<T>(scale), l1, l2, weight_decay,
+        learning_rate->dptr<float>(), scale_by_ptr, skip_if_ptr, model_diffs.data(),
+        models.data());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
+};
+
+#define REGISTER_MULTI_TENSOR_SGD_UPDATE_KERNEL(device, dtype)  \
+  REGISTER_USER_KERNEL("multi_tensor_sgd_update")               \
+      .SetCreateFn<MultiTensorSGDUpdateKernel<device, dtype>>() \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == device)      \
+                       & (user_op::HobDataType("model", 0) == GetDataType<dtype>::value));
+
+REGISTER_MULTI_TENSOR_SGD_UPDATE_KERNEL(DeviceType::kCPU, float);
+REGISTER_MULTI_TENSOR_SGD_UPDATE_KERNEL(DeviceType::kCPU, double);
+
+template<DeviceType device_type, typename T>
+class MultiTensorAdamUpdateKernel final : public user_op::OpKernel {
+ public:
+  MultiTensorAdamUpdateKernel() = default;
+  ~MultiTensorAdamUpdateKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* learning_rate = ctx->Tensor4ArgNameAndIndex("learning_rate", 0);
+    const int64_t num_tensors = ctx->user_op_conf().input_size("model");
+    std::vector<int64_t> sizes(num_tensors);
+    std::vector<const T*> model_diffs(num_tensors);
+    std::vector<T*> models(num_tensors);
+    std::vector<T*> ms(num_tensors);
+    std::vector<T*> vs(num_tensors);
+    FOR_RANGE(int64_t, i, 0, num_tensors) {
+      const user_op::Tensor* model_diff = ctx->Tensor4ArgNameAndIndex("model_diff", i);
+      user_op::Tensor* model = ctx->Tensor4ArgNameAndIndex("model", i);
+      sizes.at(i) = model->shape().elem_cnt();
+      model_diffs.at(i) = model_diff->dptr<T>();
+      models.at(i) = model->mut_dptr<T>();
+      ms.at(i) = ctx->Tensor4ArgNameAndIndex("m", i)->mut_dptr<T>();
+      vs.at(i) = ctx->Tensor4ArgNameAndIndex("v", i)->mut_dptr<T>();
+    }
+    const auto scale = ctx->Attr<double>("scale");
+    const auto l1 = ctx->Attr<float>("l1");
+    const auto l2 = ctx->Attr<float>("l2");
+    const auto beta1 = ctx->Attr<float>("beta1");
+    const auto beta2 = ctx->Attr<float>("beta2");
+    const auto epsilon = ctx->Attr<float>("epsilon");
+    const auto weight_decay = ctx->Attr<float>("weight_decay");
+    const T* scale_by_ptr = nullptr;
+    if (ctx->user_op_conf().has_input("scale_by_tensor", 0)) {
+      const user_op::Tensor* scale_by_tensor = ctx->Tensor4ArgNameAndIndex("scale_by_tensor", 0);
+      CHECK_EQ(scale_by_tensor->data_type(), GetDataType<T>::value);
+      CHECK_EQ(scale_by_tensor->shape().elem_cnt(), 1);
+      scale_by_ptr = scale_by_tensor->dptr<T>();
+    }
+    const int64_t* skip_if_ptr = nullptr;
+    if (ctx->user_op_conf().has_input("skip_if", 0)) {
+      const user_op::Tensor* skip_if = ctx->Tensor4ArgNameAndIndex("skip_if", 0);
+      CHECK_EQ(skip_if->shape().elem_cnt(), 1);
+      skip_if_ptr = skip_if->dptr<int64_t>();
+    }
+    MultiTensorAdamUpdateKernelUtil<device_type, T>::Update(
+        ctx->device_ctx(), num_tensors, sizes.data(), static_cast<T>(scale), l1, l2, beta1, beta2,
+        epsilon, weight_decay, learning_rate->dptr<float>(), scale_by_ptr, skip_if_ptr,
+        model_diffs.data(), models.data(), ms.data(), vs.data());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
+};
+
+#define REGISTER_MULTI_TENSOR_ADAM_UPDATE_KERNEL(device, dtype)  \
+  REGISTER_USER_KERNEL("multi_tensor_adam_update")               \
+      .SetCreateFn<MultiTensorAdamUpdateKernel<device, dtype>>() \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == device)       \
+                       & (user_op::HobDataType("model", 0) == GetDataType<dtype>::value));
+
+REGISTER_MULTI_TENSOR_ADAM_UPDATE_KERNEL(DeviceType::kCPU, float);
+REGISTER_MULTI_TENSOR_ADAM_UPDATE_KERNEL(DeviceType::kCPU, double);
+
 }  // namespace
 
 }  // namespace oneflow
@@ -0,0 +1,440 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/core/common/balanced_splitter.h"
+
+namespace oneflow {
+
+namespace {
+
+constexpr int64_t kMinElemCntPerThread = 32 * 1024;
+
+// x is viewed as [outer, channel, inner], channels first layouts like NCHW have inner > 1 and
+// channels last layouts like NHWC have inner == 1
+struct ChannelLayout {
+  ChannelLayout(const ShapeView& shape, int32_t axis)
+      : outer(shape.Count(0, axis)), channel(shape.At(axis)), inner(shape.Count(axis + 1)) {}
+
+  int64_t elem_cnt() const { return outer * channel * inner; }
+  int64_t row_cnt() const { return outer * channel; }
+
+  int64_t outer;
+  int64_t channel;
+  int64_t inner;
+};
+
+int64_t GetThreadNum(const ChannelLayout& layout) {
+  const int64_t max_thread_num = Global<ThreadPool>::Get()->thread_num();
+  return std::max<int64_t>(
+      std::min<int64_t>({max_thread_num, layout.elem_cnt() / kMinElemCntPerThread,
+                         layout.row_cnt()}),
+      1);
+}
+
+// Splits the rows of length inner among threads, Fn(row_begin, row_end) sees a contiguous range of
+// rows whose channel index starts from row_begin % channel.
+template<typename F>
+void ForEachRowRange(const ChannelLayout& layout, const F& Fn) {
+  const int64_t thread_num = GetThreadNum(layout);
+  const BalancedSplitter bs(layout.row_cnt(), thread_num);
+  MultiThreadLoop(thread_num, [&](size_t thread_id) {
+    const Range range = bs.At(thread_id);
+    Fn(thread_id, range.begin(), range.end());
+  });
+}
+
+// result[c] = sum of GetValue(offset, c) over all elements of channel c
+template<typename T, typename F>
+void ChannelReduceSum(const ChannelLayout& layout, const F& GetValue, T* result) {
+  const int64_t thread_num = GetThreadNum(layout);
+  std::vector<T> partial_sums(thread_num * layout.channel, GetZeroVal<T>());
+  ForEachRowRange(layout, [&](int64_t thread_id, int64_t row_begin, int64_t row_end) {
+    T* partial_sum = partial_sums.data() + thread_id * layout.channel;
+    int64_t c = row_begin % layout.channel;
+    FOR_RANGE(int64_t, row, row_begin, row_end) {
+      const int64_t offset = row * layout.inner;
+      T sum = GetZeroVal<T>();
+      for (int64_t i = offset; i < offset + layout.inner; ++i) { sum += GetValue(i, c); }
+      partial_sum[c] += sum;
+      c = c + 1 == layout.channel ? 0 : c + 1;
+    }
+  });
+  FOR_RANGE(int64_t, c, 0, layout.channel) {
+    T sum = GetZeroVal<T>();
+    FOR_RANGE(int64_t, thread_id, 0, thread_num) {
+      sum += partial_sums.at(thread_id * layout.channel + c);
+    }
+    result[c] = sum;
+  }
+}
+
+// calls Fn(offset, c) for every element
+template<typename F>
+void ChannelForEach(const ChannelLayout& layout, const F& Fn) {
+  ForEachRowRange(layout, [&](int64_t thread_id, int64_t row_begin, int64_t row_end) {
+    int64_t c = row_begin % layout.channel;
+    FOR_RANGE(int64_t, row, row_begin, row_end) {
+      const int64_t offset = row * layout.inner;
+      for (int64_t i = offset; i < offset + layout.inner; ++i) { Fn(i, c); }
+      c = c + 1 == layout.channel ? 0 : c + 1;
+    }
+  });
+}
+
+bool GetMaskBit(const int32_t* mask, int64_t i) { return (mask[i / 32] >> (i % 32)) & 1; }
+
+// y = x * scale + shift, the per channel scale and shift fold mean, variance, gamma and beta
+template<typename T>
+void ScaleShift(const ChannelLayout& layout, const T* x, const T* scale, const T* shift,
+                const T* add_to_output, T* y) {
+  if (add_to_output != nullptr) {
+    ChannelForEach(layout, [&](int64_t i, int64_t c) {
+      y[i] = x[i] * scale[c] + shift[c] + add_to_output[i];
+    });
+  } else {
+    ChannelForEach(layout, [&](int64_t i, int64_t c) { y[i] = x[i] * scale[c] + shift[c]; });
+  }
+}
+
+template<typename T>
+void AddRelu(const ChannelLayout& layout, const T* addend, T* y, int32_t* mask) {
+  const int64_t elem_cnt = layout.elem_cnt();
+  const int64_t word_cnt = RoundUp(elem_cnt, 32) / 32;
+  const int64_t thread_num = GetThreadNum(layout);
+  const BalancedSplitter bs(word_cnt, thread_num);
+  MultiThreadLoop(thread_num, [&](size_t thread_id) {
+    const Range range = bs.At(thread_id);
+    FOR_RANGE(int64_t, word, range.begin(), range.end()) {
+      int32_t bits = 0;
+      const int64_t end = std::min((word + 1) * 32, elem_cnt);
+      for (int64_t i = word * 32; i < end; ++i) {
+        const T val = addend == nullptr ? y[i] : y[i] + addend[i];
+        const bool is_positive = val > 0;
+        y[i] = is_positive ? val : GetZeroVal<T>();
+        bits |= static_cast<int32_t>(is_positive) << (i - word * 32);
+      }
+      mask[word] = bits;
+    }
+  });
+}
+
+template<typename T>
+void CheckParamTensor(const user_op::Tensor* tensor, const ChannelLayout& layout) {
+  CHECK_EQ(tensor->shape().NumAxes(), 1);
+  CHECK_EQ(tensor->shape().At(0), layout.channel);
+  CHECK_EQ(tensor->data_type(), GetDataType<T>::value);
+}
+
+const user_op::Tensor* GetAddToOutput(user_op::KernelComputeContext* ctx,
+                                      const user_op::Tensor* y) {
+  if (!ctx->user_op_conf().has_input("_add_to_output", 0)) { return nullptr; }
+  const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
+  CHECK_EQ(add_to_output->data_type(), y->data_type());
+  CHECK_EQ(add_to_output->shape(), y->shape());
+  return add_to_output;
+}
+
+}  // namespace
+
+template<typename T>
+class CpuNormalizationInferenceKernel final : public user_op::OpKernel {
+ public:
+  CpuNormalizationInferenceKernel() = default;
+  ~CpuNormalizationInferenceKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const bool training = ctx->Attr<bool>("training");
+    CHECK(!training);
+    const auto* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    auto* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+    const auto* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    const auto* beta = ctx->Tensor4ArgNameAndIndex("beta", 0);
+    const auto* moving_mean = ctx->Tensor4ArgNameAndIndex("moving_mean", 0);
+    const auto* moving_variance = ctx->Tensor4ArgNameAndIndex("moving_variance", 0);
+    const auto axis = ctx->Attr<int32_t>("axis");
+    const auto epsilon = ctx->Attr<float>("epsilon");
+    CHECK_EQ(x->shape(), y->shape());
+    CHECK_EQ(y->data_type(), x->data_type());
+    CHECK_GE(axis, 0);
+    CHECK_LT(axis, x->shape().NumAxes());
+    const ChannelLayout layout(x->shape(), axis);
+    CheckParamTensor<T>(gamma, layout);
+    CheckParamTensor<T>(beta, layout);
+    CheckParamTensor<T>(moving_mean, layout);
+    CheckParamTensor<T>(moving_variance, layout);
+    const user_op::Tensor* add_to_output = GetAddToOutput(ctx, y);
+
+    // inference normalization is an affine transform per channel
+    std::vector<T> scale(layout.channel);
+    std::vector<T> shift(layout.channel);
+    FOR_RANGE(int64_t, c, 0, layout.channel) {
+      scale[c] = gamma->dptr<T>()[c]
+                 / std::sqrt(moving_variance->dptr<T>()[c] + static_cast<T>(epsilon));
+      shift[c] = beta->dptr<T>()[c] - moving_mean->dptr<T>()[c] * scale[c];
+    }
+    ScaleShift<T>(layout, x->dptr<T>(), scale.data(), shift.data(),
+                  add_to_output == nullptr ? nullptr : add_to_output->dptr<T>(), y->mut_dptr<T>());
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_CPU_BN_INFERENCE_KERNEL(dtype)                                                 \
+  REGISTER_USER_KERNEL("normalization")                                                         \
+      .SetCreateFn<CpuNormalizationInferenceKernel<dtype>>()                                    \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                       \
+                       & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value)            \
+                       & (user_op::HobAttr<bool>("training") == false))                         \
+      .SetInplaceProposalFn([](const user_op::InferContext& ctx,                                \
+                               user_op::AddInplaceArgPair AddInplaceArgPairFn) -> Maybe<void> { \
+        if (ctx.user_op_conf().has_input("_add_to_output", 0)) {                                \
+          OF_RETURN_IF_ERROR(AddInplaceArgPairFn("y", 0, "_add_to_output", 0, true));           \
+        }                                                                                       \
+        return Maybe<void>::Ok();                                                               \
+      });
+
+REGISTER_CPU_BN_INFERENCE_KERNEL(float)
+REGISTER_CPU_BN_INFERENCE_KERNEL(double)
+
+#undef REGISTER_CPU_BN_INFERENCE_KERNEL
+
+template<typename T>
+class CpuNormalizationTrainKernel final : public user_op::OpKernel {
+ public:
+  CpuNormalizationTrainKernel() = default;
+  ~CpuNormalizationTrainKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    if (ctx->user_op_conf().op_type_name() == "normalization") {
+      CHECK(ctx->Attr<bool>("training"));
+    }
+    const auto* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    auto* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+    const auto* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    const auto* beta = ctx->Tensor4ArgNameAndIndex("beta", 0);
+    auto* moving_mean = ctx->Tensor4ArgNameAndIndex("moving_mean", 0);
+    auto* moving_variance = ctx->Tensor4ArgNameAndIndex("moving_variance", 0);
+    const auto axis = ctx->Attr<int32_t>("axis");
+    const auto epsilon = ctx->Attr<float>("epsilon");
+    const auto momentum = ctx->Attr<float>("momentum");
+    CHECK_EQ(x->shape(), y->shape());
+    CHECK_EQ(y->data_type(), x->data_type());
+    CHECK_GE(axis, 0);
+    CHECK_LT(axis, x->shape().NumAxes());
+    const ChannelLayout layout(x->shape(), axis);
+    CheckParamTensor<T>(gamma, layout);
+    CheckParamTensor<T>(beta, layout);
+    CheckParamTensor<T>(moving_mean, layout);
+    CheckParamTensor<T>(moving_variance, layout);
+    std::vector<T> mean_buf;
+    std::vector<T> inv_variance_buf;
+    T* mean_ptr = nullptr;
+    T* inv_variance_ptr = nullptr;
+    if (ctx->user_op_conf().has_output("mean", 0)) {
+      auto* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+      CheckParamTensor<T>(mean, layout);
+      mean_ptr = mean->mut_dptr<T>();
+    } else {
+      mean_buf.resize(layout.channel);
+      mean_ptr = mean_buf.data();
+    }
+    if (ctx->user_op_conf().has_output("inv_variance", 0)) {
+      auto* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+      CheckParamTensor<T>(inv_variance, layout);
+      inv_variance_ptr = inv_variance->mut_dptr<T>();
+    } else {
+      inv_variance_buf.resize(layout.channel);
+      inv_variance_ptr = inv_variance_buf.data();
+    }
+    const user_op::Tensor* add_to_output = GetAddToOutput(ctx, y);
+
+    const T* x_ptr = x->dptr<T>();
+    const int64_t reduce_cnt = layout.outer * layout.inner;
+    // two passes over x keep the variance accurate for inputs with a large mean
+    ChannelReduceSum<T>(
+        layout, [&](int64_t i, int64_t c) { return x_ptr[i]; }, mean_ptr);
+    FOR_RANGE(int64_t, c, 0, layout.channel) { mean_ptr[c] /= reduce_cnt; }
+    std::vector<T> variance(layout.channel);
+    ChannelReduceSum<T>(
+        layout,
+        [&](int64_t i, int64_t c) {
+          const T diff = x_ptr[i] - mean_ptr[c];
+          return diff * diff;
+        },
+        variance.data());
+    std::vector<T> scale(layout.channel);
+    std::vector<T> shift(layout.channel);
+    T* moving_mean_ptr = moving_mean->mut_dptr<T>();
+    T* moving_variance_ptr = moving_variance->mut_dptr<T>();
+    // the moving variance is unbiased like cudnn does
+    const T unbias_factor =
+        reduce_cnt > 1 ? static_cast<T>(reduce_cnt) / (reduce_cnt - 1) : GetOneVal<T>();
+    FOR_RANGE(int64_t, c, 0, layout.channel) {
+      variance[c] /= reduce_cnt;
+      inv_variance_ptr[c] = GetOneVal<T>() / std::sqrt(variance[c] + static_cast<T>(epsilon));
+      moving_mean_ptr[c] = moving_mean_ptr[c] * momentum + mean_ptr[c] * (1 - momentum);
+      moving_variance_ptr[c] =
+          moving_variance_ptr[c] * momentum + variance[c] * unbias_factor * (1 - momentum);
+      scale[c] = gamma->dptr<T>()[c] * inv_variance_ptr[c];
+      shift[c] = beta->dptr<T>()[c] - mean_ptr[c] * scale[c];
+    }
+    ScaleShift<T>(layout, x_ptr, scale.data(), shift.data(),
+                  add_to_output == nullptr ? nullptr : add_to_output->dptr<T>(), y->mut_dptr<T>());
+
+    if (ctx->user_op_conf().op_type_name() == "normalization_add_relu") {
+      CHECK(add_to_output == nullptr);
+      auto* mask = ctx->Tensor4ArgNameAndIndex("reserve_space", 0);
+      const T* addend_ptr = nullptr;
+      if (ctx->user_op_conf().has_input("addend", 0)) {
+        addend_ptr = ctx->Tensor4ArgNameAndIndex("addend", 0)->dptr<T>();
+      }
+      AddRelu<T>(layout, addend_ptr, y->mut_dptr<T>(), mask->mut_dptr<int32_t>());
+    }
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_CPU_BN_TRAIN_KERNEL(dtype)                                                     \
+  REGISTER_USER_KERNEL("normalization")                                                         \
+      .SetCreateFn<CpuNormalizationTrainKernel<dtype>>()                                        \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                       \
+                       & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value)            \
+                       & (user_op::HobAttr<bool>("training") == true))                          \
+      .SetInplaceProposalFn([](const user_op::InferContext& ctx,                                \
+                               user_op::AddInplaceArgPair AddInplaceArgPairFn) -> Maybe<void> { \
+        if (ctx.user_op_conf().has_input("_add_to_output", 0)) {                                \
+          OF_RETURN_IF_ERROR(AddInplaceArgPairFn("y", 0, "_add_to_output", 0, true));           \
+        }                                                                                       \
+        return Maybe<void>::Ok();                                                               \
+      });
+
+REGISTER_CPU_BN_TRAIN_KERNEL(float)
+REGISTER_CPU_BN_TRAIN_KERNEL(double)
+
+#undef REGISTER_CPU_BN_TRAIN_KERNEL
+
+#define REGISTER_CPU_BN_ADD_RELU_KERNEL(dtype)                                        \
+  REGISTER_USER_KERNEL("normalization_add_relu")                                      \
+      .SetCreateFn<CpuNormalizationTrainKernel<dtype>>()                              \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                             \
+                       & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value));
+
+REGISTER_CPU_BN_ADD_RELU_KERNEL(float)
+REGISTER_CPU_BN_ADD_RELU_KERNEL(double)
+
+#undef REGISTER_CPU_BN_ADD_RELU_KERNEL
+
+template<typename T>
+class CpuNormalizationGradKernel final : public user_op::OpKernel {
+ public:
+  CpuNormalizationGradKernel() = default;
+  ~CpuNormalizationGradKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const auto* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    auto* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    const auto* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const auto* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    auto* gamma_diff = ctx->Tensor4ArgNameAndIndex("gamma_diff", 0);
+    auto* beta_diff = ctx->Tensor4ArgNameAndIndex("beta_diff", 0);
+    const auto* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    const auto* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+    const auto axis = ctx->Attr<int32_t>("axis");
+    CHECK_EQ(dy->shape(), x->shape());
+    CHECK_EQ(dy->data_type(), x->data_type());
+    CHECK_EQ(dx->shape(), x->shape());
+    CHECK_EQ(dx->data_type(), x->data_type());
+    CHECK_GE(axis, 0);
+    CHECK_LT(axis, x->shape().NumAxes());
+    const ChannelLayout layout(x->shape(), axis);
+    CheckParamTensor<T>(gamma, layout);
+    CheckParamTensor<T>(gamma_diff, layout);
+    CheckParamTensor<T>(beta_diff, layout);
+    CheckParamTensor<T>(mean, layout);
+    CheckParamTensor<T>(inv_variance, layout);
+
+    const T* x_ptr = x->dptr<T>();
+    const T* dy_ptr = dy->dptr<T>();
+    const T* mean_ptr = mean->dptr<T>();
+    const T* inv_variance_ptr = inv_variance->dptr<T>();
+    if (ctx->user_op_conf().op_type_name() == "normalization_grad") {
+      Backward(layout, x_ptr, mean_ptr, inv_variance_ptr, gamma->dptr<T>(),
+               [&](int64_t i) { return dy_ptr[i]; }, gamma_diff->mut_dptr<T>(),
+               beta_diff->mut_dptr<T>(), dx->mut_dptr<T>());
+    } else if (ctx->user_op_conf().op_type_name() == "normalization_add_relu_grad") {
+      // the relu backward is applied on the fly through the mask instead of a temporary buffer
+      const int32_t* mask = ctx->Tensor4ArgNameAndIndex("reserve_space", 0)->dptr<int32_t>();
+      const auto GetDy = [&](int64_t i) {
+        return GetMaskBit(mask, i) ? dy_ptr[i] : GetZeroVal<T>();
+      };
+      if (ctx->user_op_conf().has_output("addend_diff", 0)) {
+        T* addend_diff_ptr = ctx->Tensor4ArgNameAndIndex("addend_diff", 0)->mut_dptr<T>();
+        ChannelForEach(layout, [&](int64_t i, int64_t c) { addend_diff_ptr[i] = GetDy(i); });
+      }
+      Backward(layout, x_ptr, mean_ptr, inv_variance_ptr, gamma->dptr<T>(), GetDy,
+               gamma_diff->mut_dptr<T>(), beta_diff->mut_dptr<T>(), dx->mut_dptr<T>());
+    } else {
+      UNIMPLEMENTED();
+    }
+  }
+
+  template<typename F>
+  static void Backward(const ChannelLayout& layout, const T* x, const T* mean,
+                       const T* inv_variance, const T* gamma, const F& GetDy, T* gamma_diff,
+                       T* beta_diff, T* dx) {
+    ChannelReduceSum<T>(
+        layout, [&](int64_t i, int64_t c) { return GetDy(i); }, beta_diff);
+    ChannelReduceSum<T>(
+        layout,
+        [&](int64_t i, int64_t c) { return GetDy(i) * (x[i] - mean[c]) * inv_variance[c]; },
+        gamma_diff);
+    const int64_t reduce_cnt = layout.outer * layout.inner;
+    // dx = gamma * inv_variance * (dy - beta_diff / m - x_hat * gamma_diff / m)
+    std::vector<T> dy_scale(layout.channel);
+    std::vector<T> x_scale(layout.channel);
+    std::vector<T> bias(layout.channel);
+    FOR_RANGE(int64_t, c, 0, layout.channel) {
+      dy_scale[c] = gamma[c] * inv_variance[c];
+      x_scale[c] = -dy_scale[c] * inv_variance[c] * gamma_diff[c] / reduce_cnt;
+      bias[c] = -dy_scale[c] * beta_diff[c] / reduce_cnt - x_scale[c] * mean[c];
+    }
+    ChannelForEach(layout, [&](int64_t i, int64_t c) {
+      dx[i] = GetDy(i) * dy_scale[c] + x[i] * x_scale[c] + bias[c];
+    });
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_CPU_BN_GRAD_KERNEL(op_type_name, dtype)                              \
+  REGISTER_USER_KERNEL(op_type_name)                                                  \
+      .SetCreateFn<CpuNormalizationGradKernel<dtype>>()                               \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                             \
+                       & (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value));
+
+REGISTER_CPU_BN_GRAD_KERNEL("normalization_grad", float)
+REGISTER_CPU_BN_GRAD_KERNEL("normalization_grad", double)
+REGISTER_CPU_BN_GRAD_KERNEL("normalization_add_relu_grad", float)
+REGISTER_CPU_BN_GRAD_KERNEL("normalization_add_relu_grad", double)
+
+#undef REGISTER_CPU_BN_GRAD_KERNEL
+
+}  // namespace oneflow
@@ -0,0 +1,168 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/quantization_kernel_util.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/core/common/cpu_isa.h"
+
+namespace oneflow {
+
+namespace {
+
+int8_t QuantizeValue(float value, float inv_scale) {
+  const float q = std::nearbyint(value * inv_scale);
+  return static_cast<int8_t>(
+      std::min(std::max(q, static_cast<float>(-kInt8QuantizationMax)),
+               static_cast<float>(kInt8QuantizationMax)));
+}
+
+void ForEachRow(int64_t m, const std::function<void(size_t)>& Handler) {
+  if (Global<ThreadPool>::Get() != nullptr && m > 1) {
+    MultiThreadLoop(m, Handler);
+  } else {
+    FOR_RANGE(int64_t, i, 0, m) { Handler(i); }
+  }
+}
+
+#ifdef OF_WITH_AVX512VNNI_DISPATCH
+
+// vpdpbusd multiplies unsigned by signed bytes, a_row is shifted into [1, 255] by adding 128 and
+// the extra 128 * sum(b_row) is subtracted from every output
+OF_TARGET_ISA("avx512f,avx512bw,avx512vnni")
+void Int8VnniGemmRow(int64_t n, int64_t k, const uint8_t* a_row, const int8_t* b,
+                     const int32_t* b_row_sums, int32_t* c_row) {
+  const int64_t tail = k % 64;
+  const __mmask64 tail_mask = tail == 0 ? 0 : (static_cast<__mmask64>(1) << tail) - 1;
+  const int64_t body = k - tail;
+  int64_t j = 0;
+  for (; j + 4 <= n; j += 4) {
+    const int8_t* b0 = b + j * k;
+    const int8_t* b1 = b0 + k;
+    const int8_t* b2 = b1 + k;
+    const int8_t* b3 = b2 + k;
+    __m512i acc0 = _mm512_setzero_si512();
+    __m512i acc1 = _mm512_setzero_si512();
+    __m512i acc2 = _mm512_setzero_si512();
+    __m512i acc3 = _mm512_setzero_si512();
+    for (int64_t p = 0; p < body; p += 64) {
+      const __m512i va = _mm512_loadu_si512(a_row + p);
+      acc0 = _mm512_dpbusd_epi32(acc0, va, _mm512_loadu_si512(b0 + p));
+      acc1 = _mm512_dpbusd_epi32(acc1, va, _mm512_loadu_si512(b1 + p));
+      acc2 = _mm512_dpbusd_epi32(acc2, va, _mm512_loadu_si512(b2 + p));
+      acc3 = _mm512_dpbusd_epi32(acc3, va, _mm512_loadu_si512(b3 + p));
+    }
+    if (tail > 0) {
+      const __m512i va = _mm512_maskz_loadu_epi8(tail_mask, a_row + body);
+      acc0 = _mm512_dpbusd_epi32(acc0, va, _mm512_maskz_loadu_epi8(tail_mask, b0 + body));
+      acc1 = _mm512_dpbusd_epi32(acc1, va, _mm512_maskz_loadu_epi8(tail_mask, b1 + body));
+      acc2 = _mm512_dpbusd_epi32(acc2, va, _mm512_maskz_loadu_epi8(tail_mask, b2 + body));
+      acc3 = _mm512_dpbusd_epi32(acc3, va, _mm512_maskz_loadu_epi8(tail_mask, b3 + body));
+    }
+    c_row[j] = _mm512_reduce_add_epi32(acc0) - 128 * b_row_sums[j];
+    c_row[j + 1] = _mm512_reduce_add_epi32(acc1) - 128 * b_row_sums[j + 1];
+    c_row[j + 2] = _mm512_reduce_add_epi32(acc2) - 128 * b_row_sums[j + 2];
+    c_row[j + 3] = _mm512_reduce_add_epi32(acc3) - 128 * b_row_sums[j + 3];
+  }
+  for (; j < n; ++j) {
+    const int8_t* b_row = b + j * k;
+    __m512i acc = _mm512_setzero_si512();
+    for (int64_t p = 0; p < body; p += 64) {
+      acc = _mm512_dpbusd_epi32(acc, _mm512_loadu_si512(a_row + p), _mm512_loadu_si512(b_row + p));
+    }
+    if (tail > 0) {
+      acc = _mm512_dpbusd_epi32(acc, _mm512_maskz_loadu_epi8(tail_mask, a_row + body),
+                                _mm512_maskz_loadu_epi8(tail_mask, b_row + body));
+    }
+    c_row[j] = _mm512_reduce_add_epi32(acc) - 128 * b_row_sums[j];
+  }
+}
+
+void Int8VnniGemm(int64_t m, int64_t n, int64_t k, const int8_t* a, const int8_t* b,
+                  const int32_t* b_row_sums, int32_t* c) {
+  std::vector<uint8_t> a_shifted(static_cast<size_t>(m) * k);
+  FOR_RANGE(size_t, i, 0, a_shifted.size()) {
+    a_shifted[i] = static_cast<uint8_t>(a[i]) ^ static_cast<uint8_t>(0x80);
+  }
+  ForEachRow(m, [&](size_t i) {
+    Int8VnniGemmRow(n, k, a_shifted.data() + i * k, b, b_row_sums, c + i * n);
+  });
+}
+
+#endif  // OF_WITH_AVX512VNNI_DISPATCH
+
+// int8 * int8 products are widened to int32 in the innermost loop, which compilers turn into
+// pmaddwd style code on any SIMD target
+void Int8PortableGemm(int64_t m, int64_t n, int64_t k, const int8_t* a, const int8_t* b,
+                      int32_t* c) {
+  ForEachRow(m, [&](size_t i) {
+    const int8_t* a_row = a + i * k;
+    int32_t* c_row = c + i * n;
+    FOR_RANGE(int64_t, j, 0, n) {
+      const int8_t* b_row = b + j * k;
+      int32_t acc = 0;
+      FOR_RANGE(int64_t, p, 0, k) {
+        acc += static_cast<int32_t>(a_row[p]) * static_cast<int32_t>(b_row[p]);
+      }
+      c_row[j] = acc;
+    }
+  });
+}
+
+}  // namespace
+
+void QuantizeToInt8(int64_t n, const float* in, float scale, int8_t* out) {
+  const float inv_scale = 1.f / scale;
+  FOR_RANGE(int64_t, i, 0, n) { out[i] = QuantizeValue(in[i], inv_scale); }
+}
+
+void DequantizeFromInt8(int64_t n, const int8_t* in, float scale, float* out) {
+  FOR_RANGE(int64_t, i, 0, n) { out[i] = scale * static_cast<float>(in[i]); }
+}
+
+void QuantizeRowsToInt8(int64_t rows, int64_t cols, const float* in, float* scales, int8_t* out,
+                        int32_t* row_sums) {
+  FOR_RANGE(int64_t, i, 0, rows) {
+    const float* in_row = in + i * cols;
+    int8_t* out_row = out + i * cols;
+    float max_abs = 0.f;
+    FOR_RANGE(int64_t, j, 0, cols) { max_abs = std::max(max_abs, std::abs(in_row[j])); }
+    scales[i] = max_abs > 0.f ? max_abs / kInt8QuantizationMax : 1.f;
+    QuantizeToInt8(cols, in_row, scales[i], out_row);
+    int32_t sum = 0;
+    FOR_RANGE(int64_t, j, 0, cols) { sum += out_row[j]; }
+    row_sums[i] = sum;
+  }
+}
+
+void Int8Gemm(int64_t m, int64_t n, int64_t k, const int8_t* a, const int8_t* b,
+              const int32_t* b_row_sums, int32_t* c) {
+#ifdef OF_WITH_AVX512VNNI_DISPATCH
+  if (CpuHasAvx512Vnni()) {
+    Int8VnniGemm(m, n, k, a, b, b_row_sums, c);
+    return;
+  }
+#endif
+  Int8PortableGemm(m, n, k, a, b, c);
+}
+
+void Int8WeightState::Init(int64_t channels, int64_t cols, const float* weight) {
+  weight_.resize(channels * cols);
+  scales_.resize(channels);
+  row_sums_.resize(channels);
+  QuantizeRowsToInt8(channels, cols, weight, scales_.data(), weight_.data(), row_sums_.data());
+  initialized_ = true;
+}
+
+}  // namespace oneflow
@@ -0,0 +1,65 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_QUANTIZATION_KERNEL_UTIL_H_
+#define ONEFLOW_USER_KERNELS_QUANTIZATION_KERNEL_UTIL_H_
+
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+// NOTE: int8 inference uses symmetric quantization with the range clamped to [-127, 127], so
+// that x ~= scale * q and the product of two quantized values fits the int32 accumulator
+constexpr int32_t kInt8QuantizationMax = 127;
+
+void QuantizeToInt8(int64_t n, const float* in, float scale, int8_t* out);
+
+void DequantizeFromInt8(int64_t n, const int8_t* in, float scale, float* out);
+
+// Quantizes every row of a (rows, cols) matrix with its own scale (max(|row|) / 127) and records
+// the row sums of the quantized values, which Int8Gemm needs to undo the unsigned shift of the
+// VNNI instructions
+void QuantizeRowsToInt8(int64_t rows, int64_t cols, const float* in, float* scales, int8_t* out,
+                        int32_t* row_sums);
+
+// c(m, n) = a(m, k) * b(n, k)^T with int32 accumulation, both operands are row major
+void Int8Gemm(int64_t m, int64_t n, int64_t k, const int8_t* a, const int8_t* b,
+              const int32_t* b_row_sums, int32_t* c);
+
+// Per output channel int8 copy of a float weight, built by the int8 kernels on their first run,
+// the weights of an int8 inference job are expected to stay constant
+class Int8WeightState final : public user_op::OpKernelState {
+ public:
+  Int8WeightState() : initialized_(false) {}
+  ~Int8WeightState() = default;
+
+  bool initialized() const { return initialized_; }
+  // weight has shape (channels, cols)
+  void Init(int64_t channels, int64_t cols, const float* weight);
+
+  const int8_t* weight() const { return weight_.data(); }
+  const float* scales() const { return scales_.data(); }
+  const int32_t* row_sums() const { return row_sums_.data(); }
+
+ private:
+  bool initialized_;
+  std::vector<int8_t> weight_;
+  std::vector<float> scales_;
+  std::vector<int32_t> row_sums_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_QUANTIZATION_KERNEL_UTIL_H_
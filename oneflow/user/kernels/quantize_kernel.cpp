@@ -0,0 +1,100 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/kernels/quantization_kernel_util.h"
+
+namespace oneflow {
+
+namespace {
+
+float GetScale(const user_op::Tensor* scale) {
+  const float value = *scale->dptr<float>();
+  CHECK_GT(value, 0.f) << "int8 scale is not calibrated, run an int8 calibration job first";
+  return value;
+}
+
+class CpuQuantizeKernel final : public user_op::OpKernel {
+ public:
+  CpuQuantizeKernel() = default;
+  ~CpuQuantizeKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    const user_op::Tensor* scale = ctx->Tensor4ArgNameAndIndex("scale", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    QuantizeToInt8(in->shape().elem_cnt(), in->dptr<float>(), GetScale(scale),
+                   out->mut_dptr<int8_t>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+class CpuDequantizeKernel final : public user_op::OpKernel {
+ public:
+  CpuDequantizeKernel() = default;
+  ~CpuDequantizeKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    const user_op::Tensor* scale = ctx->Tensor4ArgNameAndIndex("scale", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    DequantizeFromInt8(in->shape().elem_cnt(), in->dptr<int8_t>(), GetScale(scale),
+                       out->mut_dptr<float>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+// Keeps the largest max(|in|) / 127 seen so far, the calibrated scale is frozen once the
+// variable is saved and loaded by the int8 inference job.
+class CpuInt8CalibrationKernel final : public user_op::OpKernel {
+ public:
+  CpuInt8CalibrationKernel() = default;
+  ~CpuInt8CalibrationKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    user_op::Tensor* scale = ctx->Tensor4ArgNameAndIndex("scale", 0);
+    const float* in_ptr = in->dptr<float>();
+    float max_abs = 0.f;
+    FOR_RANGE(int64_t, i, 0, in->shape().elem_cnt()) {
+      max_abs = std::max(max_abs, std::abs(in_ptr[i]));
+    }
+    float* scale_ptr = scale->mut_dptr<float>();
+    *scale_ptr = std::max(*scale_ptr, max_abs / kInt8QuantizationMax);
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
+};
+
+}  // namespace
+
+REGISTER_USER_KERNEL("quantize")
+    .SetCreateFn<CpuQuantizeKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceTag() == DeviceType::kCPU)
+                     & (user_op::HobDataType("in", 0) == DataType::kFloat));
+
+REGISTER_USER_KERNEL("dequantize")
+    .SetCreateFn<CpuDequantizeKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceTag() == DeviceType::kCPU)
+                     & (user_op::HobDataType("in", 0) == DataType::kInt8));
+
+REGISTER_USER_KERNEL("int8_calibration")
+    .SetCreateFn<CpuInt8CalibrationKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceTag() == DeviceType::kCPU)
+                     & (user_op::HobDataType("in", 0) == DataType::kFloat));
+
+}  // namespace oneflow
@@ -0,0 +1,155 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/kernels/quantization_kernel_util.h"
+
+namespace oneflow {
+
+namespace {
+
+struct Int8ConvParams {
+  int64_t in_channels;
+  int64_t in_height;
+  int64_t in_width;
+  int64_t out_height;
+  int64_t out_width;
+  int32_t kernel_h;
+  int32_t kernel_w;
+  int32_t stride_h;
+  int32_t stride_w;
+  int32_t dilation_h;
+  int32_t dilation_w;
+  int32_t padding_h;
+  int32_t padding_w;
+};
+
+// Writes one (in_channels * kernel_h * kernel_w) patch per output pixel, so that the patches form
+// the row major left operand of Int8Gemm, padding is filled by 0 which is exact for symmetric
+// quantization
+void Int8Im2Col(const Int8ConvParams& params, const int8_t* in, int8_t* col) {
+  const int64_t patch_size = params.in_channels * params.kernel_h * params.kernel_w;
+  FOR_RANGE(int64_t, oh, 0, params.out_height) {
+    FOR_RANGE(int64_t, ow, 0, params.out_width) {
+      int8_t* patch = col + (oh * params.out_width + ow) * patch_size;
+      FOR_RANGE(int64_t, c, 0, params.in_channels) {
+        const int8_t* in_plane = in + c * params.in_height * params.in_width;
+        FOR_RANGE(int32_t, kh, 0, params.kernel_h) {
+          const int64_t ih = oh * params.stride_h - params.padding_h + kh * params.dilation_h;
+          FOR_RANGE(int32_t, kw, 0, params.kernel_w) {
+            const int64_t iw = ow * params.stride_w - params.padding_w + kw * params.dilation_w;
+            const bool in_bounds =
+                ih >= 0 && ih < params.in_height && iw >= 0 && iw < params.in_width;
+            *patch++ = in_bounds ? in_plane[ih * params.in_width + iw] : 0;
+          }
+        }
+      }
+    }
+  }
+}
+
+size_t ColBufSize(const Shape& out_shape, const Shape& weight_shape) {
+  return GetCudaAlignedSize(out_shape.Count(2) * weight_shape.Count(1) * sizeof(int8_t));
+}
+
+class CpuQuantizedConv2DKernel final : public user_op::OpKernel {
+ public:
+  CpuQuantizedConv2DKernel() = default;
+  ~CpuQuantizedConv2DKernel() = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return std::make_shared<Int8WeightState>();
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    const user_op::Tensor* in_scale = ctx->Tensor4ArgNameAndIndex("in_scale", 0);
+    const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const auto& kernel_size = ctx->Attr<std::vector<int32_t>>("kernel_size");
+    const auto& strides = ctx->Attr<std::vector<int32_t>>("strides");
+    const auto& dilation_rate = ctx->Attr<std::vector<int32_t>>("dilation_rate");
+    const auto& padding_before = ctx->Attr<std::vector<int32_t>>("padding_before");
+    const bool fuse_relu = ctx->Attr<bool>("fuse_relu");
+
+    Int8ConvParams params{};
+    params.in_channels = in->shape().At(1);
+    params.in_height = in->shape().At(2);
+    params.in_width = in->shape().At(3);
+    params.out_height = out->shape().At(2);
+    params.out_width = out->shape().At(3);
+    params.kernel_h = kernel_size.at(0);
+    params.kernel_w = kernel_size.at(1);
+    params.stride_h = strides.at(0);
+    params.stride_w = strides.at(1);
+    params.dilation_h = dilation_rate.at(0);
+    params.dilation_w = dilation_rate.at(1);
+    params.padding_h = padding_before.at(0);
+    params.padding_w = padding_before.at(1);
+
+    const int64_t num_images = in->shape().At(0);
+    const int64_t filters = out->shape().At(1);
+    const int64_t out_size = out->shape().Count(2);
+    const int64_t patch_size = weight->shape().Count(1);
+
+    auto* weight_state = dynamic_cast<Int8WeightState*>(state);
+    CHECK_NOTNULL(weight_state);
+    if (!weight_state->initialized()) {
+      weight_state->Init(filters, patch_size, weight->dptr<float>());
+    }
+
+    int8_t* col = tmp_buffer->mut_dptr<int8_t>();
+    int32_t* acc = reinterpret_cast<int32_t*>(tmp_buffer->mut_dptr<char>()
+                                              + ColBufSize(out->shape(), weight->shape()));
+    const float scale = *in_scale->dptr<float>();
+    const float* weight_scales = weight_state->scales();
+    const float* bias_ptr = bias != nullptr ? bias->dptr<float>() : nullptr;
+    FOR_RANGE(int64_t, i, 0, num_images) {
+      Int8Im2Col(params, in->dptr<int8_t>() + i * in->shape().Count(1), col);
+      Int8Gemm(out_size, filters, patch_size, col, weight_state->weight(),
+               weight_state->row_sums(), acc);
+      float* out_ptr = out->mut_dptr<float>() + i * out->shape().Count(1);
+      FOR_RANGE(int64_t, c, 0, filters) {
+        const float channel_scale = scale * weight_scales[c];
+        const float channel_bias = bias_ptr != nullptr ? bias_ptr[c] : 0.f;
+        float* out_plane = out_ptr + c * out_size;
+        FOR_RANGE(int64_t, p, 0, out_size) {
+          float value = static_cast<float>(acc[p * filters + c]) * channel_scale + channel_bias;
+          if (fuse_relu) { value = std::max(value, 0.f); }
+          out_plane[p] = value;
+        }
+      }
+    }
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+}  // namespace
+
+REGISTER_USER_KERNEL("quantized_conv2d")
+    .SetCreateFn<CpuQuantizedConv2DKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceTag() == DeviceType::kCPU)
+                     & (user_op::HobDataType("in", 0) == DataType::kInt8))
+    .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {
+      const Shape& out_shape = ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape();
+      const Shape& weight_shape = ctx->TensorDesc4ArgNameAndIndex("weight", 0)->shape();
+      return ColBufSize(out_shape, weight_shape) + out_shape.Count(1) * sizeof(int32_t);
+    });
+
+}  // namespace oneflow
@@ -0,0 +1,91 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/kernels/quantization_kernel_util.h"
+
+namespace oneflow {
+
+namespace {
+
+class CpuQuantizedMatmulKernel final : public user_op::OpKernel {
+ public:
+  CpuQuantizedMatmulKernel() = default;
+  ~CpuQuantizedMatmulKernel() = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return std::make_shared<Int8WeightState>();
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const user_op::Tensor* a = ctx->Tensor4ArgNameAndIndex("a", 0);
+    const user_op::Tensor* a_scale = ctx->Tensor4ArgNameAndIndex("a_scale", 0);
+    const user_op::Tensor* b = ctx->Tensor4ArgNameAndIndex("b", 0);
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const bool transpose_b = ctx->Attr<bool>("transpose_b");
+    const bool fuse_relu = ctx->Attr<bool>("fuse_relu");
+    const int64_t m = a->shape().At(0);
+    const int64_t k = a->shape().At(1);
+    const int64_t n = out->shape().At(1);
+
+    auto* weight_state = dynamic_cast<Int8WeightState*>(state);
+    CHECK_NOTNULL(weight_state);
+    if (!weight_state->initialized()) {
+      if (transpose_b) {
+        weight_state->Init(n, k, b->dptr<float>());
+      } else {
+        const float* b_ptr = b->dptr<float>();
+        std::vector<float> b_transposed(n * k);
+        FOR_RANGE(int64_t, p, 0, k) {
+          FOR_RANGE(int64_t, j, 0, n) { b_transposed[j * k + p] = b_ptr[p * n + j]; }
+        }
+        weight_state->Init(n, k, b_transposed.data());
+      }
+    }
+
+    int32_t* acc = tmp_buffer->mut_dptr<int32_t>();
+    Int8Gemm(m, n, k, a->dptr<int8_t>(), weight_state->weight(), weight_state->row_sums(), acc);
+
+    const float in_scale = *a_scale->dptr<float>();
+    const float* weight_scales = weight_state->scales();
+    const float* bias_ptr = bias != nullptr ? bias->dptr<float>() : nullptr;
+    float* out_ptr = out->mut_dptr<float>();
+    FOR_RANGE(int64_t, i, 0, m) {
+      FOR_RANGE(int64_t, j, 0, n) {
+        float value = static_cast<float>(acc[i * n + j]) * in_scale * weight_scales[j];
+        if (bias_ptr != nullptr) { value += bias_ptr[j]; }
+        if (fuse_relu) { value = std::max(value, 0.f); }
+        out_ptr[i * n + j] = value;
+      }
+    }
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+}  // namespace
+
+REGISTER_USER_KERNEL("quantized_matmul")
+    .SetCreateFn<CpuQuantizedMatmulKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceTag() == DeviceType::kCPU)
+                     & (user_op::HobDataType("a", 0) == DataType::kInt8))
+    .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {
+      return ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape().elem_cnt() * sizeof(int32_t);
+    });
+
+}  // namespace oneflow
@@ -61,6 +61,7 @@ REGISTER_KERNEL(CPU, int32_t)
 REGISTER_KERNEL(CPU, int64_t)
 REGISTER_KERNEL(CPU, float)
 REGISTER_KERNEL(CPU, double)
+REGISTER_KERNEL(CPU, bfloat16)
 #ifdef WITH_CUDA
 REGISTER_KERNEL(GPU, int8_t)
 REGISTER_KERNEL(GPU, int32_t)
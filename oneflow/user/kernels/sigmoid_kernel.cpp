@@ -49,6 +49,7 @@ class SigmoidKernel final : public user_op::OpKernel {
 
 REGISTER_SIGMOID_KERNEL(DeviceType::kCPU, float)
 REGISTER_SIGMOID_KERNEL(DeviceType::kCPU, double)
+REGISTER_SIGMOID_KERNEL(DeviceType::kCPU, bfloat16)
 #ifdef WITH_CUDA
 REGISTER_SIGMOID_KERNEL(DeviceType::kGPU, float)
 REGISTER_SIGMOID_KERNEL(DeviceType::kGPU, double)
@@ -86,6 +87,7 @@ class SigmoidGradKernel final : public user_op::OpKernel {
 
 REGISTER_SIGMOID_GRAD_KERNEL(DeviceType::kCPU, float)
 REGISTER_SIGMOID_GRAD_KERNEL(DeviceType::kCPU, double)
+REGISTER_SIGMOID_GRAD_KERNEL(DeviceType::kCPU, bfloat16)
 #ifdef WITH_CUDA
 REGISTER_SIGMOID_GRAD_KERNEL(DeviceType::kGPU, float)
 REGISTER_SIGMOID_GRAD_KERNEL(DeviceType::kGPU, double)
@@ -0,0 +1,318 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/kernel/new_kernel_util.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/core/common/balanced_splitter.h"
+
+namespace oneflow {
+
+namespace {
+
+constexpr int64_t kMinElemCntPerThread = 32 * 1024;
+
+// Same index mapping as the gpu kernels in upsample_kernel.cu
+int64_t GetNearestInputIndex(const int64_t out_dim_idx, const float scale,
+                             const int64_t in_dim_size) {
+  return std::max(
+      std::min(static_cast<int64_t>(std::floor((static_cast<float>(out_dim_idx) + 0.5f) * scale)),
+               in_dim_size - 1),
+      static_cast<int64_t>(0));
+}
+
+std::vector<int64_t> GetNearestIndexTable(const int64_t out_size, const float scale,
+                                          const int64_t in_size) {
+  std::vector<int64_t> table(out_size);
+  FOR_RANGE(int64_t, i, 0, out_size) { table[i] = GetNearestInputIndex(i, scale, in_size); }
+  return table;
+}
+
+struct BilinearTable {
+  std::vector<int64_t> lo_index;
+  std::vector<int64_t> hi_index;
+  std::vector<float> lerp;
+};
+
+BilinearTable GetBilinearTable(const int64_t out_size, const float scale, const int64_t in_size) {
+  BilinearTable table;
+  table.lo_index.resize(out_size);
+  table.hi_index.resize(out_size);
+  table.lerp.resize(out_size);
+  FOR_RANGE(int64_t, i, 0, out_size) {
+    const float in = (static_cast<float>(i) + 0.5f) * scale - 0.5f;
+    table.lo_index[i] = in > 0.0 ? std::floor(in) : 0;
+    table.hi_index[i] = in < in_size - 1 ? std::ceil(in) : in_size - 1;
+    table.lerp[i] = in - std::floor(in);
+  }
+  return table;
+}
+
+// x and y are NCHW, every one of the N * C planes is owned by exactly one thread so that the
+// backward kernels can accumulate into dx without atomics.
+template<typename F>
+void ForEachPlaneRange(const ShapeView& x_shape, const ShapeView& y_shape, const F& Fn) {
+  const int64_t plane_cnt = x_shape.At(0) * x_shape.At(1);
+  const int64_t elem_cnt = std::max(x_shape.elem_cnt(), y_shape.elem_cnt());
+  const int64_t max_thread_num = Global<ThreadPool>::Get()->thread_num();
+  const int64_t thread_num = std::max<int64_t>(
+      std::min<int64_t>({max_thread_num, elem_cnt / kMinElemCntPerThread, plane_cnt}), 1);
+  const BalancedSplitter bs(plane_cnt, thread_num);
+  MultiThreadLoop(thread_num, [&](size_t thread_id) {
+    const Range range = bs.At(thread_id);
+    Fn(range.begin(), range.end());
+  });
+}
+
+template<typename T>
+void UpsampleNearestForward(const ShapeView& x_shape, const ShapeView& y_shape, const T* x,
+                            const float scale_h, const float scale_w, T* y) {
+  const int64_t in_h = x_shape.At(2);
+  const int64_t in_w = x_shape.At(3);
+  const int64_t out_h = y_shape.At(2);
+  const int64_t out_w = y_shape.At(3);
+  const std::vector<int64_t> h_index = GetNearestIndexTable(out_h, scale_h, in_h);
+  const std::vector<int64_t> w_index = GetNearestIndexTable(out_w, scale_w, in_w);
+  ForEachPlaneRange(x_shape, y_shape, [&](int64_t plane_begin, int64_t plane_end) {
+    FOR_RANGE(int64_t, plane, plane_begin, plane_end) {
+      const T* x_plane = x + plane * in_h * in_w;
+      T* y_plane = y + plane * out_h * out_w;
+      FOR_RANGE(int64_t, oh, 0, out_h) {
+        const T* x_row = x_plane + h_index[oh] * in_w;
+        T* y_row = y_plane + oh * out_w;
+        if (oh > 0 && h_index[oh] == h_index[oh - 1]) {
+          std::copy(y_row - out_w, y_row, y_row);
+        } else {
+          FOR_RANGE(int64_t, ow, 0, out_w) { y_row[ow] = x_row[w_index[ow]]; }
+        }
+      }
+    }
+  });
+}
+
+template<typename T>
+void UpsampleNearestBackward(const ShapeView& dy_shape, const ShapeView& dx_shape, const T* dy,
+                             const float scale_h, const float scale_w, T* dx) {
+  const int64_t in_h = dx_shape.At(2);
+  const int64_t in_w = dx_shape.At(3);
+  const int64_t out_h = dy_shape.At(2);
+  const int64_t out_w = dy_shape.At(3);
+  const std::vector<int64_t> h_index = GetNearestIndexTable(out_h, scale_h, in_h);
+  const std::vector<int64_t> w_index = GetNearestIndexTable(out_w, scale_w, in_w);
+  ForEachPlaneRange(dx_shape, dy_shape, [&](int64_t plane_begin, int64_t plane_end) {
+    T* dx_begin = dx + plane_begin * in_h * in_w;
+    std::fill(dx_begin, dx + plane_end * in_h * in_w, GetZeroVal<T>());
+    FOR_RANGE(int64_t, plane, plane_begin, plane_end) {
+      const T* dy_plane = dy + plane * out_h * out_w;
+      T* dx_plane = dx + plane * in_h * in_w;
+      FOR_RANGE(int64_t, oh, 0, out_h) {
+        const T* dy_row = dy_plane + oh * out_w;
+        T* dx_row = dx_plane + h_index[oh] * in_w;
+        FOR_RANGE(int64_t, ow, 0, out_w) { dx_row[w_index[ow]] += dy_row[ow]; }
+      }
+    }
+  });
+}
+
+template<typename T>
+void UpsampleBilinearForward(const ShapeView& x_shape, const ShapeView& y_shape, const T* x,
+                             const float scale_h, const float scale_w, T* y) {
+  const int64_t in_h = x_shape.At(2);
+  const int64_t in_w = x_shape.At(3);
+  const int64_t out_h = y_shape.At(2);
+  const int64_t out_w = y_shape.At(3);
+  const BilinearTable h_table = GetBilinearTable(out_h, scale_h, in_h);
+  const BilinearTable w_table = GetBilinearTable(out_w, scale_w, in_w);
+  ForEachPlaneRange(x_shape, y_shape, [&](int64_t plane_begin, int64_t plane_end) {
+    // rows of x interpolated along w, the vertical lerp is then a contiguous loop along w
+    std::vector<T> top_buf(out_w);
+    std::vector<T> bottom_buf(out_w);
+    const auto LerpRow = [&](const T* x_row, T* out) {
+      FOR_RANGE(int64_t, ow, 0, out_w) {
+        const T left = x_row[w_table.lo_index[ow]];
+        const T right = x_row[w_table.hi_index[ow]];
+        out[ow] = left + (right - left) * static_cast<T>(w_table.lerp[ow]);
+      }
+    };
+    FOR_RANGE(int64_t, plane, plane_begin, plane_end) {
+      const T* x_plane = x + plane * in_h * in_w;
+      T* y_plane = y + plane * out_h * out_w;
+      int64_t top_cached = -1;
+      int64_t bottom_cached = -1;
+      FOR_RANGE(int64_t, oh, 0, out_h) {
+        const int64_t top_h = h_table.lo_index[oh];
+        const int64_t bottom_h = h_table.hi_index[oh];
+        if (top_h != top_cached) {
+          if (top_h == bottom_cached) {
+            std::swap(top_buf, bottom_buf);
+            bottom_cached = -1;
+          } else {
+            LerpRow(x_plane + top_h * in_w, top_buf.data());
+          }
+          top_cached = top_h;
+        }
+        if (bottom_h != bottom_cached) {
+          LerpRow(x_plane + bottom_h * in_w, bottom_buf.data());
+          bottom_cached = bottom_h;
+        }
+        const T h_lerp = static_cast<T>(h_table.lerp[oh]);
+        const T* top = top_buf.data();
+        const T* bottom = bottom_buf.data();
+        T* y_row = y_plane + oh * out_w;
+        FOR_RANGE(int64_t, ow, 0, out_w) { y_row[ow] = top[ow] + (bottom[ow] - top[ow]) * h_lerp; }
+      }
+    }
+  });
+}
+
+template<typename T>
+void UpsampleBilinearBackward(const ShapeView& dy_shape, const ShapeView& dx_shape, const T* dy,
+                              const float scale_h, const float scale_w, T* dx) {
+  const int64_t in_h = dx_shape.At(2);
+  const int64_t in_w = dx_shape.At(3);
+  const int64_t out_h = dy_shape.At(2);
+  const int64_t out_w = dy_shape.At(3);
+  const BilinearTable h_table = GetBilinearTable(out_h, scale_h, in_h);
+  const BilinearTable w_table = GetBilinearTable(out_w, scale_w, in_w);
+  ForEachPlaneRange(dx_shape, dy_shape, [&](int64_t plane_begin, int64_t plane_end) {
+    std::fill(dx + plane_begin * in_h * in_w, dx + plane_end * in_h * in_w, GetZeroVal<T>());
+    std::vector<T> dtop_buf(out_w);
+    std::vector<T> dbottom_buf(out_w);
+    const auto ScatterRow = [&](const T* drow, T* dx_row) {
+      FOR_RANGE(int64_t, ow, 0, out_w) {
+        const T w_lerp = static_cast<T>(w_table.lerp[ow]);
+        dx_row[w_table.lo_index[ow]] += (1 - w_lerp) * drow[ow];
+        dx_row[w_table.hi_index[ow]] += w_lerp * drow[ow];
+      }
+    };
+    FOR_RANGE(int64_t, plane, plane_begin, plane_end) {
+      const T* dy_plane = dy + plane * out_h * out_w;
+      T* dx_plane = dx + plane * in_h * in_w;
+      FOR_RANGE(int64_t, oh, 0, out_h) {
+        const T h_lerp = static_cast<T>(h_table.lerp[oh]);
+        const T* dy_row = dy_plane + oh * out_w;
+        T* dtop = dtop_buf.data();
+        T* dbottom = dbottom_buf.data();
+        FOR_RANGE(int64_t, ow, 0, out_w) {
+          dbottom[ow] = h_lerp * dy_row[ow];
+          dtop[ow] = dy_row[ow] - dbottom[ow];
+        }
+        ScatterRow(dbottom, dx_plane + h_table.hi_index[oh] * in_w);
+        ScatterRow(dtop, dx_plane + h_table.lo_index[oh] * in_w);
+      }
+    }
+  });
+}
+
+}  // namespace
+
+template<typename T>
+class UpsampleNearestCPUKernel final : public user_op::OpKernel {
+ public:
+  UpsampleNearestCPUKernel() = default;
+  ~UpsampleNearestCPUKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* x_blob = ctx->Tensor4ArgNameAndIndex("x", 0);
+    user_op::Tensor* y_blob = ctx->Tensor4ArgNameAndIndex("y", 0);
+    const float height_scale = ctx->Attr<float>("height_scale");
+    const float width_scale = ctx->Attr<float>("width_scale");
+    UpsampleNearestForward<T>(x_blob->shape(), y_blob->shape(), x_blob->dptr<T>(),
+                              1.f / height_scale, 1.f / width_scale, y_blob->mut_dptr<T>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T>
+class UpsampleNearestGradCPUKernel final : public user_op::OpKernel {
+ public:
+  UpsampleNearestGradCPUKernel() = default;
+  ~UpsampleNearestGradCPUKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    user_op::Tensor* dx_blob = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    if (dx_blob == nullptr) { return; }
+    const user_op::Tensor* dy_blob = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const float height_scale = ctx->Attr<float>("height_scale");
+    const float width_scale = ctx->Attr<float>("width_scale");
+    UpsampleNearestBackward<T>(dy_blob->shape(), dx_blob->shape(), dy_blob->dptr<T>(),
+                               1.f / height_scale, 1.f / width_scale, dx_blob->mut_dptr<T>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T>
+class UpsampleBilinearCPUKernel final : public user_op::OpKernel {
+ public:
+  UpsampleBilinearCPUKernel() = default;
+  ~UpsampleBilinearCPUKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* x_blob = ctx->Tensor4ArgNameAndIndex("x", 0);
+    user_op::Tensor* y_blob = ctx->Tensor4ArgNameAndIndex("y", 0);
+    const float height_scale = ctx->Attr<float>("height_scale");
+    const float width_scale = ctx->Attr<float>("width_scale");
+    UpsampleBilinearForward<T>(x_blob->shape(), y_blob->shape(), x_blob->dptr<T>(),
+                               1.f / height_scale, 1.f / width_scale, y_blob->mut_dptr<T>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T>
+class UpsampleBilinearGradCPUKernel final : public user_op::OpKernel {
+ public:
+  UpsampleBilinearGradCPUKernel() = default;
+  ~UpsampleBilinearGradCPUKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    user_op::Tensor* dx_blob = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    if (dx_blob == nullptr) { return; }
+    const user_op::Tensor* dy_blob = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const float height_scale = ctx->Attr<float>("height_scale");
+    const float width_scale = ctx->Attr<float>("width_scale");
+    UpsampleBilinearBackward<T>(dy_blob->shape(), dx_blob->shape(), dy_blob->dptr<T>(),
+                                1.f / height_scale, 1.f / width_scale, dx_blob->mut_dptr<T>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_UPSAMPLE_CPU_KERNEL(dtype, interpolation_name, kernel, grad_kernel)         \
+  REGISTER_USER_KERNEL("upsample")                                                          \
+      .SetCreateFn<kernel<dtype>>()                                                         \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                   \
+                       & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value)        \
+                       & (user_op::HobAttr<std::string>("interpolation")                    \
+                          == std::string(interpolation_name)));                             \
+  REGISTER_USER_KERNEL("upsample_grad")                                                     \
+      .SetCreateFn<grad_kernel<dtype>>()                                                    \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                   \
+                       & (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value)       \
+                       & (user_op::HobAttr<std::string>("interpolation")                    \
+                          == std::string(interpolation_name)));
+
+REGISTER_UPSAMPLE_CPU_KERNEL(float, "nearest", UpsampleNearestCPUKernel,
+                             UpsampleNearestGradCPUKernel)
+REGISTER_UPSAMPLE_CPU_KERNEL(double, "nearest", UpsampleNearestCPUKernel,
+                             UpsampleNearestGradCPUKernel)
+REGISTER_UPSAMPLE_CPU_KERNEL(float, "bilinear", UpsampleBilinearCPUKernel,
+                             UpsampleBilinearGradCPUKernel)
+REGISTER_UPSAMPLE_CPU_KERNEL(double, "bilinear", UpsampleBilinearCPUKernel,
+                             UpsampleBilinearGradCPUKernel)
+
+}  // namespace oneflow
@@ -23,6 +23,7 @@ REGISTER_USER_OP("CategoricalOrdinalEncode")
     .Input("in")
     .Output("out")
     .Attr<bool>("hash_precomputed")
+    .Attr<bool>("allow_overflow", false)
     .SetPhysicalTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
       const DataType data_type = *ctx->Dtype4ArgNameAndIndex("in", 0);
       CHECK_OR_RETURN(IsIndexDataType(data_type));
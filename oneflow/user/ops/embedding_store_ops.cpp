@@ -0,0 +1,179 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+Maybe<void> CheckIdsTensorDesc(user_op::InferContext* ctx) {
+  CHECK_EQ_OR_RETURN(ctx->parallel_ctx().parallel_num(), 1);
+  CHECK_EQ_OR_RETURN(*ctx->Dtype4ArgNameAndIndex("ids", 0), DataType::kInt64);
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> CheckShadowTensorDesc(user_op::InferContext* ctx) {
+  CHECK_EQ_OR_RETURN(*ctx->Shape4ArgNameAndIndex("shadow", 0), Shape({1}));
+  CHECK_EQ_OR_RETURN(*ctx->Dtype4ArgNameAndIndex("shadow", 0), DataType::kFloat);
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> CheckEmbeddingStoreAttr(const user_op::UserOpDefWrapper& op_def,
+                                    const user_op::UserOpConfWrapper& op_conf) {
+  CHECK_OR_RETURN(!op_conf.attr<std::string>("path").empty());
+  CHECK_GT_OR_RETURN(op_conf.attr<int64_t>("num_rows"), 0);
+  CHECK_GT_OR_RETURN(op_conf.attr<int64_t>("embedding_dim"), 0);
+  CHECK_GT_OR_RETURN(op_conf.attr<int64_t>("cache_capacity"), 0);
+  const std::string& optimizer = op_conf.attr<std::string>("optimizer");
+  CHECK_OR_RETURN(optimizer == "sgd" || optimizer == "adam")
+      << "unsupported embedding store optimizer " << optimizer;
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+// The attrs of all the ops below describe the same store, see core/embedding/embedding_store.h.
+// optimizer decides how many states every row keeps, so it is shared by them too.
+REGISTER_USER_OP("embedding_prefetch")
+    .Input("ids")
+    .Output("out")
+    .Attr<std::string>("path")
+    .Attr<int64_t>("num_rows")
+    .Attr<int64_t>("embedding_dim")
+    .Attr<int64_t>("cache_capacity")
+    .Attr<float>("initializer_range")
+    .Attr<int64_t>("seed")
+    .Attr<std::string>("optimizer", "sgd")
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      JUST(CheckIdsTensorDesc(ctx));
+      *ctx->TensorDesc4ArgNameAndIndex("out", 0) = *ctx->TensorDesc4ArgNameAndIndex("ids", 0);
+      return Maybe<void>::Ok();
+    })
+    .SetInputArgModifyFn([](user_op::GetInputArgModifier GetInputArgModifierFn,
+                            const user_op::UserOpConfWrapper&) {
+      user_op::InputArgModifier* ids = GetInputArgModifierFn("ids", 0);
+      CHECK(ids != nullptr);
+      ids->set_requires_grad(false);
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      CHECK_EQ_OR_RETURN(ctx->parallel_num(), 1);
+      return Maybe<void>::Ok();
+    })
+    .SetCheckAttrFn(CheckEmbeddingStoreAttr);
+
+// shadow is a trainable variable of shape (1,) standing for the table in the job, so that the
+// backward pass generates embedding_update, whose output is the (zero) gradient of shadow.
+REGISTER_USER_OP("embedding_lookup")
+    .Input("shadow")
+    .Input("ids")
+    .Output("embeddings")
+    .Attr<std::string>("path")
+    .Attr<int64_t>("num_rows")
+    .Attr<int64_t>("embedding_dim")
+    .Attr<int64_t>("cache_capacity")
+    .Attr<float>("initializer_range")
+    .Attr<int64_t>("seed")
+    .Attr<std::string>("optimizer", "sgd")
+    .Attr<float>("learning_rate", 0.001)
+    .Attr<float>("beta1", 0.9)
+    .Attr<float>("beta2", 0.999)
+    .Attr<float>("epsilon", 1e-8)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      JUST(CheckIdsTensorDesc(ctx));
+      JUST(CheckShadowTensorDesc(ctx));
+      DimVector dim_vec = ctx->Shape4ArgNameAndIndex("ids", 0)->dim_vec();
+      dim_vec.push_back(ctx->Attr<int64_t>("embedding_dim"));
+      *ctx->Shape4ArgNameAndIndex("embeddings", 0) = Shape(dim_vec);
+      *ctx->Dtype4ArgNameAndIndex("embeddings", 0) = DataType::kFloat;
+      return Maybe<void>::Ok();
+    })
+    .SetInputArgModifyFn([](user_op::GetInputArgModifier GetInputArgModifierFn,
+                            const user_op::UserOpConfWrapper&) {
+      user_op::InputArgModifier* ids = GetInputArgModifierFn("ids", 0);
+      CHECK(ids != nullptr);
+      ids->set_requires_grad(false);
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      CHECK_EQ_OR_RETURN(ctx->parallel_num(), 1);
+      return Maybe<void>::Ok();
+    })
+    .SetCheckAttrFn(CheckEmbeddingStoreAttr);
+
+// Applies the optimizer to the rows of ids in place, in the store. Rows without gradients are
+// left untouched, so adam is lazy here and its moments are not bias corrected.
+REGISTER_USER_OP("embedding_update")
+    .Input("shadow")
+    .Input("ids")
+    .Input("embedding_diff")
+    .Output("shadow_diff")
+    .Attr<std::string>("path")
+    .Attr<int64_t>("num_rows")
+    .Attr<int64_t>("embedding_dim")
+    .Attr<int64_t>("cache_capacity")
+    .Attr<float>("initializer_range")
+    .Attr<int64_t>("seed")
+    .Attr<std::string>("optimizer", "sgd")
+    .Attr<float>("learning_rate", 0.001)
+    .Attr<float>("beta1", 0.9)
+    .Attr<float>("beta2", 0.999)
+    .Attr<float>("epsilon", 1e-8)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      JUST(CheckIdsTensorDesc(ctx));
+      JUST(CheckShadowTensorDesc(ctx));
+      const user_op::TensorDesc* embedding_diff =
+          ctx->TensorDesc4ArgNameAndIndex("embedding_diff", 0);
+      CHECK_EQ_OR_RETURN(embedding_diff->data_type(), DataType::kFloat);
+      DimVector dim_vec = ctx->Shape4ArgNameAndIndex("ids", 0)->dim_vec();
+      dim_vec.push_back(ctx->Attr<int64_t>("embedding_dim"));
+      CHECK_EQ_OR_RETURN(embedding_diff->shape(), Shape(dim_vec));
+      *ctx->TensorDesc4ArgNameAndIndex("shadow_diff", 0) =
+          *ctx->TensorDesc4ArgNameAndIndex("shadow", 0);
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      CHECK_EQ_OR_RETURN(ctx->parallel_num(), 1);
+      return Maybe<void>::Ok();
+    })
+    .SetCheckAttrFn(CheckEmbeddingStoreAttr);
+
+REGISTER_USER_OP_GRAD("embedding_lookup")
+    .SetGenBackwardOpConfFn([](const user_op::UserOpWrapper& op, user_op::AddOpFn AddOp) {
+      if (op.NeedGenGradTensor4OpInput("shadow", 0)) {
+        user_op::UserOpConfWrapperBuilder builder(op.op_name() + "_update");
+        user_op::UserOpConfWrapper update_op =
+            builder.Op("embedding_update")
+                .Input("shadow", op.input("shadow", 0))
+                .Input("ids", op.input("ids", 0))
+                .Input("embedding_diff", op.GetGradTensorWithOpOutput("embeddings", 0))
+                .Output("shadow_diff")
+                .Attr("path", op.attr<std::string>("path"))
+                .Attr("num_rows", op.attr<int64_t>("num_rows"))
+                .Attr("embedding_dim", op.attr<int64_t>("embedding_dim"))
+                .Attr("cache_capacity", op.attr<int64_t>("cache_capacity"))
+                .Attr("initializer_range", op.attr<float>("initializer_range"))
+                .Attr("seed", op.attr<int64_t>("seed"))
+                .Attr("optimizer", op.attr<std::string>("optimizer"))
+                .Attr("learning_rate", op.attr<float>("learning_rate"))
+                .Attr("beta1", op.attr<float>("beta1"))
+                .Attr("beta2", op.attr<float>("beta2"))
+                .Attr("epsilon", op.attr<float>("epsilon"))
+                .Build();
+        op.BindGradTensorWithOpInput(update_op.output("shadow_diff", 0), "shadow", 0);
+        AddOp(update_op);
+      }
+    });
+
+}  // namespace oneflow
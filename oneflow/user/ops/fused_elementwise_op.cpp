@@ -0,0 +1,79 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+// NOTE: the op runs a straight-line program produced by FuseElementwiseOpsPass. Registers
+// [0, num_inputs) hold the inputs, instruction i reads operands[2 * i] and operands[2 * i + 1]
+// (-1 for unary instructions) and writes register num_inputs + i, the last register is the
+// output. Input i is read at ((j / input_inner_sizes[i]) % in_i.elem_cnt) for output element j,
+// which covers both same-shape inputs (inner size 1) and bias_add style broadcasting.
+REGISTER_USER_OP("fused_elementwise")
+    .InputWithMinimum("in", 1)
+    .Output("out")
+    .Attr<std::vector<std::string>>("instructions")
+    .Attr<std::vector<int32_t>>("operands")
+    .Attr<std::vector<float>>("scalars")
+    .Attr<std::vector<int64_t>>("input_inner_sizes")
+    .SetCheckAttrFn([](const user_op::UserOpDefWrapper& def,
+                       const user_op::UserOpConfWrapper& conf) -> Maybe<void> {
+      const int32_t num_inputs = conf.input_size("in");
+      const auto& instructions = conf.attr<std::vector<std::string>>("instructions");
+      const auto& operands = conf.attr<std::vector<int32_t>>("operands");
+      CHECK_GT_OR_RETURN(instructions.size(), 0);
+      CHECK_EQ_OR_RETURN(operands.size(), instructions.size() * 2);
+      CHECK_EQ_OR_RETURN(conf.attr<std::vector<float>>("scalars").size(), instructions.size());
+      CHECK_EQ_OR_RETURN(conf.attr<std::vector<int64_t>>("input_inner_sizes").size(), num_inputs);
+      FOR_RANGE(int32_t, i, 0, instructions.size()) {
+        CHECK_GE_OR_RETURN(operands.at(2 * i), 0);
+        CHECK_LT_OR_RETURN(operands.at(2 * i), num_inputs + i);
+        CHECK_GE_OR_RETURN(operands.at(2 * i + 1), -1);
+        CHECK_LT_OR_RETURN(operands.at(2 * i + 1), num_inputs + i);
+      }
+      return Maybe<void>::Ok();
+    })
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const auto& input_inner_sizes = ctx->Attr<std::vector<int64_t>>("input_inner_sizes");
+      CHECK_EQ_OR_RETURN(input_inner_sizes.at(0), 1);
+      const user_op::TensorDesc* in_0 = ctx->TensorDesc4ArgNameAndIndex("in", 0);
+      FOR_RANGE(int32_t, i, 1, ctx->user_op_conf().input_size("in")) {
+        const user_op::TensorDesc* in_i = ctx->TensorDesc4ArgNameAndIndex("in", i);
+        if (input_inner_sizes.at(i) == 1) { CHECK_EQ_OR_RETURN(in_i->shape(), in_0->shape()); }
+      }
+      *ctx->TensorDesc4ArgNameAndIndex("out", 0) = *in_0;
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      // NOTE: the pass only fuses broadcast inputs whose period divides a row of axis 0
+      const auto& input_inner_sizes = ctx->Attr<std::vector<int64_t>>("input_inner_sizes");
+      const user_op::TensorDesc& in_0 = ctx->LogicalTensorDesc4InputArgNameAndIndex("in", 0);
+      if (in_0.shape().NumAxes() > 0) {
+        user_op::UserOpSbpSignatureBuilder builder = ctx->NewBuilder();
+        builder.Split(user_op::OpArg("out", 0), 0);
+        FOR_RANGE(int32_t, i, 0, input_inner_sizes.size()) {
+          if (input_inner_sizes.at(i) == 1) {
+            builder.Split(user_op::OpArg("in", i), 0);
+          } else {
+            builder.Broadcast(user_op::OpArg("in", i));
+          }
+        }
+        builder.Build();
+      }
+      return Maybe<void>::Ok();
+    });
+
+}  // namespace oneflow
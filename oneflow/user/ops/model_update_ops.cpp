@@ -131,6 +131,30 @@ Maybe<void> InferAdamUpdateTensorDesc(user_op::InferContext* ctx) {
   return Maybe<void>::Ok();
 }
 
+Maybe<void> InferMultiTensorUpdateTensorDesc(user_op::InferContext* ctx,
+                                             const std::vector<std::string>& state_arg_names) {
+  const int64_t num_tensors = ctx->user_op_conf().input_size("model");
+  CHECK_GT_OR_RETURN(num_tensors, 0);
+  CHECK_EQ_OR_RETURN(ctx->user_op_conf().input_size("model_diff"), num_tensors);
+  const DataType data_type = ctx->TensorDesc4ArgNameAndIndex("model", 0)->data_type();
+  FOR_RANGE(int64_t, i, 0, num_tensors) {
+    const user_op::TensorDesc* model = ctx->TensorDesc4ArgNameAndIndex("model", i);
+    CHECK_EQ_OR_RETURN(model->data_type(), data_type);
+    JUST(CheckTensorDescLike(ctx->TensorDesc4ArgNameAndIndex("model_diff", i), model));
+    for (const std::string& state_arg_name : state_arg_names) {
+      CHECK_EQ_OR_RETURN(ctx->user_op_conf().input_size(state_arg_name), num_tensors);
+      JUST(CheckTensorDescLike(ctx->TensorDesc4ArgNameAndIndex(state_arg_name, i), model));
+    }
+  }
+  const user_op::TensorDesc* learning_rate = ctx->TensorDesc4ArgNameAndIndex("learning_rate", 0);
+  JUST(CheckLearningRateTenserDesc(learning_rate));
+  if (ctx->user_op_conf().has_input("scale_by_tensor", 0)) {
+    const auto* scale_by_tensor = ctx->TensorDesc4ArgNameAndIndex("scale_by_tensor", 0);
+    JUST(CheckScalarTensorDesc(scale_by_tensor, data_type));
+  }
+  return Maybe<void>::Ok();
+}
+
 Maybe<void> InferIndexedSlicesAdamUpdateTensorDesc(user_op::InferContext* ctx) {
   const user_op::TensorDesc* model = ctx->TensorDesc4ArgNameAndIndex("model", 0);
   const user_op::TensorDesc* model_diff_indices =
@@ -186,6 +210,17 @@ void AdamInputArgModifyFn(const user_op::GetInputArgModifier& GetInputArgModifie
   SetInputArgModifierMutable(GetInputArgModifierFn, "v", 0);
 }
 
+void MultiTensorUpdateInputArgModifyFn(const user_op::GetInputArgModifier& GetInputArgModifierFn,
+                                       const user_op::UserOpConfWrapper& conf,
+                                       const std::vector<std::string>& state_arg_names) {
+  FOR_RANGE(int32_t, i, 0, conf.input_size("model")) {
+    SetInputArgModifierMutable(GetInputArgModifierFn, "model", i);
+    for (const std::string& state_arg_name : state_arg_names) {
+      SetInputArgModifierMutable(GetInputArgModifierFn, state_arg_name, i);
+    }
+  }
+}
+
 void LambInputArgModifyFn(const user_op::GetInputArgModifier& GetInputArgModifierFn,
                           const user_op::UserOpConfWrapper& conf) {
   SetInputArgModifierMutable(GetInputArgModifierFn, "model", 0);
@@ -552,6 +587,59 @@ REGISTER_USER_OP("lars_update")
       SetInputArgModifierMutable(GetInputArgModifierFn, "momentum", 0);
     });
 
+
+// the multi-tensor ops update many broadcast variables with one kernel, they are only created by
+// FuseUpdateOpsPass from sgd_update and adam_update ops sharing the same attrs and placement
+
+REGISTER_USER_OP("multi_tensor_sgd_update")
+    .InputWithMinimum("model", 1)
+    .InputWithMinimum("model_diff", 1)
+    .Input("learning_rate")
+    .OptionalInput("scale_by_tensor")
+    .OptionalInput("skip_if")
+    .Attr<double>("scale", 1.0)
+    .Attr<float>("l1", 0.0)
+    .Attr<float>("l2", 0.0)
+    .Attr<float>("weight_decay", 0.0)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      return InferMultiTensorUpdateTensorDesc(ctx, {});
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder().Broadcast(ctx->inputs()).Build();
+      return Maybe<void>::Ok();
+    })
+    .SetInputArgModifyFn([](const user_op::GetInputArgModifier& GetInputArgModifierFn,
+                            const user_op::UserOpConfWrapper& conf) -> void {
+      MultiTensorUpdateInputArgModifyFn(GetInputArgModifierFn, conf, {});
+    });
+
+REGISTER_USER_OP("multi_tensor_adam_update")
+    .InputWithMinimum("model", 1)
+    .InputWithMinimum("model_diff", 1)
+    .Input("learning_rate")
+    .OptionalInput("scale_by_tensor")
+    .OptionalInput("skip_if")
+    .InputWithMinimum("m", 1)
+    .InputWithMinimum("v", 1)
+    .Attr<double>("scale", 1.0)
+    .Attr<float>("l1", 0.0)
+    .Attr<float>("l2", 0.0)
+    .Attr<float>("beta1", 0.9)
+    .Attr<float>("beta2", 0.999)
+    .Attr<float>("epsilon", 1e-8)
+    .Attr<float>("weight_decay", 0.0)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      return InferMultiTensorUpdateTensorDesc(ctx, {"m", "v"});
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder().Broadcast(ctx->inputs()).Build();
+      return Maybe<void>::Ok();
+    })
+    .SetInputArgModifyFn([](const user_op::GetInputArgModifier& GetInputArgModifierFn,
+                            const user_op::UserOpConfWrapper& conf) -> void {
+      MultiTensorUpdateInputArgModifyFn(GetInputArgModifierFn, conf, {"m", "v"});
+    });
+
 }  // namespace
 
 }  // namespace oneflow
@@ -0,0 +1,104 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+Maybe<void> CheckScaleTensorDesc(const user_op::TensorDesc* scale) {
+  CHECK_EQ_OR_RETURN(scale->shape(), Shape({1}));
+  CHECK_EQ_OR_RETURN(scale->data_type(), DataType::kFloat);
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> GetQuantizeSbpSignatures(user_op::SbpContext* ctx) {
+  const user_op::TensorDesc& in_tensor = ctx->LogicalTensorDesc4InputArgNameAndIndex("in", 0);
+  FOR_RANGE(int64_t, i, 0, in_tensor.shape().NumAxes()) {
+    ctx->NewBuilder()
+        .Split(user_op::OpArg("in", 0), i)
+        .Broadcast(user_op::OpArg("scale", 0))
+        .Split(user_op::OpArg("out", 0), i)
+        .Build();
+  }
+  return Maybe<void>::Ok();
+}
+
+void SetScaleInputArgModifier(user_op::GetInputArgModifier GetInputArgModifierFn,
+                              const user_op::UserOpConfWrapper&) {
+  user_op::InputArgModifier* scale = GetInputArgModifierFn("scale", 0);
+  CHECK(scale != nullptr);
+  scale->set_requires_grad(false);
+}
+
+}  // namespace
+
+REGISTER_USER_OP("quantize")
+    .Input("in")
+    .Input("scale")
+    .Output("out")
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* in = ctx->TensorDesc4ArgNameAndIndex("in", 0);
+      CHECK_EQ_OR_RETURN(in->data_type(), DataType::kFloat);
+      JUST(CheckScaleTensorDesc(ctx->TensorDesc4ArgNameAndIndex("scale", 0)));
+      user_op::TensorDesc* out = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      *out = *in;
+      *out->mut_data_type() = DataType::kInt8;
+      return Maybe<void>::Ok();
+    })
+    .SetInputArgModifyFn(SetScaleInputArgModifier)
+    .SetGetSbpFn(GetQuantizeSbpSignatures);
+
+REGISTER_USER_OP("dequantize")
+    .Input("in")
+    .Input("scale")
+    .Output("out")
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* in = ctx->TensorDesc4ArgNameAndIndex("in", 0);
+      CHECK_EQ_OR_RETURN(in->data_type(), DataType::kInt8);
+      JUST(CheckScaleTensorDesc(ctx->TensorDesc4ArgNameAndIndex("scale", 0)));
+      user_op::TensorDesc* out = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      *out = *in;
+      *out->mut_data_type() = DataType::kFloat;
+      return Maybe<void>::Ok();
+    })
+    .SetInputArgModifyFn(SetScaleInputArgModifier)
+    .SetGetSbpFn(GetQuantizeSbpSignatures);
+
+REGISTER_USER_OP("int8_calibration")
+    .Input("in")
+    .Input("scale")  // NOTE: needs to be initialized as 0
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      CHECK_EQ_OR_RETURN(*ctx->Dtype4ArgNameAndIndex("in", 0), DataType::kFloat);
+      return CheckScaleTensorDesc(ctx->TensorDesc4ArgNameAndIndex("scale", 0));
+    })
+    .SetInputArgModifyFn([](user_op::GetInputArgModifier GetInputArgModifierFn,
+                            const user_op::UserOpConfWrapper&) {
+      user_op::InputArgModifier* in = GetInputArgModifierFn("in", 0);
+      CHECK(in != nullptr);
+      in->set_requires_grad(false);
+
+      user_op::InputArgModifier* scale = GetInputArgModifierFn("scale", 0);
+      CHECK(scale != nullptr);
+      scale->set_requires_grad(false);
+      scale->set_is_mutable(true);
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      // NOTE: input needs to be broadcast in order to observe the global max
+      return Maybe<void>::Ok();
+    });
+
+}  // namespace oneflow
@@ -0,0 +1,80 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/ops/nn_util.h"
+
+namespace oneflow {
+
+REGISTER_USER_OP("quantized_conv2d")
+    .Input("in")        // int8, quantized with in_scale
+    .Input("in_scale")  // float, shape (1,)
+    .Input("weight")    // float, quantized per output channel by the kernel
+    .OptionalInput("bias")
+    .Output("out")  // float
+    .Attr<int32_t>("filters")
+    .Attr<std::vector<int32_t>>("padding_before")
+    .Attr<std::string>("data_format")
+    .Attr<std::vector<int32_t>>("kernel_size")
+    .Attr<std::vector<int32_t>>("strides")
+    .Attr<std::vector<int32_t>>("dilation_rate")
+    .Attr<bool>("fuse_relu", false)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* in = ctx->TensorDesc4ArgNameAndIndex("in", 0);
+      CHECK_EQ_OR_RETURN(in->shape().NumAxes(), 4);
+      CHECK_EQ_OR_RETURN(in->data_type(), DataType::kInt8);
+      CHECK_EQ_OR_RETURN(ctx->Attr<std::string>("data_format"), "channels_first");
+      const user_op::TensorDesc* in_scale = ctx->TensorDesc4ArgNameAndIndex("in_scale", 0);
+      CHECK_EQ_OR_RETURN(in_scale->shape(), Shape({1}));
+      CHECK_EQ_OR_RETURN(in_scale->data_type(), DataType::kFloat);
+
+      const int32_t filters = ctx->Attr<int32_t>("filters");
+      const auto& kernel_size = ctx->Attr<std::vector<int32_t>>("kernel_size");
+      const auto& padding_before = ctx->Attr<std::vector<int32_t>>("padding_before");
+      const auto& dilation_rate = ctx->Attr<std::vector<int32_t>>("dilation_rate");
+      const auto& strides = ctx->Attr<std::vector<int32_t>>("strides");
+      CHECK_EQ_OR_RETURN(kernel_size.size(), 2);
+      CHECK_EQ_OR_RETURN(padding_before.size(), 2);
+      CHECK_EQ_OR_RETURN(dilation_rate.size(), 2);
+      CHECK_EQ_OR_RETURN(strides.size(), 2);
+
+      const user_op::TensorDesc* weight = ctx->TensorDesc4ArgNameAndIndex("weight", 0);
+      CHECK_EQ_OR_RETURN(weight->data_type(), DataType::kFloat);
+      CHECK_EQ_OR_RETURN(weight->shape(), Shape({filters, in->shape().At(1), kernel_size.at(0),
+                                                 kernel_size.at(1)}));
+      const user_op::TensorDesc* bias = ctx->TensorDesc4ArgNameAndIndex("bias", 0);
+      if (bias != nullptr) { CHECK_EQ_OR_RETURN(bias->shape(), Shape({filters})); }
+
+      DimVector out_shape = {in->shape().At(0), filters, 0, 0};
+      for (int32_t i = 0; i < 2; ++i) {
+        CalcConvOut(in->shape().At(2 + i), kernel_size.at(i), dilation_rate.at(i), strides.at(i),
+                    padding_before.at(i), &out_shape.at(2 + i));
+      }
+      user_op::TensorDesc* out = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      *out = *in;
+      *out->mut_shape() = Shape(out_shape);
+      *out->mut_data_type() = DataType::kFloat;
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder()
+          .Broadcast(ctx->inputs())
+          .Split(user_op::OpArg("in", 0), 0)
+          .Split(user_op::OpArg("out", 0), 0)
+          .Build();
+      return Maybe<void>::Ok();
+    });
+
+}  // namespace oneflow
@@ -0,0 +1,61 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+REGISTER_USER_OP("quantized_matmul")
+    .Input("a")        // int8, quantized with a_scale
+    .Input("a_scale")  // float, shape (1,)
+    .Input("b")        // float, quantized per output column by the kernel
+    .OptionalInput("bias")
+    .Output("out")  // float
+    .Attr<bool>("transpose_b", false)
+    .Attr<bool>("fuse_relu", false)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* a = ctx->TensorDesc4ArgNameAndIndex("a", 0);
+      const user_op::TensorDesc* b = ctx->TensorDesc4ArgNameAndIndex("b", 0);
+      CHECK_EQ_OR_RETURN(a->shape().NumAxes(), 2);
+      CHECK_EQ_OR_RETURN(b->shape().NumAxes(), 2);
+      CHECK_EQ_OR_RETURN(a->data_type(), DataType::kInt8);
+      CHECK_EQ_OR_RETURN(b->data_type(), DataType::kFloat);
+      const user_op::TensorDesc* a_scale = ctx->TensorDesc4ArgNameAndIndex("a_scale", 0);
+      CHECK_EQ_OR_RETURN(a_scale->shape(), Shape({1}));
+      CHECK_EQ_OR_RETURN(a_scale->data_type(), DataType::kFloat);
+
+      const bool transpose_b = ctx->Attr<bool>("transpose_b");
+      const int64_t k = transpose_b ? b->shape().At(1) : b->shape().At(0);
+      const int64_t n = transpose_b ? b->shape().At(0) : b->shape().At(1);
+      CHECK_EQ_OR_RETURN(a->shape().At(1), k);
+      const user_op::TensorDesc* bias = ctx->TensorDesc4ArgNameAndIndex("bias", 0);
+      if (bias != nullptr) { CHECK_EQ_OR_RETURN(bias->shape(), Shape({n})); }
+
+      user_op::TensorDesc* out = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      *out = *a;
+      *out->mut_shape() = Shape({a->shape().At(0), n});
+      *out->mut_data_type() = DataType::kFloat;
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder()
+          .Broadcast(ctx->inputs())
+          .Split(user_op::OpArg("a", 0), 0)
+          .Split(user_op::OpArg("out", 0), 0)
+          .Build();
+      return Maybe<void>::Ok();
+    });
+
+}  // namespace oneflow
@@ -52,7 +52,7 @@ Maybe<void> FillScalarInSummary(const float& value, const std::string& tag, Summ
 }
 
 template<typename T>
-Maybe<void> FillHistogramInSummary(const user_op::Tensor& value, const std::string& tag,
+Maybe<void> FillHistogramInSummary(const T* values, int64_t elem_cnt, const std::string& tag,
                                    Summary* s) {
   SummaryMetadata metadata;
   SetPluginData(&metadata, kHistogramPluginName);
@@ -60,10 +60,7 @@ Maybe<void> FillHistogramInSummary(const user_op::Tensor& value, const std::stri
   v->set_tag(tag);
   *v->mutable_metadata() = metadata;
   summary::Histogram histo;
-  for (int64_t i = 0; i < value.shape().elem_cnt(); i++) {
-    double double_val = value.dptr<T>()[i];
-    histo.AppendValue(double_val);
-  }
+  histo.AppendValues<T>(values, elem_cnt);
   histo.AppendToProto(v->mutable_histo());
   return Maybe<void>::Ok();
 }
@@ -180,11 +177,19 @@ struct EventWriterHelper<DeviceType::kCPU, T> {
 
   static void WriteHistogramToFile(int64_t step, const user_op::Tensor& value,
                                    const std::string& tag) {
-    std::unique_ptr<Event> e{new Event};
-    e->set_step(step);
-    e->set_wall_time(GetWallTime());
-    FillHistogramInSummary<T>(value, tag, e->mutable_summary());
-    Global<EventsWriter>::Get()->AppendQueue(std::move(e));
+    // only the copy of the values happens on the caller thread, the histogram is summarized by
+    // the writer thread
+    const int64_t elem_cnt = value.shape().elem_cnt();
+    std::shared_ptr<std::vector<T>> values(
+        new std::vector<T>(value.dptr<T>(), value.dptr<T>() + elem_cnt));
+    const double wall_time = GetWallTime();
+    Global<EventsWriter>::Get()->AppendQueue([step, values, tag, wall_time]() {
+      std::unique_ptr<Event> e{new Event};
+      e->set_step(step);
+      e->set_wall_time(wall_time);
+      FillHistogramInSummary<T>(values->data(), values->size(), tag, e->mutable_summary());
+      return e;
+    });
   }
 
   static void WriteImageToFile(int64_t step, const user_op::Tensor& tensor,
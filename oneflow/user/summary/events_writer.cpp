@@ -21,11 +21,27 @@ namespace oneflow {
 
 namespace summary {
 
-EventsWriter::EventsWriter() : is_inited_(false) {}
+EventsWriter::EventsWriter()
+    : is_inited_(false),
+      last_flush_time_(CurrentMircoTime()),
+      appended_event_cnt_(0),
+      written_event_cnt_(0),
+      exiting_(false) {
+  writer_thread_ = std::thread(&EventsWriter::WriterLoop, this);
+}
 
-EventsWriter::~EventsWriter() { Close(); }
+EventsWriter::~EventsWriter() {
+  {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    exiting_ = true;
+  }
+  queue_cond_.notify_all();
+  writer_thread_.join();
+  Close();
+}
 
 Maybe<void> EventsWriter::Init(const std::string& logdir) {
+  std::unique_lock<std::mutex> lock(file_mutex_);
   file_system_ = std::make_unique<fs::PosixFileSystem>();
   log_dir_ = logdir + "/event";
   file_system_->RecursivelyCreateDirIfNotExist(log_dir_);
@@ -56,25 +72,67 @@ Maybe<void> EventsWriter::TryToInit() {
     event.set_wall_time(current_time);
     event.set_file_version(FILE_VERSION);
     WriteEvent(event);
-    Flush();
+    FileFlush();
   }
   return Maybe<void>::Ok();
 }
 
 void EventsWriter::AppendQueue(std::unique_ptr<Event> event) {
-  queue_mutex.lock();
-  event_queue_.emplace_back(std::move(event));
-  queue_mutex.unlock();
-  if (event_queue_.size() > MAX_QUEUE_NUM || CurrentMircoTime() - last_flush_time_ > FLUSH_TIME) {
-    Flush();
+  std::shared_ptr<Event> shared_event(event.release());
+  AppendQueue(
+      [shared_event]() { return std::unique_ptr<Event>(new Event(std::move(*shared_event))); });
+}
+
+void EventsWriter::AppendQueue(std::function<std::unique_ptr<Event>()> MakeEvent) {
+  {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    queue_cond_.wait(lock, [this]() { return event_queue_.size() < MAX_PENDING_EVENT_NUM; });
+    event_queue_.emplace_back(std::move(MakeEvent));
+    appended_event_cnt_ += 1;
+  }
+  queue_cond_.notify_all();
+}
+
+void EventsWriter::WriterLoop() {
+  while (true) {
+    std::function<std::unique_ptr<Event>()> MakeEvent;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      queue_cond_.wait(lock, [this]() { return exiting_ || !event_queue_.empty(); });
+      if (event_queue_.empty()) { break; }
+      MakeEvent = std::move(event_queue_.front());
+      event_queue_.pop_front();
+    }
+    queue_cond_.notify_all();
+    std::unique_ptr<Event> event = MakeEvent();
+    {
+      std::unique_lock<std::mutex> lock(file_mutex_);
+      if (!is_inited_) {
+        LOG(WARNING) << "Summary event is dropped because the summary writer is not created!";
+      } else if (event) {
+        WriteEvent(*event);
+      }
+      if (written_event_cnt_ % MAX_QUEUE_NUM == 0
+          || CurrentMircoTime() - last_flush_time_ > FLUSH_TIME) {
+        FileFlush();
+        last_flush_time_ = CurrentMircoTime();
+      }
+    }
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      written_event_cnt_ += 1;
+    }
+    queue_cond_.notify_all();
   }
 }
 
 void EventsWriter::Flush() {
-  queue_mutex.lock();
-  for (const std::unique_ptr<Event>& e : event_queue_) { WriteEvent(*e); }
-  event_queue_.clear();
-  queue_mutex.unlock();
+  {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    const int64_t appended_event_cnt = appended_event_cnt_;
+    queue_cond_.wait(lock, [&]() { return written_event_cnt_ >= appended_event_cnt; });
+  }
+  std::unique_lock<std::mutex> lock(file_mutex_);
   FileFlush();
   last_flush_time_ = CurrentMircoTime();
 }
@@ -98,7 +156,6 @@ void EventsWriter::WriteEvent(const Event& event) {
   writable_file_->Append(head, sizeof(head));
   writable_file_->Append(event_str.data(), event_str.size());
   writable_file_->Append(tail, sizeof(tail));
-  FileFlush();
 }
 
 void EventsWriter::FileFlush() {
@@ -108,8 +165,8 @@ void EventsWriter::FileFlush() {
 
 void EventsWriter::Close() {
   if (!is_inited_) { return; }
-  queue_mutex.unlock();
   Flush();
+  std::unique_lock<std::mutex> lock(file_mutex_);
   if (writable_file_ != nullptr) {
     writable_file_->Close();
     writable_file_.reset(nullptr);
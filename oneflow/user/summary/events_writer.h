@@ -22,18 +22,24 @@ limitations under the License.
 #include "oneflow/core/summary/event.pb.h"
 
 #include <time.h>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
+#include <thread>
 
 namespace oneflow {
 
 namespace summary {
 
 #define MAX_QUEUE_NUM 10
+#define MAX_PENDING_EVENT_NUM 256
 #define FLUSH_TIME 3 * 60 * 1000 * 1000
 #define FILE_VERSION "brain.Event:3"
 const size_t kHeadSize = sizeof(uint64_t) + sizeof(uint32_t);
 const size_t kTailSize = sizeof(uint32_t);
 
+// Events are serialized and written by a background thread. Appending an event only blocks when
+// MAX_PENDING_EVENT_NUM events are still waiting to be written.
 class EventsWriter {
  public:
   EventsWriter();
@@ -45,10 +51,13 @@ class EventsWriter {
   void Close();
 
   void AppendQueue(std::unique_ptr<Event> event);
+  // MakeEvent runs on the writer thread, so expensive summaries are built off the caller thread
+  void AppendQueue(std::function<std::unique_ptr<Event>()> MakeEvent);
   void FileFlush();
 
  private:
   Maybe<void> TryToInit();
+  void WriterLoop();
   inline static void EncodeHead(char* head, size_t size);
   inline static void EncodeTail(char* tail, const char* data, size_t size);
 
@@ -58,8 +67,15 @@ class EventsWriter {
   std::unique_ptr<fs::FileSystem> file_system_;
   std::unique_ptr<fs::WritableFile> writable_file_;
   uint64_t last_flush_time_;
-  std::vector<std::unique_ptr<Event>> event_queue_;
-  std::mutex queue_mutex;
+  std::mutex file_mutex_;
+
+  std::deque<std::function<std::unique_ptr<Event>()>> event_queue_;
+  int64_t appended_event_cnt_;
+  int64_t written_event_cnt_;
+  bool exiting_;
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cond_;
+  std::thread writer_thread_;
   OF_DISALLOW_COPY(EventsWriter);
 };
 
@@ -15,7 +15,9 @@ limitations under the License.
 */
 #include "oneflow/user/summary/histogram.h"
 #include "oneflow/core/common/maybe.h"
+#include "oneflow/core/thread/thread_manager.h"
 #include <cfloat>
+#include <cmath>
 #include <algorithm>
 
 namespace oneflow {
@@ -721,6 +723,91 @@ void Histogram::AppendValue(double value) {
   containers_.at(idx) += 1.0;
 }
 
+namespace {
+
+constexpr int64_t kHistogramChunkSize = 64 * 1024;
+// the limits around zero grow by a factor of 1.1 starting from kMinPositiveLimit
+constexpr double kMinPositiveLimit = 6.144212353328214e-06;
+const double kInvLogLimitBase = 1.0 / std::log(1.1);
+
+}  // namespace
+
+int64_t Histogram::BucketIndex(double value) const {
+  const int64_t limit_num = max_constainers_.size();
+  if (std::isnan(value)) { return limit_num - 1; }
+  // guess the bucket from the logarithmic layout of the limits, then fix it up by comparing with
+  // the real limits, so the result always equals std::upper_bound
+  const int64_t zero_idx = limit_num / 2;
+  int64_t idx = zero_idx + 1;
+  const double abs_value = std::abs(value);
+  if (abs_value >= kMinPositiveLimit) {
+    const double exponent = std::log(abs_value / kMinPositiveLimit) * kInvLogLimitBase;
+    const int64_t offset = static_cast<int64_t>(std::min<double>(exponent, zero_idx)) + 1;
+    idx = value > 0 ? zero_idx + offset + 1 : zero_idx - offset;
+  }
+  idx = std::max<int64_t>(std::min<int64_t>(idx, limit_num - 1), 0);
+  while (idx > 0 && max_constainers_[idx - 1] > value) { --idx; }
+  while (idx < limit_num - 1 && max_constainers_[idx] <= value) { ++idx; }
+  return idx;
+}
+
+template<typename T>
+void Histogram::AppendValues(const T* values, int64_t n) {
+  const int64_t chunk_num = (n + kHistogramChunkSize - 1) / kHistogramChunkSize;
+  std::vector<Histogram> chunk_histograms(chunk_num);
+  auto SummarizeChunk = [&](size_t chunk_id) {
+    Histogram* histo = &chunk_histograms.at(chunk_id);
+    const int64_t begin = chunk_id * kHistogramChunkSize;
+    const int64_t end = std::min(begin + kHistogramChunkSize, n);
+    // independent accumulators let the compiler vectorize the reductions
+    double sum[4] = {0, 0, 0, 0};
+    double sum_squares[4] = {0, 0, 0, 0};
+    double min_value[4] = {DBL_MAX, DBL_MAX, DBL_MAX, DBL_MAX};
+    double max_value[4] = {-DBL_MAX, -DBL_MAX, -DBL_MAX, -DBL_MAX};
+    int64_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+      for (int j = 0; j < 4; ++j) {
+        const double value = static_cast<double>(values[i + j]);
+        sum[j] += value;
+        sum_squares[j] += value * value;
+        min_value[j] = std::min(min_value[j], value);
+        max_value[j] = std::max(max_value[j], value);
+      }
+    }
+    for (; i < end; ++i) {
+      const double value = static_cast<double>(values[i]);
+      sum[0] += value;
+      sum_squares[0] += value * value;
+      min_value[0] = std::min(min_value[0], value);
+      max_value[0] = std::max(max_value[0], value);
+    }
+    histo->value_count_ = end - begin;
+    histo->value_sum_ = sum[0] + sum[1] + sum[2] + sum[3];
+    histo->sum_value_squares_ = sum_squares[0] + sum_squares[1] + sum_squares[2] + sum_squares[3];
+    histo->min_value_ = *std::min_element(min_value, min_value + 4);
+    histo->max_value_ = *std::max_element(max_value, max_value + 4);
+    FOR_RANGE(int64_t, k, begin, end) {
+      histo->containers_[histo->BucketIndex(static_cast<double>(values[k]))] += 1.0;
+    }
+  };
+  if (chunk_num > 1 && Global<ThreadPool>::Get() != nullptr) {
+    MultiThreadLoop(chunk_num, SummarizeChunk);
+  } else {
+    SingleThreadLoop(chunk_num, SummarizeChunk);
+  }
+  for (const Histogram& histo : chunk_histograms) { Merge(histo); }
+}
+
+void Histogram::Merge(const Histogram& other) {
+  CHECK_EQ(containers_.size(), other.containers_.size());
+  value_count_ += other.value_count_;
+  value_sum_ += other.value_sum_;
+  sum_value_squares_ += other.sum_value_squares_;
+  min_value_ = std::min(min_value_, other.min_value_);
+  max_value_ = std::max(max_value_, other.max_value_);
+  FOR_RANGE(size_t, i, 0, containers_.size()) { containers_[i] += other.containers_[i]; }
+}
+
 void Histogram::AppendToProto(HistogramProto* hist_proto) {
   hist_proto->Clear();
   hist_proto->set_num(value_count_);
@@ -744,6 +831,16 @@ void Histogram::AppendToProto(HistogramProto* hist_proto) {
   }
 }
 
+#define INSTANTIATE_HISTOGRAM_APPEND_VALUES(T) \
+  template void Histogram::AppendValues<T>(const T* values, int64_t n);
+
+INSTANTIATE_HISTOGRAM_APPEND_VALUES(float)
+INSTANTIATE_HISTOGRAM_APPEND_VALUES(double)
+INSTANTIATE_HISTOGRAM_APPEND_VALUES(int32_t)
+INSTANTIATE_HISTOGRAM_APPEND_VALUES(int64_t)
+INSTANTIATE_HISTOGRAM_APPEND_VALUES(uint8_t)
+INSTANTIATE_HISTOGRAM_APPEND_VALUES(int8_t)
+
 }  // namespace summary
 
 }  // namespace oneflow
@@ -29,6 +29,11 @@ class Histogram {
   ~Histogram() {}
 
   void AppendValue(double value);
+  // Appends n values at once. The values are split into chunks which are summarized in parallel
+  // and merged, it is much faster than calling AppendValue on every element.
+  template<typename T>
+  void AppendValues(const T* values, int64_t n);
+  void Merge(const Histogram& other);
   void AppendToProto(HistogramProto* proto);
 
  private:
@@ -38,6 +43,8 @@ class Histogram {
   double min_value_;
   double max_value_;
 
+  int64_t BucketIndex(double value) const;
+
   std::vector<double> max_constainers_;
   std::vector<double> containers_;
 };